@@ -50,6 +50,7 @@ AddPlaneNode::createPlugin()
     EffectDescriptionPtr effectDesc = ret->getEffectDescriptor();
     effectDesc->setProperty<RenderSafetyEnum>(kEffectPropRenderThreadSafety, eRenderSafetyFullySafe);
     effectDesc->setProperty<bool>(kEffectPropSupportsTiles, true);
+    effectDesc->setProperty<bool>(kEffectPropPixelLocal, true);
     ret->setProperty<ImageBitDepthEnum>(kNatronPluginPropOutputSupportedBitDepths, eImageBitDepthFloat, 0);
     ret->setProperty<ImageBitDepthEnum>(kNatronPluginPropOutputSupportedBitDepths, eImageBitDepthShort, 1);
     ret->setProperty<ImageBitDepthEnum>(kNatronPluginPropOutputSupportedBitDepths, eImageBitDepthByte, 2);
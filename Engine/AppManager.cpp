@@ -49,6 +49,7 @@
 #include <csignal>
 #include <cstddef>
 #include <cassert>
+#include <algorithm> // min
 #include <stdexcept>
 #include <cstring> // for std::memcpy, strlen
 #include <sstream> // stringstream
@@ -92,6 +93,7 @@ GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 #include <QtCore/QTextCodec>
 #include <QtCore/QCoreApplication>
 #include <QtCore/QSettings>
+#include <QtCore/QThread>
 #include <QtCore/QThreadPool>
 #include <QtCore/QTextStream>
 #include <QtNetwork/QAbstractSocket>
@@ -135,6 +137,7 @@ GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 #include "Engine/ProcessHandler.h" // ProcessInputChannel
 #include "Engine/Project.h"
 #include "Engine/PrecompNode.h"
+#include "Engine/RamBuffer.h"
 #include "Engine/ReadNode.h"
 #include "Engine/RemovePlaneNode.h"
 #include "Engine/RotoPaint.h"
@@ -197,6 +200,9 @@ setShutDownSignal(int signalId)
 #endif
 
 
+// Minimum delay between two computations of the tile cache pressure, see getTileCachePressure()
+#define NATRON_CACHE_PRESSURE_REFRESH_MS 1000
+
 #if defined(__NATRON_LINUX__) && !defined(__FreeBSD__)
 
 #define NATRON_UNIX_BACKTRACE_STACK_DEPTH 16
@@ -427,6 +433,14 @@ AppManager::takeNatronGIL()
 {
     _imp->natronPythonGIL.lock();
     ++_imp->pythonGILRCount;
+    if (_imp->pythonGILRCount == 1) {
+        _imp->pythonGILOwner = QThread::currentThread();
+        if (_imp->nPythonGILUnlockers > 0) {
+            // A script released the Python GIL while waiting in PythonGILUnlocker: take it with a thread state of this thread
+            _imp->pythonGILState = PyGILState_Ensure();
+            _imp->pythonGILStateEnsured = true;
+        }
+    }
 }
 
 void
@@ -437,11 +451,68 @@ AppManager::releaseNatronGIL()
     if (_imp->pythonGILRCount == 0) {
         NATRON_PYTHON_NAMESPACE::clearPythonStdErr();
         NATRON_PYTHON_NAMESPACE::clearPythonStdOut();
+        if (_imp->pythonGILStateEnsured) {
+            _imp->pythonGILStateEnsured = false;
+            PyGILState_Release(_imp->pythonGILState);
+        }
+        _imp->pythonGILOwner = 0;
     }
     _imp->natronPythonGIL.unlock();
 
 }
 
+void
+AppManager::releaseNatronGILForWait(PythonGILUnlocker* unlocker)
+{
+    if (_imp->pythonGILOwner != QThread::currentThread()) {
+        // The calling thread does not run Python code
+        return;
+    }
+    unlocker->_count = _imp->pythonGILRCount;
+    assert(unlocker->_count > 0);
+
+    // The Python GIL state taken by this thread in takeNatronGIL() is given back along with its thread state
+    unlocker->_gilStateEnsured = _imp->pythonGILStateEnsured;
+    unlocker->_gilState = _imp->pythonGILState;
+    _imp->pythonGILStateEnsured = false;
+
+    // Release the Python GIL first, only if this thread holds it with its own thread state: otherwise the threads taking
+    // the Natron GIL could not take it. Do not clear the Python output: it belongs to the script that is waiting.
+    PyThreadState* threadState = PyGILState_GetThisThreadState();
+    if ( threadState && (threadState == PyThreadState_GET()) ) {
+        unlocker->_threadState = PyEval_SaveThread();
+        ++_imp->nPythonGILUnlockers;
+    }
+    _imp->pythonGILRCount = 0;
+    _imp->pythonGILOwner = 0;
+    for (int i = 0; i < unlocker->_count; ++i) {
+        _imp->natronPythonGIL.unlock();
+    }
+}
+
+void
+AppManager::restoreNatronGILAfterWait(const PythonGILUnlocker& unlocker)
+{
+    if (unlocker._count == 0) {
+        return;
+    }
+
+    // Take the locks in the same order as other threads: the Natron GIL, then the Python GIL
+    for (int i = 0; i < unlocker._count; ++i) {
+        _imp->natronPythonGIL.lock();
+    }
+    assert(_imp->pythonGILRCount == 0);
+    _imp->pythonGILRCount = unlocker._count;
+    _imp->pythonGILOwner = QThread::currentThread();
+    if (unlocker._threadState) {
+        assert(_imp->nPythonGILUnlockers > 0);
+        --_imp->nPythonGILUnlockers;
+        PyEval_RestoreThread(unlocker._threadState);
+    }
+    _imp->pythonGILStateEnsured = unlocker._gilStateEnsured;
+    _imp->pythonGILState = unlocker._gilState;
+}
+
 int
 AppManager::getGILLockedCount() const
 {
@@ -690,7 +761,18 @@ AppManager::~AppManager()
 
     _imp->_backgroundIPC.reset();
 
+    if ( !_imp->cacheStatsFilePath.empty() ) {
+        FStreamsSupport::ofstream ofile;
+        FStreamsSupport::open(&ofile, _imp->cacheStatsFilePath);
+        if (ofile) {
+            ofile << getCacheStatisticsAsJSON();
+        } else {
+            std::cerr << tr("Failed to open file: ").toStdString() << _imp->cacheStatsFilePath << std::endl;
+        }
+    }
+
     _imp->storageDeleteThread->quitThread();
+    _imp->storageAllocatorThread->quitThread();
 
 
     ///Caches may have launched some threads to delete images, wait for them to be done
@@ -980,6 +1062,8 @@ AppManager::loadInternal(const CLArgs& cl)
     _imp->generalPurposeCache->setMaximumCacheSize(_imp->_settings->getGeneralPurposeCacheSize());
 
     _imp->storageDeleteThread.reset(new StorageDeleterThread);
+    _imp->storageAllocatorThread.reset(new StorageAllocatorThread);
+    _imp->storageAllocatorThread->start();
 
     _imp->declareSettingsToPython();
 
@@ -1212,6 +1296,8 @@ AppManager::loadInternalAfterInitGui(const CLArgs& cl)
         _imp->initProcessInputChannel( cl.getIPCPipeName() );
     }
 
+    _imp->cacheStatsFilePath = cl.getCacheStatsFilePath().toStdString();
+
 
     if ( cl.isInterpreterMode() ) {
         _imp->_appType = eAppTypeInterpreter;
@@ -1421,7 +1507,8 @@ AppManager::clearAllCaches()
 
     _imp->generalPurposeCache->clear();
     _imp->tileCache->clear();
-    
+    _imp->storageAllocatorThread->clearPool();
+
     ///for each app instance clear all its nodes cache
     for (AppInstanceVec::iterator it = copy.begin(); it != copy.end(); ++it) {
         (*it)->clearOpenFXPluginsCaches();
@@ -2599,6 +2686,52 @@ AppManager::getTileCache() const
     return _imp->tileCache;
 }
 
+std::string
+AppManager::getCacheStatisticsAsJSON() const
+{
+    std::stringstream ss;
+    ss << "{\n";
+    ss << "    \"tileCache\": " << (_imp->tileCache ? _imp->tileCache->getStatistics().toJSON("    ") : std::string("null")) << ",\n";
+    ss << "    \"generalPurposeCache\": " << (_imp->generalPurposeCache ? _imp->generalPurposeCache->getStatistics().toJSON("    ") : std::string("null")) << "\n";
+    ss << "}\n";
+    return ss.str();
+}
+
+void
+AppManager::resetCacheStatistics()
+{
+    if (_imp->tileCache) {
+        _imp->tileCache->getStatistics().reset();
+    }
+    if (_imp->generalPurposeCache) {
+        _imp->generalPurposeCache->getStatistics().reset();
+    }
+}
+
+double
+AppManager::getTileCachePressure() const
+{
+    if (!_imp->tileCache) {
+        return 0.;
+    }
+    QMutexLocker k(&_imp->tileCachePressureMutex);
+    TimestampVal now = getTimestampInSeconds();
+    if ( _imp->tileCachePressureSet && (getTimeElapsed(_imp->tileCachePressureTimestamp, now, getPerformanceFrequency()) * 1000. < NATRON_CACHE_PRESSURE_REFRESH_MS) ) {
+        return _imp->tileCachePressure;
+    }
+    std::size_t maxSize = _imp->tileCache->getMaximumCacheSize();
+    if (maxSize == 0) {
+        // No limit
+        _imp->tileCachePressure = 0.;
+    } else {
+        _imp->tileCachePressure = std::min(1., (double)_imp->tileCache->getCurrentSize() / maxSize);
+    }
+    _imp->tileCachePressureTimestamp = now;
+    _imp->tileCachePressureSet = true;
+
+    return _imp->tileCachePressure;
+} // getTileCachePressure
+
 void
 AppManager::deleteCacheEntriesInSeparateThread(const std::list<ImageStorageBasePtr> & entriesToDelete)
 {
@@ -2611,6 +2744,26 @@ AppManager::checkCachesMemory()
     _imp->storageDeleteThread->checkCachesMemory();
 }
 
+RamBufferPtr
+AppManager::allocateRAMStorageBuffer(std::size_t nBytes)
+{
+    if (!_imp->storageAllocatorThread) {
+        RamBufferPtr ret(new RamBuffer<char>);
+        ret->resize(nBytes);
+        return ret;
+    }
+    return _imp->storageAllocatorThread->allocateBuffer(nBytes);
+}
+
+void
+AppManager::recycleRAMStorageBuffer(const RamBufferPtr& buffer)
+{
+    if (!_imp->storageAllocatorThread) {
+        return;
+    }
+    _imp->storageAllocatorThread->recycleBuffer(buffer);
+}
+
 void
 AppManager::printCacheMemoryStats() const
 {
@@ -2622,6 +2775,7 @@ AppManager::printCacheMemoryStats() const
     QString reportStr;
     std::size_t totalBytes = 0;
     int totalNEntries = 0;
+    CacheReportInfo totalPerPriority;
     reportStr += QLatin1String("\n");
     if (!infos.empty()) {
         for (std::map<std::string, CacheReportInfo>::iterator it = infos.begin(); it!= infos.end(); ++it) {
@@ -2630,6 +2784,10 @@ AppManager::printCacheMemoryStats() const
             }
             totalBytes += it->second.nBytes;
             totalNEntries += it->second.nEntries;
+            for (int i = 0; i < NATRON_CACHE_ENTRY_PRIORITY_COUNT; ++i) {
+                totalPerPriority.nEntriesPerPriority[i] += it->second.nEntriesPerPriority[i];
+                totalPerPriority.nBytesPerPriority[i] += it->second.nBytesPerPriority[i];
+            }
             
             reportStr += QString::fromUtf8(it->first.c_str());
             reportStr += QLatin1String("--> ");
@@ -2648,6 +2806,17 @@ AppManager::printCacheMemoryStats() const
     reportStr += QLatin1String("--> ");
     reportStr += printAsRAM(totalBytes);
     reportStr += tr(" taken by %1 cache entries.").arg(QString::number(totalNEntries));
+    reportStr += QLatin1String("\n");
+
+    // Break down by priority class, from the most protected to the first evicted
+    const QString priorityLabels[NATRON_CACHE_ENTRY_PRIORITY_COUNT] = { tr("Batch"), tr("Preview"), tr("Playback"), tr("Viewer") };
+    for (int i = NATRON_CACHE_ENTRY_PRIORITY_COUNT - 1; i >= 0; --i) {
+        reportStr += QLatin1String("\n");
+        reportStr += priorityLabels[i];
+        reportStr += QLatin1String("--> ");
+        reportStr += printAsRAM(totalPerPriority.nBytesPerPriority[i]);
+        reportStr += tr(" taken by %1 cache entries.").arg(QString::number(totalPerPriority.nEntriesPerPriority[i]));
+    }
 
     appPTR->writeToErrorLog_mt_safe(tr("Cache Report"), QDateTime::currentDateTime(), reportStr);
 
@@ -3898,6 +4067,24 @@ PythonGILLocker::PythonGILLocker()
 //#endif
 }
 
+PythonGILUnlocker::PythonGILUnlocker()
+    : _count(0)
+    , _threadState(0)
+    , _gilStateEnsured(false)
+    , _gilState(PyGILState_UNLOCKED)
+{
+    if (appPTR) {
+        appPTR->releaseNatronGILForWait(this);
+    }
+}
+
+PythonGILUnlocker::~PythonGILUnlocker()
+{
+    if (appPTR) {
+        appPTR->restoreNatronGILAfterWait(*this);
+    }
+}
+
 PythonGILLocker::~PythonGILLocker()
 {
     if (appPTR) {
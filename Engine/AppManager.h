@@ -88,6 +88,7 @@ struct PythonUserCommand
 typedef std::vector<AppInstancePtr> AppInstanceVec;
 
 struct AppManagerPrivate;
+class PythonGILUnlocker;
 class AppManager
     : public QObject, public AfterQuitProcessingI, public boost::noncopyable
 {
@@ -188,6 +189,23 @@ public:
 
     CacheBasePtr getTileCache() const;
 
+    /**
+     * @brief Returns the statistics of the tile cache and of the general purpose cache as a JSON object
+     **/
+    std::string getCacheStatisticsAsJSON() const;
+
+    /**
+     * @brief Reset the statistics of all caches, e.g: to measure the cache efficiency of a single render
+     **/
+    void resetCacheStatistics();
+
+    /**
+     * @brief Returns the fraction of the tile cache maximum size that is currently used, in [0, 1].
+     * Computing the cache size requires locking all buckets, hence the value is only refreshed every
+     * NATRON_CACHE_PRESSURE_REFRESH_MS milliseconds.
+     **/
+    double getTileCachePressure() const;
+
     void deleteCacheEntriesInSeparateThread(const std::list<ImageStorageBasePtr> & entriesToDelete);
 
     /**
@@ -196,6 +214,17 @@ public:
      **/
     void checkCachesMemory();
 
+    /**
+     * @brief Returns a RAM buffer of at least nBytes, taken from the StorageAllocatorThread pool if possible.
+     * This may throw a std::bad_alloc exception.
+     **/
+    RamBufferPtr allocateRAMStorageBuffer(std::size_t nBytes);
+
+    /**
+     * @brief Gives back a buffer obtained with allocateRAMStorageBuffer to the StorageAllocatorThread pool
+     **/
+    void recycleRAMStorageBuffer(const RamBufferPtr& buffer);
+
     SettingsPtr getCurrentSettings() const WARN_UNUSED_RETURN;
     const KnobFactory & getKnobFactory() const WARN_UNUSED_RETURN;
 
@@ -346,9 +375,14 @@ public:
 
 private:
     friend class PythonGILLocker;
+    friend class PythonGILUnlocker;
     void takeNatronGIL();
 
     void releaseNatronGIL();
+
+    void releaseNatronGILForWait(PythonGILUnlocker* unlocker);
+
+    void restoreNatronGILAfterWait(const PythonGILUnlocker& unlocker);
 public:
 
     int getGILLockedCount() const;
@@ -720,6 +754,32 @@ public:
     ~PythonGILLocker();
 };
 
+/**
+ * @brief Small helper class to use as RAII to release the Natron and Python GILs held by the calling thread while it
+ * waits for other threads that may run Python code, e.g: a render with Python expressions. Both are taken back
+ * on destruction. This does nothing if the calling thread does not hold the Natron GIL.
+ * Meanwhile, threads taking the Natron GIL also take the Python GIL with their own thread state (PyGILState_Ensure).
+ **/
+class PythonGILUnlocker
+{
+    friend class AppManager;
+
+    // The number of times the Natron GIL was locked by the calling thread
+    int _count;
+
+    // The Python thread state of the calling thread, restored on destruction
+    PyThreadState* _threadState;
+
+    // The Python GIL state taken by the calling thread in takeNatronGIL(), if any
+    bool _gilStateEnsured;
+    PyGILState_STATE _gilState;
+
+public:
+    PythonGILUnlocker();
+
+    ~PythonGILUnlocker();
+};
+
 NATRON_NAMESPACE_EXIT
 
 
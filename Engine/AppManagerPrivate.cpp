@@ -91,6 +91,11 @@ AppManagerPrivate::AppManagerPrivate()
     , generalPurposeCache()
     , tileCache()
     , _backgroundIPC()
+    , cacheStatsFilePath()
+    , tileCachePressureMutex()
+    , tileCachePressure(0)
+    , tileCachePressureTimestamp()
+    , tileCachePressureSet(false)
     , _loaded(false)
     , binaryPath()
     , errorLogMutex()
@@ -109,6 +114,10 @@ AppManagerPrivate::AppManagerPrivate()
 #endif
     , natronPythonGIL(QMutex::Recursive)
     , pythonGILRCount(0)
+    , pythonGILOwner(0)
+    , nPythonGILUnlockers(0)
+    , pythonGILStateEnsured(false)
+    , pythonGILState(PyGILState_UNLOCKED)
     , glRequirements()
     , glHasTextureFloat(false)
     , hasInitializedOpenGLFunctions(false)
@@ -34,6 +34,7 @@
 
 CLANG_DIAG_OFF(uninitialized)
 #include <QtCore/QMutex>
+#include <QtCore/QThread>
 #include <QtCore/QString>
 #include <QtCore/QAtomicInt>
 #include <QtCore/QCoreApplication>
@@ -57,6 +58,7 @@ CLANG_DIAG_ON(uninitialized)
 #include "Engine/GenericSchedulerThreadWatcher.h"
 #include "Engine/TreeRenderQueueManager.h"
 #include "Engine/TLSHolder.h"
+#include "Engine/Timer.h"
 
 // include breakpad after Engine, because it includes /usr/include/AssertMacros.h on OS X which defines a check(x) macro, which conflicts with boost
 #ifdef NATRON_USE_BREAKPAD
@@ -122,8 +124,18 @@ public:
 
     boost::scoped_ptr<StorageDeleterThread> storageDeleteThread; // thread used to kill cache entries without blocking a render thread
 
+    boost::scoped_ptr<StorageAllocatorThread> storageAllocatorThread; // thread used to pre-fault RAM buffers before render threads need them
+
     boost::scoped_ptr<ProcessInputChannel> _backgroundIPC; //< object used to communicate with the main app
 
+    std::string cacheStatsFilePath; //< if not empty, the cache statistics are written to this file when exiting
+
+    // Last value returned by getTileCachePressure() and the time at which it was computed
+    mutable QMutex tileCachePressureMutex;
+    mutable double tileCachePressure;
+    mutable TimestampVal tileCachePressureTimestamp;
+    mutable bool tileCachePressureSet;
+
     //if this app is background, see the ProcessInputChannel def
     bool _loaded; //< true when the first instance is completly loaded.
 
@@ -164,6 +176,17 @@ public:
     QMutex natronPythonGIL;
     int pythonGILRCount;
 
+    // The thread holding natronPythonGIL, or NULL
+    QThread* pythonGILOwner;
+
+    // Number of PythonGILUnlocker active: while non zero, the thread taking the Natron GIL also takes the Python GIL
+    // with its own thread state. Protected by natronPythonGIL.
+    int nPythonGILUnlockers;
+
+    // True if the thread holding natronPythonGIL took the Python GIL with pythonGILState
+    bool pythonGILStateEnsured;
+    PyGILState_STATE pythonGILState;
+
 #ifdef Q_OS_WIN32
     //On Windows only, track the UNC path we came across because the WIN32 API does not provide any function to map
     //from UNC path to path with drive letter.
@@ -76,6 +76,7 @@ public:
     QString breakpadProcessFilePath;
     qint64 breakpadProcessPID;
     QString exportDocsPath;
+    QString cacheStatsFilePath;
 
     CLArgsPrivate()
         : args()
@@ -104,6 +105,7 @@ public:
         , breakpadProcessFilePath()
         , breakpadProcessPID(-1)
         , exportDocsPath()
+        , cacheStatsFilePath()
     {
     }
 
@@ -235,6 +237,7 @@ CLArgs::operator=(const CLArgs& other)
     _imp->isEmpty = other._imp->isEmpty;
     _imp->imageFilename = other._imp->imageFilename;
     _imp->exportDocsPath = other._imp->exportDocsPath;
+    _imp->cacheStatsFilePath = other._imp->cacheStatsFilePath;
 }
 
 bool
@@ -343,7 +346,11 @@ CLArgs::printUsage(const std::string& programName)
         "     breakdown contains informations about each nodes, render times etc...\n"
         "     This option is useful for debugging purposes or to control that a render\n"
         "     is working correctly.\n"
-        "     **Please note** that it does not work when writing video files."
+        "     **Please note** that it does not work when writing video files.\n"
+        "  --cache-stats <filename>\n"
+        "     Write the cache statistics (hit rate, evictions, time spent waiting for\n"
+        "     locks and tiles, bytes copied in and out of the cache...) in JSON\n"
+        "     format to the given file when %1 exits.\n\n"
         "Sample uses:\n"
         "  %1 /Users/Me/MyNatronProjects/MyProject.ntp\n"
         "  %1 -b -w MyWriter /Users/Me/MyNatronProjects/MyProject.ntp\n"
@@ -563,6 +570,12 @@ CLArgs::getExportDocsPath() const
     return _imp->exportDocsPath;
 }
 
+const QString &
+CLArgs::getCacheStatsFilePath() const
+{
+    return _imp->cacheStatsFilePath;
+}
+
 QStringList::iterator
 CLArgsPrivate::findFileNameWithExtension(const QString& extension)
 {
@@ -908,6 +921,22 @@ CLArgsPrivate::parse()
         }
     }
 
+    {
+        QStringList::iterator it = hasToken( QString::fromUtf8("cache-stats"), QString() );
+        if ( it != args.end() ) {
+            ++it;
+            if ( it != args.end() ) {
+                cacheStatsFilePath = *it;
+                args.erase(it);
+            } else {
+                std::cout << tr("You must specify the cache statistics file path").toStdString() << std::endl;
+                error = 1;
+
+                return;
+            }
+        }
+    }
+
     {
         QStringList::iterator it = hasToken( QString::fromUtf8("IPCpipe"), QString() );
         if ( it != args.end() ) {
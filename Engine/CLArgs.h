@@ -141,6 +141,7 @@ public:
     const QString& getBreakpadPipeFilePath() const;
     const QString& getBreakpadComPipeFilePath() const;
     const QString& getExportDocsPath() const;
+    const QString& getCacheStatsFilePath() const;
 
 private:
 
@@ -28,6 +28,8 @@
 #include <stdexcept>
 #include <set>
 #include <list>
+#include <algorithm>
+#include <cstring>
 
 #ifdef __NATRON_UNIX__
 #include <time.h>
@@ -60,11 +62,13 @@ GCC_DIAG_OFF(unused-parameter)
 #include <boost/interprocess/sync/interprocess_condition_any.hpp> // IPC  wait cond with a r-w mutex
 #include <boost/interprocess/sync/file_lock.hpp> // IPC  file lock
 #include <boost/interprocess/sync/named_semaphore.hpp> // IPC  named semaphore
+#include <boost/interprocess/detail/atomic.hpp> // IPC  atomic counters
 #include <boost/thread/mutex.hpp> // local mutex
 #include <boost/thread/recursive_mutex.hpp> // local mutex
 #include <boost/thread/shared_mutex.hpp> // local r-w mutex
 #include <boost/thread/locks.hpp>
 #include <boost/thread/condition_variable.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
 
 #include <boost/lexical_cast.hpp> // to convert uuid to string
 #include <boost/uuid/uuid_io.hpp>
@@ -113,16 +117,37 @@ NATRON_NAMESPACE_ENTER
 #define NATRON_CACHE_BUCKET_TOC_FILE_GROW_N_BYTES 524288 // = 512 * 1024
 
 // If we change the MemorySegmentEntryHeader struct, we must increment this version so we do not attempt to read an invalid structure.
-#define NATRON_MEMORY_SEGMENT_ENTRY_HEADER_VERSION 4
+#define NATRON_MEMORY_SEGMENT_ENTRY_HEADER_VERSION 7
 
 // After this amount of milliseconds, if a thread is not able to access a mutex, the cache is assumed to be inconsistent
 #define NATRON_CACHE_INTERPROCESS_MUTEX_TIMEOUT_MS 10000
 
+// When a timed lock cannot be taken, the thread spins for this number of attempts, then yields until
+// NATRON_CACHE_TIMED_LOCK_SLEEP_AFTER_N_ATTEMPTS attempts and then sleeps 1ms between each attempt.
+#define NATRON_CACHE_TIMED_LOCK_SPIN_N_ATTEMPTS 16
+#define NATRON_CACHE_TIMED_LOCK_SLEEP_AFTER_N_ATTEMPTS 64
+
 // Each tile storage file is 1GB, which corresponds to exactly 256 tiles of NATRON_TILE_SIZE_BYTES bytes for each 256 buckets.
 #define NATRON_NUM_TILES_PER_BUCKET_FILE 256
 #define NATRON_NUM_TILES_PER_FILE (NATRON_NUM_TILES_PER_BUCKET_FILE * NATRON_CACHE_BUCKETS_COUNT)
 #define NATRON_TILE_STORAGE_FILE_SIZE (NATRON_TILE_SIZE_BYTES * NATRON_NUM_TILES_PER_FILE)
 
+// When evicting, the maximum number of entries visited at the front of the LRU list of a bucket to find the one
+// with the lowest priority class
+#define NATRON_CACHE_EVICTION_MAX_VISITED_ENTRIES 32
+
+// Bit set in the pin count of a tile that was released while pinned: it is given back to the free tiles
+// when its last pin is released.
+#define NATRON_CACHE_TILE_PIN_FREE_PENDING 0x80000000
+
+// An entry that was not accessed for more than this amount of seconds loses the protection given by its priority class
+// and is evicted as if it had the lowest priority. This ensures high priority entries cannot fill up the cache forever.
+#define NATRON_CACHE_PRIORITY_PROTECTION_S 30
+
+// Maximum amount of milliseconds a thread waits for a notification on the entry state condition of a bucket before
+// looking-up the entry again. Notifications cannot be missed, but a process computing an entry may crash without notifying.
+#define NATRON_CACHE_ENTRY_STATE_WAIT_MAX_MS 500
+
 
 #ifdef DEBUG
 // When defined, tiles memory chunk are initialized to NaN by default and also checked against NaN
@@ -291,10 +316,19 @@ bool timed_lock_impl(Mutex* m, std::size_t timeoutMilliseconds, double frequency
         TimestampVal now = startTime;
 
         double timeElapsedMS = 0.;
+        int nAttempts = 0;
         do {
             if ((m->*try_lock_func)()) {
                 return true;
             }
+            // Do not burn a core while the mutex is held for a long time: after a few attempts,
+            // give the time slice away, then sleep a little between each attempt.
+            ++nAttempts;
+            if (nAttempts > NATRON_CACHE_TIMED_LOCK_SLEEP_AFTER_N_ATTEMPTS) {
+                CacheEntryLockerBase::sleep_milliseconds(1);
+            } else if (nAttempts > NATRON_CACHE_TIMED_LOCK_SPIN_N_ATTEMPTS) {
+                QThread::yieldCurrentThread();
+            }
             now = getTimestampInSeconds();
             timeElapsedMS = getTimeElapsed(startTime, now, frequency) * 1000.;
         } while(timeElapsedMS < timeoutMilliseconds);
@@ -342,6 +376,14 @@ public:
         m_locked = true;
     }
 
+    // Try to take the lock without blocking
+    bool try_lock()
+    {
+        assert(mp_mutex && !m_locked);
+        m_locked = (mp_mutex->*try_lock_func)();
+        return m_locked;
+    }
+
     // Try to take the lock and bail out if it failed to do
     // so after timeoutMilliseconds milliseconds.
     // If timeoutMilliseconds is 0, this is the same as lock()
@@ -527,6 +569,21 @@ typedef boost::condition_variable_any ConditionVariable;
 
 #endif // NATRON_CACHE_INTERPROCESS_ROBUST
 
+/**
+ * @brief Waits on the condition for at most timeoutMS milliseconds. The lock must be locked and is locked again when returning.
+ **/
+template <typename LOCK>
+void timedWaitCondition(ConditionVariable& cond, LOCK& lock, std::size_t timeoutMS)
+{
+#ifdef NATRON_CACHE_INTERPROCESS_ROBUST
+    // Interprocess conditions only accept an absolute time
+    boost::posix_time::ptime absTime = boost::posix_time::microsec_clock::universal_time() + boost::posix_time::milliseconds((long)timeoutMS);
+    cond.timed_wait(lock, absTime);
+#else
+    cond.timed_wait(lock, boost::posix_time::milliseconds((long)timeoutMS));
+#endif
+}
+
 
 /**
  * @brief An exception thrown when a mutex used in the cache implementation is abandonned
@@ -629,6 +686,35 @@ struct TileInternalIndexImplCompareLess
 // The list of free tiles indices in a bucket
 typedef bip::list<TileInternalIndexImpl, TileInternalIndexImplAllocator> TileInternalIndexImplList;
 
+// The pin count of each tile of a bucket, see getTilePinCountIndex()
+typedef bip::allocator<boost::uint32_t, ExternalSegmentType::segment_manager> TilePinCountAllocator;
+typedef bip::vector<boost::uint32_t, TilePinCountAllocator> TilePinCountVector;
+
+/**
+ * @brief Returns the index of the bucket holding the free tiles list and the pin count of the given tile.
+ **/
+inline int getTileBucketIndex(const TileInternalIndex& index)
+{
+#ifdef NATRON_CACHE_TILES_MEMORY_ALLOCATOR_CENTRALIZED
+    (void)index;
+    return 0;
+#else
+    return index.bucketIndex;
+#endif
+}
+
+/**
+ * @brief Returns the index of the pin count of the given tile in the tilePinCounts of its bucket.
+ **/
+inline std::size_t getTilePinCountIndex(const TileInternalIndexImpl& index)
+{
+#ifdef NATRON_CACHE_TILES_MEMORY_ALLOCATOR_CENTRALIZED
+    return (std::size_t)index.fileIndex * NATRON_NUM_TILES_PER_FILE + index.tileIndex;
+#else
+    return (std::size_t)index.fileIndex * NATRON_NUM_TILES_PER_BUCKET_FILE + index.tileIndex;
+#endif
+}
+
 typedef boost::interprocess::allocator<TileInternalIndex, ExternalSegmentType::segment_manager> TileInternalIndexAllocator;
 typedef boost::interprocess::list<TileInternalIndex, TileInternalIndexAllocator> TileInternalIndexList;
 
@@ -803,6 +889,10 @@ struct MemorySegmentEntryHeaderBase
     // Set of tile indices allocated for this entry
     TileInternalIndexList tileIndices;
 
+    // The priority class of the entry (a CacheEntryPriorityEnum). This is the highest priority of all renders that
+    // accessed the entry. Protected by lruListMutex
+    int priority;
+
     MemorySegmentEntryHeaderBase(const external_void_allocator& allocator)
     : size(0)
     , uniqueID(0)
@@ -812,8 +902,24 @@ struct MemorySegmentEntryHeaderBase
     , lruNode()
     , timestamp()
     , tileIndices(allocator)
+    , priority(eCacheEntryPriorityViewer)
     {}
 
+    /**
+     * @brief Returns the priority class used to sort this entry when evicting: an entry that was not accessed
+     * for a while loses its protection.
+     **/
+    int getEvictionPriority(const TimestampVal& now, double frequency) const
+    {
+        if (priority == eCacheEntryPriorityBatch) {
+            return priority;
+        }
+        if (getTimeElapsed(timestamp, now, frequency) > NATRON_CACHE_PRIORITY_PROTECTION_S) {
+            return eCacheEntryPriorityBatch;
+        }
+        return priority;
+    }
+
 };
 
 template <bool persistent>
@@ -936,6 +1042,16 @@ struct CacheBucketIPCData
     //
     bip::offset_ptr<TileInternalIndexImplList> freeTiles;
 
+    // Number of CacheTilesPinBase objects alive for each tile of the bucket, across all processes.
+    // It is resized along with freeTiles when a tile storage file is created.
+    // Pin counts are incremented with atomic operations under the bucketMutex taken in read mode and
+    // are decremented or flagged with NATRON_CACHE_TILE_PIN_FREE_PENDING under the bucketMutex taken in write mode.
+    bip::offset_ptr<TilePinCountVector> tilePinCounts;
+
+    // The sum of the pin counts of all tiles of the bucket, so that clear() can check it without scanning tilePinCounts.
+    // Same protection as tilePinCounts.
+    volatile boost::uint32_t nTilePins;
+
     CacheBucketIPCData(ExternalSegmentType* segment, bool allocateFreeTiles)
     : lruListFront(0)
     , lruListBack(0)
@@ -944,11 +1060,14 @@ struct CacheBucketIPCData
     , size(0)
     , entriesMap()
     , freeTiles()
+    , tilePinCounts()
+    , nTilePins(0)
     {
         external_void_allocator allocator(segment->get_segment_manager());
         entriesMap = bip::offset_ptr<EntriesMap>(segment->template construct<EntriesMap>(bip::anonymous_instance)(allocator));
         if (allocateFreeTiles) {
             freeTiles = bip::offset_ptr<TileInternalIndexImplList>(segment->template construct<TileInternalIndexImplList>(bip::anonymous_instance)(allocator));
+            tilePinCounts = bip::offset_ptr<TilePinCountVector>(segment->template construct<TilePinCountVector>(bip::anonymous_instance)(allocator));
         }
     }
 
@@ -997,16 +1116,69 @@ struct CacheBucket
     // as long as tocFile is mapped
     IPCData *ipc;
 
+    // True once this process has opened and mapped the tocFile. The table of contents of a bucket
+    // is mapped the first time the bucket is accessed rather than when the cache is created, so that
+    // the startup time does not depend on the size of the cache.
+    // This is local to the process and protected by the tocData.segmentMutex
+    bool tocMapped;
+
+    // True once this process has opened the tocFile and is counted in tocData.nProcessWithMappingValid.
+    // This may be true while tocMapped is false if the content of the file could not be read.
+    // This is local to the process and protected by the tocData.segmentMutex
+    bool tocOpened;
+
+    // Pointer to the size of this bucket in the buckets size file of the cache. This is a copy of ipc->size
+    // that can be read without mapping the ToC, see Cache::getCurrentSize()
+    U64* storedSize;
+
     CacheBucket()
     : cache()
     , tocFileManager()
     , bucketIndex(-1)
     , tocFile()
     , ipc(0)
+    , tocMapped(false)
+    , tocOpened(false)
+    , storedSize(0)
     {
 
     }
 
+    /**
+     * @brief Copies ipc->size to storedSize. This must be called whenever ipc->size changes, with
+     * the bucketMutex taken in write mode or the tocData.segmentMutex taken in write mode.
+     **/
+    void updateStoredSize()
+    {
+        if (storedSize && ipc) {
+            *storedSize = ipc->size;
+        }
+    }
+
+    /**
+     * @brief Returns the pin count of the given tile of this bucket, or NULL if no tile storage file holds this tile.
+     * This function assumes that the tocData.segmentMutex is taken at least in read mode.
+     **/
+    volatile boost::uint32_t* getTilePinCount(const TileInternalIndexImpl& index) const
+    {
+        if (!ipc || !ipc->tilePinCounts) {
+            return 0;
+        }
+        std::size_t i = getTilePinCountIndex(index);
+        if ( i >= ipc->tilePinCounts->size() ) {
+            return 0;
+        }
+        return &(*ipc->tilePinCounts)[i];
+    }
+
+    /**
+     * @brief Resets the pin counts of all tiles: called when the first process maps the ToC, since pins
+     * can only be left by a process that exited while holding them. Tiles that were released while pinned are given back
+     * to the free tiles.
+     * @param tocFileLock The tocData.segmentMutex is assumed to be taken for write-lock: this is the lock currently taken
+     **/
+    void releaseAbandonnedTilePins(Sharable_WriteLock& tocFileLock);
+
     /**
      * @brief Deallocates the cache entry pointed to by cacheEntryIt from the ToC memory mapped file.
      * This function assumes that tocData.segmentMutex must be taken in write mode
@@ -1055,9 +1227,28 @@ struct CacheBucket
     ShmEntryReadRetCodeEnum deserializeEntry(EntryType* entry, const CacheEntryBasePtr& processLocalEntry, U64 hash, bool hasWriteRights);
 
 
+    /**
+     * @brief Takes the tocData.segmentMutex in read mode and ensures the ToC is mapped in this process
+     * and that the mapping is still valid. If not, the read lock is released and the mutex is taken in write mode
+     * to map the ToC again: on return, either tocReadLock or tocWriteLock is set.
+     **/
     void checkToCMemorySegmentStatus(boost::shared_ptr<Sharable_ReadLock>* tocReadLock,
                                      boost::shared_ptr<Sharable_WriteLock>* tocWriteLock);
 
+    /**
+     * @brief Opens and maps the ToC memory mapped file for the first time in this process. This does nothing if
+     * it is already mapped.
+     * @param tocFileLock The tocData.segmentMutex is assumed to be taken for write-lock: this is the lock currently taken
+     **/
+    void mapToCMemoryFile(Sharable_WriteLock& tocFileLock);
+
+    /**
+     * @brief Opens the ToC memory mapped file and registers this process in the processes having a valid mapping,
+     * without reading its content. This does nothing if it is already opened.
+     * @param tocFileLock The tocData.segmentMutex is assumed to be taken for write-lock: this is the lock currently taken
+     **/
+    void openToCMemoryFile(Sharable_WriteLock& tocFileLock);
+
     /**
      * @brief Returns whether the ToC memory mapped file mapping is still valid.
      * The tocData.segmentMutex is assumed to be taken for read-lock
@@ -1261,6 +1452,28 @@ struct CacheIPCData
         // protect it from being written by multiple concurrent threads.
         ExclusiveMutex lruListMutex;
 
+        // Protects entryStateSerial
+        ExclusiveMutex entryStateMutex;
+
+        // Notified whenever an entry of the bucket is inserted, removed or abandonned, or when the tiles of
+        // an entry change state. Threads waiting for an entry computed by another thread/process wait on this
+        // condition instead of polling the bucket.
+        ConditionVariable entryStateCond;
+
+        // Incremented each time entryStateCond is notified. A waiter reads it before looking-up the entry and only waits
+        // if it did not change in between so that a notification cannot be missed.
+        U64 entryStateSerial;
+
+        PerBucketData()
+        : tocData()
+        , bucketMutex()
+        , lruListMutex()
+        , entryStateMutex()
+        , entryStateCond()
+        , entryStateSerial(0)
+        {
+
+        }
     };
 
 
@@ -1337,6 +1550,11 @@ struct CachePrivate
     // If the 8bit tile size is 128x128, then 4MiB can contain exactly 256 tiles.
     std::vector<StoragePtrType> tilesStorage;
 
+    // Holds the size of each bucket, see CacheBucket::storedSize. It is a memory mapped file next to the
+    // buckets directories if the cache is persistent, so that the size is known as soon as the cache is created.
+    // It has a fixed size and is never remapped.
+    StoragePtrType bucketsSizeFile;
+
 
 #ifdef NATRON_CACHE_INTERPROCESS_ROBUST
     // The IPC data object created in globalMemorySegment shared memory
@@ -1388,12 +1606,16 @@ struct CachePrivate
 
     bool useTileStorage;
 
+    // Process local telemetry counters. Mutable since they are updated from const functions
+    mutable CacheStatistics statistics;
+
     CachePrivate(Cache<persistent>* publicInterface, bool enableTileStorage)
     : _publicInterface(publicInterface)
     , maximumSize((std::size_t)8 * 1024 * 1024 * 1024) // 8GB max by default
     , maximumSizeMutex()
     , buckets()
     , tilesStorage()
+    , bucketsSizeFile()
 #ifdef NATRON_CACHE_INTERPROCESS_ROBUST
     , ipc(0)
 #else
@@ -1411,6 +1633,7 @@ struct CachePrivate
     , nThreadsTimedOutFailed(0)
     , nThreadsTimedOutFailedCond()
     , useTileStorage(enableTileStorage)
+    , statistics()
     {
         boost::uuids::random_generator gen;
         sessionUUID = gen();
@@ -1440,6 +1663,23 @@ struct CachePrivate
     // This function may throw a AbandonnedLockException
     void clearCacheBucket(int bucket_i);
 
+    /**
+     * @brief Record in the statistics that a lock could not be taken immediately and was obtained after
+     * waiting since startTime.
+     **/
+    void recordLockContention(const TimestampVal& startTime) const
+    {
+        double waitTime = getTimeElapsed(startTime, getTimestampInSeconds(), timerFrequency);
+        statistics.increment(CacheStatistics::eCounterContendedLocks);
+        statistics.increment(CacheStatistics::eCounterLockWaitUS, (U64)(waitTime * 1e6));
+    }
+
+    /**
+     * @brief Increments the entry state serial of the bucket and wakes up all threads waiting on its entry state condition.
+     * This function may throw a AbandonnedLockException
+     **/
+    void notifyEntryStateChanged(int bucketIndex);
+
     /**
      * @brief Ensure the cache returns to a correct state. Currently it wipes the cache.
      **/
@@ -1480,6 +1720,29 @@ struct CachePrivate
     void lookupEntryAndReleaseTiles(U64 entryHash,
                               const std::vector<TileInternalIndex>* tileIndices);
 
+    /**
+     * @brief Gives back a tile to the free tiles list of its bucket. The ToC is grown if needed.
+     * @param bucketWriteLock The write lock taken on the tile bucket
+     * @param tocReadLock/tocWriteLock Either one of these was taken on the tile bucket
+     * @returns True if the tile was added to the free tiles list
+     *
+     * This function may throw a AbandonnedLockException
+     **/
+    bool addFreeTile(int tileBucketIndex,
+                     const TileInternalIndexImpl& index,
+                     boost::shared_ptr<Sharable_WriteLock>& bucketWriteLock,
+                     boost::shared_ptr<Sharable_ReadLock>& tocReadLock,
+                     boost::shared_ptr<Sharable_WriteLock>& tocWriteLock);
+
+    /**
+     * @brief Releases one pin on each of the given tiles. A tile that was released by its entry while pinned is given back
+     * to the free tiles with its last pin.
+     * The SHM must be locked.
+     *
+     * This function may throw a AbandonnedLockException
+     **/
+    void unpinTiles(const std::vector<TileInternalIndex>& tileIndices);
+
     /**
      * @brief The internal function used to deallocate tiles.
      * @param cacheEntryBucketIndex The index of the bucket to which cacheEntry belongs to
@@ -1588,12 +1851,19 @@ template <typename LOCKPTR, bool persistent>
 void create_timed_lock_impl(const CachePrivate<persistent>* imp,  LOCKPTR& lock, typename LOCKPTR::element_type::mutex_type* mutex)
 {
     lock.reset(new typename LOCKPTR::element_type(*mutex, imp->timerFrequency));
+    if (lock->try_lock()) {
+        return;
+    }
+
+    // The lock is contended: record the time spent waiting for it
+    TimestampVal startTime = getTimestampInSeconds();
     if (!lock->timed_lock()) {
         throw AbandonnedLockException();
 #ifdef CACHE_TRACE_TIMEOUTS
         qDebug() << QThread::currentThread() << "Lock timeout, clearing cache since it is probably corrupted.";
 #endif
     }
+    imp->recordLockContention(startTime);
 }
 
 
@@ -1615,17 +1885,31 @@ void createTimedLock(const CachePrivate<persistent>* imp,  boost::shared_ptr<LOC
 
 #else
 
+template <typename LOCKPTR, bool persistent>
+void create_lock_impl(const CachePrivate<persistent>* imp,  LOCKPTR& lock, typename LOCKPTR::element_type::mutex_type* mutex)
+{
+    lock.reset(new typename LOCKPTR::element_type(*mutex, boost::try_to_lock));
+    if (lock->owns_lock()) {
+        return;
+    }
+
+    // The lock is contended: record the time spent waiting for it
+    TimestampVal startTime = getTimestampInSeconds();
+    lock->lock();
+    imp->recordLockContention(startTime);
+}
+
 template <typename LOCK, bool persistent>
-void createLock(const CachePrivate<persistent>* /*imp*/,  boost::scoped_ptr<LOCK>& lock, typename LOCK::mutex_type* mutex)
+void createLock(const CachePrivate<persistent>* imp,  boost::scoped_ptr<LOCK>& lock, typename LOCK::mutex_type* mutex)
 {
-    lock.reset(new LOCK(*mutex));
+    create_lock_impl<boost::scoped_ptr<LOCK> >(imp, lock, mutex);
 }
 
 
 template <typename LOCK, bool persistent>
-void createLock(const CachePrivate<persistent>* /*imp*/,  boost::shared_ptr<LOCK>& lock, typename LOCK::mutex_type* mutex)
+void createLock(const CachePrivate<persistent>* imp,  boost::shared_ptr<LOCK>& lock, typename LOCK::mutex_type* mutex)
 {
-    lock.reset(new LOCK(*mutex));
+    create_lock_impl<boost::shared_ptr<LOCK> >(imp, lock, mutex);
 }
 
 #endif // #ifdef NATRON_CACHE_INTERPROCESS_ROBUST
@@ -1664,6 +1948,20 @@ CacheEntryLocker<persistent>::create(const boost::shared_ptr<Cache<persistent> >
     std::size_t timeSpentWaiting = 0;
     ret->_imp->lookupAndSetStatus(&timeSpentWaiting, 0);
 
+    CacheStatistics& stats = cache->_imp->statistics;
+    stats.increment(CacheStatistics::eCounterLookups);
+    switch (ret->_imp->status) {
+        case CacheEntryLockerBase::eCacheEntryStatusCached:
+            stats.increment(CacheStatistics::eCounterHits);
+            break;
+        case CacheEntryLockerBase::eCacheEntryStatusMustCompute:
+            stats.increment(CacheStatistics::eCounterMisses);
+            break;
+        case CacheEntryLockerBase::eCacheEntryStatusComputationPending:
+            stats.increment(CacheStatistics::eCounterPendingEntries);
+            break;
+    }
+
     return ret;
 }
 
@@ -1852,6 +2150,116 @@ template <>
 void flushMemory(const ProcessLocalBufferPtr& /*storage*/, int /*flag*/, char* /*ptr*/, std::size_t /*numBytes*/) {}
 
 
+template <bool persistent>
+void
+CacheBucket<persistent>::openToCMemoryFile(Sharable_WriteLock& lock)
+{
+    // Private - the tocData.segmentMutex is assumed to be taken for write lock
+    if (tocOpened) {
+        return;
+    }
+    if (!persistent) {
+        tocOpened = true;
+        return;
+    }
+    boost::shared_ptr<Cache<persistent> > c = cache.lock();
+    CacheIPCData::SharedMemorySegmentData& tocData = c->_imp->ipc->bucketsData[bucketIndex].tocData;
+
+    // If another process is growing the file, wait until it is done before opening it.
+    // This process is not counted in nProcessWithMappingValid yet, so the resizing process does not wait for us.
+    while (!tocData.mappingValid) {
+        tocData.mappingInvalidCond.wait(lock);
+    }
+
+    std::string tocFilePath = c->_imp->getBucketAbsoluteDirPath(bucketIndex).toStdString() + "Index";
+    openStorage(tocFile, tocFilePath, (int)MemoryFile::eFileOpenModeOpenOrCreate);
+    ++tocData.nProcessWithMappingValid;
+    tocOpened = true;
+} // openToCMemoryFile
+
+template <bool persistent>
+void
+CacheBucket<persistent>::mapToCMemoryFile(Sharable_WriteLock& lock)
+{
+    // Private - the tocData.segmentMutex is assumed to be taken for write lock
+
+    // Another thread may have mapped it while we were waiting for the write lock
+    if (tocMapped) {
+        return;
+    }
+    boost::shared_ptr<Cache<persistent> > c = cache.lock();
+    TimestampVal mapStartTime = getTimestampInSeconds();
+
+    // Tile pins are only held by live processes: if no other process has the ToC opened, the pins it contains were abandonned
+    bool isFirstProcess = false;
+    if (persistent && !tocOpened) {
+        isFirstProcess = c->_imp->ipc->bucketsData[bucketIndex].tocData.nProcessWithMappingValid == 0;
+    }
+
+    openToCMemoryFile(lock);
+
+#ifdef CACHE_TRACE_FILE_MAPPING
+    qDebug() << "Mapping ToC of bucket" << bucketIndex;
+#endif
+
+    if (tocFile->size() == 0) {
+        growToCFile(lock, 0);
+    } else {
+        reOpenToCData(this, false /*create*/);
+        if (isFirstProcess) {
+            releaseAbandonnedTilePins(lock);
+        }
+    }
+    tocMapped = true;
+
+    // The stored size may be out of date if a process crashed while modifying the bucket
+    updateStoredSize();
+
+    double mapTime = getTimeElapsed(mapStartTime, getTimestampInSeconds(), c->_imp->timerFrequency);
+    c->_imp->statistics.increment(CacheStatistics::eCounterToCMappings);
+    c->_imp->statistics.increment(CacheStatistics::eCounterToCMappingUS, (U64)(mapTime * 1e6));
+} // mapToCMemoryFile
+
+template <bool persistent>
+void
+CacheBucket<persistent>::releaseAbandonnedTilePins(Sharable_WriteLock& lock)
+{
+    // Private - the tocData.segmentMutex is assumed to be taken for write lock
+    if (!ipc->tilePinCounts || ipc->nTilePins == 0) {
+        return;
+    }
+
+    // Free tiles followed by the tiles that were released while pinned
+    std::vector<TileInternalIndexImpl> tmpSet(ipc->freeTiles->begin(), ipc->freeTiles->end());
+    for (std::size_t i = 0; i < ipc->tilePinCounts->size(); ++i) {
+        boost::uint32_t& count = (*ipc->tilePinCounts)[i];
+        if (count & NATRON_CACHE_TILE_PIN_FREE_PENDING) {
+            TileInternalIndexImpl encodedIndex;
+#ifdef NATRON_CACHE_TILES_MEMORY_ALLOCATOR_CENTRALIZED
+            encodedIndex.fileIndex = i / NATRON_NUM_TILES_PER_FILE;
+            encodedIndex.tileIndex = i % NATRON_NUM_TILES_PER_FILE;
+#else
+            encodedIndex.fileIndex = i / NATRON_NUM_TILES_PER_BUCKET_FILE;
+            encodedIndex.tileIndex = i % NATRON_NUM_TILES_PER_BUCKET_FILE;
+#endif
+            tmpSet.push_back(encodedIndex);
+        }
+        count = 0;
+    }
+    ipc->nTilePins = 0;
+
+    for (int nAttempts = 0; nAttempts < 2; ++nAttempts) {
+        try {
+            ipc->freeTiles->clear();
+            ipc->freeTiles->insert(ipc->freeTiles->end(), tmpSet.begin(), tmpSet.end());
+            break;
+        } catch (const bip::bad_alloc&) {
+            // We may not have enough memory to store all indices, so grow the ToC mapping
+            growToCFile(lock, tmpSet.size() * sizeof(U64) * 2);
+        }
+    }
+} // releaseAbandonnedTilePins
+
 template <bool persistent>
 void
 CacheBucket<persistent>::remapToCMemoryFile(Sharable_WriteLock& lock, std::size_t minFreeSize)
@@ -2073,6 +2481,9 @@ CacheBucket<persistent>::readFromSharedMemoryEntryImpl(EntryType* cacheEntry,
 
         // Update the entry access timestamp
         cacheEntry->timestamp = getTimestampInSeconds();
+
+        // An entry accessed by a render of higher priority is promoted to that priority class
+        cacheEntry->priority = std::max(cacheEntry->priority, (int)processLocalEntry->getCachePriority());
     } // lruWriteLock
 
     return eShmEntryReadRetCodeOk;
@@ -2143,6 +2554,7 @@ CacheBucket<persistent>::deallocateCacheEntryImpl(typename EntriesMap::iterator
     // Decrement bucket size after releaseTilesInternal() which already decrements the size taken by tiles
     if (cacheEntryIt->second->size > 0) {
         ipc->size -= cacheEntryIt->second->size;
+        updateStoredSize();
 #ifdef CACHE_TRACE_SIZE
         qDebug()  << "Bucket -= "<< cacheEntryIt->second->size;
 #endif
@@ -2487,6 +2899,7 @@ CacheEntryLockerPrivate<persistent>::lookupAndCreate(boost::shared_ptr<Sharable_
     cacheEntry->size = entryToCSize;
 
     cacheEntry->pluginID.append(processLocalEntry->getKey()->getHolderPluginID().c_str());
+    cacheEntry->priority = (int)processLocalEntry->getCachePriority();
 
     // Lock the statusMutex: this will lock-out other threads interested in this entry.
     // This mutex is unlocked in deallocateCacheEntryImpl() or in insertInCache()
@@ -2528,7 +2941,13 @@ CacheBucket<persistent>::checkToCMemorySegmentStatus(boost::shared_ptr<Sharable_
     boost::shared_ptr<Cache<persistent> > c = cache.lock();
     createLock<Sharable_ReadLock>(c->_imp.get(), *tocReadLock, &c->_imp->ipc->bucketsData[bucketIndex].tocData.segmentMutex);
 
-    if (persistent) {
+    if (!tocMapped) {
+        // First access to this bucket in this process: map its table of content
+        tocReadLock->reset();
+        createLock<Sharable_WriteLock>(c->_imp.get(), *tocWriteLock, &c->_imp->ipc->bucketsData[bucketIndex].tocData.segmentMutex);
+
+        mapToCMemoryFile(**tocWriteLock);
+    } else if (persistent) {
         // Every time we take the lock, we must ensure the memory mapping is ok because the
         // memory mapped file might have been resized to fit more entries.
         if (!isToCFileMappingValid()) {
@@ -2741,6 +3160,7 @@ CacheEntryLockerPrivate<persistent>::insertInternal()
     // Record the memory taken by the entry in the bucket
     if (cacheEntryIt->second->size > 0) {
         bucket->ipc->size += cacheEntryIt->second->size;
+        bucket->updateStoredSize();
 #ifdef CACHE_TRACE_SIZE
         qDebug() << "Bucket += " << cacheEntryIt->second->size;
 #endif
@@ -2840,6 +3260,9 @@ CacheEntryLocker<persistent>::insertInCache()
 
             ++attempt_i;
         }
+        // Wake-up threads waiting for this entry: even if the insertion failed, the entry is no longer pending
+        _imp->cache->_imp->notifyEntryStateChanged(_imp->bucket->bucketIndex);
+
         if (!ok) {
             return;
         }
@@ -2888,30 +3311,41 @@ CacheEntryLocker<persistent>::waitForPendingEntry(std::size_t timeout)
     // memory files (hence take the memory segment mutex in write mode)
     //
     //
-    // Instead we chose a "polling" method: we lookup the entry every X ms: this has the advantage not to retain any cache mutex
-    // so the amount of time we wait is really just imparing this thead rather than the whole cache bucket.
+    // Instead we look-up the entry again each time the entry state condition of the bucket is notified: this has the advantage
+    // not to retain any cache mutex while waiting so the amount of time we wait is really just imparing this thead rather than the whole
+    // cache bucket. The condition is notified whenever an entry of the bucket is inserted, removed or abandonned.
+    // The serial is read before the look-up so that a notification happening in between is not missed.
+    // A process computing the entry may crash without notifying: we never wait more than NATRON_CACHE_ENTRY_STATE_WAIT_MAX_MS
+    // without looking-up again, which lets lookupAndSetStatus() take over entries of dead processes.
 
     std::size_t timeSpentWaitingForPendingEntryMS = 0;
-    std::size_t timeToWaitMS = 20;
+    TimestampVal startTime = getTimestampInSeconds();
+    double waitTime = 0.;
 
     do {
-        // Look up the cache and sleep if not found
+        U64 serial = _imp->cache->getEntryStateSerial(_imp->hash);
+
+        // Look up the cache and wait if still pending
         _imp->lookupAndSetStatus(&timeSpentWaitingForPendingEntryMS, timeout);
 
         if (_imp->status == eCacheEntryStatusComputationPending) {
 
-            timeSpentWaitingForPendingEntryMS += timeToWaitMS;
-            if (timeout == 0 || timeSpentWaitingForPendingEntryMS < timeout) {
-                CacheEntryLockerBase::sleep_milliseconds(timeToWaitMS);
-
-                // Increase the time to wait at the next iteration
-                timeToWaitMS *= 1.2;
-
+            std::size_t timeToWaitMS = NATRON_CACHE_ENTRY_STATE_WAIT_MAX_MS;
+            if (timeout > 0) {
+                // Wait at least 1ms so that the next look-up sees the timeout elapsed
+                timeToWaitMS = timeSpentWaitingForPendingEntryMS < timeout ? std::min(timeToWaitMS, timeout - timeSpentWaitingForPendingEntryMS) : 1;
             }
+            _imp->cache->waitForEntryStateChange(_imp->hash, serial, timeToWaitMS);
+
+            waitTime = getTimeElapsed(startTime, getTimestampInSeconds(), _imp->cache->_imp->timerFrequency);
+            timeSpentWaitingForPendingEntryMS = (std::size_t)(waitTime * 1000.);
         }
 
     } while(_imp->status == eCacheEntryStatusComputationPending);
 
+    waitTime = getTimeElapsed(startTime, getTimestampInSeconds(), _imp->cache->_imp->timerFrequency);
+    _imp->cache->_imp->statistics.increment(CacheStatistics::eCounterPendingEntriesWaitUS, (U64)(waitTime * 1e6));
+
     // Concurrency resumes!
     return _imp->status;
 } // waitForPendingEntry
@@ -2961,6 +3395,9 @@ CacheEntryLocker<persistent>::~CacheEntryLocker()
 
             _imp->bucket->deallocateCacheEntryImpl(cacheEntryIt, writeLock, tocReadLock, tocWriteLock, tilesReadLock, storage);
 
+            // Wake-up threads waiting for this entry so that one of them takes over the computation
+            _imp->cache->_imp->notifyEntryStateChanged(_imp->bucket->bucketIndex);
+
         } catch (...) {
             // Any exception caught here means the cache is corrupted
             _imp->cache->_imp->recoverFromInconsistentState(shmAccess);
@@ -3040,7 +3477,21 @@ Cache<persistent>::cleanupMappedProcessList()
             activeProcesses.insert(*it);
         }
     }
+    bool processesRemoved = activeProcesses.size() != _imp->processesData->mappedProcesses.size();
     _imp->processesData->mappedProcesses = activeProcesses;
+    mappedProcessesLock.reset();
+
+    // Entries pending in dead processes may now be taken over: wake-up threads waiting on them.
+    if (processesRemoved) {
+        try {
+            for (int bucket_i = 0; bucket_i < NATRON_CACHE_BUCKETS_COUNT; ++bucket_i) {
+                _imp->notifyEntryStateChanged(bucket_i);
+            }
+        } catch (...) {
+            // Any exception caught here means the cache is corrupted
+            _imp->recoverFromInconsistentState(shmReader);
+        }
+    }
 }
 
 template <bool persistent>
@@ -3233,45 +3684,40 @@ Cache<persistent>::initialize(const boost::shared_ptr<Cache<persistent> >& thisS
     // Each segment controls the table of content of the bucket.
     boost::scoped_ptr<SharedMemoryProcessLocalReadLocker<persistent> > shmReader(new SharedMemoryProcessLocalReadLocker<persistent>(_imp.get()));
 
-
+    // The table of content of each bucket is opened and mapped by checkToCMemorySegmentStatus
+    // the first time the bucket is accessed: each bucket file is versioned independently
+    // and mapping all of them here would make the startup time proportional to the cache size.
     for (int i = 0; i < NATRON_CACHE_BUCKETS_COUNT; ++i) {
 
         // Hold a weak pointer to the cache on the bucket
         _imp->buckets[i].cache = thisShared;
         _imp->buckets[i].bucketIndex = i;
-        
 
         _imp->buckets[i].tocFile.reset(new typename CacheBucket<persistent>::StorageType);
+    } // for each bucket
 
+    // Open the file holding the size of each bucket
+    try {
+        std::size_t bucketsSizeFileSize = NATRON_CACHE_BUCKETS_COUNT * sizeof(U64);
+        _imp->bucketsSizeFile.reset(new typename CacheBucket<persistent>::StorageType);
         if (persistent) {
-            // Get the bucket directory path. It ends with a separator.
-            QString bucketDirPath = _imp->getBucketAbsoluteDirPath(i);
-
-            std::string tocFilePath = bucketDirPath.toStdString() + "Index";
-            openStorage(_imp->buckets[i].tocFile, tocFilePath, (int)MemoryFile::eFileOpenModeOpenOrCreate);
-            
+            std::stringstream ss;
+            ss << _imp->directoryContainingCachePath << "/" << NATRON_CACHE_DIRECTORY_NAME << "/BucketsSize";
+            openStorage(_imp->bucketsSizeFile, ss.str(), (int)MemoryFile::eFileOpenModeOpenOrCreate);
         }
-        
-        
-    } // for each bucket
-
-    // Remap each bucket, this may potentially fail
-    for (int i = 0; i < NATRON_CACHE_BUCKETS_COUNT; ++i) {
-        try {
-
-            boost::scoped_ptr<Sharable_WriteLock> tocWriteLock;
-            {
-                // Take the ToC mapping mutex
-                createLock<Sharable_WriteLock>(_imp.get(), tocWriteLock, &_imp->ipc->bucketsData[i].tocData.segmentMutex);
-
-                _imp->buckets[i].remapToCMemoryFile(*tocWriteLock, 0);
-            }
-        } catch (...) {
-            // Any exception caught here means the cache is corrupted
-            _imp->recoverFromInconsistentState(shmReader);
-
+        if (_imp->bucketsSizeFile->size() != bucketsSizeFileSize) {
+            // The file was just created: sizes are updated when each bucket is mapped
+            resizeStorage(_imp->bucketsSizeFile, bucketsSizeFileSize);
+            std::memset(_imp->bucketsSizeFile->getData(), 0, bucketsSizeFileSize);
         }
-    } // for each bucket
+        U64* bucketsSize = (U64*)_imp->bucketsSizeFile->getData();
+        for (int i = 0; i < NATRON_CACHE_BUCKETS_COUNT; ++i) {
+            _imp->buckets[i].storedSize = &bucketsSize[i];
+        }
+    } catch (...) {
+        // Without the file, the size of the cache only accounts for the buckets mapped by this process
+        _imp->bucketsSizeFile.reset();
+    }
 
     if (persistent) {
 
@@ -3306,8 +3752,6 @@ Cache<persistent>::initialize(const boost::shared_ptr<Cache<persistent> >& thisS
             clear();
         }
     } // persistent
-    
-    
 
 } // initialize
 
@@ -3410,9 +3854,9 @@ CachePrivate<persistent>::createTileStorageInternal(
         boost::shared_ptr<Sharable_WriteLock> tocWriteLock;
 #endif
 
-        // Take the ToC read lock
+        // Take the ToC read lock, this maps the bucket ToC if needed
         if (!tocReadLock && !tocWriteLock) {
-            createLock<Sharable_ReadLock>(this, tocReadLock, &ipc->bucketsData[bucket_i].tocData.segmentMutex);
+            buckets[bucket_i].checkToCMemorySegmentStatus(&tocReadLock, &tocWriteLock);
         }
 
         // Take the bucket mutex
@@ -3460,17 +3904,25 @@ CachePrivate<persistent>::createTileStorageInternal(
             }
         }
 
+        // Each tile of the new file starts unpinned
+#ifdef NATRON_CACHE_TILES_MEMORY_ALLOCATOR_CENTRALIZED
+        std::size_t nTilePinCounts = (fileIndex + 1) * NATRON_NUM_TILES_PER_FILE;
+#else
+        std::size_t nTilePinCounts = (fileIndex + 1) * NATRON_NUM_TILES_PER_BUCKET_FILE;
+#endif
+
         {
 
             for (int nAttempts = 0; nAttempts < 2; ++nAttempts) {
                 try {
+                    buckets[bucket_i].ipc->tilePinCounts->resize(nTilePinCounts, 0);
                     buckets[bucket_i].ipc->freeTiles->clear();
                     buckets[bucket_i].ipc->freeTiles->insert(buckets[bucket_i].ipc->freeTiles->end(), tmpSet.begin(), tmpSet.end());
                     break;
                 } catch (const bip::bad_alloc&) {
 
                     // We may not have enough memory to store all indices, so grow the ToC mapping
-                    std::size_t tocMemNeeded = tmpSet.size() * sizeof(U64) * 2;
+                    std::size_t tocMemNeeded = tmpSet.size() * sizeof(U64) * 2 + nTilePinCounts * sizeof(boost::uint32_t) * 2;
 
                     if (!tocWriteLock) {
 
@@ -3509,11 +3961,11 @@ CachePrivate<persistent>::getFreeTileInternal(
     CacheBucket<persistent>& bucket = buckets[requestingBucketIndex];
 
     boost::scoped_ptr<Sharable_WriteLock> bucketWriteLock;
-    boost::scoped_ptr<Sharable_ReadLock> tocReadLock;
-    boost::scoped_ptr<Sharable_WriteLock> tocWriteLock;
+    boost::shared_ptr<Sharable_ReadLock> tocReadLock;
+    boost::shared_ptr<Sharable_WriteLock> tocWriteLock;
 
-    // Take the ToC read lock for the bucket
-    createLock<Sharable_ReadLock>(this, tocReadLock, &ipc->bucketsData[requestingBucketIndex].tocData.segmentMutex);
+    // Take the ToC read lock for the bucket, this maps the bucket ToC if needed
+    bucket.checkToCMemorySegmentStatus(&tocReadLock, &tocWriteLock);
 
 
     // Take the bucket mutex
@@ -3711,8 +4163,8 @@ Cache<persistent>::retrieveAndLockTiles(const CacheEntryBasePtr& entry,
             boost::shared_ptr<Sharable_ReadLock> tocReadLock;
             boost::shared_ptr<Sharable_WriteLock> tocWriteLock;
 
-            // Take the ToC read lock for the bucket
-            createLock<Sharable_ReadLock>(_imp.get(), tocReadLock, &_imp->ipc->bucketsData[0].tocData.segmentMutex);
+            // Take the ToC read lock for the bucket, this maps the bucket ToC if needed
+            _imp->buckets[0].checkToCMemorySegmentStatus(&tocReadLock, &tocWriteLock);
 
 
             // Take the bucket mutex
@@ -3795,6 +4247,7 @@ Cache<persistent>::retrieveAndLockTiles(const CacheEntryBasePtr& entry,
                 // Increment the size of the entry in the cache.
                 // Do it before releaseTilesInternal() is called because the function decrements the size of the tiles released.
                 bucket.ipc->size += nTilesToAlloc * NATRON_TILE_SIZE_BYTES;
+                bucket.updateStoredSize();
 
                 // Look-up the cache entry
                 bool gotEntry = bucket.tryCacheLookupImpl(entryHash, &found, &storage);
@@ -4151,31 +4604,17 @@ CachePrivate<persistent>::releaseTilesInternal(int cacheEntryBucketIndex,
         qDebug() << "Bucket" << (int)internalIndex.bucketIndex << "Tile freed" << (int)internalIndex.index.tileIndex  << "in file index" << (int)internalIndex.index.fileIndex << " Nb free tiles left in bucket:" << tileBucket.ipc->freeTiles->size();
 #endif
 
-        // Attempt to add the index to the list. The ToC memory file might be full, hence we may have to reallocate it.
-
-        for (int nAttempts = 0; nAttempts < 2; ++nAttempts) {
-            try {
-                tileBucket.ipc->freeTiles->push_back(internalIndex.index);
-                ++nSuccessfulDeallocation;
-                break;
-            } catch (const bip::bad_alloc&) {
-
-                // We may not have enough memory to store all indices, so grow the ToC mapping
-                std::size_t tocMemNeeded = tileBucket.ipc->freeTiles->size() * sizeof(U64) * 2;
-
-                if (!tocWriteLock) {
-
-                    // Release the bucket lock: it's only guarantee to be valid is while under the toc lock!
-                    bucketWriteLock.reset();
-                    tocReadLock.reset();
-                    createLock<Sharable_WriteLock>(this, tocWriteLock, &ipc->bucketsData[internalIndex.bucketIndex].tocData.segmentMutex);
-                }
-
-                tileBucket.growToCFile(*tocWriteLock, tocMemNeeded);
+        // A pinned tile is still being read: it is given back to the free tiles list when its last pin is released
+        volatile boost::uint32_t* pinCount = tileBucket.getTilePinCount(internalIndex.index);
+        if ( pinCount && (bip::ipcdetail::atomic_read32(pinCount) != 0) ) {
+            assert( !(bip::ipcdetail::atomic_read32(pinCount) & NATRON_CACHE_TILE_PIN_FREE_PENDING) );
+            bip::ipcdetail::atomic_write32(pinCount, bip::ipcdetail::atomic_read32(pinCount) | NATRON_CACHE_TILE_PIN_FREE_PENDING);
+            ++nSuccessfulDeallocation;
+            continue;
+        }
 
-                // Take back the bucket mutex
-                createLock<Sharable_WriteLock>(this, bucketWriteLock, &ipc->bucketsData[internalIndex.bucketIndex].bucketMutex);
-            }
+        if ( addFreeTile(getTileBucketIndex(internalIndex), internalIndex.index, bucketWriteLock, tocReadLock, tocWriteLock) ) {
+            ++nSuccessfulDeallocation;
         }
 
         if (persistent) {
@@ -4199,10 +4638,84 @@ CachePrivate<persistent>::releaseTilesInternal(int cacheEntryBucketIndex,
 #endif
     assert(buckets[cacheEntryBucketIndex].ipc->size >= nSuccessfulDeallocation * NATRON_TILE_SIZE_BYTES);
     buckets[cacheEntryBucketIndex].ipc->size -= nSuccessfulDeallocation * NATRON_TILE_SIZE_BYTES;
+    buckets[cacheEntryBucketIndex].updateStoredSize();
 
 
 } // releaseTilesInternal
 
+template <bool persistent>
+bool
+CachePrivate<persistent>::addFreeTile(int tileBucketIndex,
+                                      const TileInternalIndexImpl& index,
+                                      boost::shared_ptr<Sharable_WriteLock>& bucketWriteLock,
+                                      boost::shared_ptr<Sharable_ReadLock>& tocReadLock,
+                                      boost::shared_ptr<Sharable_WriteLock>& tocWriteLock)
+{
+    CacheBucket<persistent>& tileBucket = buckets[tileBucketIndex];
+
+    // Attempt to add the index to the list. The ToC memory file might be full, hence we may have to reallocate it.
+    for (int nAttempts = 0; nAttempts < 2; ++nAttempts) {
+        try {
+            tileBucket.ipc->freeTiles->push_back(index);
+            return true;
+        } catch (const bip::bad_alloc&) {
+
+            // We may not have enough memory to store all indices, so grow the ToC mapping
+            std::size_t tocMemNeeded = tileBucket.ipc->freeTiles->size() * sizeof(U64) * 2;
+
+            if (!tocWriteLock) {
+
+                // Release the bucket lock: it's only guarantee to be valid is while under the toc lock!
+                bucketWriteLock.reset();
+                tocReadLock.reset();
+                createLock<Sharable_WriteLock>(this, tocWriteLock, &ipc->bucketsData[tileBucketIndex].tocData.segmentMutex);
+            }
+
+            tileBucket.growToCFile(*tocWriteLock, tocMemNeeded);
+
+            // Take back the bucket mutex
+            createLock<Sharable_WriteLock>(this, bucketWriteLock, &ipc->bucketsData[tileBucketIndex].bucketMutex);
+        }
+    }
+    return false;
+} // addFreeTile
+
+template <bool persistent>
+void
+CachePrivate<persistent>::unpinTiles(const std::vector<TileInternalIndex>& tileIndices)
+{
+    // Tiles are sorted by bucket so that each bucket is locked once
+    for (std::size_t i = 0; i < tileIndices.size();) {
+        int tileBucketIndex = getTileBucketIndex(tileIndices[i]);
+        CacheBucket<persistent>& tileBucket = buckets[tileBucketIndex];
+
+        // Take the read lock on the toc file mapping
+        boost::shared_ptr<Sharable_ReadLock> tocReadLock;
+        boost::shared_ptr<Sharable_WriteLock> tocWriteLock;
+        tileBucket.checkToCMemorySegmentStatus(&tocReadLock, &tocWriteLock);
+
+        // Lock the bucket in write mode: no tile of the bucket can be pinned or released meanwhile
+        boost::shared_ptr<Sharable_WriteLock> bucketWriteLock;
+        createLock<Sharable_WriteLock>(this, bucketWriteLock, &ipc->bucketsData[tileBucketIndex].bucketMutex);
+
+        for (; i < tileIndices.size() && getTileBucketIndex(tileIndices[i]) == tileBucketIndex; ++i) {
+            volatile boost::uint32_t* pinCount = tileBucket.getTilePinCount(tileIndices[i].index);
+            if ( !pinCount || !(bip::ipcdetail::atomic_read32(pinCount) & ~NATRON_CACHE_TILE_PIN_FREE_PENDING) ) {
+                // The pin counts were reset since, see releaseAbandonnedTilePins()
+                continue;
+            }
+            bip::ipcdetail::atomic_dec32(pinCount);
+            assert(tileBucket.ipc->nTilePins > 0);
+            bip::ipcdetail::atomic_dec32(&tileBucket.ipc->nTilePins);
+            if (bip::ipcdetail::atomic_read32(pinCount) == NATRON_CACHE_TILE_PIN_FREE_PENDING) {
+                // The tile was released while pinned and this was the last pin
+                bip::ipcdetail::atomic_write32(pinCount, 0);
+                addFreeTile(tileBucketIndex, tileIndices[i].index, bucketWriteLock, tocReadLock, tocWriteLock);
+            }
+        }
+    }
+} // unpinTiles
+
 template <bool persistent>
 void
 CachePrivate<persistent>::lookupEntryAndReleaseTiles(U64 entryHash, const std::vector<TileInternalIndex>* tileIndices)
@@ -4273,6 +4786,150 @@ Cache<persistent>::releaseTiles(const CacheEntryBasePtr& entry, const std::vecto
 
 } // releaseTiles
 
+template <bool persistent>
+class CacheTilesPinImpl : public CacheTilesPinBase
+{
+public:
+
+    // Holds a reference to the cache so that it outlives the pin
+    CacheBasePtr cacheRef;
+    Cache<persistent>* cache;
+
+    // The tiles we incremented the pin count of, sorted by bucket
+    std::vector<TileInternalIndex> pinnedTiles;
+
+    CacheTilesPinImpl()
+    : CacheTilesPinBase()
+    , cacheRef()
+    , cache(0)
+    , pinnedTiles()
+    {
+
+    }
+
+    virtual ~CacheTilesPinImpl()
+    {
+        if (!cache || pinnedTiles.empty()) {
+            return;
+        }
+
+        // The SHM must be locked while we release the pins
+        boost::scoped_ptr<SharedMemoryProcessLocalReadLocker<persistent> > shmAccess(new SharedMemoryProcessLocalReadLocker<persistent>(cache->_imp.get()));
+        try {
+            cache->_imp->unpinTiles(pinnedTiles);
+        } catch (...) {
+            // Any exception caught here means the cache is corrupted
+            cache->_imp->recoverFromInconsistentState(shmAccess);
+        }
+    }
+};
+
+template <bool persistent>
+CacheTilesPinPtr
+Cache<persistent>::pinTiles(const CacheEntryBasePtr& entry,
+                            const std::vector<TileInternalIndex>& tileIndices,
+                            std::vector<void*>* tilesData)
+{
+    assert(_imp->useTileStorage);
+    assert(tilesData);
+
+    U64 entryHash = entry->getHashKey();
+    int bucketIndex = getBucketCacheBucketIndex(entryHash);
+    CacheBucket<persistent>& bucket = _imp->buckets[bucketIndex];
+
+    boost::shared_ptr<CacheTilesPinImpl<persistent> > ret(new CacheTilesPinImpl<persistent>);
+    ret->cacheRef = entry->getCache();
+    ret->cache = this;
+
+    // Pin the tiles bucket by bucket so that each bucket is locked once
+    std::vector<TileInternalIndex> sortedTiles(tileIndices);
+    std::sort(sortedTiles.begin(), sortedTiles.end(), TileInternalIndexCompareLess());
+
+    // Public function, the SHM must be locked
+    boost::scoped_ptr<SharedMemoryProcessLocalReadLocker<persistent> > shmAccess(new SharedMemoryProcessLocalReadLocker<persistent>(_imp.get()));
+    try {
+
+        // Take the tilesStorageMutex in read mode so the memory mapped tile files are not cleared while we pin
+        boost::shared_ptr<Sharable_ReadLock> tileReadLock;
+        createLock<Sharable_ReadLock>(_imp.get(), tileReadLock, &_imp->ipc->tilesStorageMutex);
+
+        ret->pinnedTiles.reserve(sortedTiles.size());
+        for (std::size_t i = 0; i < sortedTiles.size();) {
+            int tileBucketIndex = getTileBucketIndex(sortedTiles[i]);
+            CacheBucket<persistent>& tileBucket = _imp->buckets[tileBucketIndex];
+
+            // Take the read lock on the toc file mapping
+            boost::shared_ptr<Sharable_ReadLock> tocReadLock;
+            boost::shared_ptr<Sharable_WriteLock> tocWriteLock;
+            tileBucket.checkToCMemorySegmentStatus(&tocReadLock, &tocWriteLock);
+
+            // Releasing a tile requires the bucket write lock: pins may be taken concurrently in read mode
+            boost::shared_ptr<Sharable_ReadLock> bucketReadLock;
+            createLock<Sharable_ReadLock>(_imp.get(), bucketReadLock, &_imp->ipc->bucketsData[tileBucketIndex].bucketMutex);
+
+            for (; i < sortedTiles.size() && getTileBucketIndex(sortedTiles[i]) == tileBucketIndex; ++i) {
+                volatile boost::uint32_t* pinCount = tileBucket.getTilePinCount(sortedTiles[i].index);
+                if (!pinCount || (bip::ipcdetail::atomic_read32(pinCount) & NATRON_CACHE_TILE_PIN_FREE_PENDING)) {
+                    // The cache may have been cleared since, or the tile was released
+                    return CacheTilesPinPtr();
+                }
+                bip::ipcdetail::atomic_inc32(pinCount);
+                bip::ipcdetail::atomic_inc32(&tileBucket.ipc->nTilePins);
+                ret->pinnedTiles.push_back(sortedTiles[i]);
+            }
+        }
+
+        // Now that the tiles are pinned, check that they still belong to the entry: they cannot be re-allocated
+        // to another entry until the pins are released.
+        {
+            boost::shared_ptr<Sharable_ReadLock> tocReadLock;
+            boost::shared_ptr<Sharable_WriteLock> tocWriteLock;
+            bucket.checkToCMemorySegmentStatus(&tocReadLock, &tocWriteLock);
+
+            boost::shared_ptr<Sharable_ReadLock> bucketReadLock;
+            createLock<Sharable_ReadLock>(_imp.get(), bucketReadLock, &_imp->ipc->bucketsData[bucketIndex].bucketMutex);
+
+            typename CacheBucket<persistent>::EntriesMap* storage;
+            typename CacheBucket<persistent>::EntriesMap::iterator found;
+            if (!bucket.tryCacheLookupImpl(entryHash, &found, &storage)) {
+                return CacheTilesPinPtr();
+            }
+
+            // The hash may be shared by an entry of another type
+            if (found->second->uniqueID != entry->getKey()->getUniqueID()) {
+                return CacheTilesPinPtr();
+            }
+
+            std::vector<TileInternalIndex> entryTiles(found->second->tileIndices.begin(), found->second->tileIndices.end());
+            std::sort(entryTiles.begin(), entryTiles.end(), TileInternalIndexCompareLess());
+            for (std::size_t i = 0; i < sortedTiles.size(); ++i) {
+                if ( !std::binary_search(entryTiles.begin(), entryTiles.end(), sortedTiles[i], TileInternalIndexCompareLess()) ) {
+                    return CacheTilesPinPtr();
+                }
+            }
+        }
+
+        tilesData->resize(tileIndices.size());
+        for (std::size_t i = 0; i < tileIndices.size(); ++i) {
+            U32 fileIndex = tileIndices[i].index.fileIndex;
+            if (fileIndex >= _imp->tilesStorage.size()) {
+                // The cache may have been cleared since
+                return CacheTilesPinPtr();
+            }
+            char* data = _imp->tilesStorage[fileIndex]->getData();
+            (*tilesData)[i] = getTileIndexPointer(data, tileIndices[i]);
+        }
+    } catch (...) {
+        // Do not attempt to unpin from a corrupted cache
+        ret->pinnedTiles.clear();
+
+        // Any exception caught here means the cache is corrupted
+        _imp->recoverFromInconsistentState(shmAccess);
+        return CacheTilesPinPtr();
+    }
+    return ret;
+} // pinTiles
+
 template <bool persistent>
 void
 CachePrivate<persistent>::ensureSharedMemoryIntegrity()
@@ -4465,9 +5122,26 @@ template <bool persistent>
 std::size_t
 Cache<persistent>::getCurrentSize() const
 {
+    // This is called often, e.g: before each insertion to check if entries should be evicted.
+    // Read the stored size of each bucket instead of locking and mapping the ToC of each bucket.
+    // The stored size is updated under the bucket lock but the sum is only a snapshot anyway.
+    std::size_t ret = 0;
+    bool hasStoredSize = true;
+    for (int i = 0; i < NATRON_CACHE_BUCKETS_COUNT; ++i) {
+        if (!_imp->buckets[i].storedSize) {
+            hasStoredSize = false;
+            break;
+        }
+        ret += *_imp->buckets[i].storedSize;
+    }
+    if (hasStoredSize) {
+        return ret;
+    }
+
+    // The buckets size file could not be opened
     boost::scoped_ptr<SharedMemoryProcessLocalReadLocker<persistent> > shmReader(new SharedMemoryProcessLocalReadLocker<persistent>(_imp.get()));
 
-    std::size_t ret = 0;
+    ret = 0;
     for (int i = 0; i < NATRON_CACHE_BUCKETS_COUNT; ++i) {
 
         try {
@@ -4694,6 +5368,7 @@ Cache<persistent>::removeEntry(const CacheEntryBasePtr& entry)
             typename CacheBucket<persistent>::EntriesMap* storage;
             if (bucket.tryCacheLookupImpl(hash, &cacheEntryIt, &storage)) {
                 bucket.deallocateCacheEntryImpl(cacheEntryIt, writeLock, tocReadLock, tocWriteLock, tilesReadLock, storage);
+                _imp->notifyEntryStateChanged(bucketIndex);
             }
         }
     } catch (...) {
@@ -4731,16 +5406,95 @@ CachePrivate<persistent>::clearCacheBucket(int bucket_i)
     {
 
         createLock<Sharable_WriteLock>(this, tocWriteLock, &ipc->bucketsData[bucket_i].tocData.segmentMutex);
+
+        // The ToC may never have been accessed by this process: open the file but do not read it,
+        // it may be corrupted.
+        bucket.openToCMemoryFile(*tocWriteLock);
+
         // Close and re-create the memory mapped files
         std::string tocFilePath = getStoragePath(bucket.tocFile);
         clearStorage(bucket.tocFile);
         openStorage(bucket.tocFile, tocFilePath, (int)MemoryFile::eFileOpenModeOpenTruncateOrCreate);
         bucket.remapToCMemoryFile(*tocWriteLock, 0);
+        bucket.tocMapped = true;
+        bucket.updateStoredSize();
 
     }
 
+    // Pending entries were removed as well
+    notifyEntryStateChanged(bucket_i);
+
 } // clearCacheBucket
 
+template <bool persistent>
+void
+CachePrivate<persistent>::notifyEntryStateChanged(int bucketIndex)
+{
+    CacheIPCData::PerBucketData& data = ipc->bucketsData[bucketIndex];
+    boost::scoped_ptr<ExclusiveLock> lock;
+    createLock<ExclusiveLock>(this, lock, &data.entryStateMutex);
+    ++data.entryStateSerial;
+    data.entryStateCond.notify_all();
+} // notifyEntryStateChanged
+
+template <bool persistent>
+U64
+Cache<persistent>::getEntryStateSerial(U64 hash) const
+{
+    int bucketIndex = Cache::getBucketCacheBucketIndex(hash);
+
+    boost::scoped_ptr<SharedMemoryProcessLocalReadLocker<persistent> > shmReader(new SharedMemoryProcessLocalReadLocker<persistent>(_imp.get()));
+    try {
+        boost::scoped_ptr<ExclusiveLock> lock;
+        createLock<ExclusiveLock>(_imp.get(), lock, &_imp->ipc->bucketsData[bucketIndex].entryStateMutex);
+        return _imp->ipc->bucketsData[bucketIndex].entryStateSerial;
+    } catch (...) {
+        // Any exception caught here means the cache is corrupted
+        _imp->recoverFromInconsistentState(shmReader);
+    }
+    return 0;
+} // getEntryStateSerial
+
+template <bool persistent>
+void
+Cache<persistent>::notifyEntryStateChanged(U64 hash)
+{
+    int bucketIndex = Cache::getBucketCacheBucketIndex(hash);
+
+    boost::scoped_ptr<SharedMemoryProcessLocalReadLocker<persistent> > shmReader(new SharedMemoryProcessLocalReadLocker<persistent>(_imp.get()));
+    try {
+        _imp->notifyEntryStateChanged(bucketIndex);
+    } catch (...) {
+        // Any exception caught here means the cache is corrupted
+        _imp->recoverFromInconsistentState(shmReader);
+    }
+} // notifyEntryStateChanged
+
+template <bool persistent>
+bool
+Cache<persistent>::waitForEntryStateChange(U64 hash, U64 serial, std::size_t timeoutMS) const
+{
+    int bucketIndex = Cache::getBucketCacheBucketIndex(hash);
+
+    boost::scoped_ptr<SharedMemoryProcessLocalReadLocker<persistent> > shmReader(new SharedMemoryProcessLocalReadLocker<persistent>(_imp.get()));
+    try {
+        CacheIPCData::PerBucketData& data = _imp->ipc->bucketsData[bucketIndex];
+        boost::scoped_ptr<ExclusiveLock> lock;
+        createLock<ExclusiveLock>(_imp.get(), lock, &data.entryStateMutex);
+
+        // Only wait if nothing changed since the caller read the serial
+        if (data.entryStateSerial == serial) {
+            timedWaitCondition(data.entryStateCond, *lock, timeoutMS);
+        }
+        return data.entryStateSerial != serial;
+    } catch (...) {
+        // Any exception caught here means the cache is corrupted
+        _imp->recoverFromInconsistentState(shmReader);
+    }
+    // The cache was wiped: the caller must look-up again
+    return true;
+} // waitForEntryStateChange
+
 
 template <bool persistent>
 void
@@ -4759,6 +5513,31 @@ Cache<persistent>::clear()
 
         boost::scoped_ptr<Sharable_WriteLock> tileWriteLock;
         createLock<Sharable_WriteLock>(_imp.get(), tileWriteLock, &_imp->ipc->tilesStorageMutex);
+
+        // No tile can be pinned while we hold the tilesStorageMutex: wait for the pins that are alive to be released
+        // since their tile pointers are about to be invalidated. Releasing a pin does not take the tilesStorageMutex.
+        // After the timeout, the pins are assumed to be abandonned.
+        std::size_t waitedMS = 0;
+        for (int bucket_i = 0; bucket_i < NATRON_CACHE_BUCKETS_COUNT; ++bucket_i) {
+            for (;;) {
+                boost::uint32_t nTilePins;
+                {
+                    boost::shared_ptr<Sharable_ReadLock> tocReadLock;
+                    boost::shared_ptr<Sharable_WriteLock> tocWriteLock;
+                    _imp->buckets[bucket_i].checkToCMemorySegmentStatus(&tocReadLock, &tocWriteLock);
+
+                    boost::shared_ptr<Sharable_ReadLock> bucketReadLock;
+                    createLock<Sharable_ReadLock>(_imp.get(), bucketReadLock, &_imp->ipc->bucketsData[bucket_i].bucketMutex);
+                    nTilePins = bip::ipcdetail::atomic_read32(&_imp->buckets[bucket_i].ipc->nTilePins);
+                }
+                if (nTilePins == 0 || waitedMS >= NATRON_CACHE_INTERPROCESS_MUTEX_TIMEOUT_MS) {
+                    break;
+                }
+                CacheEntryLockerBase::sleep_milliseconds(1);
+                ++waitedMS;
+            }
+        }
+
         for (int bucket_i = 0; bucket_i < NATRON_CACHE_BUCKETS_COUNT; ++bucket_i) {
             _imp->clearCacheBucket(bucket_i);
         } // for each bucket
@@ -4859,10 +5638,12 @@ Cache<persistent>::evictLRUEntries(std::size_t nBytesToFree)
         boost::scoped_ptr<SharedMemoryProcessLocalReadLocker<persistent> > shmReader(new SharedMemoryProcessLocalReadLocker<persistent>(_imp.get()));
 
         // Cycle through each bucket, and establish which LRU entry of the buckets is the entry that
-        // has the oldest timestamp
+        // has the lowest priority class and then the oldest timestamp
         U64 oldestEntryHash = (U64)-1;
         bool oldestEntryTimeStampSet = false;
         TimestampVal oldestEntryTimeStamp;
+        int oldestEntryPriority = 0;
+        const TimestampVal now = getTimestampInSeconds();
 
         for (int bucket_i = 0; bucket_i < NATRON_CACHE_BUCKETS_COUNT; ++bucket_i) {
             CacheBucket<persistent> & bucket = _imp->buckets[bucket_i];
@@ -4881,36 +5662,47 @@ Cache<persistent>::evictLRUEntries(std::size_t nBytesToFree)
 
 
                 U64 hash = 0;
+                int hashPriority = 0;
+                TimestampVal hashTimeStamp;
+                typename CacheBucket<persistent>::EntriesMap::iterator cacheEntryIt;
+                typename CacheBucket<persistent>::EntriesMap* storage;
                 {
                     // Lock the LRU list
 
                     boost::scoped_ptr<ExclusiveLock> lruWriteLock;
                     createLock<ExclusiveLock>(_imp.get(), lruWriteLock, &_imp->ipc->bucketsData[bucket_i].lruListMutex);
-                    // The least recently used entry is the one at the front of the linked list
-                    if (bucket.ipc->lruListFront) {
-                        hash = bucket.ipc->lruListFront->hash;
+                    // The least recently used entry is the one at the front of the linked list.
+                    // Among the first entries of the list, pick the one with the lowest priority class: since the list
+                    // is sorted from the oldest to the most recent, the first one found is also the oldest of its class.
+                    bip::offset_ptr<LRUListNode> node = bucket.ipc->lruListFront;
+                    for (int nVisited = 0; node && nVisited < NATRON_CACHE_EVICTION_MAX_VISITED_ENTRIES; node = node->next, ++nVisited) {
+                        if (!bucket.tryCacheLookupImpl(node->hash, &cacheEntryIt, &storage)) {
+                            continue;
+                        }
+                        int entryPriority = cacheEntryIt->second->getEvictionPriority(now, _imp->timerFrequency);
+                        if (hash == 0 || entryPriority < hashPriority) {
+                            hash = node->hash;
+                            hashPriority = entryPriority;
+                            hashTimeStamp = cacheEntryIt->second->timestamp;
+                        }
+                        if (hashPriority == eCacheEntryPriorityBatch) {
+                            // Cannot find a lower priority
+                            break;
+                        }
                     }
                 }
                 if (hash == 0) {
                     continue;
                 }
 
-                typename CacheBucket<persistent>::EntriesMap::iterator cacheEntryIt;
-                typename CacheBucket<persistent>::EntriesMap* storage;
-                if (!bucket.tryCacheLookupImpl(hash, &cacheEntryIt, &storage)) {
-                    continue;
-                }
-
 
-                if (!oldestEntryTimeStampSet) {
+                if (!oldestEntryTimeStampSet ||
+                    hashPriority < oldestEntryPriority ||
+                    (hashPriority == oldestEntryPriority && hashTimeStamp < oldestEntryTimeStamp)) {
                     oldestEntryTimeStampSet = true;
-                    oldestEntryTimeStamp = cacheEntryIt->second->timestamp;
+                    oldestEntryTimeStamp = hashTimeStamp;
+                    oldestEntryPriority = hashPriority;
                     oldestEntryHash = hash;
-                } else {
-                    if (cacheEntryIt->second->timestamp < oldestEntryTimeStamp) {
-                        oldestEntryTimeStamp = cacheEntryIt->second->timestamp;
-                        oldestEntryHash = hash;
-                    }
                 }
 
 
@@ -4962,6 +5754,9 @@ Cache<persistent>::evictLRUEntries(std::size_t nBytesToFree)
             assert(curSize >= entrySize);
             curSize -= entrySize;
 
+            _imp->statistics.increment(CacheStatistics::eCounterEvictedEntries);
+            _imp->statistics.increment(CacheStatistics::eCounterEvictedBytes, entrySize + cacheEntryIt->second->tileIndices.size() * NATRON_TILE_SIZE_BYTES);
+
             bucket.deallocateCacheEntryImpl(cacheEntryIt, bucketLock, tocReadLock, tocWriteLock, tilesReadLock, storage);
         } catch (...) {
             // Any exception caught here means the cache is corrupted
@@ -5010,9 +5805,13 @@ Cache<persistent>::getMemoryStats(std::map<std::string, CacheReportInfo>* infos)
 
                     std::string pluginID(cacheEntryIt->second->pluginID.c_str());
                     CacheReportInfo& entryData = (*infos)[pluginID];
+                    std::size_t entryBytes = cacheEntryIt->second->size + cacheEntryIt->second->tileIndices.size() * NATRON_TILE_SIZE_BYTES;
                     ++entryData.nEntries;
-                    entryData.nBytes += cacheEntryIt->second->size;
-                    entryData.nBytes += cacheEntryIt->second->tileIndices.size() * NATRON_TILE_SIZE_BYTES;
+                    entryData.nBytes += entryBytes;
+
+                    int priority = std::max(0, std::min(cacheEntryIt->second->priority, NATRON_CACHE_ENTRY_PRIORITY_COUNT - 1));
+                    ++entryData.nEntriesPerPriority[priority];
+                    entryData.nBytesPerPriority[priority] += entryBytes;
                 }
                 it = it->next;
             }
@@ -5027,6 +5826,13 @@ Cache<persistent>::getMemoryStats(std::map<std::string, CacheReportInfo>* infos)
     } // for each bucket
 } // getMemoryStats
 
+template <bool persistent>
+CacheStatistics&
+Cache<persistent>::getStatistics() const
+{
+    return _imp->statistics;
+}
+
 template class Cache<true>;
 template class Cache<false>;
 
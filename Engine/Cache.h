@@ -46,6 +46,7 @@
 #endif
 
 #include "Engine/CacheEntryBase.h"
+#include "Engine/CacheStatistics.h"
 #include "Engine/ImageTilesState.h"
 #include "Engine/EngineFwd.h"
 
@@ -182,17 +183,49 @@ struct CacheReportInfo
     int nEntries;
     std::size_t nBytes;
 
+    // Same as above, but broken down by CacheEntryPriorityEnum
+    int nEntriesPerPriority[NATRON_CACHE_ENTRY_PRIORITY_COUNT];
+    std::size_t nBytesPerPriority[NATRON_CACHE_ENTRY_PRIORITY_COUNT];
+
     CacheReportInfo()
     : nEntries(0)
     , nBytes(0)
     {
-
+        for (int i = 0; i < NATRON_CACHE_ENTRY_PRIORITY_COUNT; ++i) {
+            nEntriesPerPriority[i] = 0;
+            nBytesPerPriority[i] = 0;
+        }
     }
 };
 
 template <bool persistent>
 struct CacheBucket;
 
+/**
+ * @brief A pin on tiles of a cache entry, obtained with CacheBase::pinTiles.
+ * Each pinned tile has its reference count incremented. As long as this object is alive, the pinned tiles are not
+ * re-allocated to another entry: if the entry is evicted or removed meanwhile, its pinned tiles are only given back to
+ * the cache when the last pin on them is released, and clearing the cache waits for the pins to be released.
+ * The tile pointers returned by pinTiles thus remain valid and hold the entry data.
+ * No cache lock is held by this object. The pins are released when it is destroyed.
+ **/
+class CacheTilesPinBase
+{
+public:
+
+    CacheTilesPinBase()
+    {
+
+    }
+
+    virtual ~CacheTilesPinBase()
+    {
+
+    }
+};
+
+typedef boost::shared_ptr<CacheTilesPinBase> CacheTilesPinPtr;
+
 /**
  * @brief Small RAII style class used to lock an entry corresponding to a hash key to ensure
  * only a single thread can work on it at once.
@@ -338,6 +371,9 @@ private:
 template <bool persistent>
 struct CachePrivate;
 
+template <bool persistent>
+class CacheTilesPinImpl;
+
 class CacheBase
 {
 
@@ -477,6 +513,20 @@ public:
      **/
     virtual void releaseTiles(const CacheEntryBasePtr& entry, const std::vector<TileInternalIndex>& tileIndices) = 0;
 
+    /**
+     * @brief Pins existing tiles of the given entry, see CacheTilesPinBase.
+     * Unlike retrieveAndLockTiles, the returned object does not hold any cache lock: the caller may access the tiles
+     * with multiple threads without blocking other cache operations.
+     * Pins should not be held for long since clearing the cache waits for them.
+     *
+     * @param tileIndices The indices of the tiles to pin. They must have been allocated for the entry.
+     * @param tilesData[out] In output, the pointer of each tile, in the same order as tileIndices.
+     * @returns A pin object, or NULL if the entry is no longer in the cache or no longer owns all the tiles.
+     **/
+    virtual CacheTilesPinPtr pinTiles(const CacheEntryBasePtr& entry,
+                                      const std::vector<TileInternalIndex>& tileIndices,
+                                      std::vector<void*>* tilesData) = 0;
+
     /**
      * @brief Returns whether a cache entry exists for the given hash.
      * This is significantly faster than the get() function but does not return the entry.
@@ -507,6 +557,33 @@ public:
      **/
     virtual void getMemoryStats(std::map<std::string, CacheReportInfo>* infos) const = 0;
 
+    /**
+     * @brief Returns the hit/miss, eviction and wait time counters of the cache for this process.
+     * The counters may be incremented from any thread and reset with CacheStatistics::reset().
+     **/
+    virtual CacheStatistics& getStatistics() const = 0;
+
+    /**
+     * @brief Returns the serial of the entry state condition of the bucket holding the given hash.
+     * This must be read before checking the state of an entry, and then passed to waitForEntryStateChange().
+     **/
+    virtual U64 getEntryStateSerial(U64 hash) const = 0;
+
+    /**
+     * @brief Wakes up all threads (from any process) waiting in waitForEntryStateChange() on the bucket holding the given hash.
+     * This is called by the cache itself when an entry is inserted, removed or abandonned, and should be called
+     * by entries when their state changes without going through the cache, e.g: when tiles of an image are marked rendered.
+     **/
+    virtual void notifyEntryStateChanged(U64 hash) = 0;
+
+    /**
+     * @brief Blocks until notifyEntryStateChanged() is called for the bucket holding the given hash or until timeoutMS milliseconds
+     * have elapsed. Returns immediately if the state changed since serial was obtained with getEntryStateSerial().
+     * Notifications are per bucket, hence the caller must check again the state of the entry it is interested in when returning.
+     * @returns True if the state changed, false if the wait timed out.
+     **/
+    virtual bool waitForEntryStateChange(U64 hash, U64 serial, std::size_t timeoutMS) const = 0;
+
     /**
      * @brief Scans the set of currently registered processes to check if they are still alive.
      * If a process is no longer active, it is removed from the mapped process list, potentially
@@ -566,6 +643,7 @@ class Cache
     friend struct CacheEntryLockerPrivate<persistent>;
     friend class CacheEntryLocker<persistent>;
     friend struct CacheBucket<persistent>;
+    friend class CacheTilesPinImpl<persistent>;
 
     void initialize(const boost::shared_ptr<Cache<persistent> >& thisShared);
 
@@ -613,11 +691,18 @@ public:
 #endif
     virtual void unLockTiles(void* cacheData, bool invalidate) OVERRIDE FINAL;
     virtual void releaseTiles(const CacheEntryBasePtr& entry, const std::vector<TileInternalIndex>& tileIndices) OVERRIDE FINAL;
+    virtual CacheTilesPinPtr pinTiles(const CacheEntryBasePtr& entry,
+                                      const std::vector<TileInternalIndex>& tileIndices,
+                                      std::vector<void*>* tilesData) OVERRIDE FINAL WARN_UNUSED_RETURN;
     virtual bool hasCacheEntryForHash(U64 hash) const OVERRIDE FINAL;
     virtual void evictLRUEntries(std::size_t nBytesToFree) OVERRIDE FINAL;
     virtual void clear() OVERRIDE FINAL;
     virtual void removeEntry(const CacheEntryBasePtr& entry) OVERRIDE FINAL;
     virtual void getMemoryStats(std::map<std::string, CacheReportInfo>* infos) const OVERRIDE FINAL;
+    virtual CacheStatistics& getStatistics() const OVERRIDE FINAL;
+    virtual U64 getEntryStateSerial(U64 hash) const OVERRIDE FINAL WARN_UNUSED_RETURN;
+    virtual void notifyEntryStateChanged(U64 hash) OVERRIDE FINAL;
+    virtual bool waitForEntryStateChange(U64 hash, U64 serial, std::size_t timeoutMS) const OVERRIDE FINAL;
     virtual void cleanupMappedProcessList() OVERRIDE FINAL;
     virtual boost::uuids::uuid getCurrentProcessUUID() const OVERRIDE FINAL WARN_UNUSED_RETURN;
     virtual bool isUUIDCurrentlyActive(const boost::uuids::uuid& tag) const OVERRIDE FINAL WARN_UNUSED_RETURN;
@@ -36,10 +36,12 @@ struct CacheEntryBasePrivate
 
     CacheBaseWPtr cache;
     CacheEntryKeyBasePtr key;
+    CacheEntryPriorityEnum priority;
 
     CacheEntryBasePrivate(const CacheBasePtr& cache)
     : cache(cache)
     , key()
+    , priority(eCacheEntryPriorityViewer)
     {
         
     }
@@ -88,6 +90,18 @@ CacheEntryBase::setKey(const CacheEntryKeyBasePtr& key)
     _imp->key = key;
 }
 
+void
+CacheEntryBase::setCachePriority(CacheEntryPriorityEnum priority)
+{
+    _imp->priority = priority;
+}
+
+CacheEntryPriorityEnum
+CacheEntryBase::getCachePriority() const
+{
+    return _imp->priority;
+}
+
 U64
 CacheEntryBase::getHashKey(bool forceComputation) const
 {
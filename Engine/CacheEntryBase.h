@@ -106,6 +106,14 @@ public:
      **/
     void setKey(const CacheEntryKeyBasePtr& key);
 
+    /**
+     * @brief Set the priority class of this entry. When the cache has to free memory,
+     * entries of a lower priority class are evicted first.
+     * Note that this should be done prior to inserting this entry in the cache.
+     **/
+    void setCachePriority(CacheEntryPriorityEnum priority);
+    CacheEntryPriorityEnum getCachePriority() const;
+
     /**
      * @brief Get the hash key for this entry
      **/
@@ -0,0 +1,211 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "CacheStatistics.h"
+
+#include <sstream>
+#include <cassert>
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QMutex>
+
+#include "Engine/Timer.h"
+
+// When the process local 32-bit value of a counter exceeds this, it is folded in the 64-bit total.
+#define NATRON_CACHE_STATISTICS_FOLD_THRESHOLD (1 << 29)
+
+NATRON_NAMESPACE_ENTER
+
+struct CacheStatisticsCounter
+{
+    // Recent increments, modified atomically without lock
+    QAtomicInt pending;
+
+    // Total of the increments folded so far, protected by CacheStatisticsPrivate::foldMutex
+    U64 total;
+
+    CacheStatisticsCounter()
+    : pending(0)
+    , total(0)
+    {
+
+    }
+};
+
+struct CacheStatisticsPrivate
+{
+    CacheStatisticsCounter counters[CacheStatistics::eCounterCount];
+
+    // Protects the total of all counters and resetTime
+    mutable QMutex foldMutex;
+
+    TimestampVal resetTime;
+    double frequency;
+
+    CacheStatisticsPrivate()
+    : counters()
+    , foldMutex()
+    , resetTime(getTimestampInSeconds())
+    , frequency(getPerformanceFrequency())
+    {
+
+    }
+
+    // foldMutex must be locked
+    void fold(CacheStatisticsCounter& counter)
+    {
+        int value = counter.pending.fetchAndStoreRelaxed(0);
+        counter.total += (U64)value;
+    }
+};
+
+CacheStatistics::CacheStatistics()
+: _imp(new CacheStatisticsPrivate)
+{
+
+}
+
+CacheStatistics::~CacheStatistics()
+{
+
+}
+
+void
+CacheStatistics::increment(CounterEnum counter, U64 amount)
+{
+    assert(counter >= 0 && counter < eCounterCount);
+    CacheStatisticsCounter& c = _imp->counters[counter];
+    if (amount >= NATRON_CACHE_STATISTICS_FOLD_THRESHOLD) {
+        // Too big to be accumulated in the 32-bit value
+        QMutexLocker k(&_imp->foldMutex);
+        c.total += amount;
+        return;
+    }
+    int prev = c.pending.fetchAndAddRelaxed((int)amount);
+    if (prev + (int)amount >= NATRON_CACHE_STATISTICS_FOLD_THRESHOLD) {
+        QMutexLocker k(&_imp->foldMutex);
+        _imp->fold(c);
+    }
+}
+
+U64
+CacheStatistics::getValue(CounterEnum counter) const
+{
+    assert(counter >= 0 && counter < eCounterCount);
+    QMutexLocker k(&_imp->foldMutex);
+    CacheStatisticsCounter& c = _imp->counters[counter];
+    _imp->fold(c);
+    return c.total;
+}
+
+double
+CacheStatistics::getTimeSinceReset() const
+{
+    QMutexLocker k(&_imp->foldMutex);
+    return getTimeElapsed(_imp->resetTime, getTimestampInSeconds(), _imp->frequency);
+}
+
+void
+CacheStatistics::reset()
+{
+    QMutexLocker k(&_imp->foldMutex);
+    for (int i = 0; i < eCounterCount; ++i) {
+        _imp->counters[i].pending.fetchAndStoreRelaxed(0);
+        _imp->counters[i].total = 0;
+    }
+    _imp->resetTime = getTimestampInSeconds();
+}
+
+const char*
+CacheStatistics::getCounterName(CounterEnum counter)
+{
+    switch (counter) {
+        case eCounterLookups:
+            return "lookups";
+        case eCounterHits:
+            return "hits";
+        case eCounterMisses:
+            return "misses";
+        case eCounterPendingEntries:
+            return "pendingEntries";
+        case eCounterPendingEntriesWaitUS:
+            return "pendingEntriesWaitUs";
+        case eCounterEvictedEntries:
+            return "evictedEntries";
+        case eCounterEvictedBytes:
+            return "evictedBytes";
+        case eCounterContendedLocks:
+            return "contendedLocks";
+        case eCounterLockWaitUS:
+            return "lockWaitUs";
+        case eCounterPendingTilesWaits:
+            return "pendingTilesWaits";
+        case eCounterPendingTilesWaitUS:
+            return "pendingTilesWaitUs";
+        case eCounterBytesReadFromCache:
+            return "bytesReadFromCache";
+        case eCounterBytesWrittenToCache:
+            return "bytesWrittenToCache";
+        case eCounterToCMappings:
+            return "tocMappings";
+        case eCounterToCMappingUS:
+            return "tocMappingUs";
+        case eCounterCount:
+            break;
+    }
+    return "";
+}
+
+std::string
+CacheStatistics::toJSON(const std::string& indent) const
+{
+    U64 values[eCounterCount];
+    double elapsed;
+    {
+        QMutexLocker k(&_imp->foldMutex);
+        for (int i = 0; i < eCounterCount; ++i) {
+            _imp->fold(_imp->counters[i]);
+            values[i] = _imp->counters[i].total;
+        }
+        elapsed = getTimeElapsed(_imp->resetTime, getTimestampInSeconds(), _imp->frequency);
+    }
+
+    double hitRate = values[eCounterLookups] > 0 ? (double)values[eCounterHits] / values[eCounterLookups] : 0.;
+
+    std::stringstream ss;
+    ss << "{\n";
+    ss << indent << "    \"elapsedSeconds\": " << elapsed << ",\n";
+    ss << indent << "    \"hitRate\": " << hitRate << ",\n";
+    for (int i = 0; i < eCounterCount; ++i) {
+        ss << indent << "    \"" << getCounterName((CounterEnum)i) << "\": " << values[i];
+        if (i < eCounterCount - 1) {
+            ss << ",";
+        }
+        ss << "\n";
+    }
+    ss << indent << "}";
+    return ss.str();
+} // toJSON
+
+NATRON_NAMESPACE_EXIT
@@ -0,0 +1,140 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef Engine_CacheStatistics_h
+#define Engine_CacheStatistics_h
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <string>
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/scoped_ptr.hpp>
+#endif
+
+#include "Global/GlobalDefines.h"
+#include "Engine/EngineFwd.h"
+
+NATRON_NAMESPACE_ENTER
+
+/**
+ * @brief Counters describing the efficiency of the cache over time: hit rates, evictions, time spent waiting on
+ * locks or on tiles computed by other threads and amount of data copied in and out of the cache.
+ *
+ * Counters are local to the process: when the cache is persistent and shared between processes, each process reports
+ * its own usage.
+ *
+ * Incrementing a counter is a single atomic operation on a 32-bit integer. The value is folded into a 64-bit total
+ * under a mutex only when the 32-bit value grows large or when the statistics are sampled, so that this can be called from
+ * hot paths of the cache.
+ **/
+struct CacheStatisticsPrivate;
+class CacheStatistics
+{
+public:
+
+    enum CounterEnum
+    {
+        // Number of calls to Cache::get()
+        eCounterLookups = 0,
+
+        // Number of lookups that found the entry in the cache
+        eCounterHits,
+
+        // Number of lookups that did not find the entry: the caller must compute it
+        eCounterMisses,
+
+        // Number of lookups for which the entry was being computed by another thread or process
+        eCounterPendingEntries,
+
+        // Time spent in CacheEntryLocker::waitForPendingEntry, in microseconds
+        eCounterPendingEntriesWaitUS,
+
+        // Number of entries evicted to free memory and the memory they held, in bytes
+        eCounterEvictedEntries,
+        eCounterEvictedBytes,
+
+        // Number of cache locks that could not be taken immediately, and time spent waiting on them, in microseconds
+        eCounterContendedLocks,
+        eCounterLockWaitUS,
+
+        // Number of calls to ImageCacheEntry::waitForPendingTiles that had to wait and time spent waiting, in microseconds
+        eCounterPendingTilesWaits,
+        eCounterPendingTilesWaitUS,
+
+        // Bytes copied from cached tiles to images and from images to cached tiles
+        eCounterBytesReadFromCache,
+        eCounterBytesWrittenToCache,
+
+        // Number of bucket table of contents opened and mapped by this process and time spent mapping them, in microseconds
+        eCounterToCMappings,
+        eCounterToCMappingUS,
+
+        eCounterCount
+    };
+
+    CacheStatistics();
+
+    ~CacheStatistics();
+
+    /**
+     * @brief Adds the given amount to the counter. This is thread-safe and does not take any lock in general.
+     **/
+    void increment(CounterEnum counter, U64 amount = 1);
+
+    /**
+     * @brief Returns the current value of the counter
+     **/
+    U64 getValue(CounterEnum counter) const;
+
+    /**
+     * @brief Returns the number of seconds elapsed since the statistics were created or last reset
+     **/
+    double getTimeSinceReset() const;
+
+    /**
+     * @brief Reset all counters to 0
+     **/
+    void reset();
+
+    /**
+     * @brief Returns a name suitable to identify the counter, e.g: in the JSON output
+     **/
+    static const char* getCounterName(CounterEnum counter);
+
+    /**
+     * @brief Returns all counters as a JSON object, along with the hit rate and the elapsed time
+     * since the last reset. Each line after the first is prefixed by indent, so that the object can be
+     * nested in another one.
+     **/
+    std::string toJSON(const std::string& indent = std::string()) const;
+
+private:
+
+    boost::scoped_ptr<CacheStatisticsPrivate> _imp;
+};
+
+NATRON_NAMESPACE_EXIT
+
+#endif // Engine_CacheStatistics_h
@@ -255,6 +255,7 @@ Curve::setInterpolator(const KeyFrameInterpolatorPtr& interpolator)
     }
     QMutexLocker l(&_imp->_lock);
     _imp->interpolator = interpolator;
+    _imp->invalidateSegments();
 }
 
 void
@@ -263,6 +264,7 @@ Curve::setPeriodic(bool periodic)
     QMutexLocker k(&_imp->_lock);
     _imp->isPeriodic = periodic;
     _imp->keyFrames.clear();
+    _imp->invalidateSegments();
 }
 
 bool
@@ -283,6 +285,7 @@ Curve::clearKeyFrames()
     QMutexLocker l(&_imp->_lock);
 
     _imp->keyFrames.clear();
+    _imp->invalidateSegments();
 }
 
 bool
@@ -474,6 +477,7 @@ Curve::cloneAndCheckIfChanged(const Curve& other, double offset, const RangeD* r
                 ++oit;
             }
         }
+        _imp->invalidateSegments();
     }
     if (!listeners.empty()) {
         notifyKeyFramesChanged(listeners, *oldKeys, otherKeys);
@@ -648,6 +652,7 @@ bool applyKeyFrameConflictsFlags(KeyFrame& tmp, const KeyFrame & cp, SetKeyFrame
 std::pair<KeyFrameSet::iterator, ValueChangedReturnCodeEnum> Curve::setOrUpdateKeyframeInternal(const KeyFrame & cp, SetKeyFrameFlags flags)
 {
     // PRIVATE - should not lock
+    _imp->invalidateSegments();
     if (_imp->clampKeyFramesTimeToIntegers) {
         std::pair<KeyFrameSet::iterator, bool> newKey = _imp->keyFrames.insert(cp);
         // keyframe at this time exists, erase and insert again
@@ -756,6 +761,7 @@ Curve::removeKeyFrame(KeyFrameSet::const_iterator it)
 
     KeyFrame removedKey = *it;
     _imp->keyFrames.erase(it);
+    _imp->invalidateSegments();
 
     if (mustRefreshPrev) {
         refreshDerivatives( eCurveChangedReasonDerivativesChanged, find( prevKey.getTime(), _imp->keyFrames.end()) );
@@ -1057,37 +1063,65 @@ Curve::getValueAt(TimeValue t,
     //    return (*_imp->keyFrames.begin()).getValue();
     //}
 
-    // find the first keyframe with time greater than t
-    KeyFrameSet::const_iterator itup = _imp->keyFrames.upper_bound(value);
-    value = _imp->interpolator->interpolate(t, itup, _imp->keyFrames, _imp->isPeriodic, TimeValue(_imp->xMin), TimeValue(_imp->xMax));
+    if ( _imp->interpolator->isCubicInterpolator() ) {
+        // The value only depends on the polynomial of the segment around t: use the cached one
+        _imp->ensureSegments();
+        TimeValue tInPeriod = t;
+        const CurveSegment& segment = _imp->getSegment(&tInPeriod);
 
-    double v = value.getValue();
+        // Properties don't follow an interpolation unlike the value of the keyframe, thus copy the properties from P0
+        value = segment.startKey;
+        value.setTime(tInPeriod);
+        value.setValue( Interpolation::interpolateSegment(segment.cubic, tInPeriod) );
+    } else {
+        // find the first keyframe with time greater than t
+        KeyFrameSet::const_iterator itup = _imp->keyFrames.upper_bound(value);
+        value = _imp->interpolator->interpolate(t, itup, _imp->keyFrames, _imp->isPeriodic, TimeValue(_imp->xMin), TimeValue(_imp->xMax));
+    }
 
+    value.setValue( clampAndRoundValue(value.getValue(), doClamp) );
+    return value;
+} // getValueAt
 
-    bool mustUpdateKeyFrame = false;
-    if ( doClamp ) {
-        v = clampValueToCurveYRange(v);
-        mustUpdateKeyFrame = true;
-    }
+void
+Curve::getValuesAt(const std::vector<TimeValue>& times,
+                   bool doClamp,
+                   std::vector<double>* values) const
+{
+    QMutexLocker l(&_imp->_lock);
 
-    switch (_imp->type) {
-        case eCurveTypeString:
-        case eCurveTypeInt:
-            v = std::floor(v + 0.5);
-            mustUpdateKeyFrame = true;
-            break;
-        case eCurveTypeBool:
-            v = v >= 0.5 ? 1. : 0.;
-            mustUpdateKeyFrame = true;
-            break;
-        default:
-            break;
+    values->resize( times.size() );
+    if ( _imp->keyFrames.empty() ) {
+        // A curve with no control points is considered to be 0
+        std::fill(values->begin(), values->end(), 0.);
+        return;
     }
-    if (mustUpdateKeyFrame) {
-        value.setValue(v);
+    if ( !_imp->interpolator->isCubicInterpolator() ) {
+        for (std::size_t i = 0; i < times.size(); ++i) {
+            (*values)[i] = getValueAt(times[i], doClamp).getValue();
+        }
+        return;
     }
-    return value;
-} // getValueAt
+
+    _imp->ensureSegments();
+    const std::vector<double>& keyTimes = _imp->segmentsKeyTimes;
+    std::size_t segmentIndex = 0;
+    for (std::size_t i = 0; i < times.size(); ++i) {
+        TimeValue t = times[i];
+        if (_imp->isPeriodic) {
+            t = KeyFrameInterpolator::getTimeInPeriod(TimeValue(_imp->xMin), TimeValue(_imp->xMax), _imp->keyFrames, t);
+            segmentIndex = _imp->getSegmentIndex(t);
+        } else if (i > 0 && times[i - 1] <= t) {
+            // Times are increasing: the segment is at or after the previous one
+            while (segmentIndex < keyTimes.size() && keyTimes[segmentIndex] <= t) {
+                ++segmentIndex;
+            }
+        } else {
+            segmentIndex = _imp->getSegmentIndex(t);
+        }
+        (*values)[i] = clampAndRoundValue(Interpolation::interpolateSegment(_imp->segments[segmentIndex].cubic, t), doClamp);
+    }
+} // getValuesAt
 
 double
 Curve::getDerivativeAt(TimeValue t) const
@@ -1106,41 +1140,15 @@ Curve::getDerivativeAt(TimeValue t) const
     //}
 
 
-    KeyFrame k(t, 0.);
-    // find the first keyframe with time greater than t
-    KeyFrameSet::const_iterator itup = _imp->keyFrames.upper_bound(k);
-
-    KeyFrame keyCur, keyNext;
-
-    KeyFrameInterpolator::interParams(_imp->keyFrames,
-                                      _imp->isPeriodic,
-                                      _imp->xMin,
-                                      _imp->xMax,
-                                      &t,
-                                      itup,
-                                      &keyCur, &keyNext);
-    
-
+    _imp->ensureSegments();
+    const CurveSegment& segment = _imp->getSegment(&t);
 
     double d;
 
     if ( _imp->yMin != -std::numeric_limits<double>::infinity() || _imp->yMax != std::numeric_limits<double>::infinity()) {
-        d = Interpolation::derive_clamp(keyCur.getTime(), keyCur.getValue(),
-                                        keyCur.getRightDerivative(),
-                                        keyNext.getLeftDerivative(),
-                                        keyNext.getTime(), keyNext.getValue(),
-                                        t,
-                                        _imp->yMin, _imp->yMax,
-                                        keyCur.getInterpolation(),
-                                        keyNext.getInterpolation());
+        d = Interpolation::deriveSegment_clamp(segment.cubic, t, _imp->yMin, _imp->yMax);
     } else {
-        d = Interpolation::derive(keyCur.getTime(), keyCur.getValue(),
-                                  keyCur.getRightDerivative(),
-                                  keyNext.getLeftDerivative(),
-                                  keyNext.getTime(), keyNext.getValue(),
-                                  t,
-                                  keyCur.getInterpolation(),
-                                  keyNext.getInterpolation());
+        d = Interpolation::deriveSegment(segment.cubic, t);
     }
 
     return d;
@@ -1170,80 +1178,37 @@ Curve::getIntegrateFromTo(TimeValue t1,
     //    return (*_imp->keyFrames.begin()).getValue();
     //}
 
-    KeyFrame k(t1, 0.);
-    // find the first keyframe with time strictly greater than t1
-
-    KeyFrameSet::const_iterator itup = _imp->keyFrames.upper_bound(k);
-
-    KeyFrame keyCur, keyNext;
-
-    KeyFrameInterpolator::interParams(_imp->keyFrames,
-                                      _imp->isPeriodic,
-                                      _imp->xMin,
-                                      _imp->xMax,
-                                      &t1,
-                                      itup,
-                                      &keyCur, &keyNext);
+    _imp->ensureSegments();
+    const std::vector<double>& keyTimes = _imp->segmentsKeyTimes;
 
+    // find the first keyframe with time strictly greater than t1
+    std::size_t next = _imp->getSegmentIndex(t1);
+    const CurveSegment* segment = &_imp->getSegment(&t1);
 
-    
+    const bool clamped = _imp->yMin != -std::numeric_limits<double>::infinity() || _imp->yMax != std::numeric_limits<double>::infinity();
     double sum = 0.;
 
     // while there are still keyframes after the current time, add to the total sum and advance
-    while (itup != _imp->keyFrames.end() && itup->getTime() < t2) {
-        // add integral from t1 to itup->getTime() to sum
-        if ( _imp->yMin != -std::numeric_limits<double>::infinity() || _imp->yMax != std::numeric_limits<double>::infinity()) {
-
-            sum += Interpolation::integrate_clamp(keyCur.getTime(), keyCur.getValue(),
-                                                  keyCur.getRightDerivative(),
-                                                  keyNext.getLeftDerivative(),
-                                                  keyNext.getTime(), keyNext.getValue(),
-                                                  TimeValue(t1), itup->getTime(),
-                                                  _imp->yMin, _imp->yMax,
-                                                  keyCur.getInterpolation(),
-                                                  keyNext.getInterpolation());
+    while (next < keyTimes.size() && keyTimes[next] < t2) {
+        // add integral from t1 to the next keyframe time to sum
+        TimeValue nextTime(keyTimes[next]);
+        if (clamped) {
+            sum += Interpolation::integrateSegment_clamp(segment->cubic, t1, nextTime, _imp->yMin, _imp->yMax);
         } else {
-            sum += Interpolation::integrate(keyCur.getTime(), keyCur.getValue(),
-                                            keyCur.getRightDerivative(),
-                                            keyNext.getLeftDerivative(),
-                                            keyNext.getTime(), keyNext.getValue(),
-                                            TimeValue(t1), itup->getTime(),
-                                            keyCur.getInterpolation(),
-                                            keyNext.getInterpolation());
+            sum += Interpolation::integrateSegment(segment->cubic, t1, nextTime);
         }
         // advance
-        t1 = itup->getTime();
-        ++itup;
-
-        KeyFrameInterpolator::interParams(_imp->keyFrames,
-                                          _imp->isPeriodic,
-                                          _imp->xMin,
-                                          _imp->xMax,
-                                          &t1,
-                                          itup,
-                                          &keyCur, &keyNext);
-
+        t1 = nextTime;
+        ++next;
+        segment = &_imp->getSegment(&t1);
     }
-    
-    assert( itup == _imp->keyFrames.end() || t2 <= itup->getTime() );
+
+    assert( next == keyTimes.size() || t2 <= keyTimes[next] );
     // add integral from t1 to t2 to sum
-    if ( _imp->yMin != -std::numeric_limits<double>::infinity() || _imp->yMax != std::numeric_limits<double>::infinity()) {
-        sum += Interpolation::integrate_clamp(keyCur.getTime(), keyCur.getValue(),
-                                              keyCur.getRightDerivative(),
-                                              keyNext.getLeftDerivative(),
-                                              keyNext.getTime(), keyNext.getValue(),
-                                              t1, t2,
-                                              _imp->yMin, _imp->yMax,
-                                              keyCur.getInterpolation(),
-                                              keyNext.getInterpolation());
+    if (clamped) {
+        sum += Interpolation::integrateSegment_clamp(segment->cubic, t1, t2, _imp->yMin, _imp->yMax);
     } else {
-        sum += Interpolation::integrate(keyCur.getTime(), keyCur.getValue(),
-                                        keyCur.getRightDerivative(),
-                                        keyNext.getLeftDerivative(),
-                                        keyNext.getTime(), keyNext.getValue(),
-                                        t1, t2,
-                                        keyCur.getInterpolation(),
-                                        keyNext.getInterpolation());
+        sum += Interpolation::integrateSegment(segment->cubic, t1, t2);
     }
 
     return opposite ? -sum : sum;
@@ -1276,6 +1241,27 @@ Curve::clampValueToCurveYRange(double v) const
     return v;
 }
 
+double
+Curve::clampAndRoundValue(double v,
+                          bool doClamp) const
+{
+    // PRIVATE - should not lock
+    if (doClamp) {
+        v = clampValueToCurveYRange(v);
+    }
+
+    switch (_imp->type) {
+        case eCurveTypeString:
+        case eCurveTypeInt:
+            return std::floor(v + 0.5);
+        case eCurveTypeBool:
+            return v >= 0.5 ? 1. : 0.;
+        default:
+            break;
+    }
+    return v;
+}
+
 bool
 Curve::isAnimated() const
 {
@@ -1293,6 +1279,7 @@ Curve::setXRange(double a,
 
     _imp->xMin = a;
     _imp->xMax = b;
+    _imp->invalidateSegments();
 }
 
 std::pair<double, double> Curve::getXRange() const
@@ -1330,6 +1317,7 @@ Curve::setKeyFrameValueAndTimeNoUpdate(double value,
     newKey.setTime(time);
     newKey.setValue(value);
     _imp->keyFrames.erase(k);
+    _imp->invalidateSegments();
 
     return setOrUpdateKeyframeInternal(newKey).first;
 }
@@ -1540,6 +1528,7 @@ Curve::transformKeyframesValueAndTime(const std::list<double>& times,
 
         // Now move finalSet to the member keyframes
         _imp->keyFrames.clear();
+        _imp->invalidateSegments();
         for (KeyFrameSet::const_iterator it = finalSet.begin();
              it != finalSet.end();
              ++it) {
@@ -1877,6 +1866,7 @@ Curve::refreshDerivatives(Curve::CurveChangedReasonEnum reason,
     newKey.setRightDerivative(vcurDerivRight);
 
     std::pair<KeyFrameSet::iterator, bool> newKeyIt = _imp->keyFrames.insert(newKey);
+    _imp->invalidateSegments();
 
     // keyframe at this time exists, erase and insert again
     if (!newKeyIt.second) {
@@ -2060,7 +2050,8 @@ Curve::setYRange(double yMin,
 void
 Curve::onCurveChanged()
 {
-
+    // PRIVATE - should not lock
+    _imp->invalidateSegments();
 }
 
 void
@@ -2320,6 +2311,7 @@ Curve::setKeyframesInternal(const KeyFrameSet& keys, bool refreshDerivatives)
 
     if (!refreshDerivatives) {
         _imp->keyFrames = keys;
+        _imp->invalidateSegments();
     } else {
         _imp->keyFrames.clear();
 
@@ -366,6 +366,13 @@ public:
      **/
     KeyFrame getValueAt(TimeValue t, bool clamp = true) const WARN_UNUSED_RETURN;
 
+    /**
+     * @brief Same as getValueAt() for each of the given times, but only returns the values.
+     * The curve is locked once for the whole batch and, when times are increasing, segments are found
+     * by walking forward instead of searching the keyframes for each time.
+     **/
+    void getValuesAt(const std::vector<TimeValue>& times, bool clamp, std::vector<double>* values) const;
+
     double getDerivativeAt(TimeValue t) const WARN_UNUSED_RETURN;
 
     double getIntegrateFromTo(TimeValue t1, TimeValue t2) const WARN_UNUSED_RETURN;
@@ -676,6 +683,11 @@ private:
 
     double clampValueToCurveYRange(double v) const WARN_UNUSED_RETURN;
 
+    /**
+     * @brief Applies the Y range clamping (if clamp is true) and the rounding of the curve type to an interpolated value
+     **/
+    double clampAndRoundValue(double v, bool clamp) const WARN_UNUSED_RETURN;
+
     void setKeyframesInternal(const KeyFrameSet& keys, bool refreshDerivatives);
 
     ///returns an iterator to the new keyframe in the keyframe set and
@@ -31,6 +31,9 @@
 #include <boost/shared_ptr.hpp>
 #endif
 
+#include <vector>
+#include <algorithm>
+
 #include <QtCore/QMutex>
 
 #include "Engine/Variant.h"
@@ -39,6 +42,7 @@
 #include "Engine/KnobTypes.h"
 #include "Engine/KnobFile.h"
 #include "Engine/KeyFrameInterpolator.h"
+#include "Engine/Interpolation.h"
 
 
 #include "Engine/EngineFwd.h"
@@ -49,6 +53,16 @@ NATRON_NAMESPACE_ENTER
 
 
 
+/**
+ * @brief The cubic polynomial of the curve in-between two keyframes along with the keyframe whose
+ * properties are returned by getValueAt() within that range.
+ **/
+struct CurveSegment
+{
+    Interpolation::CubicSegment cubic;
+    KeyFrame startKey;
+};
+
 struct CurvePrivate
 {
     KeyFrameSet keyFrames;
@@ -64,6 +78,13 @@ struct CurvePrivate
     bool isPeriodic;
     bool clampKeyFramesTimeToIntegers;
 
+    // Cache of the polynomial of each segment, computed lazily under _lock by ensureSegments():
+    // segments[i] covers [segmentsKeyTimes[i-1], segmentsKeyTimes[i]), segments[0] is before the first
+    // keyframe and segments[n] after the last one.
+    mutable std::vector<double> segmentsKeyTimes;
+    mutable std::vector<CurveSegment> segments;
+    mutable bool segmentsValid;
+
     CurvePrivate()
     : keyFrames()
     , interpolator(new KeyFrameInterpolator)
@@ -78,6 +99,9 @@ struct CurvePrivate
     , _lock(QMutex::Recursive)
     , isPeriodic(false)
     , clampKeyFramesTimeToIntegers(true)
+    , segmentsKeyTimes()
+    , segments()
+    , segmentsValid(false)
     {
     }
 
@@ -101,10 +125,72 @@ struct CurvePrivate
         displayMax = other.displayMax;
         isPeriodic = other.isPeriodic;
         clampKeyFramesTimeToIntegers = other.clampKeyFramesTimeToIntegers;
+        invalidateSegments();
     }
 
+    /**
+     * @brief Must be called under _lock whenever the keyframes or a property affecting the interpolation change
+     **/
+    void invalidateSegments()
+    {
+        segmentsValid = false;
+    }
 
-    
+    /**
+     * @brief Computes the polynomial of each segment if needed. Must be called under _lock with at least 1 keyframe.
+     **/
+    void ensureSegments() const
+    {
+        if (segmentsValid) {
+            return;
+        }
+        assert(!keyFrames.empty());
+        segmentsKeyTimes.resize(keyFrames.size());
+        segments.resize(keyFrames.size() + 1);
+
+        std::size_t i = 0;
+        KeyFrameSet::const_iterator itup = keyFrames.begin();
+        for (;;) {
+            KeyFrame kNext;
+            CurveSegment& seg = segments[i];
+            KeyFrameInterpolator::getSegmentKeyFrames(keyFrames, isPeriodic, xMin, xMax, itup, &seg.startKey, &kNext);
+            Interpolation::computeSegment(seg.startKey.getTime(), seg.startKey.getValue(),
+                                          seg.startKey.getRightDerivative(),
+                                          kNext.getLeftDerivative(),
+                                          kNext.getTime(), kNext.getValue(),
+                                          seg.startKey.getInterpolation(),
+                                          kNext.getInterpolation(),
+                                          &seg.cubic);
+            if ( itup == keyFrames.end() ) {
+                break;
+            }
+            segmentsKeyTimes[i] = itup->getTime();
+            ++itup;
+            ++i;
+        }
+        segmentsValid = true;
+    }
+
+    /**
+     * @brief Returns the index of the segment containing t, that is the index of the first keyframe with time > t
+     **/
+    std::size_t getSegmentIndex(double t) const
+    {
+        return std::upper_bound(segmentsKeyTimes.begin(), segmentsKeyTimes.end(), t) - segmentsKeyTimes.begin();
+    }
+
+    /**
+     * @brief Returns the segment containing t. For a periodic curve, t is brought back in the periodic range.
+     * Must be called under _lock after ensureSegments().
+     **/
+    const CurveSegment& getSegment(TimeValue* t) const
+    {
+        assert(segmentsValid);
+        if (isPeriodic) {
+            *t = KeyFrameInterpolator::getTimeInPeriod(TimeValue(xMin), TimeValue(xMax), keyFrames, *t);
+        }
+        return segments[getSegmentIndex(*t)];
+    }
 };
 
 NATRON_NAMESPACE_EXIT
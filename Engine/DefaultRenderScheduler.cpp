@@ -176,6 +176,7 @@ DefaultScheduler::createFrameRenderResults(TimeValue time, const std::vector<Vie
             args->stats = stats;
             args->draftMode = false;
             args->playback = true;
+            args->cachePriority = eCacheEntryPriorityBatch;
             args->byPassCache = false;
 
             subResults->render = TreeRender::create(args);
@@ -122,7 +122,9 @@ DiskCacheNode::~DiskCacheNode()
 
 bool
 DiskCacheNode::shouldCacheOutput(bool /*isFrameVaryingOrAnimated*/,
-                                 int /*visitsCount*/) const
+                                 int /*visitsCount*/,
+                                 const RectI& /*renderWindow*/,
+                                 std::size_t /*outputBytes*/) const
 {
     // The disk cache node always caches.
     return true;
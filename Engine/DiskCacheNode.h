@@ -87,7 +87,7 @@ private:
                              ValueChangedReasonEnum reason,
                              ViewSetSpec view,
                              TimeValue time) OVERRIDE FINAL;
-    virtual bool shouldCacheOutput(bool isFrameVaryingOrAnimated, int visitsCount) const OVERRIDE FINAL WARN_UNUSED_RETURN;
+    virtual bool shouldCacheOutput(bool isFrameVaryingOrAnimated, int visitsCount, const RectI& renderWindow, std::size_t outputBytes) const OVERRIDE FINAL WARN_UNUSED_RETURN;
     boost::scoped_ptr<DiskCacheNodePrivate> _imp;
 };
 
@@ -53,6 +53,7 @@ EffectDescription::initializeProperties() const
     createProperty<bool>(kEffectPropSupportsCanReturnDistortion, false);
     createProperty<bool>(kEffectPropSupportsCanReturn3x3Transform, false);
     createProperty<bool>(kEffectPropSupportsAlphaFillWith1, true);
+    createProperty<bool>(kEffectPropPixelLocal, false);
 }
 
 NATRON_NAMESPACE_EXIT
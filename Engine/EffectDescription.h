@@ -98,6 +98,13 @@ NATRON_NAMESPACE_ENTER
  **/
 #define kEffectPropImageBufferLayout "EffectPropImageBufferLayout"
 
+/**
+ * @brief x1 bool property (optional) indicating whether the plug-in is pixel-local: each pixel of the output only depends on
+ * the pixel at the same location in its inputs. The inputs of such an effect may be streamed render window by render window.
+ * Default value - false
+ **/
+#define kEffectPropPixelLocal "EffectPropPixelLocal"
+
 
 
 class EffectDescription : public PropertiesHolder
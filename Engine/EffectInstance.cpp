@@ -45,6 +45,7 @@ GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 
 #include <QtCore/QReadWriteLock>
 #include <QtCore/QCoreApplication>
+#include <QtCore/QDateTime>
 #include <QtConcurrentMap> // QtCore on Qt4, QtConcurrent on Qt5
 #include <QtConcurrentRun> // QtCore on Qt4, QtConcurrent on Qt5
 
@@ -462,68 +463,38 @@ EffectInstance::refreshMetadaWarnings(const NodeMetadata &metadata)
 
 bool
 EffectInstance::shouldCacheOutput(bool isFrameVaryingOrAnimated,
-                                  int visitsCount) const
+                                  int visitsCount,
+                                  const RectI& renderWindow,
+                                  std::size_t outputBytes) const
 {
-    if (visitsCount > 1) {
-        // The node is referenced multiple times by getFramesNeeded of downstream nodes, cache it
-        return true;
-    }
-
-    NodePtr node = getNode();
-
-    OutputNodesMap outputs;
-    node->getOutputs(outputs);
-    for (OutputNodesMap::const_iterator it = outputs.begin(); it != outputs.end(); ++it) {
-        if (it->first->isSettingsPanelVisible()) {
-            // An output node has its settings panel opened, meaning the user is likely to be heavily editing
-            // that node, hence requesting this node's image a lot. Cache it.
-            return true;
-        }
-    }
-
-    if (!isFrameVaryingOrAnimated) {
-        // This image never changes, cache it once.
-        return true;
-    }
-
-    if ( isTemporalImageAccessEnabled() ) {
-        // Very heavy to compute since many frames are fetched upstream. Cache it.
-        return true;
-    }
-   
-    if ( isForceCachingEnabled() ) {
-        // Users wants it cached
-        return true;
-    }
-
-    NodeGroupPtr parentIsGroup = toNodeGroup( node->getGroup() );
-    if ( parentIsGroup && parentIsGroup->isForceCachingEnabled() && (parentIsGroup->getOutputNodeInput() == node) ) {
-        // If the parent node is a group and it has its force caching enabled, cache the output of the Group Output's node input.
-        return true;
-    }
-
-    if ( appPTR->isAggressiveCachingEnabled() ) {
-        ///Users wants all nodes cached
-        return true;
-    }
-
-    if ( node->isPreviewEnabled() && !appPTR->isBackground() ) {
-        // The node has a preview, meaning the image will be computed several times between previews & actual renders. Cache it.
-        return true;
-    }
+    const char* reason = "";
+    bool ret = _imp->computeCachingDecision(isFrameVaryingOrAnimated, visitsCount, renderWindow, outputBytes, &reason);
 
-    if ( isDuringPaintStrokeCreation() ) {
-        // When painting we must always cache
-        return true;
+    SettingsPtr settings = appPTR->getCurrentSettings();
+    if ( !settings || !settings->isPerformanceLoggingEnabled() ) {
+        return ret;
     }
 
-    RotoDrawableItemPtr attachedStroke = getAttachedRotoItem();
-    if ( attachedStroke && attachedStroke->getModel()->getNode()->isSettingsPanelVisible() ) {
-        // Internal RotoPaint tree and the Roto node has its settings panel opened, cache it.
-        return true;
+    // Log only when the decision changes, otherwise this would be printed for every render
+    QString message;
+    {
+        CachingCostModel& model = _imp->common->cachingCostModel;
+        QMutexLocker k(&model.lock);
+        if ( (model.lastDecision == (int)ret) && (model.lastReason == reason) ) {
+            return ret;
+        }
+        model.lastDecision = (int)ret;
+        model.lastReason = reason;
+        message = tr("%1: %2 (time per pixel: %3 s, reuse ratio: %4, size: %5)")
+                  .arg( ret ? tr("Caches its output") : tr("Does not cache its output") )
+                  .arg( QString::fromUtf8(reason) )
+                  .arg(model.timePerPixel)
+                  .arg(model.reuseRatio)
+                  .arg( printAsRAM(outputBytes) );
     }
+    appPTR->writeToErrorLog_mt_safe(QString::fromUtf8( getScriptName_mt_safe().c_str() ), QDateTime::currentDateTime(), message);
 
-    return false;
+    return ret;
 } // shouldCacheOutput
 
 const std::string &
@@ -842,7 +813,10 @@ EffectInstance::getImagePlane(const GetImageInArgs& inArgs, GetImageOutArgs* out
     FrameViewRequestPtr outputRequest;
     {
         ActionRetCodeEnum status;
-        if (currentRender) {
+
+        // A streamed input was not rendered upfront: render it in a separate render for this render window only
+        const bool isStreamedInput = currentRender && _imp->isInputStreamed(inArgs.inputNb);
+        if (currentRender && !isStreamedInput) {
 
             AcceptedRequestConcatenationFlags concatFlags = _imp->getConcatenationFlagsForInput(inArgs.inputNb);
 
@@ -852,12 +826,12 @@ EffectInstance::getImagePlane(const GetImageInArgs& inArgs, GetImageOutArgs* out
             outputRequest = subLaunchData->getOutputRequest();
             status = subLaunchData->getStatus();
         } else {
-            // We are not during a render, create one.
+            // We are not during a render or the input is streamed, create one.
             TreeRender::CtorArgsPtr rargs(new TreeRender::CtorArgs());
             rargs->provider = getThisTreeRenderQueueProviderShared();
             rargs->time = inputTime;
             rargs->view = inputView;
-            rargs->treeRootEffect = inputEffect;
+            rargs->treeRootEffect = isStreamedInput ? getInputMainInstance(inArgs.inputNb) : inputEffect;
             rargs->canonicalRoI = roiCanonical;
             rargs->proxyScale = inputProxyScale;
             rargs->mipMapLevel = inputMipMapLevel;
@@ -866,7 +840,14 @@ EffectInstance::getImagePlane(const GetImageInArgs& inArgs, GetImageOutArgs* out
             }
             rargs->draftMode = isDraftMode;
             rargs->playback = isPlayback;
+            if (currentRender) {
+                rargs->cachePriority = currentRender->getCachePriority();
+            }
             rargs->byPassCache = false;
+            rargs->streamedRender = isStreamedInput;
+            if (isStreamedInput) {
+                rargs->parentRender = currentRender;
+            }
             TreeRenderPtr renderObject = TreeRender::create(rargs);
             if (!currentRender) {
                 currentRender = renderObject;
@@ -2199,6 +2180,23 @@ EffectInstance::supportsTiles() const
     return _imp->descriptionPtr->getPropertyUnsafe<bool>(kEffectPropSupportsTiles);
 }
 
+void
+EffectInstance::setPixelLocal(bool pixelLocal)
+{
+    QMutexLocker k(&_imp->common->pluginsPropMutex);
+    _imp->descriptionPtr->setProperty(kEffectPropPixelLocal, pixelLocal);
+    if (!getMainInstance()) {
+        onPropertiesChanged(*_imp->descriptionPtr);
+    }
+}
+
+bool
+EffectInstance::isPixelLocal() const
+{
+    // Don't need to lock, since the render instance has a local copy of the properties
+    return _imp->descriptionPtr->getPropertyUnsafe<bool>(kEffectPropPixelLocal);
+}
+
 ImageBufferLayoutEnum
 EffectInstance::getPreferredBufferLayout() const
 {
@@ -1276,6 +1276,12 @@ public:
     bool supportsTiles() const;
     void setSupportsTiles(bool supports);
 
+    /**
+     * @brief Is this effect pixel-local ? See kEffectPropPixelLocal
+     **/
+    bool isPixelLocal() const;
+    void setPixelLocal(bool pixelLocal);
+
 
     /**
      * @brief When true the plug-in may have actions called with an abitrary render scale.
@@ -1433,8 +1439,14 @@ public:
 public:
 
 
-
-    virtual bool shouldCacheOutput(bool isFrameVaryingOrAnimated, int visitsCount) const;
+    /**
+     * @brief Returns whether the image rendered in renderWindow, weighing outputBytes, should be kept in the cache.
+     * The per-node caching policy is honored first, then images that are known to be requested again are cached.
+     * Otherwise the decision is taken from the render time per pixel measured on this node, the observed reuse of
+     * its output images and the pressure on the cache: an image is cached if the time it would save per MB of cache
+     * is high enough.
+     **/
+    virtual bool shouldCacheOutput(bool isFrameVaryingOrAnimated, int visitsCount, const RectI& renderWindow, std::size_t outputBytes) const;
 
 
     /**
@@ -1753,6 +1765,16 @@ public:
 
     void setForceCachingEnabled(bool b);
 
+    NodeCachingPolicyEnum getCachingPolicy() const;
+
+    void setCachingPolicy(NodeCachingPolicyEnum policy);
+
+    /**
+     * @brief Converts the value of the legacy forceCaching parameter, loaded from an older project,
+     * to the caching policy.
+     **/
+    void loadLegacyForceCaching();
+
     bool isKeepInAnimationModuleButtonDown() const;
 
     bool getHideInputsKnobValue() const;
@@ -309,11 +309,38 @@ EffectInstance::createNodePage(const KnobPagePtr& settingsPage)
         param->setIsPersistent(true);
         param->setEvaluateOnChange(false);
         param->setHintToolTip( tr("When checked, the output of this node will always be kept in the RAM cache for fast access of already computed images.") );
+        // Superseded by the cachingPolicy parameter, kept to load older projects: see loadLegacyForceCaching()
+        param->setSecret(true);
         settingsPage->addKnob(param);
 
         _imp->defKnobs->forceCaching = param;
     }
 
+    {
+        KnobChoicePtr param = createKnob<KnobChoice>("cachingPolicy");
+        param->setLabel(tr("Caching"));
+        param->setKnobDeclarationType(KnobI::eKnobDeclarationTypeHost);
+        param->setAnimationEnabled(false);
+        param->setAddNewLine(false);
+        param->setIsPersistent(true);
+        param->setEvaluateOnChange(false);
+        {
+            std::vector<ChoiceOption> entries;
+            assert(entries.size() == eNodeCachingPolicyAutomatic);
+            entries.push_back(ChoiceOption("Automatic", "", tr("The output of this node is kept in the RAM cache when the render time it saves is worth the memory it uses. This is estimated from the render time of this node, how often the same images are requested and how full the cache is.").toStdString()));
+            assert(entries.size() == eNodeCachingPolicyAlways);
+            entries.push_back(ChoiceOption("Always", "", tr("The output of this node is always kept in the RAM cache for fast access of already computed images.").toStdString()));
+            assert(entries.size() == eNodeCachingPolicyNever);
+            entries.push_back(ChoiceOption("Never", "", tr("The output of this node is never kept in the RAM cache, e.g: because it is cheap to compute.").toStdString()));
+            param->populateChoices(entries);
+        }
+        param->setDefaultValue(eNodeCachingPolicyAutomatic);
+        param->setHintToolTip( tr("Controls whether the output of this node is kept in the RAM cache for fast access of already computed images.") );
+        settingsPage->addKnob(param);
+
+        _imp->defKnobs->cachingPolicy = param;
+    }
+
     {
         KnobBoolPtr param = createKnob<KnobBool>(kEnablePreviewKnobName);
         param->setLabel(tr("Preview"));
@@ -971,18 +998,43 @@ EffectInstance::setHideInputsKnobValue(bool hidden)
 bool
 EffectInstance::isForceCachingEnabled() const
 {
-    KnobBoolPtr b = _imp->defKnobs->forceCaching.lock();
-    return b ? b->getValue() : false;
+    return getCachingPolicy() == eNodeCachingPolicyAlways;
 }
 
 void
 EffectInstance::setForceCachingEnabled(bool value)
+{
+    setCachingPolicy(value ? eNodeCachingPolicyAlways : eNodeCachingPolicyAutomatic);
+}
+
+NodeCachingPolicyEnum
+EffectInstance::getCachingPolicy() const
+{
+    KnobChoicePtr k = _imp->defKnobs->cachingPolicy.lock();
+    return k ? (NodeCachingPolicyEnum)k->getValue() : eNodeCachingPolicyAutomatic;
+}
+
+void
+EffectInstance::setCachingPolicy(NodeCachingPolicyEnum policy)
+{
+    KnobChoicePtr k = _imp->defKnobs->cachingPolicy.lock();
+    if (k) {
+        k->setValue((int)policy);
+    }
+}
+
+void
+EffectInstance::loadLegacyForceCaching()
 {
     KnobBoolPtr b = _imp->defKnobs->forceCaching.lock();
-    if (!b) {
+    if ( !b || !b->getValue() ) {
         return;
     }
-    b->setValue(value);
+    setCachingPolicy(eNodeCachingPolicyAlways);
+
+    // Reset the legacy parameter so that it is not converted again when the project is re-opened
+    // after the policy was changed
+    b->setValue(false);
 }
 
 KnobStringPtr
@@ -27,9 +27,14 @@
 #include <cassert>
 #include <stdexcept>
 #include <bitset>
+#include <algorithm> // max
 #include <QDebug>
 
 #include "Engine/AppInstance.h"
+#include "Engine/AppManager.h"
+#include "Engine/CacheEntryBase.h"
+#include "Engine/Hash64.h"
+#include "Engine/KnobItemsTable.h"
 #include "Engine/Node.h"
 #include "Engine/NodeGroup.h"
 #include "Engine/OSGLContext.h"
@@ -40,11 +45,29 @@
 #include "Engine/Project.h"
 #include "Engine/TreeRender.h"
 #include "Engine/RenderStats.h"
+#include "Engine/RotoPaint.h"
 #include "Engine/RotoStrokeItem.h"
 #include "Engine/ViewIdx.h"
 
 #define kNatronPersistentWarningCheckForNan "NatronPersistentWarningCheckForNan"
 
+// Weight of a new measurement in the moving averages of the caching cost model
+#define NATRON_CACHING_COST_MODEL_EMA_FACTOR 0.2
+
+// Number of recently requested images remembered to detect reuse
+#define NATRON_CACHING_COST_MODEL_HISTORY_SIZE 32
+
+// Expected reuse added when a downstream node has its settings panel opened: the user is likely
+// to be editing that node, hence requesting this node's image a lot
+#define NATRON_CACHING_COST_MODEL_PANEL_OPENED_REUSE 1.
+
+// Minimum render time that caching an image must save per MB of cache used, in seconds, when the cache is empty.
+// This is divided by the fraction of the cache that is free, so that less images are cached as the cache fills up.
+#define NATRON_CACHING_COST_MODEL_MIN_SECONDS_SAVED_PER_MB 0.002
+
+// Lower bound of the free fraction of the cache used to scale NATRON_CACHING_COST_MODEL_MIN_SECONDS_SAVED_PER_MB
+#define NATRON_CACHING_COST_MODEL_MIN_FREE_FRACTION 0.05
+
 NATRON_NAMESPACE_ENTER
 
 
@@ -204,8 +227,174 @@ EffectInstance::Implementation::resolveRenderBackend(const TreeRenderExecutionDa
     return eActionStatusOK;
 } // resolveRenderBackend
 
+void
+EffectInstance::Implementation::recordRenderCost(double timeSeconds, U64 nPixels)
+{
+    if (nPixels == 0 || timeSeconds <= 0) {
+        return;
+    }
+    double timePerPixel = timeSeconds / nPixels;
+
+    CachingCostModel& model = common->cachingCostModel;
+    QMutexLocker k(&model.lock);
+    if (model.timePerPixel == 0) {
+        model.timePerPixel = timePerPixel;
+    } else {
+        model.timePerPixel += NATRON_CACHING_COST_MODEL_EMA_FACTOR * (timePerPixel - model.timePerPixel);
+    }
+}
+
+void
+EffectInstance::Implementation::recordOutputRequest(U64 imageID)
+{
+    CachingCostModel& model = common->cachingCostModel;
+    QMutexLocker k(&model.lock);
+
+    bool reused = false;
+    for (std::list<U64>::iterator it = model.recentRequests.begin(); it != model.recentRequests.end(); ++it) {
+        if (*it == imageID) {
+            model.recentRequests.erase(it);
+            reused = true;
+            break;
+        }
+    }
+    model.recentRequests.push_front(imageID);
+    if (model.recentRequests.size() > NATRON_CACHING_COST_MODEL_HISTORY_SIZE) {
+        model.recentRequests.pop_back();
+    }
+
+    model.reuseRatio += NATRON_CACHING_COST_MODEL_EMA_FACTOR * ((reused ? 1. : 0.) - model.reuseRatio);
+}
+
+bool
+EffectInstance::Implementation::computeCachingDecision(bool isFrameVaryingOrAnimated,
+                                                       int visitsCount,
+                                                       const RectI& renderWindow,
+                                                       std::size_t outputBytes,
+                                                       const char** reason) const
+{
+    if ( _publicInterface->isDuringPaintStrokeCreation() ) {
+        // When painting we must always cache
+        *reason = "painting";
+        return true;
+    }
+
+    NodeCachingPolicyEnum policy = _publicInterface->getCachingPolicy();
+    if (policy == eNodeCachingPolicyNever) {
+        *reason = "caching policy set to never";
+        return false;
+    }
+
+    if (policy == eNodeCachingPolicyAlways) {
+        // Users wants it cached
+        *reason = "caching policy set to always";
+        return true;
+    }
+
+    if (visitsCount > 1) {
+        // The node is referenced multiple times by getFramesNeeded of downstream nodes, cache it
+        *reason = "image requested multiple times by the render";
+        return true;
+    }
+
+    if (!isFrameVaryingOrAnimated) {
+        // This image never changes, cache it once.
+        *reason = "image does not vary over time";
+        return true;
+    }
+
+    if ( _publicInterface->isTemporalImageAccessEnabled() ) {
+        // Very heavy to compute since many frames are fetched upstream. Cache it.
+        *reason = "temporal image access";
+        return true;
+    }
+
+    NodePtr node = _publicInterface->getNode();
+    NodeGroupPtr parentIsGroup = toNodeGroup( node->getGroup() );
+    if ( parentIsGroup && parentIsGroup->isForceCachingEnabled() && (parentIsGroup->getOutputNodeInput() == node) ) {
+        // If the parent node is a group and it has its force caching enabled, cache the output of the Group Output's node input.
+        *reason = "output of a group with caching policy set to always";
+        return true;
+    }
+
+    if ( appPTR->isAggressiveCachingEnabled() ) {
+        ///Users wants all nodes cached
+        *reason = "aggressive caching enabled";
+        return true;
+    }
+
+    if ( node->isPreviewEnabled() && !appPTR->isBackground() ) {
+        // The node has a preview, meaning the image will be computed several times between previews & actual renders. Cache it.
+        *reason = "preview enabled";
+        return true;
+    }
+
+    RotoPaintPtr parentIsRotoPaint = toRotoPaint(parentIsGroup);
+    if ( parentIsRotoPaint && parentIsRotoPaint->isCompositingCheckpoint(node) ) {
+        // This node composites a block of items on top of the ones below: when an item changes, the stack is composited again from
+        // the nearest checkpoint below it.
+        *reason = "rotopaint compositing checkpoint";
+        return true;
+    }
+
+    RotoDrawableItemPtr attachedStroke = _publicInterface->getAttachedRotoItem();
+    if ( attachedStroke && attachedStroke->getModel()->getNode()->isSettingsPanelVisible() ) {
+        // Internal RotoPaint tree and the Roto node has its settings panel opened, cache it.
+        // The merge node of an item outputs the whole stack below it: caching it for every item would hold a full image
+        // per item, instead only checkpoints are cached.
+        if (attachedStroke->getMergeNode() != node) {
+            *reason = "roto settings panel opened";
+            return true;
+        }
+    }
+
+    bool outputPanelOpened = false;
+    {
+        OutputNodesMap outputs;
+        node->getOutputs(outputs);
+        for (OutputNodesMap::const_iterator it = outputs.begin(); it != outputs.end(); ++it) {
+            if (it->first->isSettingsPanelVisible()) {
+                outputPanelOpened = true;
+                break;
+            }
+        }
+    }
+
+    double timePerPixel, reuseRatio;
+    {
+        const CachingCostModel& model = common->cachingCostModel;
+        QMutexLocker k(&model.lock);
+        timePerPixel = model.timePerPixel;
+        reuseRatio = model.reuseRatio;
+    }
+
+    if (timePerPixel == 0 || outputBytes == 0) {
+        // Nothing measured yet: only cache if a downstream node is being edited
+        *reason = outputPanelOpened ? "downstream settings panel opened" : "no render cost measured yet";
+        return outputPanelOpened;
+    }
+
+    // The render time we expect to save by caching the image
+    double expectedReuse = reuseRatio;
+    if (outputPanelOpened) {
+        expectedReuse += NATRON_CACHING_COST_MODEL_PANEL_OPENED_REUSE;
+    }
+    double timeSaved = timePerPixel * (double)renderWindow.area() * expectedReuse;
+
+    // The time that must be saved to be worth the cache memory, higher when the cache is full
+    double freeFraction = std::max(NATRON_CACHING_COST_MODEL_MIN_FREE_FRACTION, 1. - appPTR->getTileCachePressure());
+    double minTimeSaved = NATRON_CACHING_COST_MODEL_MIN_SECONDS_SAVED_PER_MB * ((double)outputBytes / (1024. * 1024.)) / freeFraction;
+
+    if (timeSaved >= minTimeSaved) {
+        *reason = "render time saved is worth the cache memory";
+        return true;
+    }
+    *reason = "render time saved is not worth the cache memory";
+    return false;
+} // computeCachingDecision
+
 CacheAccessModeEnum
-EffectInstance::Implementation::shouldRenderUseCache(const TreeRenderExecutionDataPtr& requestPassSharedData, const FrameViewRequestPtr& requestPassData)
+EffectInstance::Implementation::shouldRenderUseCache(const TreeRenderExecutionDataPtr& requestPassSharedData, const FrameViewRequestPtr& requestPassData, const RectI& renderMappedRoI)
 {
     bool retSet = false;
     CacheAccessModeEnum ret = eCacheAccessModeNone;
@@ -224,7 +413,17 @@ EffectInstance::Implementation::shouldRenderUseCache(const TreeRenderExecutionDa
 
         // Always cache an image if the color picker requested it
         const bool imageRequestedForColorPicker = render->isExtraResultsRequestedForNode(_publicInterface->getNode());
-        if (treeRoot == _publicInterface->getNode()->getEffectInstance() || imageRequestedForColorPicker)  {
+        const bool isTreeRoot = treeRoot == _publicInterface->getNode()->getEffectInstance();
+        if (imageRequestedForColorPicker) {
+            ret = eCacheAccessModeReadWrite;
+            retSet = true;
+        } else if (render->isStreamedRender()) {
+            // The output of a streamed render only covers a render window of the effect downstream and is
+            // released right after: do not cache it. The inputs where the stream stops are
+            // cached so that they are not rendered again for each render window.
+            ret = isTreeRoot ? eCacheAccessModeNone : eCacheAccessModeReadWrite;
+            retSet = true;
+        } else if (isTreeRoot)  {
             ret = eCacheAccessModeReadWrite;
             retSet = true;
         }
@@ -234,7 +433,26 @@ EffectInstance::Implementation::shouldRenderUseCache(const TreeRenderExecutionDa
         const bool isFrameVaryingOrAnimated = _publicInterface->isFrameVarying() || _publicInterface->getHasAnimation();
         const int requestsCount = requestPassData->getNumListeners(requestPassSharedData);
 
-        bool useCache = _publicInterface->shouldCacheOutput(isFrameVaryingOrAnimated,  requestsCount);
+        const ImagePlaneDesc& plane = requestPassData->getPlaneDesc();
+        if (requestPassData->checkIfCachingCostNotRecordedAndMark()) {
+            // Identify the image by the node frame/view hash, the plane and the mipmap level
+            Hash64 imageID;
+            {
+                HashableObject::ComputeHashArgs args;
+                args.time = _publicInterface->getCurrentRenderTime();
+                args.view = _publicInterface->getCurrentRenderView();
+                args.hashType = HashableObject::eComputeHashTypeTimeViewVariant;
+                imageID.append(_publicInterface->computeHash(args));
+            }
+            Hash64::appendQString(QString::fromUtf8(plane.getPlaneID().c_str()), &imageID);
+            imageID.append(requestPassData->getMipMapLevel());
+            imageID.computeHash();
+            recordOutputRequest(imageID.value());
+        }
+
+        const std::size_t outputBytes = (std::size_t)renderMappedRoI.area() * plane.getNumComponents() * getSizeOfForBitDepth(_publicInterface->getBitDepth(-1));
+
+        bool useCache = _publicInterface->shouldCacheOutput(isFrameVaryingOrAnimated, requestsCount, renderMappedRoI, outputBytes);
         if (useCache) {
             ret = eCacheAccessModeReadWrite;
         } else {
@@ -271,6 +489,7 @@ EffectInstance::Implementation::launchIsolatedRender(const FrameViewRequestPtr&
     rargs->plane = requestPassData->getPlaneDesc();
     rargs->draftMode = requestPassData->getParentRender()->isDraftRender();
     rargs->playback = requestPassData->getParentRender()->isPlayback();
+    rargs->cachePriority = requestPassData->getParentRender()->getCachePriority();
     rargs->byPassCache = false;
     TreeRenderPtr renderObject = TreeRender::create(rargs);
     _publicInterface->launchRender(renderObject);
@@ -323,6 +542,9 @@ EffectInstance::Implementation::tiledRenderingFunctor(const RectToRender & rectT
     if (rectToRender.identityInputNumber != -1) {
         stat = renderHandlerIdentity(rectToRender, args);
     } else {
+        // Measure the render cost to decide whether the output should be cached, see shouldCacheOutput
+        TimeLapse renderTime;
+
         stat = renderHandlerPlugin(rectToRender, args);
         if (isFailureRetCode(stat)) {
             return stat;
@@ -334,6 +556,10 @@ EffectInstance::Implementation::tiledRenderingFunctor(const RectToRender & rectT
         if (isFailureRetCode(stat)) {
             return stat;
         }
+
+        if (!render->isRenderAborted()) {
+            recordRenderCost(renderTime.getTimeSinceCreation(), (U64)rectToRender.rect.area());
+        }
     }
 
 
@@ -30,6 +30,7 @@
 #include "EffectInstance.h"
 
 #include <map>
+#include <set>
 #include <list>
 #include <string>
 
@@ -128,6 +129,7 @@ struct DefaultKnobs
     KnobStringWPtr nodeInfos;
     KnobButtonWPtr refreshInfoButton;
     KnobBoolWPtr forceCaching;
+    KnobChoiceWPtr cachingPolicy;
     KnobBoolWPtr hideInputs;
     KnobStringWPtr beforeFrameRender;
     KnobStringWPtr beforeRender;
@@ -162,6 +164,36 @@ struct RenderDefaultKnobs
 
 
 
+// Measurements used to decide if the output of a node is worth caching, see EffectInstance::shouldCacheOutput()
+struct CachingCostModel
+{
+    mutable QMutex lock;
+
+    // Exponential moving average of the time spent to render a single pixel, in seconds. 0 until the first render.
+    double timePerPixel;
+
+    // Exponential moving average of the fraction of the images requested to this node that were recently requested already
+    double reuseRatio;
+
+    // Identifiers of the images most recently requested to this node, most recent first
+    std::list<U64> recentRequests;
+
+    // The last decision taken, so that only changes are logged
+    int lastDecision;
+    std::string lastReason;
+
+    CachingCostModel()
+    : lock()
+    , timePerPixel(0)
+    , reuseRatio(0)
+    , recentRequests()
+    , lastDecision(-1)
+    , lastReason()
+    {
+
+    }
+};
+
 // Data shared accross all clones
 struct EffectInstanceCommonData
 {
@@ -204,6 +236,9 @@ struct EffectInstanceCommonData
     // we keep another shared pointer for render clones only, in  RenderCloneData
     NodeWPtr node;
 
+    // Render cost and reuse of the output images, shared by all render clones
+    CachingCostModel cachingCostModel;
+
     EffectInstanceCommonData()
     : attachedContextsMutex(QMutex::Recursive)
     , attachedContexts()
@@ -216,6 +251,7 @@ struct EffectInstanceCommonData
     , interacts()
     , timelineInteracts()
     , node()
+    , cachingCostModel()
     {
 
     }
@@ -298,6 +334,10 @@ struct RenderCloneData
     // A shared pointer to the node, to ensure it does not get deleted while rendering
     NodePtr node;
 
+    // Inputs that are not rendered upfront but pulled render window by render window from getImage(),
+    // see EffectInstance::Implementation::canStreamInput
+    std::set<int> streamedInputs;
+
     RenderCloneData()
     : lock()
     , instanceSafeRenderMutex()
@@ -307,6 +347,7 @@ struct RenderCloneData
     , frameRangeResults()
     , metadataResults()
     , node()
+    , streamedInputs()
     {
 
     }
@@ -439,7 +480,23 @@ public:
      * @brief Helper function in the implementation of renderRoI to determine if a render should use the Cache or not.
      * @returns The cache access type, i.e: none, write only or read/write
      **/
-    CacheAccessModeEnum shouldRenderUseCache(const TreeRenderExecutionDataPtr& requestPassSharedData, const FrameViewRequestPtr& requestPassData);
+    CacheAccessModeEnum shouldRenderUseCache(const TreeRenderExecutionDataPtr& requestPassSharedData, const FrameViewRequestPtr& requestPassData, const RectI& renderMappedRoI);
+
+    /**
+     * @brief Update the caching cost model with the time it took to render the given number of pixels
+     **/
+    void recordRenderCost(double timeSeconds, U64 nPixels);
+
+    /**
+     * @brief Update the caching cost model with a request for the image identified by imageID
+     **/
+    void recordOutputRequest(U64 imageID);
+
+    /**
+     * @brief Implementation of EffectInstance::shouldCacheOutput. A short description of the rule that took the decision
+     * is set in reason.
+     **/
+    bool computeCachingDecision(bool isFrameVaryingOrAnimated, int visitsCount, const RectI& renderWindow, std::size_t outputBytes, const char** reason) const;
 
     /**
      * @brief If a plug-in is using host frame-threading, potentially concurrent threads are calling getImagePlane().
@@ -447,6 +504,22 @@ public:
      **/
     ActionRetCodeEnum launchIsolatedRender(const FrameViewRequestPtr& requestPassData);
 
+    /**
+     * @brief Returns true if the given input can be streamed: instead of being rendered upfront on the full RoI,
+     * it is rendered by getImage() for each render window of this effect, in small images that are not cached.
+     * This is only possible if this effect is pixel-local (see kEffectPropPixelLocal), both effects are fully thread-safe
+     * CPU effects and the input is needed at the current frame/view only.
+     **/
+    bool canStreamInput(const FrameViewRequestPtr& requestPassData,
+                        const EffectInstancePtr& mainInstanceInput,
+                        const FrameRangesMap& inputFrames,
+                        AcceptedRequestConcatenationFlags concatenationFlags) const;
+
+    /**
+     * @brief Returns true if the given input was marked as streamed in handleUpstreamFramesNeeded
+     **/
+    bool isInputStreamed(int inputNb) const;
+
     ActionRetCodeEnum handleUpstreamFramesNeeded(const TreeRenderExecutionDataPtr& requestPassSharedData,
                                                  const FrameViewRequestPtr& requestPassData,
                                                  const RenderScale& proxyScale,
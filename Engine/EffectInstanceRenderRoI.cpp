@@ -672,11 +672,11 @@ EffectInstance::Implementation::checkRestToRender(bool updateTilesStateFromCache
 
         // Estimate num cpus according to the rectangle to render.
         // the MultiThread suite will adjust the tasks to the actual number of cpus available, no need to do the clamping ourselves.
+        // Streamed inputs are rendered once for each of these render windows, see canStreamInput.
         unsigned int nCPUs = ( std::min(mainRenderRect.x2 - mainRenderRect.x1, 4096) * (mainRenderRect.y2 - mainRenderRect.y1) ) / 4096;
         if (nCPUs > 1) {
             reducedRects = mainRenderRect.splitIntoSmallerRects(nCPUs);
         }
-        
     }
     for (std::list<RectI>::const_iterator it = reducedRects.begin(); it != reducedRects.end(); ++it) {
         if (!it->isNull()) {
@@ -880,6 +880,65 @@ EffectInstance::Implementation::launchRenderForSafetyAndBackend(const FrameViewR
 } // launchInternalRender
 
 
+bool
+EffectInstance::Implementation::canStreamInput(const FrameViewRequestPtr& requestPassData,
+                                               const EffectInstancePtr& mainInstanceInput,
+                                               const FrameRangesMap& inputFrames,
+                                               AcceptedRequestConcatenationFlags concatenationFlags) const
+{
+    TreeRenderPtr render = _publicInterface->getCurrentRender();
+    if (!render->isPixelLocalStreamingEnabled()) {
+        return false;
+    }
+
+    // Only CPU renders may be split in render windows by the host
+    if (requestPassData->getRenderDevice() != eRenderBackendTypeCPU) {
+        return false;
+    }
+
+    // Both effects must be able to render any portion of the image concurrently
+    if (_publicInterface->getRenderThreadSafety() != eRenderSafetyFullySafeFrame || !_publicInterface->supportsTiles()) {
+        return false;
+    }
+    if (mainInstanceInput->getRenderThreadSafety() != eRenderSafetyFullySafeFrame || !mainInstanceInput->supportsTiles()) {
+        return false;
+    }
+
+    // A concatenated input must be requested upfront so that its transform is collected
+    if (concatenationFlags != eAcceptedRequestConcatenationNone) {
+        return false;
+    }
+
+    // The color picker needs the full image of the input
+    if (render->isExtraResultsRequestedForNode(mainInstanceInput->getNode())) {
+        return false;
+    }
+
+    // The effect must be pixel-local: each render window only needs the same region of the input
+    if (!_publicInterface->isPixelLocal()) {
+        return false;
+    }
+
+    // The input must be needed at the current frame/view only
+    if (inputFrames.size() != 1 || inputFrames.begin()->first != _publicInterface->getCurrentRenderView()) {
+        return false;
+    }
+    const std::vector<RangeD>& ranges = inputFrames.begin()->second;
+    if (ranges.size() != 1 || ranges[0].min != ranges[0].max || ranges[0].min != (double)_publicInterface->getCurrentRenderTime()) {
+        return false;
+    }
+    return true;
+} // canStreamInput
+
+bool
+EffectInstance::Implementation::isInputStreamed(int inputNb) const
+{
+    if (!renderData) {
+        return false;
+    }
+    QMutexLocker k(&renderData->lock);
+    return renderData->streamedInputs.find(inputNb) != renderData->streamedInputs.end();
+}
 
 
 ActionRetCodeEnum
@@ -973,6 +1032,14 @@ EffectInstance::Implementation::handleUpstreamFramesNeeded(const TreeRenderExecu
         } else {
             _publicInterface->getNode()->clearPersistentMessage(kNatronPersistentErrorInfiniteRoI);
         }
+
+        // If the input is streamed, it will be rendered from getImage() for each render window instead
+        if (canStreamInput(requestPassData, mainInstanceInput, it->second, concatenationFlags)) {
+            QMutexLocker k(&renderData->lock);
+            renderData->streamedInputs.insert(inputNb);
+            continue;
+        }
+
         bool inputIsContinuous = mainInstanceInput->canRenderContinuously();
 
         int nbRequestedFramesForInput = 0;
@@ -1377,7 +1444,7 @@ EffectInstance::requestRenderInternal(const RectD & roiCanonical,
                 cachePolicy = eCacheAccessModeReadWrite;
             }
         } else {
-            cachePolicy = _imp->shouldRenderUseCache(requestPassSharedData, requestData);
+            cachePolicy = _imp->shouldRenderUseCache(requestPassSharedData, requestData, renderMappedRoI);
         }
     }
 
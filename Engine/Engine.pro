@@ -101,6 +101,7 @@ SOURCES += \
     Cache.cpp \
     CacheEntryBase.cpp \
     CacheEntryKeyBase.cpp \
+    CacheStatistics.cpp \
     CLArgs.cpp \
     CoonsRegularization.cpp \
     ColorParser.cpp \
@@ -131,6 +132,7 @@ SOURCES += \
     FrameViewRequest.cpp \
     GenericSchedulerThread.cpp \
     GenericSchedulerThreadWatcher.cpp \
+    GLProgramBinaryCache.cpp \
     GPUContextPool.cpp \
     GroupInput.cpp \
     GroupOutput.cpp \
@@ -217,6 +219,7 @@ SOURCES += \
     PyNodeGroup.cpp \
     PyNode.cpp \
     PyExprUtils.cpp \
+    PyImageBuffer.cpp \
     PyOverlayInteract.cpp \
     PyParameter.cpp \
     PyRoto.cpp \
@@ -233,6 +236,7 @@ SOURCES += \
     RotoBezierTriangulation.cpp \
     RotoDrawableItem.cpp \
     RotoItem.cpp \
+    RotoItemsSpatialIndex.cpp \
     RotoLayer.cpp \
     RotoPaint.cpp \
     RotoPaintInteract.cpp \
@@ -359,6 +363,7 @@ HEADERS += \
     Cache.h \
     CacheEntryBase.h \
     CacheEntryKeyBase.h \
+    CacheStatistics.h \
     CoonsRegularization.h \
     CornerPinOverlayInteract.h \
     ChoiceOption.h \
@@ -390,6 +395,7 @@ HEADERS += \
     FrameViewRequest.h \
     GenericSchedulerThread.h \
     GenericSchedulerThreadWatcher.h \
+    GLProgramBinaryCache.h \
     GLShader.h \
     GPUContextPool.h \
     GroupInput.h \
@@ -401,6 +407,7 @@ HEADERS += \
     ImageCacheEntry.h \
     ImageCacheEntryProcessing.h \
     ImageCacheKey.h \
+    ImageKernelDispatch.h \
     ImagePrivate.h \
     ImagePlaneDesc.h \
     InputDescription.h \
@@ -475,6 +482,7 @@ HEADERS += \
     PropertiesHolder.h \
     PyAppInstance.h \
     PyGlobalFunctions.h \
+    PyImageBuffer.h \
     PyItemsTable.h \
     PyNodeGroup.h \
     PyNode.h \
@@ -498,6 +506,7 @@ HEADERS += \
     RotoDrawableItem.h \
     RotoLayer.h \
     RotoItem.h \
+    RotoItemsSpatialIndex.h \
     RotoPaint.h \
     RotoPaintPrivate.h \
     RotoPoint.h \
@@ -267,6 +267,7 @@ class Project;
 class ProjectBeingLoadedInfo;
 class PyPanelI;
 class RAMImageStorage;
+template<typename T> class RamBuffer;
 class ReadNode;
 class RectD;
 class RectI;
@@ -445,6 +446,7 @@ typedef boost::shared_ptr<Plugin> PluginPtr;
 typedef boost::shared_ptr<PluginGroupNode> PluginGroupNodePtr;
 typedef boost::shared_ptr<PluginMemory> PluginMemoryPtr;
 typedef boost::shared_ptr<RAMImageStorage> RAMImageStoragePtr;
+typedef boost::shared_ptr<RamBuffer<char> > RamBufferPtr;
 typedef boost::shared_ptr<ReadNode> ReadNodePtr;
 typedef boost::shared_ptr<RenderEngine> RenderEnginePtr;
 typedef boost::shared_ptr<RenderActionTLSData> RenderActionTLSDataPtr;
@@ -26,8 +26,19 @@
 
 #include <cmath>
 #include <cassert>
+#include <list>
 #include <stdexcept>
 
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_OFF
+// /usr/local/include/boost/bind/arg.hpp:37:9: warning: unused typedef 'boost_static_assert_typedef_37' [-Wunused-local-typedef]
+#include <boost/bind.hpp>
+GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
+#endif
+
+#include <QtCore/QFuture>
+#include <QtConcurrentMap>
+
 #ifndef M_PI_2
 #define M_PI_2      1.57079632679489661923132169163975144   /* pi/2           */
 #endif
@@ -395,12 +406,20 @@ generateBezier(const std::vector<Point>& points,
     generatedBezier->push_back(lastCp);
 } // generateBezier
 
+/**
+ * @brief Fit a Bezier to the points with the given end tangents, splitting at the point of maximum error
+ * until each segment is within the error.
+ * If cpIndices is not NULL, it receives for each generated control point the index of the point it
+ * was placed on, offset by firstIndex.
+ **/
 static void
 fit_cubic_internal(const std::vector<Point>& points,
                    const Point&  tHat1,
                    const Point& tHat2,
                    double error,
-                   std::vector<SimpleBezierCP>* generatedBezier)
+                   std::vector<SimpleBezierCP>* generatedBezier,
+                   std::size_t firstIndex = 0,
+                   std::vector<std::size_t>* cpIndices = 0)
 {
     //Error below which you try iterating
     double iterationError = error * error;
@@ -424,6 +443,10 @@ fit_cubic_internal(const std::vector<Point>& points,
         lastCp.leftTan.y = lastCp.p.y + tHat2.y * dist * (1./ 3);
         generatedBezier->push_back(firstCp);
         generatedBezier->push_back(lastCp);
+        if (cpIndices) {
+            cpIndices->push_back(firstIndex);
+            cpIndices->push_back(firstIndex + 1);
+        }
 
         return;
     }
@@ -444,6 +467,10 @@ fit_cubic_internal(const std::vector<Point>& points,
             generateBezier(points, u, tHat1, tHat2, generatedBezier);
             maxError = computeMaxError(points, *generatedBezier, u, &splitPoint);
             if (maxError < error) {
+                if (cpIndices) {
+                    cpIndices->push_back(firstIndex);
+                    cpIndices->push_back(firstIndex + points.size() - 1);
+                }
                 return;
             }
         }
@@ -461,10 +488,18 @@ fit_cubic_internal(const std::vector<Point>& points,
     }
 
     std::vector<SimpleBezierCP> first, second;
-    fit_cubic_internal(firstSplit, tHat1, tHatCenter, error, &first);
+    std::vector<std::size_t> firstIndices, secondIndices;
+    fit_cubic_internal(firstSplit, tHat1, tHatCenter, error, &first, firstIndex, cpIndices ? &firstIndices : 0);
     tHatCenter.x = -tHatCenter.x;
     tHatCenter.y = -tHatCenter.y;
-    fit_cubic_internal(secondSplit, tHatCenter, tHat2, error, &second);
+    fit_cubic_internal(secondSplit, tHatCenter, tHat2, error, &second, firstIndex + splitPoint, cpIndices ? &secondIndices : 0);
+    if (cpIndices) {
+        // The first control point of the second segment is merged with the last one of the first segment
+        cpIndices->insert( cpIndices->end(), firstIndices.begin(), firstIndices.end() );
+        if ( !secondIndices.empty() ) {
+            cpIndices->insert( cpIndices->end(), secondIndices.begin() + 1, secondIndices.end() );
+        }
+    }
     generatedBezier->clear();
     if ( !first.empty() ) {
         generatedBezier->insert( generatedBezier->end(), first.begin(), first.end() );
@@ -504,6 +539,48 @@ fit_cubic_for_sub_set(const std::vector<Point>& points,
     fit_cubic_internal(points, tHat1, tHat2, error, generatedBezier);
 }
 
+static std::vector<SimpleBezierCP>
+fit_cubic_for_sub_set_functor(const std::vector<Point>* points,
+                              double error)
+{
+    std::vector<SimpleBezierCP> ret;
+    fit_cubic_for_sub_set(*points, error, &ret);
+    return ret;
+}
+
+static std::vector<SimpleBezierCP>
+fit_cubic_functor(const std::vector<Point>* points,
+                  double error)
+{
+    std::vector<SimpleBezierCP> ret;
+    FitCurve::fit_cubic(*points, error, &ret);
+    return ret;
+}
+
+/**
+ * @brief Applies func to each of the given sets of points on the global thread pool, results are in the same order.
+ **/
+template <typename FUNC>
+static void
+fitSetsInParallel(const std::vector<const std::vector<Point>*>& pointSets,
+                  FUNC func,
+                  double error,
+                  std::vector<std::vector<SimpleBezierCP> >* results)
+{
+    results->clear();
+    if ( pointSets.empty() ) {
+        return;
+    }
+    if (pointSets.size() == 1) {
+        // Not worth a thread
+        results->push_back( func(pointSets.front(), error) );
+        return;
+    }
+    QFuture<std::vector<SimpleBezierCP> > future = QtConcurrent::mapped( pointSets, boost::bind(func, _1, error) );
+    future.waitForFinished();
+    results->assign( future.begin(), future.end() );
+}
+
 NATRON_NAMESPACE_ANONYMOUS_EXIT
 
 
@@ -596,9 +673,16 @@ FitCurve::fit_cubic(const std::vector<Point>& points,
     }
 
 
+    // The subsets are independent from each other: fit them in parallel, then merge them in order
+    std::vector<const std::vector<Point>*> subsets;
     for (std::list<std::vector<Point> >::iterator it = pointSets.begin(); it != pointSets.end(); ++it) {
-        std::vector<SimpleBezierCP> subsetBezier;
-        fit_cubic_for_sub_set(*it, error, &subsetBezier);
+        subsets.push_back(&*it);
+    }
+    std::vector<std::vector<SimpleBezierCP> > subsetsBezier;
+    fitSetsInParallel(subsets, fit_cubic_for_sub_set_functor, error, &subsetsBezier);
+
+    for (std::vector<std::vector<SimpleBezierCP> >::const_iterator it = subsetsBezier.begin(); it != subsetsBezier.end(); ++it) {
+        const std::vector<SimpleBezierCP>& subsetBezier = *it;
         for (std::size_t i = 0; i < subsetBezier.size(); ++i) {
             //For the first segment point check if the  point is not already inserted in generatedBezie
             bool found = false;
@@ -617,5 +701,150 @@ FitCurve::fit_cubic(const std::vector<Point>& points,
     }
 } // FitCurve::fit_cubic
 
+void
+FitCurve::fit_cubic_batch(const std::vector<std::vector<Point> >& pointSets,
+                          double error,
+                          std::vector<std::vector<SimpleBezierCP> >* generatedBeziers)
+{
+    std::vector<const std::vector<Point>*> sets( pointSets.size() );
+    for (std::size_t i = 0; i < pointSets.size(); ++i) {
+        sets[i] = &pointSets[i];
+    }
+    fitSetsInParallel(sets, fit_cubic_functor, error, generatedBeziers);
+}
+
+struct FitCurve::IncrementalFitterPrivate
+{
+    double error;
+
+    // All the points appended so far, without consecutive duplicates
+    std::vector<Point> points;
+
+    // Control points of the segments that will not be fitted again. The last one is the first control point of the tail
+    // and its right tangent is given by the tail.
+    std::vector<SimpleBezierCP> committed;
+
+    // Index in points of the first point of the tail
+    std::size_t tailStart;
+
+    // Unit tangent leaving the first point of the tail, so that the tail joins the committed segments smoothly
+    Point tailStartTangent;
+
+    // Fit of the points from tailStart to the last point
+    std::vector<SimpleBezierCP> tail;
+
+    IncrementalFitterPrivate(double error)
+    : error(error)
+    , points()
+    , committed()
+    , tailStart(0)
+    , tailStartTangent()
+    , tail()
+    {
+        tailStartTangent.x = tailStartTangent.y = 0.;
+    }
+};
+
+FitCurve::IncrementalFitter::IncrementalFitter(double error)
+: _imp( new IncrementalFitterPrivate(error) )
+{
+}
+
+FitCurve::IncrementalFitter::~IncrementalFitter()
+{
+}
+
+void
+FitCurve::IncrementalFitter::clear()
+{
+    _imp->points.clear();
+    _imp->committed.clear();
+    _imp->tail.clear();
+    _imp->tailStart = 0;
+}
+
+std::size_t
+FitCurve::IncrementalFitter::getPointsCount() const
+{
+    return _imp->points.size();
+}
+
+std::size_t
+FitCurve::IncrementalFitter::getTailPointsCount() const
+{
+    return _imp->points.size() - _imp->tailStart;
+}
+
+void
+FitCurve::IncrementalFitter::appendPoint(const Point& p)
+{
+    std::vector<Point>& points = _imp->points;
+
+    // Same threshold as the duplicates removal of fit_cubic
+    if ( !points.empty() && (std::abs(points.back().x - p.x) < 1e-4) && (std::abs(points.back().y - p.y) < 1e-4) ) {
+        return;
+    }
+    points.push_back(p);
+
+    std::size_t nPoints = points.size();
+    if (nPoints == 1) {
+        SimpleBezierCP cp;
+        cp.p = p;
+        cp.leftTan = cp.rightTan = p;
+        _imp->tail.assign(1, cp);
+
+        return;
+    }
+    if ( _imp->committed.empty() ) {
+        _imp->tailStartTangent = computeEndTangent(points[0], points[1]);
+    }
+
+    // Only the tail is fitted again, the committed segments do not depend on the points after them
+    std::vector<Point> tailPoints(points.begin() + _imp->tailStart, points.end());
+    Point tHat2 = computeEndTangent(points[nPoints - 1], points[nPoints - 2]);
+    std::vector<SimpleBezierCP> fitted;
+    std::vector<std::size_t> cpIndices;
+    fit_cubic_internal(tailPoints, _imp->tailStartTangent, tHat2, _imp->error, &fitted, _imp->tailStart, &cpIndices);
+    assert( fitted.size() == cpIndices.size() && fitted.size() >= 2 );
+
+    if (fitted.size() == 2) {
+        _imp->tail.swap(fitted);
+
+        return;
+    }
+
+    // The tail had to be split: all segments but the last one are final, the tail restarts at the last split point
+    std::size_t lastSplit = fitted.size() - 2;
+    if ( _imp->committed.empty() ) {
+        _imp->committed.push_back(fitted[0]);
+    } else {
+        _imp->committed.back().rightTan = fitted[0].rightTan;
+    }
+    _imp->committed.insert( _imp->committed.end(), fitted.begin() + 1, fitted.begin() + lastSplit + 1 );
+
+    _imp->tailStart = cpIndices[lastSplit];
+    assert(_imp->tailStart >= 1 && _imp->tailStart < nPoints - 1);
+    // This is the tangent fit_cubic_internal used on the right of the split point
+    Point tHatCenter = computeCenterTangent(points[_imp->tailStart - 1], points[_imp->tailStart], points[_imp->tailStart + 1]);
+    _imp->tailStartTangent.x = -tHatCenter.x;
+    _imp->tailStartTangent.y = -tHatCenter.y;
+    _imp->tail.assign( fitted.begin() + lastSplit, fitted.end() );
+} // appendPoint
+
+void
+FitCurve::IncrementalFitter::getBezier(std::vector<SimpleBezierCP>* generatedBezier) const
+{
+    generatedBezier->clear();
+    if ( _imp->committed.empty() ) {
+        *generatedBezier = _imp->tail;
+
+        return;
+    }
+    *generatedBezier = _imp->committed;
+    assert( !_imp->tail.empty() );
+    generatedBezier->back().rightTan = _imp->tail.front().rightTan;
+    generatedBezier->insert( generatedBezier->end(), _imp->tail.begin() + 1, _imp->tail.end() );
+}
+
 NATRON_NAMESPACE_EXIT
 
@@ -29,6 +29,10 @@
 
 #include <vector>
 
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/scoped_ptr.hpp>
+#endif
+
 #include "Global/GlobalDefines.h"
 
 #include "Engine/EngineFwd.h"
@@ -52,6 +56,63 @@ struct SimpleBezierCP
  * @param generatedBezier[out] The fitted Bezier generated
  **/
 void fit_cubic(const std::vector<Point>& points, double error, std::vector<SimpleBezierCP>* generatedBezier);
+
+/**
+ * @brief Same as fit_cubic() for several independent sets of points, e.g: to simplify many curves at once.
+ * The sets are fitted in parallel on the global thread pool.
+ * @param generatedBeziers[out] The fitted Bezier of each set, in the same order as pointSets
+ **/
+void fit_cubic_batch(const std::vector<std::vector<Point> >& pointSets, double error, std::vector<std::vector<SimpleBezierCP> >* generatedBeziers);
+
+struct IncrementalFitterPrivate;
+
+/**
+ * @brief Fits a Bezier curve to points that are appended one at a time, e.g: while the user is drawing.
+ * Only the last segment (the tail) is fitted again when a point is appended: once fitting the tail requires
+ * to split it, all the segments but the last one are kept as is and the tail restarts at the last split point.
+ * Each point is within the same error of the curve as with fit_cubic(), however the result may differ from
+ * fit_cubic() on the whole set, which can split at other points and also splits at corners.
+ **/
+class IncrementalFitter
+{
+public:
+
+    /**
+     * @param error User-defined error squared, same as fit_cubic()
+     **/
+    IncrementalFitter(double error);
+
+    ~IncrementalFitter();
+
+    /**
+     * @brief Appends a point and updates the tail of the curve. Points (almost) equal to the last point are ignored.
+     **/
+    void appendPoint(const Point& p);
+
+    /**
+     * @brief Removes all points
+     **/
+    void clear();
+
+    /**
+     * @brief Returns the number of points appended, without the ignored duplicates
+     **/
+    std::size_t getPointsCount() const;
+
+    /**
+     * @brief Returns the number of points that are fitted again when a point is appended
+     **/
+    std::size_t getTailPointsCount() const;
+
+    /**
+     * @brief Returns the curve fitted to all the points appended so far
+     **/
+    void getBezier(std::vector<SimpleBezierCP>* generatedBezier) const;
+
+private:
+
+    boost::scoped_ptr<IncrementalFitterPrivate> _imp;
+};
 }
 
 NATRON_NAMESPACE_EXIT
@@ -220,6 +220,9 @@ struct FrameViewRequestPrivate
     // True if cache write is allowed but not cache read
     bool byPassCache;
 
+    // True once the request was counted in the caching cost model of the effect
+    bool cachingCostRecorded;
+
     FrameViewRequestPrivate(const ImagePlaneDesc& plane,
                             unsigned int mipMapLevel,
                             const RenderScale& proxyScale,
@@ -252,6 +255,7 @@ struct FrameViewRequestPrivate
     , canonicalRoDs()
     , pixelRoDs()
     , byPassCache(false)
+    , cachingCostRecorded(false)
     {
 #ifdef TRACE_REQUEST_LIFETIME
         nodeName = effect->getNode()->getScriptName_mt_safe();
@@ -601,6 +605,17 @@ FrameViewRequest::setByPassCacheEnabled(bool enabled)
     _imp->byPassCache = enabled;
 }
 
+bool
+FrameViewRequest::checkIfCachingCostNotRecordedAndMark() const
+{
+    assert(!_imp->renderLock.tryLock());
+    if (_imp->cachingCostRecorded) {
+        return false;
+    }
+    _imp->cachingCostRecorded = true;
+    return true;
+}
+
 void
 FrameViewRequest::setFallbackRenderDevice(RenderBackendTypeEnum device)
 {
@@ -362,6 +362,13 @@ public:
     bool checkIfByPassCacheEnabledAndTurnoff() const;
     void setByPassCacheEnabled(bool enabled);
 
+    /**
+     * @brief Returns true the first time it is called for this request and false afterwards.
+     * This is used to count each request only once in the caching cost model of the effect,
+     * even if the request is rendered in multiple passes.
+     **/
+    bool checkIfCachingCostNotRecordedAndMark() const;
+
     /**
      * @brief set/get the fallback render device used if the first render attempt did not work out.
      **/
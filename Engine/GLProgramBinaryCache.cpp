@@ -0,0 +1,247 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "GLProgramBinaryCache.h"
+
+#include <vector>
+
+#ifdef HAVE_OSMESA
+#include "Engine/OSGLFunctions_mesa.h"
+#endif
+
+#include <QtCore/QByteArray>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDataStream>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QString>
+#include <QtCore/QThread>
+
+#include "Engine/AppManager.h"
+#include "Engine/Hash64.h"
+#include "Engine/OSGLContext.h"
+#include "Engine/OSGLFunctions.h"
+
+// Tokens of GL_ARB_get_program_binary, the GL headers we use are generated for OpenGL 2.0
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+// Written at the start of each cache entry, to be bumped whenever the layout of the entries changes
+#define NATRON_GL_PROGRAM_BINARY_CACHE_MAGIC 0x4e50524f
+#define NATRON_GL_PROGRAM_BINARY_CACHE_VERSION 1
+
+NATRON_NAMESPACE_ENTER
+
+typedef void (APIENTRY *GetProgramBinaryProc)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+typedef void (APIENTRY *ProgramBinaryProc)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+typedef void (APIENTRY *ProgramParameteriProc)(GLuint program, GLenum pname, GLint value);
+
+namespace {
+
+struct ProgramBinaryFunctions
+{
+    GetProgramBinaryProc getProgramBinary;
+    ProgramBinaryProc programBinary;
+    ProgramParameteriProc programParameteri;
+
+    ProgramBinaryFunctions()
+    : getProgramBinary(0)
+    , programBinary(0)
+    , programParameteri(0)
+    {
+#ifdef HAVE_OSMESA
+        getProgramBinary = (GetProgramBinaryProc)OSMesaGetProcAddress("glGetProgramBinary");
+        programBinary = (ProgramBinaryProc)OSMesaGetProcAddress("glProgramBinary");
+        programParameteri = (ProgramParameteriProc)OSMesaGetProcAddress("glProgramParameteri");
+#endif
+    }
+
+    bool isValid() const
+    {
+        return getProgramBinary && programBinary && programParameteri;
+    }
+};
+
+const ProgramBinaryFunctions&
+getCPUFunctions()
+{
+    static ProgramBinaryFunctions functions;
+    return functions;
+}
+
+std::string
+getDriverID()
+{
+    std::string ret;
+    const GLenum names[3] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+    for (int i = 0; i < 3; ++i) {
+        const char* str = (const char*)GL_CPU::GetString(names[i]);
+        if (str) {
+            ret += str;
+        }
+        ret += '\n';
+    }
+    return ret;
+}
+
+QString
+getEntryFilePath(const std::string& driverID, const std::string& sources)
+{
+    Hash64 hash;
+    Hash64::appendQString(QString::fromUtf8(driverID.c_str()), &hash);
+    Hash64::appendQString(QString::fromUtf8(sources.c_str()), &hash);
+    hash.computeHash();
+
+    QString path = QString::fromUtf8(appPTR->getCacheDirPath().c_str());
+    path += QLatin1Char('/');
+    path += QString::fromUtf8(NATRON_GL_PROGRAM_BINARY_CACHE_DIR_NAME);
+    path += QLatin1Char('/');
+    path += QString::number(hash.value(), 16);
+    path += QString::fromUtf8(".bin");
+    return path;
+}
+
+} // anon namespace
+
+bool
+GLProgramBinaryCache::isSupported(bool gpuContext)
+{
+    if (gpuContext || !getCPUFunctions().isValid()) {
+        return false;
+    }
+    const char* extensions = (const char*)GL_CPU::GetString(GL_EXTENSIONS);
+    if (!extensions || !OSGLContext::stringInExtensionString("GL_ARB_get_program_binary", extensions)) {
+        return false;
+    }
+
+    // The driver may expose the extension without any format, e.g: if its own shader cache is disabled
+    GLint nFormats = 0;
+    GL_CPU::GetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &nFormats);
+    return nFormats > 0;
+}
+
+void
+GLProgramBinaryCache::setProgramRetrievable(bool gpuContext, unsigned int program)
+{
+    if (!isSupported(gpuContext)) {
+        return;
+    }
+    getCPUFunctions().programParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+bool
+GLProgramBinaryCache::loadProgram(bool gpuContext, unsigned int program, const std::string& sources)
+{
+    if (!isSupported(gpuContext)) {
+        return false;
+    }
+
+    std::string driverID = getDriverID();
+    QFile file(getEntryFilePath(driverID, sources));
+    if ( !file.open(QIODevice::ReadOnly) ) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    quint32 magic, version, binaryFormat;
+    QByteArray entryDriverID, entrySources, binary;
+    stream >> magic >> version;
+    if (magic != NATRON_GL_PROGRAM_BINARY_CACHE_MAGIC || version != NATRON_GL_PROGRAM_BINARY_CACHE_VERSION) {
+        return false;
+    }
+    stream >> entryDriverID >> entrySources >> binaryFormat >> binary;
+    if (stream.status() != QDataStream::Ok || binary.isEmpty()) {
+        return false;
+    }
+    if (std::string(entryDriverID.constData(), entryDriverID.size()) != driverID ||
+        std::string(entrySources.constData(), entrySources.size()) != sources) {
+        return false;
+    }
+
+    getCPUFunctions().programBinary(program, (GLenum)binaryFormat, binary.constData(), (GLsizei)binary.size());
+
+    // The driver may reject a binary, e.g: if it was built for another CPU
+    GLint isLinked = GL_FALSE;
+    GL_CPU::GetProgramiv(program, GL_LINK_STATUS, &isLinked);
+    return isLinked == GL_TRUE;
+} // loadProgram
+
+void
+GLProgramBinaryCache::saveProgram(bool gpuContext, unsigned int program, const std::string& sources)
+{
+    if (!isSupported(gpuContext)) {
+        return;
+    }
+
+    GLint binaryLength = 0;
+    GL_CPU::GetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+    if (binaryLength <= 0) {
+        return;
+    }
+    std::vector<char> binary(binaryLength);
+    GLenum binaryFormat = 0;
+    GLsizei writtenLength = 0;
+    getCPUFunctions().getProgramBinary(program, binaryLength, &writtenLength, &binaryFormat, &binary[0]);
+    if (writtenLength <= 0) {
+        return;
+    }
+
+    std::string driverID = getDriverID();
+    QString filePath = getEntryFilePath(driverID, sources);
+    if ( QFile::exists(filePath) ) {
+        // Another context saved it already
+        return;
+    }
+    QDir().mkpath( QFileInfo(filePath).absolutePath() );
+
+    // Write to a file private to this thread of this process and rename it once complete so that a concurrent
+    // loadProgram() never reads a partial entry. The cache directory may be shared by several Natron processes.
+    QString tmpFilePath = filePath + QLatin1Char('.') + QString::number( QCoreApplication::applicationPid() ) +
+                          QLatin1Char('.') + QString::number( (qulonglong)(quintptr)QThread::currentThread(), 16 );
+    {
+        QFile file(tmpFilePath);
+        if ( !file.open(QIODevice::WriteOnly | QIODevice::Truncate) ) {
+            return;
+        }
+        QDataStream stream(&file);
+        stream << (quint32)NATRON_GL_PROGRAM_BINARY_CACHE_MAGIC << (quint32)NATRON_GL_PROGRAM_BINARY_CACHE_VERSION;
+        stream << QByteArray(driverID.c_str(), (int)driverID.size());
+        stream << QByteArray(sources.c_str(), (int)sources.size());
+        stream << (quint32)binaryFormat;
+        stream << QByteArray(&binary[0], (int)writtenLength);
+    }
+    if ( !QFile::rename(tmpFilePath, filePath) ) {
+        QFile::remove(tmpFilePath);
+    }
+} // saveProgram
+
+NATRON_NAMESPACE_EXIT
@@ -0,0 +1,96 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef NATRON_ENGINE_GLPROGRAMBINARYCACHE_H
+#define NATRON_ENGINE_GLPROGRAMBINARYCACHE_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <string>
+
+#include "Engine/EngineFwd.h"
+
+// Name of the directory, in the cache directory, where linked shader programs are saved
+#define NATRON_GL_PROGRAM_BINARY_CACHE_DIR_NAME "GLProgramCache"
+
+NATRON_NAMESPACE_ENTER
+
+template <bool USEOPENGL>
+class OSGLFunctions;
+
+/**
+ * @brief Maps the OpenGL functions class used by a GLShader to the kind of context it runs on.
+ **/
+template <typename GL>
+struct GLFunctionsTraits;
+
+template <bool USEOPENGL>
+struct GLFunctionsTraits<OSGLFunctions<USEOPENGL> >
+{
+    static const bool isGPUContext = USEOPENGL;
+};
+
+/**
+ * @brief Persistent cache of linked shader programs.
+ * Once a program is linked, its binary is retrieved with glGetProgramBinary and saved in the cache directory.
+ * The next context that needs a program made of the same sources reloads it with glProgramBinary instead of
+ * compiling the sources again.
+ *
+ * Entries are identified by the driver (vendor, renderer and version strings) and the full sources of the
+ * program, including the #define lines prepended to them. Both are stored in the entry and compared when loading,
+ * so that a hash collision or a driver update can never load a wrong program.
+ *
+ * The entry points of GL_ARB_get_program_binary are only resolved for OSMesa contexts: with llvmpipe each compilation
+ * goes through LLVM which is costly, whereas GPU drivers usually have their own shader cache.
+ * All functions must be called with the context current on the calling thread.
+ **/
+class GLProgramBinaryCache
+{
+public:
+
+    /**
+     * @brief Returns true if programs can be saved and loaded for this kind of context
+     **/
+    static bool isSupported(bool gpuContext);
+
+    /**
+     * @brief Must be called before linking a program so that the driver keeps its binary retrievable.
+     **/
+    static void setProgramRetrievable(bool gpuContext, unsigned int program);
+
+    /**
+     * @brief Loads into program the binary of a program previously linked from the given sources.
+     * Returns false if there is no valid entry, in which case the program must be compiled and linked.
+     **/
+    static bool loadProgram(bool gpuContext, unsigned int program, const std::string& sources);
+
+    /**
+     * @brief Saves the binary of the given linked program in the cache.
+     **/
+    static void saveProgram(bool gpuContext, unsigned int program, const std::string& sources);
+};
+
+NATRON_NAMESPACE_EXIT
+
+#endif // NATRON_ENGINE_GLPROGRAMBINARYCACHE_H
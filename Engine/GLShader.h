@@ -31,9 +31,13 @@
 #include <boost/scoped_ptr.hpp>
 #endif
 
+#include <string>
+
 #include "Global/GlobalDefines.h"
 #include "Global/GLIncludes.h"
 
+#include "Engine/GLProgramBinaryCache.h"
+#include "Engine/Timer.h"
 #include "Engine/EngineFwd.h"
 
 NATRON_NAMESPACE_ENTER
@@ -71,6 +75,16 @@ public:
     virtual bool setUniform(const char* name, float value) = 0;
     virtual bool setUniform(const char* name, const OfxRGBAColourF& values) = 0;
     virtual bool getAttribLocation(const char* name, GLint* loc) const = 0;
+
+    /**
+     * @brief Returns true if link() loaded the program from the GLProgramBinaryCache instead of compiling it
+     **/
+    virtual bool isLoadedFromProgramCache() const = 0;
+
+    /**
+     * @brief Returns the time in seconds spent compiling the shaders in addShader() and linking them in link()
+     **/
+    virtual double getLinkDuration() const = 0;
 };
 
 template <typename GL>
@@ -90,6 +104,8 @@ public:
 
      *
      * Once programs have been added successfully, you can link() the programs together.
+     * link() loads the program from the GLProgramBinaryCache when possible instead of linking
+     * the compiled shaders.
      * When done, the shader is ready to be used. Call bind() to activate the shader
      * and unbind() to deactivate it.
      * To set uniforms, call the setUniform function.
@@ -101,6 +117,10 @@ public:
     , _vertexAttached(false)
     , _fragmentAttached(false)
     , _firstTime(true)
+    , _vertexSource()
+    , _fragmentSource()
+    , _loadedFromProgramCache(false)
+    , _linkDuration(0)
     {
 
     }
@@ -134,39 +154,20 @@ public:
 
         }
 
-        GLuint shader = 0;
+        // Keep the sources: they identify the program in the GLProgramBinaryCache
         if (type == eShaderTypeVertex) {
-            _vertexID = GL::CreateShader(GL_VERTEX_SHADER);
-
-            shader = _vertexID;
+            _vertexSource = src;
         } else if (type == eShaderTypeFragment) {
-            _fragmentID = GL::CreateShader(GL_FRAGMENT_SHADER);
-
-            shader = _fragmentID;
+            _fragmentSource = src;
         } else {
             assert(false);
-        }
-
-        GL::ShaderSource(shader, 1, (const GLchar**)&src, 0);
-        GL::CompileShader(shader);
-        GLint isCompiled;
-        GL::GetShaderiv(shader, GL_COMPILE_STATUS, &isCompiled);
-        if (isCompiled == GL_FALSE) {
-            if (error) {
-                getShaderInfoLog(shader, error);
-            }
-
             return false;
         }
 
-        GL::AttachShader(_shaderID, shader);
-        if (type == eShaderTypeVertex) {
-            _vertexAttached = true;
-        } else {
-            _fragmentAttached = true;
-        }
-        
-        return true;
+        TimestampVal startTime = getTimestampInSeconds();
+        bool ok = compileShader(type, src, error);
+        _linkDuration += getTimeElapsed(startTime, getTimestampInSeconds(), getPerformanceFrequency());
+        return ok;
     }
 
     virtual void bind() OVERRIDE FINAL
@@ -176,18 +177,10 @@ public:
 
     virtual bool link(std::string* error = 0) OVERRIDE FINAL
     {
-        GL::LinkProgram(_shaderID);
-        GLint isLinked;
-        GL::GetProgramiv(_shaderID, GL_LINK_STATUS, &isLinked);
-        if (isLinked == GL_FALSE) {
-            if (error) {
-                getShaderInfoLog(_shaderID, error);
-            }
-
-            return false;
-        }
-        
-        return true;
+        TimestampVal startTime = getTimestampInSeconds();
+        bool ok = linkInternal(error);
+        _linkDuration += getTimeElapsed(startTime, getTimestampInSeconds(), getPerformanceFrequency());
+        return ok;
     }
 
     virtual void unbind() OVERRIDE FINAL
@@ -245,8 +238,85 @@ public:
         return *loc != -1;
     }
 
+    virtual bool isLoadedFromProgramCache() const OVERRIDE FINAL
+    {
+        return _loadedFromProgramCache;
+    }
+
+    virtual double getLinkDuration() const OVERRIDE FINAL
+    {
+        return _linkDuration;
+    }
+
 private:
 
+    bool linkInternal(std::string* error)
+    {
+        const bool isGPUContext = GLFunctionsTraits<GL>::isGPUContext;
+
+        // Identify the program by all its sources
+        std::string sources;
+        sources += "vertex:\n";
+        sources += _vertexSource;
+        sources += "\nfragment:\n";
+        sources += _fragmentSource;
+
+        if ( GLProgramBinaryCache::loadProgram(isGPUContext, _shaderID, sources) ) {
+            _loadedFromProgramCache = true;
+            return true;
+        }
+
+        GLProgramBinaryCache::setProgramRetrievable(isGPUContext, _shaderID);
+        GL::LinkProgram(_shaderID);
+        GLint isLinked;
+        GL::GetProgramiv(_shaderID, GL_LINK_STATUS, &isLinked);
+        if (isLinked == GL_FALSE) {
+            if (error) {
+                getShaderInfoLog(_shaderID, error);
+            }
+
+            return false;
+        }
+
+        GLProgramBinaryCache::saveProgram(isGPUContext, _shaderID, sources);
+        return true;
+    }
+
+    bool compileShader(ShaderTypeEnum type, const char* src, std::string* error)
+    {
+        GLuint shader = 0;
+        if (type == eShaderTypeVertex) {
+            _vertexID = GL::CreateShader(GL_VERTEX_SHADER);
+
+            shader = _vertexID;
+        } else {
+            _fragmentID = GL::CreateShader(GL_FRAGMENT_SHADER);
+
+            shader = _fragmentID;
+        }
+
+        GL::ShaderSource(shader, 1, (const GLchar**)&src, 0);
+        GL::CompileShader(shader);
+        GLint isCompiled;
+        GL::GetShaderiv(shader, GL_COMPILE_STATUS, &isCompiled);
+        if (isCompiled == GL_FALSE) {
+            if (error) {
+                getShaderInfoLog(shader, error);
+            }
+
+            return false;
+        }
+
+        GL::AttachShader(_shaderID, shader);
+        if (type == eShaderTypeVertex) {
+            _vertexAttached = true;
+        } else {
+            _fragmentAttached = true;
+        }
+
+        return true;
+    }
+
     void getShaderInfoLog(GLuint shader,
                           std::string* error)
     {
@@ -264,6 +334,9 @@ private:
     GLuint _fragmentID;
     bool _vertexAttached, _fragmentAttached;
     bool _firstTime;
+    std::string _vertexSource, _fragmentSource;
+    bool _loadedFromProgramCache;
+    double _linkDuration;
 };
 
 NATRON_NAMESPACE_EXIT
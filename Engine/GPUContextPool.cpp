@@ -24,11 +24,13 @@
 
 #include "GPUContextPool.h"
 
+#include <algorithm>
 #include <set>
 #include <stdexcept>
 
 #include <QMutex>
 #include <QWaitCondition>
+#include <QtCore/QAtomicInt>
 #include <QtCore/QThread>
 
 #include "Engine/AppManager.h"
@@ -37,6 +39,12 @@
 
 #include "Global/GLIncludes.h"
 
+// Environment variable read by llvmpipe when the first OSMesa context is created to determine its number of rasterizer threads
+#define NATRON_LLVMPIPE_THREADS_ENV_VAR "LP_NUM_THREADS"
+
+// Number of threads working for each OSMesa context: the render thread issuing the OpenGL calls
+// and (this number - 1) llvmpipe rasterizer threads.
+#define NATRON_CPU_OPENGL_CONTEXT_THREADS 4
 
 NATRON_NAMESPACE_ENTER
 
@@ -58,6 +66,12 @@ struct GPUContextPoolPrivate
     OSGLContextWPtr lastUsedCPUGLContext;
     OSGLContextWPtr cpuGLShareContext;
 
+    // Number of llvmpipe rasterizer threads of each OSMesa context, -1 until the first context is created
+    QAtomicInt rasterizerThreadsPerCPUContext;
+
+    // Number of OSMesa contexts currently attached to a thread
+    QAtomicInt nAttachedCPUContexts;
+
     std::map<QThread*, OSGLContextAttacherWPtr> perThreadsActiveContext;
 
     GPUContextPoolPrivate()
@@ -68,10 +82,34 @@ struct GPUContextPoolPrivate
     , cpuGLContextPool()
     , lastUsedCPUGLContext()
     , cpuGLShareContext()
+    , rasterizerThreadsPerCPUContext(-1)
+    , nAttachedCPUContexts(0)
     {
     }
+
+    void initRasterizerThreadsCount();
 };
 
+void
+GPUContextPoolPrivate::initRasterizerThreadsCount()
+{
+    if ((int)rasterizerThreadsPerCPUContext != -1) {
+        return;
+    }
+
+    // Respect the value set by the user if any
+    bool userValueOk = false;
+    int nThreads = qgetenv(NATRON_LLVMPIPE_THREADS_ENV_VAR).toInt(&userValueOk);
+    if (!userValueOk || nThreads < 0) {
+        const int nHardwareThreads = std::max(1, appPTR->getHardwareIdealThreadCount());
+        nThreads = std::min(NATRON_CPU_OPENGL_CONTEXT_THREADS, nHardwareThreads) - 1;
+
+        // This must be set before llvmpipe is initialized, i.e: before the first OSMesa context is created.
+        qputenv( NATRON_LLVMPIPE_THREADS_ENV_VAR, QByteArray::number(nThreads) );
+    }
+    rasterizerThreadsPerCPUContext.fetchAndStoreRelease(nThreads);
+}
+
 GPUContextPool::GPUContextPool()
     : _imp( new GPUContextPoolPrivate() )
 {
@@ -116,6 +154,24 @@ GPUContextPool::unregisterContextForThread()
 
 }
 
+void
+GPUContextPool::onCPUContextAttachmentChanged(bool attached)
+{
+    _imp->nAttachedCPUContexts.fetchAndAddRelaxed(attached ? 1 : -1);
+}
+
+int
+GPUContextPool::getCPUOpenGLContextRasterizerThreadsCount() const
+{
+    return std::max(0, (int)_imp->rasterizerThreadsPerCPUContext);
+}
+
+int
+GPUContextPool::getNBusyRasterizerThreads() const
+{
+    return std::max(0, (int)_imp->nAttachedCPUContexts) * getCPUOpenGLContextRasterizerThreadsCount();
+}
+
 OSGLContextAttacherPtr
 GPUContextPool::getThreadLocalContext() const
 {
@@ -234,8 +290,11 @@ GPUContextPool::getOrCreateCPUOpenGLContext(bool retrieveLastContext)
         rendererID = settings->getOpenGLCPUDriver();
     }
 
-    // For CPU Contexts, use the threads count, we are not limited by the graphic card
-    const int maxContexts = appPTR->getHardwareIdealThreadCount();
+    // For CPU Contexts, we are not limited by the graphic card but by the threads count: each context needs
+    // a render thread plus its rasterizer threads.
+    _imp->initRasterizerThreadsCount();
+    const int nHardwareThreads = std::max(1, appPTR->getHardwareIdealThreadCount());
+    const int maxContexts = std::max(1, nHardwareThreads / (1 + getCPUOpenGLContextRasterizerThreadsCount()));
 
     if ( (int)_imp->cpuGLContextPool.size() < maxContexts ) {
         //  Create a new one
@@ -62,10 +62,25 @@ public:
      * When exiting this function, the context is not necessarily current to the thread.
      * To make it current, create a OSGLContextAttacher object and call the attach() function.
      *
+     * The contexts are shared by all render threads. Their count is bounded so that the render threads
+     * using them plus the llvmpipe rasterizer threads of each context do not exceed the hardware thread count.
+     *
      * @param retrieveLastContext If true, the context that was asked for the last time is re-used
      **/
     OSGLContextPtr getOrCreateCPUOpenGLContext(bool retrieveLastContext = false);
 
+    /**
+     * @brief Returns the number of llvmpipe rasterizer threads owned by each OSMesa context.
+     * 0 means each context rasterizes on the thread that issues the OpenGL calls.
+     **/
+    int getCPUOpenGLContextRasterizerThreadsCount() const;
+
+    /**
+     * @brief Returns the number of llvmpipe rasterizer threads of all OSMesa contexts currently attached to a thread.
+     * These threads are counted as busy by MultiThread::getNCPUsAvailable().
+     **/
+    int getNBusyRasterizerThreads() const;
+
 
     /**
      * @brief Clear all created contexts
@@ -84,6 +99,8 @@ private:
 
     void unregisterContextForThread();
 
+    void onCPUContextAttachmentChanged(bool attached);
+
 
     friend class OSGLContextAttacher;
     boost::scoped_ptr<GPUContextPoolPrivate> _imp;
@@ -24,6 +24,7 @@
 
 #include "HashableObject.h"
 #include <list>
+#include <map>
 #include <QMutex>
 
 #include "Engine/Hash64.h"
@@ -48,6 +49,9 @@ struct HashableObjectPrivate
 
     bool metadataSlaveCacheValid;
 
+    // The time invariant part of the time/view variant hash, per view
+    std::map<ViewIdx, HashableObject::TimeInvariantHashPart> timeInvariantPartCache;
+
     // protects all members
     mutable QMutex hashCacheMutex;
 
@@ -62,6 +66,7 @@ struct HashableObjectPrivate
     , timeViewInvariantCacheValid(false)
     , metadataSlaveCache(0)
     , metadataSlaveCacheValid(false)
+    , timeInvariantPartCache()
     , hashCacheMutex(QMutex::Recursive) // It might recurse when calling getValue on a knob with an expression because of randomSeed
     , hashCacheEnabled(true)
     {
@@ -76,6 +81,7 @@ struct HashableObjectPrivate
     , timeViewInvariantCacheValid(false)
     , metadataSlaveCache()
     , metadataSlaveCacheValid(false)
+    , timeInvariantPartCache() // Not copied: it references the objects of other
     , hashCacheMutex(QMutex::Recursive)
     , hashCacheEnabled(true)
     {
@@ -170,6 +176,31 @@ HashableObject::findCachedHash(const FindHashArgs& args, U64 *hash) const
 }
 
 
+bool
+HashableObject::findCachedTimeInvariantHashPart(ViewIdx view, TimeInvariantHashPart* part) const
+{
+    QMutexLocker k(&_imp->hashCacheMutex);
+    if (!_imp->hashCacheEnabled) {
+        return false;
+    }
+    std::map<ViewIdx, TimeInvariantHashPart>::const_iterator found = _imp->timeInvariantPartCache.find(view);
+    if ( found == _imp->timeInvariantPartCache.end() ) {
+        return false;
+    }
+    *part = found->second;
+    return true;
+}
+
+void
+HashableObject::setCachedTimeInvariantHashPart(ViewIdx view, const TimeInvariantHashPart& part)
+{
+    QMutexLocker k(&_imp->hashCacheMutex);
+    if (!_imp->hashCacheEnabled) {
+        return;
+    }
+    _imp->timeInvariantPartCache[view] = part;
+}
+
 void
 HashableObject::computeHash_noCache(const ComputeHashArgs& args, Hash64* hash)
 {
@@ -258,6 +289,7 @@ HashableObject::invalidateHashCacheInternal(std::set<HashableObject*>* invalidat
         _imp->timeViewVariantHashCache.clear();
         _imp->timeViewInvariantCacheValid = false;
         _imp->metadataSlaveCacheValid = false;
+        _imp->timeInvariantPartCache.clear();
     }
     for (std::set<HashableObjectWPtr>::const_iterator it = _imp->listeners.begin(); it != _imp->listeners.end(); ++it) {
         HashableObjectPtr listener = it->lock();
@@ -33,6 +33,7 @@
 #endif
 
 #include <set>
+#include <vector>
 
 #include "Global/GlobalDefines.h"
 #include "Engine/TimeValue.h"
@@ -164,6 +165,36 @@ public:
 
 protected:
 
+    /**
+     * @brief The part of the time/view variant hash of an object that does not depend on the time, e.g: the hash
+     * of all parameters that are not animated. It is cached for each view until the hash is invalidated, so that
+     * computing the hash at a new time only needs to append the hash of the objects that vary over time.
+     **/
+    struct TimeInvariantHashPart
+    {
+        // Hash of all objects that do not vary over time
+        U64 hash;
+
+        // Objects whose hash must be appended at each time, in order
+        std::vector<HashableObjectWPtr> timeVariantObjects;
+
+        TimeInvariantHashPart()
+        : hash(0)
+        , timeVariantObjects()
+        {
+
+        }
+    };
+
+    /**
+     * @brief Look for the time invariant part of the hash for the given view. Returns false if nothing is found
+     **/
+    bool findCachedTimeInvariantHashPart(ViewIdx view, TimeInvariantHashPart* part) const;
+
+    /**
+     * @brief Cache the time invariant part of the hash for the given view. It is cleared by invalidateHashCache()
+     **/
+    void setCachedTimeInvariantHashPart(ViewIdx view, const TimeInvariantHashPart& part);
 
     /**
      * @brief Must be implemented by deriving classes to add to the hash.
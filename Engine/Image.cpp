@@ -491,6 +491,10 @@ Image::fill(const RectI & roi,
         return eActionStatusOK;
     }
 
+    // Sparse buffers that were not written to yet already read as zero: clearing them is free and does not commit memory.
+    if (r == 0.f && g == 0.f && b == 0.f && a == 0.f && _imp->isZeroFilled()) {
+        return eActionStatusOK;
+    }
 
 
     Image::CPUData data;
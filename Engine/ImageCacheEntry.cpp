@@ -49,6 +49,7 @@
 #include "Engine/ThreadPool.h"
 #include "Engine/TreeRenderQueueManager.h"
 #include "Engine/Timer.h"
+#include "Engine/TreeRender.h"
 
 // Define to log tiles status in the console
 //#define TRACE_TILES_STATUS
@@ -56,6 +57,13 @@
 //#define TRACE_RENDERED_TILES
 //#define TRACE_TILES_STATUS_SHORT
 
+// Maximum amount of milliseconds waitForPendingTiles() waits for a notification before checking again the tiles state
+// and whether the render was aborted.
+#define NATRON_IMAGE_CACHE_PENDING_TILES_WAIT_MAX_MS 100
+
+// When the entry is not cached, waitForPendingTiles() has no condition to wait on and polls at this interval
+#define NATRON_IMAGE_CACHE_PENDING_TILES_NO_CACHE_POLL_MS 10
+
 #if defined(TRACE_TILES_STATUS) || defined(TRACE_TILES_STATUS_SHORT)
 #include <QTextStream>
 #endif
@@ -280,6 +288,19 @@ struct DownscaleTile : public TileData
     boost::shared_ptr<TileData> srcTiles[4];
 };
 
+/**
+ * @brief Returns the number of bytes covered by the given tiles, used for the cache statistics
+ **/
+static U64
+getTilesDataSize(const std::vector<boost::shared_ptr<TileData> >& tiles, ImageBitDepthEnum bitdepth)
+{
+    U64 nPixels = 0;
+    for (std::size_t i = 0; i < tiles.size(); ++i) {
+        nPixels += (U64)tiles[i]->bounds.area();
+    }
+    return nPixels * getSizeOfForBitDepth(bitdepth);
+}
+
 
 struct ImageCacheEntryPrivate
 {
@@ -460,6 +481,19 @@ struct ImageCacheEntryPrivate
 
     };
 
+    /**
+     * @brief Returns the cache priority class of the render producing this image
+     **/
+    CacheEntryPriorityEnum getCachePriority() const
+    {
+        EffectInstancePtr renderClone = effect.lock();
+        TreeRenderPtr render;
+        if (renderClone) {
+            render = renderClone->getCurrentRender();
+        }
+        return render ? render->getCachePriority() : eCacheEntryPriorityViewer;
+    }
+
     /**
      * @brief Update the state of this local entry from the cache entry
      **/
@@ -477,6 +511,12 @@ struct ImageCacheEntryPrivate
      **/
     bool markCacheEntriesAsAbortedInternal();
 
+    /**
+     * @brief Wakes up threads waiting in waitForPendingTiles() on this entry, possibly in other processes.
+     * Must be called after the state of tiles in the cache was changed.
+     **/
+    void notifyTilesStateChanged();
+
     /**
      * @brief Only relevant if the cache entry is persistent: update the cache from our local cache entry
      **/
@@ -665,6 +705,7 @@ ImageCacheEntry::ensureRoI(const RectI& roi,
     if (mustUpdateCache) {
         _imp->updateCachedTilesStateMap(_imp->markedTiles, false);
         _imp->markedTiles.clear();
+        _imp->notifyTilesStateChanged();
     }
 } // ensureRoI
 
@@ -1612,17 +1653,52 @@ ImageCacheEntryPrivate::fetchAndCopyCachedTiles()
 
     // Allocated buffers for tiles
     std::vector<std::pair<TileInternalIndex, void*> > allocatedTiles;
-    void* cacheData;
-    bool gotTiles = tileCache->retrieveAndLockTiles(internalCacheEntry, &tileIndicesToFetch,
+
+    // Pin the tiles so that they cannot be freed by another thread during the copy: no cache lock is held meanwhile
+    CacheTilesPinPtr tilesPin;
+
 #ifdef NATRON_CACHE_TILES_MEMORY_ALLOCATOR_CENTRALIZED
-                                                    tilesAllocNeeded,
+    bool readOnlyAccess = tilesAllocNeeded == 0;
 #else
-                                                    &tilesAllocNeeded,
+    bool readOnlyAccess = tilesAllocNeeded.empty();
 #endif
-                                                    &fetchedExistingTiles, &allocatedTiles, &cacheData);
-    boost::scoped_ptr<CacheDataLock_RAII> cacheDataDeleter(new CacheDataLock_RAII(tileCache, cacheData));
-    if (!gotTiles) {
-        return eActionStatusFailed;
+    if (readOnlyAccess) {
+        tilesPin = tileCache->pinTiles(internalCacheEntry, tileIndicesToFetch, &fetchedExistingTiles);
+        if (!tilesPin) {
+            return eActionStatusFailed;
+        }
+    } else {
+        {
+            void* cacheData;
+            bool gotTiles = tileCache->retrieveAndLockTiles(internalCacheEntry, &tileIndicesToFetch,
+#ifdef NATRON_CACHE_TILES_MEMORY_ALLOCATOR_CENTRALIZED
+                                                            tilesAllocNeeded,
+#else
+                                                            &tilesAllocNeeded,
+#endif
+                                                            &fetchedExistingTiles, &allocatedTiles, &cacheData);
+            CacheDataLock_RAII cacheDataDeleter(tileCache, cacheData);
+            if (!gotTiles) {
+                return eActionStatusFailed;
+            }
+        }
+
+        // The allocated tiles now belong to the entry: pin them along with the existing tiles, since the
+        // locks taken by retrieveAndLockTiles were released.
+        std::vector<TileInternalIndex> tilesToPin(tileIndicesToFetch);
+        for (std::size_t i = 0; i < allocatedTiles.size(); ++i) {
+            tilesToPin.push_back(allocatedTiles[i].first);
+        }
+        std::vector<void*> pinnedTilesData;
+        tilesPin = tileCache->pinTiles(internalCacheEntry, tilesToPin, &pinnedTilesData);
+        if (!tilesPin) {
+            return eActionStatusFailed;
+        }
+        assert(pinnedTilesData.size() == fetchedExistingTiles.size() + allocatedTiles.size());
+        std::copy(pinnedTilesData.begin(), pinnedTilesData.begin() + fetchedExistingTiles.size(), fetchedExistingTiles.begin());
+        for (std::size_t i = 0; i < allocatedTiles.size(); ++i) {
+            allocatedTiles[i].second = pinnedTilesData[fetchedExistingTiles.size() + i];
+        }
     }
 
 
@@ -1776,9 +1852,10 @@ ImageCacheEntryPrivate::fetchAndCopyCachedTiles()
     processor->setValues(this, tilesToCopy);
     ActionRetCodeEnum stat = processor->launchThreadsBlocking();
 
+    appPTR->getTileCache()->getStatistics().increment(CacheStatistics::eCounterBytesReadFromCache, getTilesDataSize(tilesToCopy, bitdepth));
 
-    // Release the tiles lock before calling updateCachedTilesStateMap which may try to take a write lock on an already taken read lock
-    cacheDataDeleter.reset();
+    // Release the pins once the copy is done
+    tilesPin.reset();
 
     // In persistent mode we have to actually copy the states map from the cache entry to the cache
     if (internalCacheEntry->isPersistent() && stateMapUpdated) {
@@ -1828,6 +1905,7 @@ ImageCacheEntry::fetchCachedTilesAndUpdateStatus(bool readOnly, TileStateHeader*
             }
             _imp->internalCacheEntry->tileSizeX = _imp->localTilesState.tileSizeX;
             _imp->internalCacheEntry->tileSizeY = _imp->localTilesState.tileSizeY;
+            _imp->internalCacheEntry->setCachePriority(_imp->getCachePriority());
 
             CacheEntryLockerBasePtr cacheAccess = _imp->internalCacheEntry->getFromCache();
 
@@ -1849,6 +1927,7 @@ ImageCacheEntry::fetchCachedTilesAndUpdateStatus(bool readOnly, TileStateHeader*
                 }
                 _imp->internalCacheEntry->tileSizeX = _imp->localTilesState.tileSizeX;
                 _imp->internalCacheEntry->tileSizeY = _imp->localTilesState.tileSizeY;
+                _imp->internalCacheEntry->setCachePriority(_imp->getCachePriority());
                 _imp->markedTiles.clear();
                 _imp->tilesToFetch.clear();
                 _imp->tilesToDownscale.clear();
@@ -2052,7 +2131,7 @@ ImageCacheEntry::markCacheTilesAsAborted()
         if (_imp->internalCacheEntry->isPersistent()) {
             _imp->updateCachedTilesStateMap(_imp->markedTiles, false);
         }
-
+        _imp->notifyTilesStateChanged();
     }
 
     _imp->markedTiles.clear();
@@ -2233,6 +2312,7 @@ ImageCacheEntry::markCacheTilesInRegionAsNotRendered(const RectI& roi)
         if (_imp->internalCacheEntry->isPersistent()) {
             _imp->updateCachedTilesStateMap(std::vector<TilesSet>(), true);
         }
+        _imp->notifyTilesStateChanged();
     }
 
 } // markCacheTilesInRegionAsNotRendered
@@ -2424,6 +2504,8 @@ ImageCacheEntry::markCacheTilesAsRendered()
     assert(stat == eActionStatusOK);
     (void)stat;
 
+    appPTR->getTileCache()->getStatistics().increment(CacheStatistics::eCounterBytesWrittenToCache, getTilesDataSize(tilesToCopy, _imp->bitdepth));
+
     // We must delete the CacheDataLock_RAII now because updateCachedTilesStateMap may attempt to get a write lock on an already taken read lock
 
     cacheDataDeleter.reset();
@@ -2432,8 +2514,19 @@ ImageCacheEntry::markCacheTilesAsRendered()
     if (_imp->internalCacheEntry->isPersistent()) {
         _imp->updateCachedTilesStateMap(tilesToUpdate, false);
     }
+
+    _imp->notifyTilesStateChanged();
 } // markCacheTilesAsRendered
 
+void
+ImageCacheEntryPrivate::notifyTilesStateChanged()
+{
+    if (cachePolicy == eCacheAccessModeNone) {
+        return;
+    }
+    internalCacheEntry->getCache()->notifyEntryStateChanged(internalCacheEntry->getHashKey());
+} // notifyTilesStateChanged
+
 bool
 ImageCacheEntry::waitForPendingTiles()
 {
@@ -2454,7 +2547,8 @@ ImageCacheEntry::waitForPendingTiles()
     // some mutexes protecting the memory mapping of the cache itself.
     //
     // For more explanation see comments in CacheEntryLocker::waitForPendingEntry:
-    // Instead we implement polling
+    // Instead we wait on the entry state condition of the cache bucket, which is notified by the threads rendering
+    // the tiles in markCacheTilesAsRendered() and markCacheTilesAsAborted().
 
     // If this thread is a threadpool thread, it may wait for a while that results gets available.
     // Release the thread to the thread pool so that it may use this thread for other runnables
@@ -2462,13 +2556,22 @@ ImageCacheEntry::waitForPendingTiles()
     RELEASE_THREAD_RAII();
 
     std::size_t timeSpentWaitingForPendingEntryMS = 0;
-    std::size_t timeToWaitMS = 40;
+    TimeLapse waitTimer;
 
+    // When not using the cache, the entry is local to this process and there is no condition to wait on
+    CacheBasePtr cache;
+    if (_imp->cachePolicy != eCacheAccessModeNone) {
+        cache = _imp->internalCacheEntry->getCache();
+    }
+    U64 entryHash = _imp->internalCacheEntry->getHashKey();
 
     bool hasUnrenderedTile;
     bool hasPendingResults;
 
     do {
+        // Read the serial before the tiles state so that a notification happening in between is not missed
+        U64 serial = cache ? cache->getEntryStateSerial(entryHash) : 0;
+
         hasUnrenderedTile = false;
         hasPendingResults = false;
         ActionRetCodeEnum stat = fetchCachedTilesAndUpdateStatus(false, NULL, &hasUnrenderedTile, &hasPendingResults);
@@ -2476,14 +2579,15 @@ ImageCacheEntry::waitForPendingTiles()
             return true;
         }
 
-        if (hasPendingResults) {
-
-            timeSpentWaitingForPendingEntryMS += timeToWaitMS;
-            CacheEntryLockerBase::sleep_milliseconds(timeToWaitMS);
-
-            // Increase the time to wait at the next iteration
-            timeToWaitMS *= 1.2;
+        if (hasPendingResults && !hasUnrenderedTile) {
 
+            // The notification is per cache bucket: we may be woken up for another entry, in which case we just check again
+            if (cache) {
+                cache->waitForEntryStateChange(entryHash, serial, NATRON_IMAGE_CACHE_PENDING_TILES_WAIT_MAX_MS);
+            } else {
+                CacheEntryLockerBase::sleep_milliseconds(NATRON_IMAGE_CACHE_PENDING_TILES_NO_CACHE_POLL_MS);
+            }
+            timeSpentWaitingForPendingEntryMS = (std::size_t)(waitTimer.getTimeSinceCreation() * 1000.);
 
         }
 #ifdef DEBUG
@@ -2494,6 +2598,12 @@ ImageCacheEntry::waitForPendingTiles()
 
     } while(hasPendingResults && !hasUnrenderedTile && !_imp->effect.lock()->isRenderAborted());
 
+    if (timeSpentWaitingForPendingEntryMS > 0) {
+        CacheStatistics& stats = appPTR->getTileCache()->getStatistics();
+        stats.increment(CacheStatistics::eCounterPendingTilesWaits);
+        stats.increment(CacheStatistics::eCounterPendingTilesWaitUS, (U64)(waitTimer.getTimeSinceCreation() * 1e6));
+    }
+
 #if defined(TRACE_TILES_STATUS) || defined(TRACE_TILES_STATUS_SHORT)
     _imp->writeDebugStatus("waitForPendingTiles", false);
 #endif
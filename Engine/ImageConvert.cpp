@@ -37,6 +37,7 @@ GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 #include <QtCore/QDebug>
 
 #include "Engine/AppManager.h"
+#include "Engine/ImageKernelDispatch.h"
 #include "Engine/Texture.h"
 #include "Engine/Lut.h"
 
@@ -761,39 +762,34 @@ convertToFormatInternalForDstDepth(const RectI & renderWindow,
     return eActionStatusFailed;
 } // convertToFormatInternalForDstDepth
 
-template <typename SRCPIX, int srcMaxValue>
-ActionRetCodeEnum
-convertToFormatInternalForSrcDepth(const RectI & renderWindow,
-                                   ViewerColorSpaceEnum srcColorSpace,
-                                   ViewerColorSpaceEnum dstColorSpace,
-                                   bool requiresUnpremult,
-                                   int conversionChannel,
-                                   Image::AlphaChannelHandlingEnum alphaHandling,
-                                   Image::MonoToPackedConversionEnum monoConversion,
-                                   const void* srcBufPtrs[4],
-                                   int srcNComps,
-                                   const RectI& srcBounds,
-                                   void* dstBufPtrs[4],
-                                   int dstNComps,
-                                   ImageBitDepthEnum dstBitDepth,
-                                   const RectI& dstBounds,
-                                   const EffectInstancePtr& renderClone)
+struct ConvertArgs
 {
-    switch ( dstBitDepth ) {
-        case eImageBitDepthByte:
-            ///Same as a copy
-            return convertToFormatInternalForDstDepth<SRCPIX, srcMaxValue, unsigned char, 255>(renderWindow, srcColorSpace, dstColorSpace, requiresUnpremult, conversionChannel, alphaHandling, monoConversion, srcBufPtrs, srcNComps, srcBounds, dstBufPtrs, dstNComps, dstBounds, renderClone);
-        case eImageBitDepthShort:
-            return convertToFormatInternalForDstDepth<SRCPIX, srcMaxValue, unsigned short, 65535>(renderWindow, srcColorSpace, dstColorSpace, requiresUnpremult, conversionChannel, alphaHandling, monoConversion, srcBufPtrs, srcNComps, srcBounds, dstBufPtrs, dstNComps, dstBounds, renderClone);
-        case eImageBitDepthHalf:
-            break;
-        case eImageBitDepthFloat:
-            return convertToFormatInternalForDstDepth<SRCPIX, srcMaxValue, float, 1>(renderWindow, srcColorSpace, dstColorSpace, requiresUnpremult, conversionChannel, alphaHandling, monoConversion, srcBufPtrs, srcNComps, srcBounds, dstBufPtrs, dstNComps, dstBounds, renderClone);
-        case eImageBitDepthNone:
-            break;
+    RectI renderWindow;
+    ViewerColorSpaceEnum srcColorSpace;
+    ViewerColorSpaceEnum dstColorSpace;
+    bool requiresUnpremult;
+    int conversionChannel;
+    Image::AlphaChannelHandlingEnum alphaHandling;
+    Image::MonoToPackedConversionEnum monoConversion;
+    const void** srcBufPtrs;
+    int srcNComps;
+    RectI srcBounds;
+    void** dstBufPtrs;
+    int dstNComps;
+    RectI dstBounds;
+    EffectInstancePtr renderClone;
+};
+
+template <typename SRCPIX, int srcMaxValue, typename DSTPIX, int dstMaxValue>
+class ConvertKernel
+{
+public:
+
+    static ActionRetCodeEnum run(const ConvertArgs& args)
+    {
+        return convertToFormatInternalForDstDepth<SRCPIX, srcMaxValue, DSTPIX, dstMaxValue>(args.renderWindow, args.srcColorSpace, args.dstColorSpace, args.requiresUnpremult, args.conversionChannel, args.alphaHandling, args.monoConversion, args.srcBufPtrs, args.srcNComps, args.srcBounds, args.dstBufPtrs, args.dstNComps, args.dstBounds, args.renderClone);
     }
-    return eActionStatusFailed;
-}
+};
 
 ActionRetCodeEnum
 ImagePrivate::convertCPUImage(const RectI & renderWindow,
@@ -815,20 +811,22 @@ ImagePrivate::convertCPUImage(const RectI & renderWindow,
 {
     assert( srcBounds.contains(renderWindow) && dstBounds.contains(renderWindow) );
 
-    switch ( srcBitDepth ) {
-        case eImageBitDepthByte:
-            ///Same as a copy
-            return convertToFormatInternalForSrcDepth<unsigned char, 255>(renderWindow, srcColorSpace, dstColorSpace, requiresUnpremult, conversionChannel, alphaHandling, monoConversion, srcBufPtrs, srcNComps, srcBounds, dstBufPtrs, dstNComps, dstBitDepth, dstBounds, renderClone);
-        case eImageBitDepthShort:
-            return convertToFormatInternalForSrcDepth<unsigned short, 65535>(renderWindow, srcColorSpace, dstColorSpace, requiresUnpremult, conversionChannel, alphaHandling, monoConversion, srcBufPtrs, srcNComps, srcBounds, dstBufPtrs, dstNComps, dstBitDepth, dstBounds, renderClone);
-        case eImageBitDepthHalf:
-            break;
-        case eImageBitDepthFloat:
-            return convertToFormatInternalForSrcDepth<float, 1>(renderWindow, srcColorSpace, dstColorSpace, requiresUnpremult, conversionChannel, alphaHandling, monoConversion, srcBufPtrs, srcNComps, srcBounds, dstBufPtrs, dstNComps, dstBitDepth, dstBounds, renderClone);
-        case eImageBitDepthNone:
-            break;
-    }
-    return eActionStatusFailed;
+    ConvertArgs args;
+    args.renderWindow = renderWindow;
+    args.srcColorSpace = srcColorSpace;
+    args.dstColorSpace = dstColorSpace;
+    args.requiresUnpremult = requiresUnpremult;
+    args.conversionChannel = conversionChannel;
+    args.alphaHandling = alphaHandling;
+    args.monoConversion = monoConversion;
+    args.srcBufPtrs = srcBufPtrs;
+    args.srcNComps = srcNComps;
+    args.srcBounds = srcBounds;
+    args.dstBufPtrs = dstBufPtrs;
+    args.dstNComps = dstNComps;
+    args.dstBounds = dstBounds;
+    args.renderClone = renderClone;
+    return ImageConversionKernelTable<ConvertArgs, ConvertKernel>::run(srcBitDepth, dstBitDepth, args);
 } // convertCPUImage
 
 template <typename GL>
@@ -35,6 +35,7 @@ GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 
 #include <QtCore/QDebug>
 
+#include "Engine/ImageKernelDispatch.h"
 #include "Engine/OSGLContext.h"
 #include "Engine/OSGLFunctions.h"
 
@@ -508,59 +509,41 @@ copyUnProcessedChannelsForDstComponents(const void* originalImgPtrs[4],
     }
 } // Image::copyUnProcessedChannelsForComponents
 
-template <typename PIX, int maxValue, int srcNComps>
-static ActionRetCodeEnum
-copyUnProcessedChannelsForSrcComps(const void* originalImgPtrs[4],
-                                   const RectI& originalImgBounds,
-                                   void* dstImgPtrs[4],
-                                   int dstImgNComps,
-                                   const RectI& dstBounds,
-                                   const std::bitset<4> processChannels,
-                                   const RectI& roi,
-                                   const EffectInstancePtr& renderClone)
+struct CopyUnProcessedChannelsArgs
 {
-    switch (dstImgNComps) {
-        case 1:
-            return copyUnProcessedChannelsForDstComponents<PIX, maxValue, srcNComps, 1>(originalImgPtrs, originalImgBounds, dstImgPtrs, dstBounds, processChannels, roi, renderClone);
-        case 2:
-            return copyUnProcessedChannelsForDstComponents<PIX, maxValue, srcNComps, 2>(originalImgPtrs, originalImgBounds, dstImgPtrs, dstBounds, processChannels, roi, renderClone);
-        case 3:
-            return copyUnProcessedChannelsForDstComponents<PIX, maxValue, srcNComps, 3>(originalImgPtrs, originalImgBounds, dstImgPtrs, dstBounds, processChannels, roi, renderClone);
-        case 4:
-            return copyUnProcessedChannelsForDstComponents<PIX, maxValue, srcNComps, 4>(originalImgPtrs, originalImgBounds, dstImgPtrs, dstBounds, processChannels, roi, renderClone);
-        default:
-            return eActionStatusFailed;
-    }
-}
-
-template <typename PIX, int maxValue>
-static ActionRetCodeEnum
-copyUnProcessedChannelsForDepth(const void* originalImgPtrs[4],
-                                const RectI& originalImgBounds,
-                                int originalImgNComps,
-                                void* dstImgPtrs[4],
-                                int dstImgNComps,
-                                const RectI& dstBounds,
-                                const std::bitset<4> processChannels,
-                                const RectI& roi,
-                                const EffectInstancePtr& renderClone)
+    const void** originalImgPtrs;
+    RectI originalImgBounds;
+    int originalImgNComps;
+    void** dstImgPtrs;
+    RectI dstBounds;
+    std::bitset<4> processChannels;
+    RectI roi;
+    EffectInstancePtr renderClone;
+};
+
+template <typename PIX, int maxValue, int dstNComps>
+class CopyUnProcessedChannelsKernel
 {
+public:
 
-    switch (originalImgNComps) {
-        case 0:
-            return copyUnProcessedChannelsForSrcComps<PIX, maxValue, 0>(originalImgPtrs, originalImgBounds, dstImgPtrs, dstImgNComps, dstBounds, processChannels, roi, renderClone);
-        case 1:
-            return copyUnProcessedChannelsForSrcComps<PIX, maxValue, 1>(originalImgPtrs, originalImgBounds, dstImgPtrs, dstImgNComps, dstBounds, processChannels, roi, renderClone);
-        case 2:
-            return copyUnProcessedChannelsForSrcComps<PIX, maxValue, 2>(originalImgPtrs, originalImgBounds, dstImgPtrs, dstImgNComps, dstBounds, processChannels, roi, renderClone);
-        case 3:
-            return copyUnProcessedChannelsForSrcComps<PIX, maxValue, 3>(originalImgPtrs, originalImgBounds, dstImgPtrs, dstImgNComps, dstBounds, processChannels, roi, renderClone);
-        case 4:
-            return copyUnProcessedChannelsForSrcComps<PIX, maxValue, 4>(originalImgPtrs, originalImgBounds, dstImgPtrs, dstImgNComps,dstBounds, processChannels, roi, renderClone);
-        default:
-            return eActionStatusFailed;
+    static ActionRetCodeEnum run(const CopyUnProcessedChannelsArgs& args)
+    {
+        switch (args.originalImgNComps) {
+            case 0:
+                return copyUnProcessedChannelsForDstComponents<PIX, maxValue, 0, dstNComps>(args.originalImgPtrs, args.originalImgBounds, args.dstImgPtrs, args.dstBounds, args.processChannels, args.roi, args.renderClone);
+            case 1:
+                return copyUnProcessedChannelsForDstComponents<PIX, maxValue, 1, dstNComps>(args.originalImgPtrs, args.originalImgBounds, args.dstImgPtrs, args.dstBounds, args.processChannels, args.roi, args.renderClone);
+            case 2:
+                return copyUnProcessedChannelsForDstComponents<PIX, maxValue, 2, dstNComps>(args.originalImgPtrs, args.originalImgBounds, args.dstImgPtrs, args.dstBounds, args.processChannels, args.roi, args.renderClone);
+            case 3:
+                return copyUnProcessedChannelsForDstComponents<PIX, maxValue, 3, dstNComps>(args.originalImgPtrs, args.originalImgBounds, args.dstImgPtrs, args.dstBounds, args.processChannels, args.roi, args.renderClone);
+            case 4:
+                return copyUnProcessedChannelsForDstComponents<PIX, maxValue, 4, dstNComps>(args.originalImgPtrs, args.originalImgBounds, args.dstImgPtrs, args.dstBounds, args.processChannels, args.roi, args.renderClone);
+            default:
+                return eActionStatusFailed;
+        }
     }
-} // Image::copyUnProcessedChannelsForDepth
+}; // CopyUnProcessedChannelsKernel
 
 ActionRetCodeEnum
 ImagePrivate::copyUnprocessedChannelsCPU(const void* originalImgPtrs[4],
@@ -574,23 +557,21 @@ ImagePrivate::copyUnprocessedChannelsCPU(const void* originalImgPtrs[4],
                                          const RectI& roi,
                                          const EffectInstancePtr& renderClone)
 {
-    switch (dstImgBitDepth) {
-        case eImageBitDepthByte:
-            return copyUnProcessedChannelsForDepth<unsigned char, 255>(originalImgPtrs, originalImgBounds, originalImgNComps, dstImgPtrs, dstImgNComps, dstBounds, processChannels, roi, renderClone);
-        case eImageBitDepthFloat:
-            return copyUnProcessedChannelsForDepth<float, 1>(originalImgPtrs, originalImgBounds, originalImgNComps, dstImgPtrs, dstImgNComps, dstBounds, processChannels, roi, renderClone);
-        case eImageBitDepthShort:
-            return copyUnProcessedChannelsForDepth<unsigned short, 65535>(originalImgPtrs, originalImgBounds, originalImgNComps, dstImgPtrs, dstImgNComps, dstBounds, processChannels, roi, renderClone);
-
-        case eImageBitDepthHalf:
-        case eImageBitDepthNone:
-            return eActionStatusFailed;
-    }
-    return eActionStatusFailed;
+    CopyUnProcessedChannelsArgs args;
+    args.originalImgPtrs = originalImgPtrs;
+    args.originalImgBounds = originalImgBounds;
+    args.originalImgNComps = originalImgNComps;
+    args.dstImgPtrs = dstImgPtrs;
+    args.dstBounds = dstBounds;
+    args.processChannels = processChannels;
+    args.roi = roi;
+    args.renderClone = renderClone;
+    return ImageKernelTable<CopyUnProcessedChannelsArgs, CopyUnProcessedChannelsKernel>::run(dstImgBitDepth, dstImgNComps, args);
 }
 
 
 
+
 template <typename GL>
 void
 copyUnProcessedChannelsGLInternal(const GLImageStoragePtr& originalTexture,
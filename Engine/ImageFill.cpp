@@ -23,6 +23,7 @@
 // ***** END PYTHON BLOCK *****
 
 #include "ImagePrivate.h"
+#include "Engine/ImageKernelDispatch.h"
 #include "Engine/Texture.h"
 NATRON_NAMESPACE_ENTER
 
@@ -182,85 +183,58 @@ fillCPUBlack(void* ptrs[4],
     return eActionStatusOK;
 } // fillCPUBlack
 
-template <typename PIX, int maxValue, int nComps>
-static ActionRetCodeEnum
-fillForDepthForComponents(void* ptrs[4],
-                          float r,
-                          float g,
-                          float b,
-                          float a,
-                          const RectI& bounds,
-                          const RectI& roi,
-                          const EffectInstancePtr& renderClone)
+struct FillArgs
 {
-    const float fillValue[4] = {
-        nComps == 1 ? a * maxValue : r * maxValue, g * maxValue, b * maxValue, a * maxValue
-    };
-
-    int nCompsPerBuffer = nComps;
-    if (nComps > 1 && ptrs[1]) {
-        nCompsPerBuffer = 1;
-    }
+    void** ptrs;
+    float color[4];
+    RectI bounds;
+    RectI roi;
+    EffectInstancePtr renderClone;
+};
 
+template <typename PIX, int maxValue, int nComps>
+class FillKernel
+{
+public:
 
-    // now we're safe: the image contains the area in roi
-    PIX* dstPixelPtrs[4] = {NULL, NULL, NULL, NULL};
-    int dstPixelStride;
-    Image::getChannelPointers<PIX>((const PIX**)ptrs, roi.x1, roi.y1, bounds, nComps, (PIX**)dstPixelPtrs, &dstPixelStride);
+    static ActionRetCodeEnum run(const FillArgs& args)
+    {
+        const RectI& roi = args.roi;
 
-    std::size_t nElementsPerRow = nCompsPerBuffer * dstPixelStride;
+        PIX fillValue[nComps];
+        if (nComps == 1) {
+            fillValue[0] = (PIX)(args.color[3] * maxValue);
+        } else {
+            for (int c = 0; c < nComps; ++c) {
+                fillValue[c] = (PIX)(args.color[c] * maxValue);
+            }
+        }
 
+        for (int y = roi.y1; y < roi.y2; ++y) {
 
-    for (int y = roi.y1; y < roi.y2; ++y) {
+            if (args.renderClone && args.renderClone->isRenderAborted()) {
+                return eActionStatusAborted;
+            }
 
-        if (renderClone && renderClone->isRenderAborted()) {
-            return eActionStatusAborted;
-        }
+            // Resolve the channel pointers once per scan-line: all nComps channels are present in the
+            // image so the loop below has no branch and a constant number of channels.
+            PIX* dstPixelPtrs[4] = {NULL, NULL, NULL, NULL};
+            int dstPixelStride;
+            Image::getChannelPointers<PIX, nComps>((const PIX**)args.ptrs, roi.x1, y, args.bounds, (PIX**)dstPixelPtrs, &dstPixelStride);
+            if (!dstPixelPtrs[0]) {
+                continue;
+            }
 
-        for (int x = roi.x1; x < roi.x2; ++x) {
-            for (int c = 0; c < 4; ++c) {
-                if (dstPixelPtrs[c]) {
-                    *dstPixelPtrs[c] = fillValue[c];
-                    dstPixelPtrs[c] += dstPixelStride;
+            const int width = roi.width();
+            for (int x = 0; x < width; ++x) {
+                for (int c = 0; c < nComps; ++c) {
+                    dstPixelPtrs[c][x * dstPixelStride] = fillValue[c];
                 }
             }
         }
-        for (int c = 0; c < 4; ++c) {
-            if (dstPixelPtrs[c]) {
-                dstPixelPtrs[c] += nElementsPerRow - roi.width() * dstPixelStride;
-            }
-        }
+        return eActionStatusOK;
     }
-    return eActionStatusOK;
-} // fillForDepthForComponents
-
-
-template <typename PIX, int maxValue>
-static ActionRetCodeEnum
-fillForDepth(void* ptrs[4],
-             float r,
-             float g,
-             float b,
-             float a,
-             int nComps,
-             const RectI& bounds,
-             const RectI& roi,
-             const EffectInstancePtr& renderClone)
-{
-    switch (nComps) {
-        case 1:
-            return fillForDepthForComponents<PIX, maxValue, 1>(ptrs, r, g, b, a, bounds, roi, renderClone);
-        case 2:
-            return fillForDepthForComponents<PIX, maxValue, 2>(ptrs, r, g, b, a, bounds, roi, renderClone);
-        case 3:
-            return fillForDepthForComponents<PIX, maxValue, 3>(ptrs, r, g, b, a, bounds, roi, renderClone);
-        case 4:
-            return fillForDepthForComponents<PIX, maxValue, 4>(ptrs, r, g, b, a, bounds, roi, renderClone);
-        default:
-            break;
-    }
-    return eActionStatusFailed;
-} // fillForDepth
+}; // FillKernel
 
 
 ActionRetCodeEnum
@@ -279,19 +253,16 @@ ImagePrivate::fillCPU(void* ptrs[4],
         return fillCPUBlack(ptrs, nComps, bitDepth, bounds, roi, renderClone);
     }
 
-    switch (bitDepth) {
-        case eImageBitDepthByte:
-            return fillForDepth<unsigned char, 255>(ptrs, r, g, b, a, nComps, bounds, roi, renderClone);
-        case eImageBitDepthFloat:
-            return fillForDepth<float, 1>(ptrs, r, g, b, a, nComps, bounds, roi, renderClone);
-        case eImageBitDepthShort:
-            return fillForDepth<unsigned short, 65535>(ptrs, r, g, b, a, nComps, bounds, roi, renderClone);
-        case eImageBitDepthHalf:
-        default:
-            break;
-    }
-    return eActionStatusFailed;
-
+    FillArgs args;
+    args.ptrs = ptrs;
+    args.color[0] = r;
+    args.color[1] = g;
+    args.color[2] = b;
+    args.color[3] = a;
+    args.bounds = bounds;
+    args.roi = roi;
+    args.renderClone = renderClone;
+    return ImageKernelTable<FillArgs, FillKernel>::run(bitDepth, nComps, args);
 
 } // fillCPU
 
@@ -0,0 +1,144 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef NATRON_ENGINE_IMAGEKERNELDISPATCH_H
+#define NATRON_ENGINE_IMAGEKERNELDISPATCH_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <cstddef>
+
+#include "Global/GlobalDefines.h"
+
+#include "Engine/EngineFwd.h"
+
+// Number of bit depths for which CPU kernels are compiled: byte, short and float. Half is not supported on CPU.
+#define NATRON_IMAGE_KERNEL_N_DEPTHS 3
+
+NATRON_NAMESPACE_ENTER
+
+/**
+ * @brief Returns the row of the kernel tables for the given bit depth, or -1 if no CPU kernel exists for it.
+ **/
+inline int
+getImageKernelDepthIndex(ImageBitDepthEnum depth)
+{
+    switch (depth) {
+        case eImageBitDepthByte:
+            return 0;
+        case eImageBitDepthShort:
+            return 1;
+        case eImageBitDepthFloat:
+            return 2;
+        case eImageBitDepthHalf:
+        case eImageBitDepthNone:
+            break;
+    }
+    return -1;
+}
+
+/**
+ * @brief Table of the specializations of a CPU kernel for each bit depth and number of components.
+ * KERNEL<PIX, maxValue, nComps> must have a static function run(const ARGS&) returning an ActionRetCodeEnum.
+ *
+ * The kernel is resolved once per operation with getKernel(): it can then be written with the
+ * pixel type and channel count as compile-time constants instead of switching on them in its loops.
+ **/
+template <typename ARGS, template <typename PIX, int maxValue, int nComps> class KERNEL>
+class ImageKernelTable
+{
+public:
+
+    typedef ActionRetCodeEnum (*KernelFunction)(const ARGS& args);
+
+    /**
+     * @brief Returns the kernel specialized for the given depth and number of components (1 to 4), or NULL if there is none.
+     **/
+    static KernelFunction getKernel(ImageBitDepthEnum depth, int nComps)
+    {
+        static const KernelFunction table[NATRON_IMAGE_KERNEL_N_DEPTHS][4] = {
+            { &KERNEL<unsigned char, 255, 1>::run, &KERNEL<unsigned char, 255, 2>::run, &KERNEL<unsigned char, 255, 3>::run, &KERNEL<unsigned char, 255, 4>::run },
+            { &KERNEL<unsigned short, 65535, 1>::run, &KERNEL<unsigned short, 65535, 2>::run, &KERNEL<unsigned short, 65535, 3>::run, &KERNEL<unsigned short, 65535, 4>::run },
+            { &KERNEL<float, 1, 1>::run, &KERNEL<float, 1, 2>::run, &KERNEL<float, 1, 3>::run, &KERNEL<float, 1, 4>::run }
+        };
+        int depthIndex = getImageKernelDepthIndex(depth);
+        if (depthIndex < 0 || nComps < 1 || nComps > 4) {
+            return NULL;
+        }
+        return table[depthIndex][nComps - 1];
+    }
+
+    /**
+     * @brief Resolves the kernel and runs it. Returns eActionStatusFailed if there is no kernel for this depth/components.
+     **/
+    static ActionRetCodeEnum run(ImageBitDepthEnum depth, int nComps, const ARGS& args)
+    {
+        KernelFunction kernel = getKernel(depth, nComps);
+        if (!kernel) {
+            return eActionStatusFailed;
+        }
+        return kernel(args);
+    }
+};
+
+/**
+ * @brief Same as ImageKernelTable for kernels converting between two bit depths.
+ * KERNEL<SRCPIX, srcMaxValue, DSTPIX, dstMaxValue> must have a static function run(const ARGS&).
+ * The number of components is left to the kernel which usually dispatches on it from there.
+ **/
+template <typename ARGS, template <typename SRCPIX, int srcMaxValue, typename DSTPIX, int dstMaxValue> class KERNEL>
+class ImageConversionKernelTable
+{
+public:
+
+    typedef ActionRetCodeEnum (*KernelFunction)(const ARGS& args);
+
+    static KernelFunction getKernel(ImageBitDepthEnum srcDepth, ImageBitDepthEnum dstDepth)
+    {
+        static const KernelFunction table[NATRON_IMAGE_KERNEL_N_DEPTHS][NATRON_IMAGE_KERNEL_N_DEPTHS] = {
+            { &KERNEL<unsigned char, 255, unsigned char, 255>::run, &KERNEL<unsigned char, 255, unsigned short, 65535>::run, &KERNEL<unsigned char, 255, float, 1>::run },
+            { &KERNEL<unsigned short, 65535, unsigned char, 255>::run, &KERNEL<unsigned short, 65535, unsigned short, 65535>::run, &KERNEL<unsigned short, 65535, float, 1>::run },
+            { &KERNEL<float, 1, unsigned char, 255>::run, &KERNEL<float, 1, unsigned short, 65535>::run, &KERNEL<float, 1, float, 1>::run }
+        };
+        int srcIndex = getImageKernelDepthIndex(srcDepth);
+        int dstIndex = getImageKernelDepthIndex(dstDepth);
+        if (srcIndex < 0 || dstIndex < 0) {
+            return NULL;
+        }
+        return table[srcIndex][dstIndex];
+    }
+
+    static ActionRetCodeEnum run(ImageBitDepthEnum srcDepth, ImageBitDepthEnum dstDepth, const ARGS& args)
+    {
+        KernelFunction kernel = getKernel(srcDepth, dstDepth);
+        if (!kernel) {
+            return eActionStatusFailed;
+        }
+        return kernel(args);
+    }
+};
+
+NATRON_NAMESPACE_EXIT
+
+#endif // NATRON_ENGINE_IMAGEKERNELDISPATCH_H
@@ -24,194 +24,157 @@
 
 #include "ImagePrivate.h"
 
+#include <algorithm>
+
+#include "Engine/ImageKernelDispatch.h"
+
 NATRON_NAMESPACE_ENTER
 
-template<int srcNComps, int dstNComps, typename PIX, int maxValue, bool masked, bool maskInvert>
-static ActionRetCodeEnum
-applyMaskMixForMaskInvert(const void* originalImgPtrs[4],
-                          const RectI& originalImgBounds,
-                          const void* maskImgPtrs[4],
-                          const RectI& maskImgBounds,
-                          void* dstImgPtrs[4],
-                          double mix,
-                          const RectI& bounds,
-                          const RectI& roi,
-                          const EffectInstancePtr& renderClone)
+struct MaskMixArgs
 {
+    const void** originalImgPtrs;
+    RectI originalImgBounds;
+    int originalImgNComps;
+    const void** maskImgPtrs;
+    RectI maskImgBounds;
+    void** dstImgPtrs;
+    double mix;
+    bool invertMask;
+    RectI bounds;
+    RectI roi;
+    EffectInstancePtr renderClone;
+};
+
+/**
+ * @brief Mixes count pixels of a scan-line. Channels that do not exist in the source and pixels outside of
+ * the source or mask images are read from a zero value with a stride of 0 so that the loop has no branch.
+ **/
+template <typename PIX, int maxValue, int dstNComps, bool masked, bool maskInvert>
+static void
+applyMaskMixForPixels(PIX* dstPixelPtrs[4],
+                      int dstPixelStride,
+                      const PIX* srcPixelPtrs[4],
+                      const int srcPixelStrides[4],
+                      const PIX* maskPixelPtr,
+                      int maskPixelStride,
+                      float mix,
+                      int count)
+{
+    for (int x = 0; x < count; ++x) {
+        float alpha = mix;
+        if (masked) {
+            float maskScale = maskPixelPtr[x * maskPixelStride] * (1.f / maxValue);
+            if (maskInvert) {
+                maskScale = 1.f - maskScale;
+            }
+            alpha *= maskScale;
+        }
+        for (int c = 0; c < dstNComps; ++c) {
+            float dstF = Image::convertPixelDepth<PIX, float>(dstPixelPtrs[c][x * dstPixelStride]);
+            float srcF = Image::convertPixelDepth<PIX, float>(srcPixelPtrs[c][x * srcPixelStrides[c]]);
+            float v = dstF * alpha + (1.f - alpha) * srcF;
+            dstPixelPtrs[c][x * dstPixelStride] = Image::convertPixelDepth<float, PIX>(v);
+        }
+    }
+} // applyMaskMixForPixels
 
-    PIX* dstPixelPtrs[4] = {NULL, NULL, NULL, NULL};
-    int dstPixelStride;
-    Image::getChannelPointers<PIX, dstNComps>((const PIX**)dstImgPtrs, roi.x1, roi.y1, bounds, (PIX**)dstPixelPtrs, &dstPixelStride);
-
-    const std::size_t dstRowElements = (std::size_t)bounds.width() * dstPixelStride;
+template <typename PIX, int maxValue, int dstNComps, bool masked, bool maskInvert>
+static ActionRetCodeEnum
+applyMaskMixForMaskInvert(const MaskMixArgs& args)
+{
+    static const PIX zero = 0;
+    const RectI& roi = args.roi;
+    const bool hasSrc = args.originalImgPtrs[0] && args.originalImgNComps > 0;
 
-    for ( int y = roi.y1; y < roi.y2; ++y) {
+    for (int y = roi.y1; y < roi.y2; ++y) {
 
-        if (renderClone && renderClone->isRenderAborted()) {
+        if (args.renderClone && args.renderClone->isRenderAborted()) {
             return eActionStatusAborted;
         }
-        for (int x = roi.x1; x < roi.x2; ++x) {
 
-            PIX* srcPixelPtrs[4] = {NULL, NULL, NULL, NULL};
-            int srcPixelStride = 0;
-            if (originalImgPtrs[0]) {
-                Image::getChannelPointers<PIX, srcNComps>((const PIX**)originalImgPtrs, x, y, originalImgBounds, (PIX**)srcPixelPtrs, &srcPixelStride);
+        PIX* dstPixelPtrs[4] = {NULL, NULL, NULL, NULL};
+        int dstPixelStride;
+        Image::getChannelPointers<PIX, dstNComps>((const PIX**)args.dstImgPtrs, roi.x1, y, args.bounds, (PIX**)dstPixelPtrs, &dstPixelStride);
+        if (!dstPixelPtrs[0]) {
+            continue;
+        }
+
+        // Split the scan-line where the source and mask images start and end so that
+        // each segment either reads from an image or from zero.
+        int srcX1 = roi.x2, srcX2 = roi.x2;
+        if (hasSrc && y >= args.originalImgBounds.y1 && y < args.originalImgBounds.y2) {
+            srcX1 = std::min(std::max(args.originalImgBounds.x1, roi.x1), roi.x2);
+            srcX2 = std::max(std::min(args.originalImgBounds.x2, roi.x2), srcX1);
+        }
+        int maskX1 = roi.x2, maskX2 = roi.x2;
+        if (masked && y >= args.maskImgBounds.y1 && y < args.maskImgBounds.y2) {
+            maskX1 = std::min(std::max(args.maskImgBounds.x1, roi.x1), roi.x2);
+            maskX2 = std::max(std::min(args.maskImgBounds.x2, roi.x2), maskX1);
+        }
+        int breaks[6] = {roi.x1, srcX1, srcX2, maskX1, maskX2, roi.x2};
+        std::sort(breaks, breaks + 6);
+
+        for (int i = 0; i < 5; ++i) {
+            const int x1 = breaks[i];
+            const int x2 = breaks[i + 1];
+            if (x1 >= x2) {
+                continue;
             }
 
-            float maskScale = 1.f;
-            if (!masked) {
-                // just mix
-                float alpha = mix;
-                for (int c = 0; c < dstNComps; ++c) {
-                    float dstF = Image::convertPixelDepth<PIX, float>(*dstPixelPtrs[c]);
-                    float srcF;
-                    if (*srcPixelPtrs[c]) {
-                        srcF = Image::convertPixelDepth<PIX, float>(*srcPixelPtrs[c]);
-                        srcPixelPtrs[c] += srcPixelStride;
-                    } else {
-                        srcF = 0.;
+            const PIX* srcPixelPtrs[4] = {&zero, &zero, &zero, &zero};
+            int srcPixelStrides[4] = {0, 0, 0, 0};
+            if (x1 >= srcX1 && x1 < srcX2) {
+                PIX* srcChannelPtrs[4] = {NULL, NULL, NULL, NULL};
+                int srcPixelStride = 0;
+                Image::getChannelPointers<PIX>((const PIX**)args.originalImgPtrs, x1, y, args.originalImgBounds, args.originalImgNComps, srcChannelPtrs, &srcPixelStride);
+                for (int c = 0; c < 4; ++c) {
+                    if (srcChannelPtrs[c]) {
+                        srcPixelPtrs[c] = srcChannelPtrs[c];
+                        srcPixelStrides[c] = srcPixelStride;
                     }
-                    float v = dstF * alpha + (1.f - alpha) * srcF;
-                    *dstPixelPtrs[c] = Image::convertPixelDepth<float, PIX>(v);
-
-                    dstPixelPtrs[c] += dstPixelStride;
                 }
-            } else {
-
-                PIX* maskPixelPtrs[4] = {NULL, NULL, NULL, NULL};
-                int maskPixelStride;
-                Image::getChannelPointers<PIX, 1>((const PIX**)maskImgPtrs, x, y, maskImgBounds, (PIX**)maskPixelPtrs, &maskPixelStride);
-
-                // figure the scale factor from that pixel
-                if (!maskPixelPtrs[0]) {
-                    maskScale = maskInvert ? 1.f : 0.f;
-                } else {
-                    maskScale = *maskPixelPtrs[0] * (1.f / maxValue);
-                    if (maskInvert) {
-                        maskScale = 1.f - maskScale;
-                    }
-                    maskPixelPtrs[0] += maskPixelStride;
+            }
 
-                }
-                float alpha = mix * maskScale;
-                for (int c = 0; c < dstNComps; ++c) {
-                    float dstF = Image::convertPixelDepth<PIX, float>(*dstPixelPtrs[c]);
-                    float srcF;
-                    if (*srcPixelPtrs[c]) {
-                        srcF = Image::convertPixelDepth<PIX, float>(*srcPixelPtrs[c]);
-                        srcPixelPtrs[c] += srcPixelStride;
-                    } else {
-                        srcF = 0.;
-                    }
-                    float v = dstF * alpha + (1.f - alpha) * srcF;
-                    *dstPixelPtrs[c] = Image::convertPixelDepth<float, PIX>(v);
-                    dstPixelPtrs[c] += dstPixelStride;
+            const PIX* maskPixelPtr = &zero;
+            int maskPixelStride = 0;
+            if (masked && x1 >= maskX1 && x1 < maskX2) {
+                PIX* maskChannelPtrs[4] = {NULL, NULL, NULL, NULL};
+                int stride = 0;
+                Image::getChannelPointers<PIX, 1>((const PIX**)args.maskImgPtrs, x1, y, args.maskImgBounds, maskChannelPtrs, &stride);
+                if (maskChannelPtrs[0]) {
+                    maskPixelPtr = maskChannelPtrs[0];
+                    maskPixelStride = stride;
                 }
             }
-        }
-        for (int c = 0; c < dstNComps; ++c) {
-            dstPixelPtrs[c] += (dstRowElements - roi.width() * dstPixelStride);
+
+            PIX* dstSegmentPtrs[4] = {NULL, NULL, NULL, NULL};
+            for (int c = 0; c < dstNComps; ++c) {
+                dstSegmentPtrs[c] = dstPixelPtrs[c] + (x1 - roi.x1) * dstPixelStride;
+            }
+            applyMaskMixForPixels<PIX, maxValue, dstNComps, masked, maskInvert>(dstSegmentPtrs, dstPixelStride, srcPixelPtrs, srcPixelStrides, maskPixelPtr, maskPixelStride, (float)args.mix, x2 - x1);
         }
     }
     return eActionStatusOK;
 } // applyMaskMixForMaskInvert
 
-template<int srcNComps, int dstNComps, typename PIX, int maxValue, bool masked>
-static ActionRetCodeEnum
-applyMaskMixForMasked(const void* originalImgPtrs[4],
-                      const RectI& originalImgBounds,
-                      const void* maskImgPtrs[4],
-                      const RectI& maskImgBounds,
-                      void* dstImgPtrs[4],
-                      double mix,
-                      bool invertMask,
-                      const RectI& bounds,
-                      const RectI& roi,
-                      const EffectInstancePtr& renderClone)
+template <typename PIX, int maxValue, int dstNComps>
+class MaskMixKernel
 {
-    if (invertMask) {
-        return applyMaskMixForMaskInvert<srcNComps, dstNComps, PIX, maxValue, masked, true>(originalImgPtrs, originalImgBounds, maskImgPtrs, maskImgBounds, dstImgPtrs, mix, bounds, roi, renderClone);
-    } else {
-        return applyMaskMixForMaskInvert<srcNComps, dstNComps, PIX, maxValue, masked, false>(originalImgPtrs, originalImgBounds, maskImgPtrs, maskImgBounds, dstImgPtrs, mix, bounds, roi, renderClone);
-    }
-}
-
-template<int srcNComps, int dstNComps, typename PIX, int maxValue>
-static ActionRetCodeEnum
-applyMaskMixForDepth(const void* originalImgPtrs[4],
-                     const RectI& originalImgBounds,
-                     const void* maskImgPtrs[4],
-                     const RectI& maskImgBounds,
-                     void* dstImgPtrs[4],
-                     double mix,
-                     bool invertMask,
-                     const RectI& bounds,
-                     const RectI& roi,
-                     const EffectInstancePtr& renderClone)
-{
-    if (maskImgPtrs[0]) {
-        return applyMaskMixForMasked<srcNComps, dstNComps, PIX, maxValue, true>(originalImgPtrs, originalImgBounds, maskImgPtrs, maskImgBounds, dstImgPtrs, mix, invertMask, bounds, roi, renderClone);
-    } else {
-        return applyMaskMixForMasked<srcNComps, dstNComps, PIX, maxValue, false>(originalImgPtrs, originalImgBounds, maskImgPtrs, maskImgBounds, dstImgPtrs, mix, invertMask, bounds, roi, renderClone);
-    }
-}
-
-template <int srcNComps, int dstNComps>
-static ActionRetCodeEnum
-applyMaskMixForDstComponents(const void* originalImgPtrs[4],
-                             const RectI& originalImgBounds,
-                             const void* maskImgPtrs[4],
-                             const RectI& maskImgBounds,
-                             void* dstImgPtrs[4],
-                             ImageBitDepthEnum dstImgBitDepth,
-                             double mix,
-                             bool invertMask,
-                             const RectI& bounds,
-                             const RectI& roi,
-                             const EffectInstancePtr& renderClone)
-{
-    switch (dstImgBitDepth) {
-        case eImageBitDepthByte:
-            return applyMaskMixForDepth<srcNComps, dstNComps, unsigned char, 255>(originalImgPtrs, originalImgBounds, maskImgPtrs, maskImgBounds, dstImgPtrs, mix, invertMask, bounds, roi, renderClone);
-        case eImageBitDepthShort:
-            return applyMaskMixForDepth<srcNComps, dstNComps, unsigned short, 65535>(originalImgPtrs, originalImgBounds, maskImgPtrs, maskImgBounds, dstImgPtrs, mix, invertMask, bounds, roi, renderClone);
-        case eImageBitDepthFloat:
-            return applyMaskMixForDepth<srcNComps, dstNComps, float, 1>(originalImgPtrs, originalImgBounds, maskImgPtrs, maskImgBounds, dstImgPtrs, mix, invertMask, bounds, roi, renderClone);
-        default:
-            assert(false);
-            return eActionStatusFailed;
-    }
-}
+public:
 
-template<int srcNComps>
-static ActionRetCodeEnum
-applyMaskMixForSrcComponents(const void* originalImgPtrs[4],
-                             const RectI& originalImgBounds,
-                             const void* maskImgPtrs[4],
-                             const RectI& maskImgBounds,
-                             void* dstImgPtrs[4],
-                             ImageBitDepthEnum dstImgBitDepth,
-                             int dstImgNComps,
-                             double mix,
-                             bool invertMask,
-                             const RectI& bounds,
-                             const RectI& roi,
-                             const EffectInstancePtr& renderClone)
-{
-
-    switch (dstImgNComps) {
-        case 1:
-            return applyMaskMixForDstComponents<srcNComps, 1>(originalImgPtrs, originalImgBounds, maskImgPtrs, maskImgBounds, dstImgPtrs, dstImgBitDepth, mix, invertMask, bounds, roi, renderClone);
-        case 2:
-            return applyMaskMixForDstComponents<srcNComps, 2>(originalImgPtrs, originalImgBounds, maskImgPtrs, maskImgBounds, dstImgPtrs, dstImgBitDepth, mix, invertMask, bounds, roi, renderClone);
-        case 3:
-            return applyMaskMixForDstComponents<srcNComps, 3>(originalImgPtrs, originalImgBounds, maskImgPtrs, maskImgBounds, dstImgPtrs, dstImgBitDepth, mix, invertMask, bounds, roi, renderClone);
-        case 4:
-            return applyMaskMixForDstComponents<srcNComps, 4>(originalImgPtrs, originalImgBounds, maskImgPtrs, maskImgBounds, dstImgPtrs, dstImgBitDepth, mix, invertMask, bounds, roi, renderClone);
-        default:
-            return eActionStatusFailed;
+    static ActionRetCodeEnum run(const MaskMixArgs& args)
+    {
+        if (args.maskImgPtrs[0]) {
+            if (args.invertMask) {
+                return applyMaskMixForMaskInvert<PIX, maxValue, dstNComps, true, true>(args);
+            } else {
+                return applyMaskMixForMaskInvert<PIX, maxValue, dstNComps, true, false>(args);
+            }
+        } else {
+            return applyMaskMixForMaskInvert<PIX, maxValue, dstNComps, false, false>(args);
+        }
     }
-}
+}; // MaskMixKernel
 
 ActionRetCodeEnum
 ImagePrivate::applyMaskMixCPU(const void* originalImgPtrs[4],
@@ -228,19 +191,19 @@ ImagePrivate::applyMaskMixCPU(const void* originalImgPtrs[4],
                               const RectI& roi,
                               const EffectInstancePtr& renderClone)
 {
-    switch (originalImgNComps) {
-        case 1:
-            return applyMaskMixForSrcComponents<1>(originalImgPtrs, originalImgBounds, maskImgPtrs, maskImgBounds, dstImgPtrs, dstImgBitDepth, dstImgNComps, mix, invertMask, bounds, roi, renderClone);
-        case 2:
-            return applyMaskMixForSrcComponents<2>(originalImgPtrs, originalImgBounds, maskImgPtrs, maskImgBounds, dstImgPtrs, dstImgBitDepth, dstImgNComps, mix, invertMask, bounds, roi, renderClone);
-        case 3:
-            return applyMaskMixForSrcComponents<3>(originalImgPtrs, originalImgBounds, maskImgPtrs, maskImgBounds, dstImgPtrs, dstImgBitDepth, dstImgNComps, mix, invertMask, bounds, roi, renderClone);
-        case 4:
-            return applyMaskMixForSrcComponents<4>(originalImgPtrs, originalImgBounds, maskImgPtrs, maskImgBounds, dstImgPtrs, dstImgBitDepth, dstImgNComps, mix, invertMask, bounds, roi, renderClone);
-        default:
-            return applyMaskMixForSrcComponents<0>(originalImgPtrs, originalImgBounds, maskImgPtrs, maskImgBounds, dstImgPtrs, dstImgBitDepth, dstImgNComps, mix, invertMask, bounds, roi, renderClone);
-    }
-
+    MaskMixArgs args;
+    args.originalImgPtrs = originalImgPtrs;
+    args.originalImgBounds = originalImgBounds;
+    args.originalImgNComps = originalImgNComps;
+    args.maskImgPtrs = maskImgPtrs;
+    args.maskImgBounds = maskImgBounds;
+    args.dstImgPtrs = dstImgPtrs;
+    args.mix = mix;
+    args.invertMask = invertMask;
+    args.bounds = bounds;
+    args.roi = roi;
+    args.renderClone = renderClone;
+    return ImageKernelTable<MaskMixArgs, MaskMixKernel>::run(dstImgBitDepth, dstImgNComps, args);
 }
 
 template <typename GL>
@@ -84,6 +84,24 @@ ImagePrivate::getCPUDataInternal(const RectI& bounds,
     }
 } // getCPUDataInternal
 
+bool
+ImagePrivate::isZeroFilled() const
+{
+    if (!channels[0]) {
+        return false;
+    }
+    for (int i = 0; i < 4; ++i) {
+        if (!channels[i]) {
+            continue;
+        }
+        RAMImageStoragePtr isRAMBuffer = toRAMImageStorage(channels[i]);
+        if (!isRAMBuffer || !isRAMBuffer->isZeroFilled()) {
+            return false;
+        }
+    }
+    return true;
+} // isZeroFilled
+
 ActionRetCodeEnum
 ImagePrivate::initAndFetchFromCache(const Image::InitStorageArgs& args)
 {
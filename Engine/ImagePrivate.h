@@ -123,6 +123,11 @@ struct ImagePrivate
 
     ActionRetCodeEnum initAndFetchFromCache(const Image::InitStorageArgs& args);
 
+    /**
+     * @brief Returns true if all buffers of the image are in RAM and known to only contain zeros
+     **/
+    bool isZeroFilled() const;
+
     static void getCPUDataInternal(const RectI& bounds,
                                    int nComps,
                                    const ImageStorageBasePtr storage[4],
@@ -25,6 +25,9 @@
 
 #include "ImageStorage.h"
 
+#include <algorithm>
+
+#include <QAtomicInt>
 #include <QMutex>
 #include <QThread>
 #include <QCoreApplication>
@@ -151,8 +154,10 @@ ImageStorageBase::deallocateMemory()
 struct RAMImageStoragePrivate
 {
 
-    // Set if externalBuffer is not set
-    boost::scoped_ptr<RamBuffer<char> > buffer;
+    // Set if externalBuffer is not set. The buffer comes from the StorageAllocatorThread pool and
+    // may be larger than bufferSize
+    RamBufferPtr buffer;
+    std::size_t bufferSize;
 
     // Set if buffer is not set
     void* externalBuffer;
@@ -164,14 +169,23 @@ struct RAMImageStoragePrivate
 
     RectI bounds;
 
+    // True if buffer was allocated zero-filled instead of being taken from the StorageAllocatorThread pool
+    bool sparse;
+
+    // Non-zero as long as a sparse buffer was not handed out for writing
+    QAtomicInt zeroFilled;
+
     RAMImageStoragePrivate()
     : buffer()
+    , bufferSize(0)
     , externalBuffer(0)
     , externalBufferSize(0)
     , externalBufferFreeFunc(0)
     , bitDepth(eImageBitDepthFloat)
     , numComps(1)
     , bounds()
+    , sparse(false)
+    , zeroFilled(0)
     {
 
     }
@@ -218,7 +232,7 @@ std::size_t
 RAMImageStorage::getBufferSize() const
 {
     if (_imp->buffer) {
-        return _imp->buffer->size();
+        return _imp->bufferSize;
     } else if (_imp->externalBuffer) {
         return _imp->externalBufferSize;
     } else {
@@ -242,6 +256,8 @@ RAMImageStorage::getData() const
 char*
 RAMImageStorage::getData()
 {
+    // The caller may write to the buffer
+    _imp->zeroFilled.fetchAndStoreRelease(0);
     if (_imp->buffer) {
         return _imp->buffer->getData();
     } else if (_imp->externalBuffer) {
@@ -252,6 +268,11 @@ RAMImageStorage::getData()
 
 }
 
+bool
+RAMImageStorage::isZeroFilled() const
+{
+    return (int)_imp->zeroFilled > 0;
+}
 
 void
 RAMImageStorage::allocateMemoryImpl(const AllocateMemoryArgs& args)
@@ -271,13 +292,23 @@ RAMImageStorage::allocateMemoryImpl(const AllocateMemoryArgs& args)
     assert(!_imp->externalBuffer || _imp->externalBufferFreeFunc);
 
     if (!_imp->externalBuffer) {
-        _imp->buffer.reset(new RamBuffer<char>);
         std::size_t nBytes = getSizeOfForBitDepth(_imp->bitDepth) * _imp->numComps;
 
         nBytes *= ramArgs->bounds.width();
         nBytes *= ramArgs->bounds.height();
 
-        _imp->buffer->resize(nBytes);
+        if (nBytes >= NATRON_RAM_IMAGE_STORAGE_SPARSE_MIN_BYTES) {
+            // Pre-faulting a huge buffer would commit all of it although only a small part may be rendered,
+            // e.g: a shape on a large canvas. Let the OS map zero pages on demand instead.
+            _imp->buffer.reset(new RamBuffer<char>);
+            _imp->buffer->resizeZeroed(nBytes);
+            _imp->sparse = true;
+            _imp->zeroFilled.fetchAndStoreRelease(1);
+        } else {
+            // Take a pre-faulted buffer from the allocator pool if possible
+            _imp->buffer = appPTR->allocateRAMStorageBuffer(nBytes);
+        }
+        _imp->bufferSize = nBytes;
     }
 }
 
@@ -285,7 +316,14 @@ void
 RAMImageStorage::deallocateMemoryImpl()
 {
     if (_imp->buffer) {
+        if (!_imp->sparse) {
+            // Give back the buffer to the allocator pool so it can be re-used without page-faulting
+            appPTR->recycleRAMStorageBuffer(_imp->buffer);
+        }
         _imp->buffer.reset();
+        _imp->bufferSize = 0;
+        _imp->sparse = false;
+        _imp->zeroFilled.fetchAndStoreRelease(0);
     } else if (_imp->externalBuffer) {
         if (_imp->externalBufferFreeFunc) {
             // Call the user provided delete func
@@ -302,7 +340,7 @@ RAMImageStorage::canSoftCopy(const ImageStorageBase& other)
         if (!isRamStorage->_imp->buffer.get() || !_imp->buffer.get()) {
             return false;
         }
-        return isRamStorage->_imp->buffer->size() == _imp->buffer->size();
+        return isRamStorage->_imp->bufferSize == _imp->bufferSize;
     } else {
         return false;
     }
@@ -314,6 +352,10 @@ RAMImageStorage::softCopy(const ImageStorageBase& other)
     const RAMImageStorage* isRamStorage = dynamic_cast<const RAMImageStorage*>(&other);
     if (isRamStorage) {
         _imp->buffer.swap(isRamStorage->_imp->buffer);
+        std::swap(_imp->bufferSize, isRamStorage->_imp->bufferSize);
+        std::swap(_imp->sparse, isRamStorage->_imp->sparse);
+        _imp->zeroFilled.fetchAndStoreRelease(0);
+        isRamStorage->_imp->zeroFilled.fetchAndStoreRelease(0);
     } else {
         assert(false);
     }
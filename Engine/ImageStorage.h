@@ -33,6 +33,10 @@
 
 #include "Engine/EngineFwd.h"
 
+// RAM image buffers of at least this size are allocated sparse, see RAMImageStorage.
+// This is the size above which buffers are not pooled by the StorageAllocatorThread anyway.
+#define NATRON_RAM_IMAGE_STORAGE_SPARSE_MIN_BYTES 67108864 // = 64 * 1024 * 1024
+
 NATRON_NAMESPACE_ENTER
 
 
@@ -205,6 +209,10 @@ public:
 /**
  * @brief Image storaged based in RAM process memory.
  * The allocate() args must be of RAMAllocateMemoryArgs type.
+ *
+ * Buffers of at least NATRON_RAM_IMAGE_STORAGE_SPARSE_MIN_BYTES are sparse: they are not taken from the allocator pool
+ * but allocated zero-filled, so that the OS only commits memory for the pages that are written to. Untouched regions
+ * read as zero and a buffer that was not written to since its allocation does not need to be cleared.
  **/
 struct RAMImageStoragePrivate;
 class RAMImageStorage : public ImageStorageBase
@@ -227,8 +235,18 @@ public:
 
     const char* getData() const;
 
+    /**
+     * @brief Returns a pointer to the buffer to write to. The buffer is no longer considered zero-filled.
+     **/
     char* getData();
 
+    /**
+     * @brief Returns true if the buffer is known to only contain zeros: it was allocated sparse and
+     * the non-const getData() was not called since.
+     * MT-safe
+     **/
+    bool isZeroFilled() const;
+
     virtual bool canSoftCopy(const ImageStorageBase& other) OVERRIDE FINAL;
 
     virtual void softCopy(const ImageStorageBase& other) OVERRIDE FINAL;
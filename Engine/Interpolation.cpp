@@ -71,6 +71,8 @@ hermiteToCubicCoeffs(double P0,
 }
 
 // evaluate at t
+// The polynomials are evaluated with Horner's scheme. Null higher order coefficients (e.g. for linear or
+// constant segments) are skipped, so that an infinite t does not produce NaN on a constant segment.
 static double
 cubicEval(double c0,
           double c1,
@@ -78,11 +80,17 @@ cubicEval(double c0,
           double c3,
           double t)
 {
-    const double t2 = t * t;
-    const double t3 = t2 * t;
-    assert(t == t && t2 == t2 && t3 == t3 && c0 == c0 && c1 == c1 && c2 == c2 && c3 == c3);
+    assert(t == t && c0 == c0 && c1 == c1 && c2 == c2 && c3 == c3);
+
+    if (c3) {
+        return c0 + t * ( c1 + t * (c2 + t * c3) );
+    } else if (c2) {
+        return c0 + t * (c1 + t * c2);
+    } else if (c1) {
+        return c0 + c1 * t;
+    }
 
-    return c0 + (c1 ? c1 * t : 0.) + (c2 ? c2 * t2 : 0.) + (c3 ? c3 * t3 : 0.);
+    return c0;
 }
 
 // integrate from 0 to t
@@ -93,12 +101,17 @@ cubicIntegrate(double c0,
                double c3,
                double t)
 {
-    const double t2 = t * t;
-    const double t3 = t2 * t;
-    const double t4 = t3 * t;
-    assert(t == t && t2 == t2 && t3 == t3 && t4 == t4 && c0 == c0 && c1 == c1 && c2 == c2 && c3 == c3);
+    assert(t == t && c0 == c0 && c1 == c1 && c2 == c2 && c3 == c3);
+
+    if (c3) {
+        return t * ( c0 + t * ( c1 / 2 + t * (c2 * (1. / 3) + t * c3 / 4) ) );
+    } else if (c2) {
+        return t * ( c0 + t * (c1 / 2 + t * c2 * (1. / 3) ) );
+    } else if (c1) {
+        return t * (c0 + t * c1 / 2);
+    }
 
-    return (c0 ? c0 * t : 0.) + (c1 ? c1 * t2 / 2 : 0.) + (c2 ? c2 * t3 * (1./ 3) : 0.) + (c3 ? c3 * t4 / 4 : 0.);
+    return c0 ? c0 * t : 0.;
 }
 
 // derive at t
@@ -109,10 +122,15 @@ cubicDerive(double /*c0*/,
             double c3,
             double t)
 {
-    const double t2 = t * t;
-    assert(t == t && t2 == t2 && c1 == c1 && c2 == c2 && c3 == c3);
+    assert(t == t && c1 == c1 && c2 == c2 && c3 == c3);
+
+    if (c3) {
+        return c1 + t * (2 * c2 + t * 3 * c3);
+    } else if (c2) {
+        return c1 + 2 * c2 * t;
+    }
 
-    return c1 + (c2 ? 2 * c2 * t : 0.) + (c3 ? 3 * c3 * t2 : 0.);
+    return c1;
 }
 
 #define EQN_EPS 1e-9
@@ -410,25 +428,16 @@ Interpolation::solveQuartic(double c0,
     return num;
 } // solveQuartic
 
-/**
- * @brief Interpolates using the control points P0(t0,v0) , P3(t3,v3)
- * and the derivatives P1(t1,v1) (being the derivative at P0 with respect to
- * t \in [t1,t2]) and P2(t2,v2) (being the derivative at P3 with respect to
- * t \in [t1,t2]) the value at 'currentTime' using the
- * interpolation method "interp".
- * Note that for CATMULL-ROM you must use the function interpolate_catmullRom
- * which will compute the derivatives for you.
- **/
-double
-Interpolation::interpolate(double tcur,
-                           const double vcur,              //start control point
-                           const double vcurDerivRight, //being the derivative dv/dt at tcur
-                           const double vnextDerivLeft, //being the derivative dv/dt at tnext
-                           double tnext,
-                           const double vnext,               //end control point
-                           double currentTime,
-                           KeyframeTypeEnum interp,
-                           KeyframeTypeEnum interpNext)
+void
+Interpolation::computeSegment(double tcur,
+                              const double vcur,              //start control point
+                              const double vcurDerivRight, //being the derivative dv/dt at tcur
+                              const double vnextDerivLeft, //being the derivative dv/dt at tnext
+                              double tnext,
+                              const double vnext,               //end control point
+                              KeyframeTypeEnum interp,
+                              KeyframeTypeEnum interpNext,
+                              CubicSegment* segment)
 {
     double P0 = vcur;
     double P3 = vnext;
@@ -436,9 +445,6 @@ Interpolation::interpolate(double tcur,
     double P0pr = vcurDerivRight * (tnext - tcur); // normalize for x \in [0,1]
     double P3pl = vnextDerivLeft * (tnext - tcur); // normalize for x \in [0,1]
 
-    // if the following is true, this makes the special case for eKeyframeTypeConstant at tnext useless, and we can always use a cubic - the strict "currentTime < tnext" is the key
-    // commented-out: the following assert is not true for periodic curves and passing the flag to interpolate would only be required in NDEBUG
-    //assert( ( (interp == eKeyframeTypeNone) || (tcur <= currentTime) ) && ( (currentTime < tnext) || (interpNext == eKeyframeTypeNone) ) );
     // after the last / before the first keyframe, derivatives are wrt currentTime (i.e. non-normalized)
     if (interp == eKeyframeTypeNone) {
         // virtual previous frame at t-1
@@ -456,16 +462,92 @@ Interpolation::interpolate(double tcur,
         P3 = P0 + P0pr;
         tnext = tcur + 1;
     }
-    double c0, c1, c2, c3;
-    hermiteToCubicCoeffs(P0, P0pr, P3pl, P3, &c0, &c1, &c2, &c3);
+    segment->tcur = tcur;
+    segment->tnext = tnext;
+    hermiteToCubicCoeffs(P0, P0pr, P3pl, P3, &segment->c0, &segment->c1, &segment->c2, &segment->c3);
+}
 
-    const double t = (currentTime - tcur) / (tnext - tcur);
-    double ret = cubicEval(c0, c1, c2, c3, t);
+double
+Interpolation::interpolateSegment(const CubicSegment& segment,
+                                  double currentTime)
+{
+    const double t = (currentTime - segment.tcur) / (segment.tnext - segment.tcur);
+
+    return cubicEval(segment.c0, segment.c1, segment.c2, segment.c3, t);
+}
+
+double
+Interpolation::deriveSegment(const CubicSegment& segment,
+                             double currentTime)
+{
+    const double t = (currentTime - segment.tcur) / (segment.tnext - segment.tcur);
 
     // cubicDerive: divide the result by (tnext-tcur)
+    return cubicDerive(segment.c0, segment.c1, segment.c2, segment.c3, t) / (segment.tnext - segment.tcur);
+}
+
+double
+Interpolation::deriveSegment_clamp(const CubicSegment& segment,
+                                   double currentTime,
+                                   double vmin,
+                                   double vmax)
+{
+    const double t = (currentTime - segment.tcur) / (segment.tnext - segment.tcur);
+    double v = cubicEval(segment.c0, segment.c1, segment.c2, segment.c3, t);
+
+    if ( (vmin < v) && (v < vmax) ) {
+        // cubicDerive: divide the result by (tnext-tcur)
+        return cubicDerive(segment.c0, segment.c1, segment.c2, segment.c3, t) / (segment.tnext - segment.tcur);
+    }
+
+    // function is clamped at t, derivative is 0.
+    return 0.;
+}
+
+double
+Interpolation::integrateSegment(const CubicSegment& segment,
+                                TimeValue time1,
+                                TimeValue time2)
+{
+    const double t2 = (time2 - segment.tcur) / (segment.tnext - segment.tcur);
+    double ret = cubicIntegrate(segment.c0, segment.c1, segment.c2, segment.c3, t2);
+
+    if (time1 != segment.tcur) {
+        const double t1 = (time1 - segment.tcur) / (segment.tnext - segment.tcur);
+        ret -= cubicIntegrate(segment.c0, segment.c1, segment.c2, segment.c3, t1);
+    }
 
     // cubicIntegrate: multiply the result by (tnext-tcur)
-    return ret;
+    return ret * (segment.tnext - segment.tcur);
+}
+
+/**
+ * @brief Interpolates using the control points P0(t0,v0) , P3(t3,v3)
+ * and the derivatives P1(t1,v1) (being the derivative at P0 with respect to
+ * t \in [t1,t2]) and P2(t2,v2) (being the derivative at P3 with respect to
+ * t \in [t1,t2]) the value at 'currentTime' using the
+ * interpolation method "interp".
+ * Note that for CATMULL-ROM you must use the function interpolate_catmullRom
+ * which will compute the derivatives for you.
+ **/
+double
+Interpolation::interpolate(double tcur,
+                           const double vcur,              //start control point
+                           const double vcurDerivRight, //being the derivative dv/dt at tcur
+                           const double vnextDerivLeft, //being the derivative dv/dt at tnext
+                           double tnext,
+                           const double vnext,               //end control point
+                           double currentTime,
+                           KeyframeTypeEnum interp,
+                           KeyframeTypeEnum interpNext)
+{
+    // if the following is true, this makes the special case for eKeyframeTypeConstant at tnext useless, and we can always use a cubic - the strict "currentTime < tnext" is the key
+    // commented-out: the following assert is not true for periodic curves and passing the flag to interpolate would only be required in NDEBUG
+    //assert( ( (interp == eKeyframeTypeNone) || (tcur <= currentTime) ) && ( (currentTime < tnext) || (interpNext == eKeyframeTypeNone) ) );
+    CubicSegment segment;
+    computeSegment(tcur, vcur, vcurDerivRight, vnextDerivLeft, tnext, vnext, interp, interpNext, &segment);
+
+    return interpolateSegment(segment, currentTime);
 }
 
 /// derive at currentTime. The derivative is with respect to currentTime
@@ -480,41 +562,12 @@ Interpolation::derive(double tcur,
                       KeyframeTypeEnum interp,
                       KeyframeTypeEnum interpNext)
 {
-    double P0 = vcur;
-    double P3 = vnext;
-    // Hermite coefficients P0' and P3' are the derivatives with respect to x \in [0,1]
-    double P0pr = vcurDerivRight * (tnext - tcur); // normalize for x \in [0,1]
-    double P3pl = vnextDerivLeft * (tnext - tcur); // normalize for x \in [0,1]
-
     // if the following is true, this makes the special case for eKeyframeTypeConstant at tnext useless, and we can always use a cubic - the strict "currentTime < tnext" is the key
     assert( ( (interp == eKeyframeTypeNone) || (tcur <= currentTime) ) && ( (currentTime < tnext) || (interpNext == eKeyframeTypeNone) ) );
-    // after the last / before the first keyframe, derivatives are wrt currentTime (i.e. non-normalized)
-    if (interp == eKeyframeTypeNone) {
-        // virtual previous frame at t-1
-        P0 = P3 - P3pl;
-        P0pr = P3pl;
-        tcur = tnext - 1.;
-    } else if (interp == eKeyframeTypeConstant) {
-        P0pr = 0.;
-        P3pl = 0.;
-        P3 = P0;
-    }
-    if (interpNext == eKeyframeTypeNone) {
-        // virtual next frame at t+1
-        P3pl = P0pr;
-        P3 = P0 + P0pr;
-        tnext = tcur + 1;
-    }
-    double c0, c1, c2, c3;
-    hermiteToCubicCoeffs(P0, P0pr, P3pl, P3, &c0, &c1, &c2, &c3);
-
-    const double t = (currentTime - tcur) / (tnext - tcur);
-    double ret = cubicDerive(c0, c1, c2, c3, t);
+    CubicSegment segment;
+    computeSegment(tcur, vcur, vcurDerivRight, vnextDerivLeft, tnext, vnext, interp, interpNext, &segment);
 
-    // cubicDerive: divide the result by (tnext-tcur)
-
-    // cubicIntegrate: multiply the result by (tnext-tcur)
-    return ret / (tnext - tcur);
+    return deriveSegment(segment, currentTime);
 }
 
 /// interpolate and derive at currentTime. The derivative is with respect to currentTime
@@ -531,43 +584,12 @@ Interpolation::derive_clamp(double tcur,
                             KeyframeTypeEnum interp,
                             KeyframeTypeEnum interpNext)
 {
-    double P0 = vcur;
-    double P3 = vnext;
-    // Hermite coefficients P0' and P3' are the derivatives with respect to x \in [0,1]
-    double P0pr = vcurDerivRight * (tnext - tcur); // normalize for x \in [0,1]
-    double P3pl = vnextDerivLeft * (tnext - tcur); // normalize for x \in [0,1]
-
     // if the following is true, this makes the special case for eKeyframeTypeConstant at tnext useless, and we can always use a cubic - the strict "currentTime < tnext" is the key
     assert( ( (interp == eKeyframeTypeNone) || (tcur <= currentTime) ) && ( (currentTime < tnext) || (interpNext == eKeyframeTypeNone) ) );
-    // after the last / before the first keyframe, derivatives are wrt currentTime (i.e. non-normalized)
-    if (interp == eKeyframeTypeNone) {
-        // virtual previous frame at t-1
-        P0 = P3 - P3pl;
-        P0pr = P3pl;
-        tcur = tnext - 1.;
-    } else if (interp == eKeyframeTypeConstant) {
-        P0pr = 0.;
-        P3pl = 0.;
-        P3 = P0;
-    }
-    if (interpNext == eKeyframeTypeNone) {
-        // virtual next frame at t+1
-        P3pl = P0pr;
-        P3 = P0 + P0pr;
-        tnext = tcur + 1;
-    }
-    double c0, c1, c2, c3;
-    hermiteToCubicCoeffs(P0, P0pr, P3pl, P3, &c0, &c1, &c2, &c3);
+    CubicSegment segment;
+    computeSegment(tcur, vcur, vcurDerivRight, vnextDerivLeft, tnext, vnext, interp, interpNext, &segment);
 
-    const double t = (currentTime - tcur) / (tnext - tcur);
-    double v = cubicEval(c0, c1, c2, c3, t);
-    if ( (vmin < v) && (v < vmax) ) {
-        // cubicDerive: divide the result by (tnext-tcur)
-        return cubicDerive(c0, c1, c2, c3, t) / (tnext - tcur);
-    }
-
-    // function is clamped at t, derivative is 0.
-    return 0.;
+    return deriveSegment_clamp(segment, currentTime, vmin, vmax);
 }
 
 // integrate from time1 to time2
@@ -583,44 +605,12 @@ Interpolation::integrate(double tcur,
                          KeyframeTypeEnum interp,
                          KeyframeTypeEnum interpNext)
 {
-    double P0 = vcur;
-    double P3 = vnext;
-    // Hermite coefficients P0' and P3' are the derivatives with respect to x \in [0,1]
-    double P0pr = vcurDerivRight * (tnext - tcur); // normalize for x \in [0,1]
-    double P3pl = vnextDerivLeft * (tnext - tcur); // normalize for x \in [0,1]
-
     // in the next expression, the correct test is t2 <= tnext (not <), in order to integrate from tcur to tnext
     assert( ( (interp == eKeyframeTypeNone) || (tcur <= time1) ) && (time1 <= time2) && ( (time2 <= tnext) || (interpNext == eKeyframeTypeNone) ) );
-    // after the last / before the first keyframe, derivatives are wrt currentTime (i.e. non-normalized)
-    if (interp == eKeyframeTypeNone) {
-        // virtual previous frame at t-1
-        P0 = P3 - P3pl;
-        P0pr = P3pl;
-        tcur = tnext - 1.;
-    } else if (interp == eKeyframeTypeConstant) {
-        P0pr = 0.;
-        P3pl = 0.;
-        P3 = P0;
-    }
-    if (interpNext == eKeyframeTypeNone) {
-        // virtual next frame at t+1
-        P3pl = P0pr;
-        P3 = P0 + P0pr;
-        tnext = tcur + 1;
-    }
-    double c0, c1, c2, c3;
-    hermiteToCubicCoeffs(P0, P0pr, P3pl, P3, &c0, &c1, &c2, &c3);
-
-    const double t2 = (time2 - tcur) / (tnext - tcur);
-    double ret = cubicIntegrate(c0, c1, c2, c3, t2);
-    if (time1 != tcur) {
-        const double t1 = (time1 - tcur) / (tnext - tcur);
-        ret -= cubicIntegrate(c0, c1, c2, c3, t1);
-    }
-    // cubicDerive: divide the result by (tnext-tcur)
+    CubicSegment segment;
+    computeSegment(tcur, vcur, vcurDerivRight, vnextDerivLeft, tnext, vnext, interp, interpNext, &segment);
 
-    // cubicIntegrate: multiply the result by (tnext-tcur)
-    return ret * (tnext - tcur);
+    return integrateSegment(segment, time1, time2);
 }
 
 NATRON_NAMESPACE_ANONYMOUS_ENTER
@@ -710,61 +700,22 @@ statusUpdate(FuncTypeEnum status,
     return status;
 }
 
-// integrate from time1 to time2 with clamping of the function values in [vmin,vmax]
+// integrate the segment from time1 to time2 with clamping of the function values in [vmin,vmax]
 double
-Interpolation::integrate_clamp(double tcur,
-                               const double vcur,              //start control point
-                               const double vcurDerivRight, //being the derivative dv/dt at tcur
-                               const double vnextDerivLeft, //being the derivative dv/dt at tnext
-                               double tnext,
-                               const double vnext,               //end control point
-                               TimeValue time1,
-                               TimeValue time2,
-                               double vmin,
-                               double vmax,
-                               KeyframeTypeEnum interp,
-                               KeyframeTypeEnum interpNext)
+Interpolation::integrateSegment_clamp(const CubicSegment& segment,
+                                      TimeValue time1,
+                                      TimeValue time2,
+                                      double vmin,
+                                      double vmax)
 {
     if ( vmin == -std::numeric_limits<double>::infinity() &&
          vmax == +std::numeric_limits<double>::infinity() ) {
-        return integrate(tcur,
-                         vcur,              //start control point
-                         vcurDerivRight, //being the derivative dv/dt at tcur
-                         vnextDerivLeft, //being the derivative dv/dt at tnext
-                         tnext,
-                         vnext,               //end control point
-                         time1,
-                         time2,
-                         interp,
-                         interpNext);
-    }
-    double P0 = vcur;
-    double P3 = vnext;
-    // Hermite coefficients P0' and P3' are the derivatives with respect to x \in [0,1]
-    double P0pr = vcurDerivRight * (tnext - tcur); // normalize for x \in [0,1]
-    double P3pl = vnextDerivLeft * (tnext - tcur); // normalize for x \in [0,1]
-
-    // in the next expression, the correct test is t2 <= tnext (not <), in order to integrate from tcur to tnext
-    assert( ( (interp == eKeyframeTypeNone) || (tcur <= time1) ) && (time1 <= time2) && ( (time2 <= tnext) || (interpNext == eKeyframeTypeNone) ) );
-    // after the last / before the first keyframe, derivatives are wrt currentTime (i.e. non-normalized)
-    if (interp == eKeyframeTypeNone) {
-        // virtual previous frame at t-1
-        P0 = P3 - P3pl;
-        P0pr = P3pl;
-        tcur = tnext - 1.;
-    } else if (interp == eKeyframeTypeConstant) {
-        P0pr = 0.;
-        P3pl = 0.;
-        P3 = P0;
-    }
-    if (interpNext == eKeyframeTypeNone) {
-        // virtual next frame at t+1
-        P3pl = P0pr;
-        P3 = P0 + P0pr;
-        tnext = tcur + 1;
+        return integrateSegment(segment, time1, time2);
     }
-    double c0, c1, c2, c3;
-    hermiteToCubicCoeffs(P0, P0pr, P3pl, P3, &c0, &c1, &c2, &c3);
+    const double c0 = segment.c0;
+    const double c1 = segment.c1;
+    const double c2 = segment.c2;
+    const double c3 = segment.c3;
 
     // solve cubic = vmax
     double tmax[3];
@@ -790,8 +741,8 @@ Interpolation::integrate_clamp(double tcur,
         sols.push_back( Sol(eSolTypeMin, tmin[i], omin[i], deriv) );
     }
 
-    const double t2 = (time2 - tcur) / (tnext - tcur);
-    const double t1 = (time1 - tcur) / (tnext - tcur);
+    const double t2 = (time2 - segment.tcur) / (segment.tnext - segment.tcur);
+    const double t1 = (time1 - segment.tcur) / (segment.tnext - segment.tcur);
 
     // special case: no solution, do the same as Interpolation::integrate()
     if ( sols.empty() ) {
@@ -801,13 +752,13 @@ Interpolation::integrate_clamp(double tcur,
         // - or it' constant
 
         double ret = cubicIntegrate(c0, c1, c2, c3, t2);
-        if (time1 != tcur) {
+        if (time1 != segment.tcur) {
             ret -= cubicIntegrate(c0, c1, c2, c3, t1);
         }
         // cubicDerive: divide the result by (tnext-tcur)
 
         // cubicIntegrate: multiply the result by (tnext-tcur)
-        return ret * (tnext - tcur);
+        return ret * (segment.tnext - segment.tcur);
     }
 
     // sort the solutions wrt time
@@ -864,7 +815,30 @@ Interpolation::integrate_clamp(double tcur,
     }
 
     // cubicIntegrate: multiply the result by (tnext-tcur)
-    return ret * (tnext - tcur);
+    return ret * (segment.tnext - segment.tcur);
+} // integrateSegment_clamp
+
+// integrate from time1 to time2 with clamping of the function values in [vmin,vmax]
+double
+Interpolation::integrate_clamp(double tcur,
+                               const double vcur,              //start control point
+                               const double vcurDerivRight, //being the derivative dv/dt at tcur
+                               const double vnextDerivLeft, //being the derivative dv/dt at tnext
+                               double tnext,
+                               const double vnext,               //end control point
+                               TimeValue time1,
+                               TimeValue time2,
+                               double vmin,
+                               double vmax,
+                               KeyframeTypeEnum interp,
+                               KeyframeTypeEnum interpNext)
+{
+    // in the next expression, the correct test is t2 <= tnext (not <), in order to integrate from tcur to tnext
+    assert( ( (interp == eKeyframeTypeNone) || (tcur <= time1) ) && (time1 <= time2) && ( (time2 <= tnext) || (interpNext == eKeyframeTypeNone) ) );
+    CubicSegment segment;
+    computeSegment(tcur, vcur, vcurDerivRight, vnextDerivLeft, tnext, vnext, interp, interpNext, &segment);
+
+    return integrateSegment_clamp(segment, time1, time2, vmin, vmax);
 } // integrate_clamp
 
 /**
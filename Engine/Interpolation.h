@@ -35,6 +35,55 @@
 NATRON_NAMESPACE_ENTER
 
 namespace Interpolation {
+/**
+ * @brief The cubic polynomial c0 + c1 * x + c2 * x^2 + c3 * x^3 interpolating a curve between the times tcur and tnext,
+ * with x = (t - tcur) / (tnext - tcur).
+ * It only depends on the two keyframes around the segment, so it can be computed once when keyframes change
+ * and re-used for every evaluation.
+ **/
+struct CubicSegment
+{
+    double tcur, tnext;
+    double c0, c1, c2, c3;
+
+    CubicSegment()
+    : tcur(0.)
+    , tnext(1.)
+    , c0(0.)
+    , c1(0.)
+    , c2(0.)
+    , c3(0.)
+    {
+    }
+};
+
+/**
+ * @brief Computes the polynomial of the segment between the control points P0(tcur,vcur) and P3(tnext,vnext).
+ * The parameters are the same as the ones of interpolate().
+ **/
+void computeSegment(double tcur, const double vcur, //start control point
+                    const double vcurDerivRight, //being the derivative dv/dt at tcur
+                    const double vnextDerivLeft, //being the derivative dv/dt at tnext
+                    double tnext, const double vnext, //end control point
+                    KeyframeTypeEnum interp,
+                    KeyframeTypeEnum interpNext,
+                    CubicSegment* segment);
+
+/// interpolate the segment at currentTime
+double interpolateSegment(const CubicSegment& segment, double currentTime) WARN_UNUSED_RETURN;
+
+/// derive the segment at currentTime. The derivative is with respect to currentTime
+double deriveSegment(const CubicSegment& segment, double currentTime) WARN_UNUSED_RETURN;
+
+/// derive the segment at currentTime. The derivative is with respect to currentTime. The function is clamped between vmin an vmax.
+double deriveSegment_clamp(const CubicSegment& segment, double currentTime, double vmin, double vmax) WARN_UNUSED_RETURN;
+
+/// integrate the segment from time1 to time2
+double integrateSegment(const CubicSegment& segment, TimeValue time1, TimeValue time2) WARN_UNUSED_RETURN;
+
+/// integrate the segment from time1 to time2. The function is clamped between vmin an vmax.
+double integrateSegment_clamp(const CubicSegment& segment, TimeValue time1, TimeValue time2, double vmin, double vmax) WARN_UNUSED_RETURN;
+
 /**
  * @brief Interpolates using the control points P0(t0,v0) , P3(t3,v3)
  * and the derivatives P1(t1,v1) (being the derivative at P0 with respect to
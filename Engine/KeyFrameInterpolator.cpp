@@ -50,25 +50,35 @@ KeyFrameInterpolator::~KeyFrameInterpolator()
 
 }
 
-void
-KeyFrameInterpolator::ensureIteratorInPeriod(TimeValue xMin,
-                                             TimeValue xMax,
-                                             const KeyFrameSet& keyFrames,
-                                             TimeValue *t,
-                                             KeyFrameSet::const_iterator *itup)
+TimeValue
+KeyFrameInterpolator::getTimeInPeriod(TimeValue xMin,
+                                      TimeValue xMax,
+                                      const KeyFrameSet& keyFrames,
+                                      TimeValue t)
 {
     const double period = xMax - xMin;
 
     double minKeyFrameX = keyFrames.begin()->getTime() + xMin;
     assert(xMin < xMax);
-    if (*t < minKeyFrameX || *t > minKeyFrameX + period) {
+    if (t < minKeyFrameX || t > minKeyFrameX + period) {
         // This will bring t either in minTime <= t <= maxTime or t in the range minTime - (maxTime - minTime) < t < minTime
-        *t = TimeValue(std::fmod(*t - minKeyFrameX, period ) + minKeyFrameX);
-        if (*t < minKeyFrameX) {
-            *t = TimeValue(*t + period);
+        t = TimeValue(std::fmod(t - minKeyFrameX, period ) + minKeyFrameX);
+        if (t < minKeyFrameX) {
+            t = TimeValue(t + period);
         }
-        assert(*t >= minKeyFrameX && *t <= minKeyFrameX + period);
+        assert(t >= minKeyFrameX && t <= minKeyFrameX + period);
     }
+    return t;
+}
+
+void
+KeyFrameInterpolator::ensureIteratorInPeriod(TimeValue xMin,
+                                             TimeValue xMax,
+                                             const KeyFrameSet& keyFrames,
+                                             TimeValue *t,
+                                             KeyFrameSet::const_iterator *itup)
+{
+    *t = getTimeInPeriod(xMin, xMax, keyFrames, *t);
     *itup = keyFrames.upper_bound(KeyFrame(*t, 0.));
 
 }
@@ -86,12 +96,29 @@ KeyFrameInterpolator::interParams(const KeyFrameSet &keyFrames,
 
     assert(keyFrames.size() >= 1);
     assert( itup == keyFrames.end() || *t < itup->getTime() );
-    double period = xMax - xMin;
 
     if (isPeriodic) {
         ensureIteratorInPeriod(TimeValue(xMin), TimeValue(xMax), keyFrames, t, &itup);
     }
 
+    getSegmentKeyFrames(keyFrames, isPeriodic, xMin, xMax, itup, kCur, kNext);
+
+    // between two keyframes, kCur is the last keyframe with time <= t
+    assert( itup == keyFrames.begin() || itup == keyFrames.end() || kCur->getTime() <= *t );
+} // interParams
+
+void
+KeyFrameInterpolator::getSegmentKeyFrames(const KeyFrameSet &keyFrames,
+                                          bool isPeriodic,
+                                          double xMin,
+                                          double xMax,
+                                          KeyFrameSet::const_iterator itup,
+                                          KeyFrame* kCur,
+                                          KeyFrame* kNext)
+{
+    assert(keyFrames.size() >= 1);
+    double period = xMax - xMin;
+
     if ( itup == keyFrames.begin() ) {
         // We are in the case where all keys have a greater time
         *kNext = *itup;
@@ -132,11 +159,10 @@ KeyFrameInterpolator::interParams(const KeyFrameSet &keyFrames,
         // get the last keyframe with time <= t
         KeyFrameSet::const_iterator itcur = itup;
         --itcur;
-        assert(itcur->getTime() <= *t);
         *kCur = *itcur;
         *kNext = *itup;
     }
-} // interParams
+} // getSegmentKeyFrames
 
 KeyFrame
 KeyFrameInterpolator::interpolate(TimeValue t,
@@ -43,6 +43,23 @@ public:
 
     virtual KeyFrameInterpolatorPtr createCopy() const;
 
+    /**
+     * @brief Returns true if interpolate() only evaluates the cubic polynomial of the segment around t, i.e:
+     * the result can be computed from the segments precomputed by the curve.
+     **/
+    virtual bool isCubicInterpolator() const
+    {
+        return true;
+    }
+
+    /**
+     * @brief For a periodic curve, returns t brought back in the periodic range
+     **/
+    static TimeValue getTimeInPeriod(TimeValue xmin,
+                                     TimeValue xmax,
+                                     const KeyFrameSet& keyframes,
+                                     TimeValue t);
+
     /**
      * @brief For a periodic curve, ensure t and the iterator point to keyframes in the periodic range
      **/
@@ -64,6 +81,19 @@ public:
                             KeyFrameSet::const_iterator itup,
                             KeyFrame* kCur,
                             KeyFrame* kNext);
+
+    /**
+     * @brief Returns the keyframes around the segment ending at itup (the first keyframe with time > t).
+     * This is the part of interParams() that does not depend on t: for a periodic curve itup must
+     * already be in the periodic range.
+     **/
+    static void getSegmentKeyFrames(const KeyFrameSet &keyFrames,
+                                    bool isPeriodic,
+                                    double xMin,
+                                    double xMax,
+                                    KeyFrameSet::const_iterator itup,
+                                    KeyFrame* kCur,
+                                    KeyFrame* kNext);
     
     /**
      * @brief Interpolate the given keyframe 
@@ -104,6 +134,11 @@ public:
 
     virtual KeyFrameInterpolatorPtr createCopy() const OVERRIDE;
 
+    virtual bool isCubicInterpolator() const OVERRIDE FINAL
+    {
+        return false;
+    }
+
     virtual KeyFrame interpolate(TimeValue t,
                                  KeyFrameSet::const_iterator itup,
                                  const KeyFrameSet& keyframes,
@@ -5524,9 +5524,56 @@ KnobHolder::updateHasAnimation()
     _imp->common->hasAnimation = hasAnimation;
 }
 
+/**
+ * @brief Returns true if the hash of the knob for the given view may change over time
+ **/
+static bool
+isKnobHashTimeVariant(const KnobIPtr& knob, ViewIdx view)
+{
+    int nDims = knob->getNDimensions();
+    for (int i = 0; i < nDims; ++i) {
+        if ( knob->isAnimated(DimIdx(i), view) || knob->hasExpression(DimIdx(i), view) ) {
+            return true;
+        }
+    }
+    return false;
+}
+
 void
 KnobHolder::appendToHash(const ComputeHashArgs& args, Hash64* hash)
 {
+    if ( (args.hashType == eComputeHashTypeTimeViewVariant) && isHashCachingEnabled() ) {
+        // Most knobs are not animated: their hash is computed once per view and cached until a knob changes.
+        // Only animated knobs and knobs with an expression are hashed again at each time.
+        TimeInvariantHashPart part;
+        if ( !findCachedTimeInvariantHashPart(args.view, &part) ) {
+            Hash64 timeInvariantHash;
+            KnobsVec knobs = getKnobs_mt_safe();
+            for (KnobsVec::const_iterator it = knobs.begin(); it!=knobs.end(); ++it) {
+                if (!(*it)->getEvaluateOnChange()) {
+                    continue;
+                }
+                if ( isKnobHashTimeVariant(*it, args.view) ) {
+                    part.timeVariantObjects.push_back(*it);
+                } else {
+                    timeInvariantHash.append( (*it)->computeHash(args) );
+                }
+            }
+            timeInvariantHash.computeHash();
+            part.hash = timeInvariantHash.value();
+            setCachedTimeInvariantHashPart(args.view, part);
+        }
+
+        hash->append(part.hash);
+        for (std::vector<HashableObjectWPtr>::const_iterator it = part.timeVariantObjects.begin(); it != part.timeVariantObjects.end(); ++it) {
+            HashableObjectPtr knob = it->lock();
+            if (knob) {
+                hash->append( knob->computeHash(args) );
+            }
+        }
+        return;
+    }
+
     KnobsVec knobs = getKnobs_mt_safe();
     for (KnobsVec::const_iterator it = knobs.begin(); it!=knobs.end(); ++it) {
         if (!(*it)->getEvaluateOnChange()) {
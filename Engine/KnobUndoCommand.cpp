@@ -789,13 +789,42 @@ MultipleKnobEditsUndoCommand::mergeWith(const UndoCommandPtr &command)
         } else {
             // copy the other dimension of that knob which changed and set the dimension to -1 so
             // that subsequent calls to undo() and redo() clone all dimensions at once
-            foundExistinKnob->second.insert( foundExistinKnob->second.end(), otherIt->second.begin(), otherIt->second.end() );
+            for (std::list<ValueToSet>::const_iterator it2 = otherIt->second.begin(); it2 != otherIt->second.end(); ++it2) {
+                bool dimensionAlreadyEdited = false;
+                for (std::list<ValueToSet>::const_iterator it3 = foundExistinKnob->second.begin(); it3 != foundExistinKnob->second.end(); ++it3) {
+                    if ( (int)it3->dimension == (int)it2->dimension ) {
+                        dimensionAlreadyEdited = true;
+                        break;
+                    }
+                }
+                foundExistinKnob->second.push_back(*it2);
+                if (dimensionAlreadyEdited) {
+                    // undo() only restores the old values of the first edit of each dimension: do not keep
+                    // a copy of the animation for each subsequent edit, only the new value.
+                    foundExistinKnob->second.back().oldValues.clear();
+                }
+            }
         }
     }
 
     return true;
 }
 
+std::size_t
+MultipleKnobEditsUndoCommand::getMemoryCost() const
+{
+    std::size_t ret = UndoCommand::getMemoryCost() + sizeof(MultipleKnobEditsUndoCommand) - sizeof(UndoCommand);
+    for (ParamsMap::const_iterator it = knobs.begin(); it != knobs.end(); ++it) {
+        for (std::list<ValueToSet>::const_iterator it2 = it->second.begin(); it2 != it->second.end(); ++it2) {
+            ret += sizeof(ValueToSet);
+            for (PerDimViewKeyFramesMap::const_iterator it3 = it2->oldValues.begin(); it3 != it2->oldValues.end(); ++it3) {
+                ret += it3->second.size() * sizeof(KeyFrame);
+            }
+        }
+    }
+    return ret;
+}
+
 RestoreDefaultsCommand::RestoreDefaultsCommand(const std::list<KnobIPtr > & knobs,
                                                DimSpec targetDim,
                                                ViewSetSpec targetView)
@@ -217,6 +217,13 @@ private:
         return true;
     }
 
+    virtual std::size_t getMemoryCost() const OVERRIDE FINAL
+    {
+        return UndoCommand::getMemoryCost() + sizeof(KnobUndoCommand) - sizeof(UndoCommand) +
+               (_oldValue.capacity() + _newValue.capacity()) * sizeof(T) +
+               _valueChangedReturnCode.capacity() * sizeof(ValueChangedReturnCodeEnum);
+    }
+
 private:
 
     void refreshAnimationModuleSelectedKeyframe()
@@ -356,6 +363,7 @@ public:
     virtual void undo() OVERRIDE FINAL;
     virtual void redo() OVERRIDE FINAL;
     virtual bool mergeWith(const UndoCommandPtr& command) OVERRIDE FINAL;
+    virtual std::size_t getMemoryCost() const OVERRIDE FINAL;
 };
 
 struct PasteKnobClipBoardUndoCommandPrivate;
@@ -52,6 +52,7 @@ GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 
 #include "Engine/AppManager.h"
 #include "Engine/EffectInstance.h"
+#include "Engine/GPUContextPool.h"
 #include "Engine/Node.h"
 #include "Engine/Settings.h"
 #include "Engine/TLSHolder.h"
@@ -606,7 +607,11 @@ MultiThread::getNCPUsAvailable(const EffectInstancePtr& /*effect*/)
     // maxThreadCount() is set by the setting the preferences
     const int maxThreadsCount = std::max(1,QThreadPool::globalInstance()->maxThreadCount());
 
-    int ret = std::max(1, maxThreadsCount - activeThreadsCount);
+    // The llvmpipe rasterizer threads of the OSMesa contexts in use are not thread pool threads but still occupy CPUs
+    GPUContextPool* contextPool = appPTR->getGPUContextPool();
+    const int busyRasterizerThreadsCount = contextPool ? contextPool->getNBusyRasterizerThreads() : 0;
+
+    int ret = std::max(1, maxThreadsCount - activeThreadsCount - busyRasterizerThreadsCount);
     return ret;
 #if 0
     // If the effect is currently rendering and it is the first render in the TreeRenderQueueManager priority list
@@ -1561,6 +1561,103 @@ static PyObject* Sbk_EffectFunc_removeParamFromViewerUI(PyObject* self, PyObject
         return 0;
 }
 
+static PyObject* Sbk_EffectFunc_renderPlane(PyObject* self, PyObject* args, PyObject* kwds)
+{
+    ::Effect* cppSelf = 0;
+    SBK_UNUSED(cppSelf)
+    if (!Shiboken::Object::isValid(self))
+        return 0;
+    cppSelf = ((::Effect*)Shiboken::Conversions::cppPointer(SbkNatronEngineTypes[SBK_EFFECT_IDX], (SbkObject*)self));
+    PyObject* pyResult = 0;
+    int overloadId = -1;
+    PythonToCppFunc pythonToCpp[] = { 0, 0, 0, 0 };
+    SBK_UNUSED(pythonToCpp)
+    int numNamedArgs = (kwds ? PyDict_Size(kwds) : 0);
+    int numArgs = PyTuple_GET_SIZE(args);
+    PyObject* pyArgs[] = {0, 0, 0, 0};
+
+    // invalid argument lengths
+    if (numArgs + numNamedArgs > 4) {
+        PyErr_SetString(PyExc_TypeError, "NatronEngine.Effect.renderPlane(): too many arguments");
+        return 0;
+    } else if (numArgs < 3) {
+        PyErr_SetString(PyExc_TypeError, "NatronEngine.Effect.renderPlane(): not enough arguments");
+        return 0;
+    }
+
+    if (!PyArg_ParseTuple(args, "|OOOO:renderPlane", &(pyArgs[0]), &(pyArgs[1]), &(pyArgs[2]), &(pyArgs[3])))
+        return 0;
+
+
+    // Overloaded function decisor
+    // 0: renderPlane(double,int,ImageLayer,int)const
+    if ((pythonToCpp[0] = Shiboken::Conversions::isPythonToCppConvertible(Shiboken::Conversions::PrimitiveTypeConverter<double>(), (pyArgs[0])))
+        && (pythonToCpp[1] = Shiboken::Conversions::isPythonToCppConvertible(Shiboken::Conversions::PrimitiveTypeConverter<int>(), (pyArgs[1])))
+        && (pythonToCpp[2] = Shiboken::Conversions::isPythonToCppReferenceConvertible((SbkObjectType*)SbkNatronEngineTypes[SBK_IMAGELAYER_IDX], (pyArgs[2])))) {
+        if (numArgs == 3) {
+            overloadId = 0; // renderPlane(double,int,ImageLayer,int)const
+        } else if ((pythonToCpp[3] = Shiboken::Conversions::isPythonToCppConvertible(Shiboken::Conversions::PrimitiveTypeConverter<int>(), (pyArgs[3])))) {
+            overloadId = 0; // renderPlane(double,int,ImageLayer,int)const
+        }
+    }
+
+    // Function signature not found.
+    if (overloadId == -1) goto Sbk_EffectFunc_renderPlane_TypeError;
+
+    // Call function/method
+    {
+        if (kwds) {
+            PyObject* value = PyDict_GetItemString(kwds, "mipMapLevel");
+            if (value && pyArgs[3]) {
+                PyErr_SetString(PyExc_TypeError, "NatronEngine.Effect.renderPlane(): got multiple values for keyword argument 'mipMapLevel'.");
+                return 0;
+            } else if (value) {
+                pyArgs[3] = value;
+                if (!(pythonToCpp[3] = Shiboken::Conversions::isPythonToCppConvertible(Shiboken::Conversions::PrimitiveTypeConverter<int>(), (pyArgs[3]))))
+                    goto Sbk_EffectFunc_renderPlane_TypeError;
+            }
+        }
+        double cppArg0;
+        pythonToCpp[0](pyArgs[0], &cppArg0);
+        int cppArg1;
+        pythonToCpp[1](pyArgs[1], &cppArg1);
+        if (!Shiboken::Object::isValid(pyArgs[2]))
+            return 0;
+        ::ImageLayer cppArg2_local = ::ImageLayer(::QString(), ::QString(), ::QStringList());
+        ::ImageLayer* cppArg2 = &cppArg2_local;
+        if (Shiboken::Conversions::isImplicitConversion((SbkObjectType*)SbkNatronEngineTypes[SBK_IMAGELAYER_IDX], pythonToCpp[2]))
+            pythonToCpp[2](pyArgs[2], &cppArg2_local);
+        else
+            pythonToCpp[2](pyArgs[2], &cppArg2);
+
+        int cppArg3 = 0;
+        if (pythonToCpp[3]) pythonToCpp[3](pyArgs[3], &cppArg3);
+
+        if (!PyErr_Occurred()) {
+            // renderPlane(double,int,ImageLayer,int)const
+            // Begin code injection
+
+            // renderPlane returns a new reference, or NULL with the Python error set
+            pyResult = const_cast<const ::Effect*>(cppSelf)->renderPlane(cppArg0, cppArg1, *cppArg2, cppArg3);
+
+            // End of code injection
+
+
+        }
+    }
+
+    if (PyErr_Occurred() || !pyResult) {
+        Py_XDECREF(pyResult);
+        return 0;
+    }
+    return pyResult;
+
+    Sbk_EffectFunc_renderPlane_TypeError:
+        const char* overloads[] = {"float, int, NatronEngine.ImageLayer, int = 0", 0};
+        Shiboken::setErrorAboutWrongArguments(args, "NatronEngine.Effect.renderPlane", overloads);
+        return 0;
+}
+
 static PyObject* Sbk_EffectFunc_setColor(PyObject* self, PyObject* args)
 {
     ::Effect* cppSelf = 0;
@@ -1952,6 +2049,7 @@ static PyMethodDef Sbk_Effect_methods[] = {
     {"registerOverlay", (PyCFunction)Sbk_EffectFunc_registerOverlay, METH_VARARGS},
     {"removeOverlay", (PyCFunction)Sbk_EffectFunc_removeOverlay, METH_O},
     {"removeParamFromViewerUI", (PyCFunction)Sbk_EffectFunc_removeParamFromViewerUI, METH_O},
+    {"renderPlane", (PyCFunction)Sbk_EffectFunc_renderPlane, METH_VARARGS|METH_KEYWORDS},
     {"setColor", (PyCFunction)Sbk_EffectFunc_setColor, METH_VARARGS},
     {"setLabel", (PyCFunction)Sbk_EffectFunc_setLabel, METH_O},
     {"setPagesOrder", (PyCFunction)Sbk_EffectFunc_setPagesOrder, METH_O},
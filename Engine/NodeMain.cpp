@@ -981,6 +981,7 @@ Node::loadKnobsFromSerialization(const SERIALIZATION_NAMESPACE::NodeSerializatio
 
         }
 
+        _imp->effect->loadLegacyForceCaching();
 
     }
 
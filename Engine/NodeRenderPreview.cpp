@@ -295,6 +295,7 @@ Node::makePreviewImage(TimeValue time,
         args->proxyScale = RenderScale(1.);
         args->draftMode = false;
         args->playback = false;
+        args->cachePriority = eCacheEntryPriorityPreview;
         args->byPassCache = false;
     }
 
@@ -28,6 +28,8 @@
 #include <sstream> // stringstream
 #include <cstring> // strlen
 
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDateTime>
 #include <QtCore/QDebug>
 #include <QtCore/QMutex>
 #include <QtCore/QWaitCondition>
@@ -48,6 +50,7 @@
 
 #include "Engine/AppManager.h"
 #include "Engine/GPUContextPool.h"
+#include "Engine/Settings.h"
 
 #include "Global/GLIncludes.h"
 
@@ -314,6 +317,11 @@ struct OSGLContextPrivate
     std::vector<GLShaderBasePtr> applyMaskMixShader;
     std::vector<GLShaderBasePtr> copyUnprocessedChannelsShader;
 
+    // Time spent creating the shader programs above and how they were obtained, reported when the context is destroyed
+    double shaderProgramsLinkDuration;
+    int nShaderProgramsCompiled;
+    int nShaderProgramsLoadedFromCache;
+
     OSGLContextPrivate(bool useGPUContext)
         : useGPUContext(useGPUContext)
         , _platformContext()
@@ -333,10 +341,23 @@ struct OSGLContextPrivate
         , fillImageShader()
         , applyMaskMixShader(4)
         , copyUnprocessedChannelsShader(16)
+        , shaderProgramsLinkDuration(0)
+        , nShaderProgramsCompiled(0)
+        , nShaderProgramsLoadedFromCache(0)
     {
 
     }
 
+    void recordShaderProgram(const GLShaderBasePtr& shader)
+    {
+        shaderProgramsLinkDuration += shader->getLinkDuration();
+        if (shader->isLoadedFromProgramCache()) {
+            ++nShaderProgramsLoadedFromCache;
+        } else {
+            ++nShaderProgramsCompiled;
+        }
+    }
+
 
 };
 
@@ -392,6 +413,17 @@ OSGLContext::OSGLContext(const FramebufferConfig& pixelFormatAttrs,
 
 OSGLContext::~OSGLContext()
 {
+    if ( (_imp->nShaderProgramsCompiled > 0 || _imp->nShaderProgramsLoadedFromCache > 0) && appPTR ) {
+        SettingsPtr settings = appPTR->getCurrentSettings();
+        if ( settings && settings->isPerformanceLoggingEnabled() ) {
+            appPTR->writeToErrorLog_mt_safe( _imp->useGPUContext ? QString::fromUtf8("OpenGL") : QString::fromUtf8("OSMesa"), QDateTime::currentDateTime(),
+                                             QCoreApplication::translate("OSGLContext", "Created %1 shader programs in %2 ms, %3 of them loaded from the program cache")
+                                             .arg(_imp->nShaderProgramsCompiled + _imp->nShaderProgramsLoadedFromCache)
+                                             .arg(_imp->shaderProgramsLinkDuration * 1000.)
+                                             .arg(_imp->nShaderProgramsLoadedFromCache) );
+        }
+    }
+
     setContextCurrentInternal(0, 0, 0, 0);
 
     if (_imp->pboID) {
@@ -899,6 +931,7 @@ OSGLContext::getOrCreateCopyTexShader()
     } else {
         _imp->copyTexShader = getOrCreateCopyTexShaderInternal<GL_CPU>();
     }
+    _imp->recordShaderProgram(_imp->copyTexShader);
     return _imp->copyTexShader;
 
 }
@@ -914,6 +947,7 @@ OSGLContext::getOrCreateFillShader()
     } else {
         _imp->fillImageShader = getOrCreateFillShaderInternal<GL_CPU>();
     }
+    _imp->recordShaderProgram(_imp->fillImageShader);
     return _imp->fillImageShader;
 }
 
@@ -930,6 +964,7 @@ OSGLContext::getOrCreateMaskMixShader(bool maskEnabled, bool maskInvert)
         _imp->applyMaskMixShader[shader_i] = getOrCreateMaskMixShaderInternal<GL_CPU>(maskEnabled, maskInvert);
     }
 
+    _imp->recordShaderProgram(_imp->applyMaskMixShader[shader_i]);
     return _imp->applyMaskMixShader[shader_i];
 }
 
@@ -963,10 +998,19 @@ OSGLContext::getOrCreateCopyUnprocessedChannelsShader(bool doR,
         _imp->copyUnprocessedChannelsShader[index] = getOrCreateCopyUnprocessedChannelsShaderInternal<GL_CPU>(doR, doG, doB, doA);
     }
     
+    _imp->recordShaderProgram(_imp->copyUnprocessedChannelsShader[index]);
     return _imp->copyUnprocessedChannelsShader[index];
 
 }
 
+void
+OSGLContext::recordShaderProgram(const GLShaderBasePtr& shader)
+{
+    if (shader) {
+        _imp->recordShaderProgram(shader);
+    }
+}
+
 
 OSGLContextAttacher::OSGLContextAttacher(const OSGLContextPtr& c)
 : _c(c)
@@ -1059,6 +1103,11 @@ OSGLContextAttacher::attach()
         // be used by any other thread until dettach() is called
         _c->setContextCurrentInternal(_width, _height, _rowWidth, _buffer);
         ++_attached;
+
+        // The rasterizer threads of an OSMesa context are busy while it is attached
+        if (!_c->isGPUContext()) {
+            appPTR->getGPUContextPool()->onCPUContextAttachmentChanged(true);
+        }
     }
 }
 
@@ -1073,6 +1122,9 @@ OSGLContextAttacher::dettach()
 {
 
     if (_attached == 1) {
+        if (!_c->isGPUContext()) {
+            appPTR->getGPUContextPool()->onCPUContextAttachmentChanged(false);
+        }
         appPTR->getGPUContextPool()->unregisterContextForThread();
         _c->unsetCurrentContext();
         assert(_attached > 0);
@@ -140,6 +140,10 @@ public:
                                                              bool doB,
                                                              bool doA);
 
+    /**
+     * @brief Accounts the given shader program, created by an effect for this context, in the shader statistics of the context.
+     **/
+    void recordShaderProgram(const GLShaderBasePtr& shader);
 
 
     static void unsetCurrentContextNoRenderInternal(bool useGPU, OSGLContext* context);
@@ -190,6 +190,16 @@ public:
         return appPTR->getHardwareIdealThreadCount();
     }
 
+    inline QString getCacheStatistics() const
+    {
+        return QString::fromUtf8( appPTR->getCacheStatisticsAsJSON().c_str() );
+    }
+
+    inline void resetCacheStatistics()
+    {
+        appPTR->resetCacheStatistics();
+    }
+
     inline App* getInstance(int idx) const
     {
         AppInstancePtr app = appPTR->getAppInstance(idx);
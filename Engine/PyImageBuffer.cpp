@@ -0,0 +1,300 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "PyImageBuffer.h"
+
+#include <cassert>
+
+GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_OFF
+CLANG_DIAG_OFF(mismatched-tags)
+GCC_DIAG_OFF(unused-parameter)
+#include "natronengine_python.h"
+#include <shiboken.h> // produces many warnings
+GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
+CLANG_DIAG_ON(mismatched-tags)
+GCC_DIAG_ON(unused-parameter)
+
+#include "Engine/CacheEntryBase.h"
+#include "Engine/Image.h"
+#include "Engine/RectI.h"
+
+// Python 2 only exposes the new buffer protocol on types that declare it
+#if PY_MAJOR_VERSION >= 3
+#define NATRON_PY_IMAGE_BUFFER_TYPE_FLAGS Py_TPFLAGS_DEFAULT
+#else
+#define NATRON_PY_IMAGE_BUFFER_TYPE_FLAGS (Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_NEWBUFFER)
+#endif
+
+NATRON_NAMESPACE_ENTER
+NATRON_PYTHON_NAMESPACE_ENTER
+
+namespace {
+
+/**
+ * @brief The Python object. It is allocated by the Python allocator which does not call constructors:
+ * everything that is not plain old data is held by pointer.
+ **/
+struct PyImageBufferObject
+{
+    PyObject_HEAD
+
+    // Holds the image, and thus its buffer, alive
+    ImagePtr* image;
+
+    // Pointer to the first element of the buffer
+    void* data;
+
+    int x1, y1, x2, y2;
+    int nComps;
+    unsigned int mipMapLevel;
+
+    // Buffer protocol description, referenced by the Py_buffer views
+    char format[2];
+    Py_ssize_t itemSize;
+    Py_ssize_t len;
+    Py_ssize_t shape[3];
+    Py_ssize_t strides[3];
+    bool cContiguous;
+};
+
+void
+ImageBuffer_dealloc(PyObject* self)
+{
+    PyImageBufferObject* obj = (PyImageBufferObject*)self;
+
+    delete obj->image;
+    obj->image = 0;
+    Py_TYPE(self)->tp_free(self);
+}
+
+int
+ImageBuffer_getbuffer(PyObject* self,
+                      Py_buffer* view,
+                      int flags)
+{
+    PyImageBufferObject* obj = (PyImageBufferObject*)self;
+
+    if (!view) {
+        PyErr_SetString(PyExc_ValueError, "NULL view in getbuffer");
+        return -1;
+    }
+    view->obj = NULL;
+    if ( (flags & PyBUF_WRITABLE) == PyBUF_WRITABLE ) {
+        // The image may be shared with the cache and other renders
+        PyErr_SetString(PyExc_BufferError, "NatronEngine.ImageBuffer is read-only");
+        return -1;
+    }
+    const bool stridesRequested = (flags & PyBUF_STRIDES) == PyBUF_STRIDES;
+    if ( !obj->cContiguous && ( !stridesRequested ||
+                                ( (flags & PyBUF_C_CONTIGUOUS) == PyBUF_C_CONTIGUOUS ) ||
+                                ( (flags & PyBUF_F_CONTIGUOUS) == PyBUF_F_CONTIGUOUS ) ||
+                                ( (flags & PyBUF_ANY_CONTIGUOUS) == PyBUF_ANY_CONTIGUOUS ) ) ) {
+        PyErr_SetString(PyExc_BufferError, "NatronEngine.ImageBuffer: the image is not contiguous, strides are required");
+        return -1;
+    }
+
+    view->buf = obj->data;
+    view->len = obj->len;
+    view->readonly = 1;
+    view->itemsize = obj->itemSize;
+    view->format = (flags & PyBUF_FORMAT) == PyBUF_FORMAT ? obj->format : NULL;
+    view->ndim = 3;
+    view->shape = (flags & PyBUF_ND) == PyBUF_ND ? obj->shape : NULL;
+    view->strides = stridesRequested ? obj->strides : NULL;
+    view->suboffsets = NULL;
+    view->internal = NULL;
+    if (!view->shape) {
+        // The consumer sees a contiguous sequence of bytes
+        view->ndim = 1;
+        view->itemsize = 1;
+    }
+
+    Py_INCREF(self);
+    view->obj = self;
+
+    return 0;
+} // ImageBuffer_getbuffer
+
+void
+ImageBuffer_releasebuffer(PyObject* /*self*/,
+                          Py_buffer* /*view*/)
+{
+    // Nothing to do: the description of the buffer lives as long as the object
+}
+
+PyObject*
+ImageBuffer_getBounds(PyObject* self,
+                      void* /*closure*/)
+{
+    PyImageBufferObject* obj = (PyImageBufferObject*)self;
+    RectI bounds(obj->x1, obj->y1, obj->x2, obj->y2);
+
+    return Shiboken::Conversions::copyToPython( (SbkObjectType*)SbkNatronEngineTypes[SBK_RECTI_IDX], &bounds );
+}
+
+PyObject*
+ImageBuffer_getComponentsCount(PyObject* self,
+                               void* /*closure*/)
+{
+    return PyLong_FromLong( ( (PyImageBufferObject*)self )->nComps );
+}
+
+PyObject*
+ImageBuffer_getMipMapLevel(PyObject* self,
+                           void* /*closure*/)
+{
+    return PyLong_FromLong( ( (PyImageBufferObject*)self )->mipMapLevel );
+}
+
+PyGetSetDef ImageBuffer_getset[] = {
+    {(char*)"bounds", (getter)ImageBuffer_getBounds, 0, (char*)"Bounds of the image, in pixel coordinates at the mipmap level of the image", 0},
+    {(char*)"components", (getter)ImageBuffer_getComponentsCount, 0, (char*)"Number of components of each pixel", 0},
+    {(char*)"mipMapLevel", (getter)ImageBuffer_getMipMapLevel, 0, (char*)"Mipmap level at which the image was rendered", 0},
+    {0, 0, 0, 0, 0}
+};
+
+PyBufferProcs ImageBuffer_bufferProcs;
+
+PyTypeObject*
+getImageBufferType()
+{
+    // Only called with the GIL held
+    static PyTypeObject type;
+    static bool initialized = false;
+
+    if (initialized) {
+        return &type;
+    }
+
+    PyTypeObject emptyType = { PyVarObject_HEAD_INIT(NULL, 0) };
+    type = emptyType;
+    type.tp_name = "NatronEngine.ImageBuffer";
+    type.tp_basicsize = sizeof(PyImageBufferObject);
+    type.tp_dealloc = (destructor)ImageBuffer_dealloc;
+    type.tp_flags = NATRON_PY_IMAGE_BUFFER_TYPE_FLAGS;
+    type.tp_doc = "Image rendered in memory, its pixels are accessible through the buffer protocol, e.g: numpy.asarray(image)";
+    type.tp_getset = ImageBuffer_getset;
+
+    ImageBuffer_bufferProcs.bf_getbuffer = (getbufferproc)ImageBuffer_getbuffer;
+    ImageBuffer_bufferProcs.bf_releasebuffer = (releasebufferproc)ImageBuffer_releasebuffer;
+    type.tp_as_buffer = &ImageBuffer_bufferProcs;
+
+    if (PyType_Ready(&type) < 0) {
+        return 0;
+    }
+    initialized = true;
+
+    return &type;
+} // getImageBufferType
+
+const char*
+getBufferFormat(ImageBitDepthEnum bitDepth)
+{
+    switch (bitDepth) {
+    case eImageBitDepthByte:
+        return "B";
+    case eImageBitDepthShort:
+        return "H";
+    case eImageBitDepthHalf:
+        return "e";
+    case eImageBitDepthFloat:
+        return "f";
+    case eImageBitDepthNone:
+        break;
+    }
+
+    return 0;
+}
+
+} // anon namespace
+
+PyObject*
+createImageBufferObject(const ImagePtr& image)
+{
+    if (!image || image->getStorageMode() != eStorageModeRAM) {
+        PyErr_SetString(PyExc_ValueError, "NatronEngine.ImageBuffer: the image must be in RAM");
+        return 0;
+    }
+
+    Image::CPUData data;
+    image->getCPUData(&data);
+    const char* format = getBufferFormat(data.bitDepth);
+    if (!data.ptrs[0] || !format || data.nComps <= 0) {
+        PyErr_SetString(PyExc_ValueError, "NatronEngine.ImageBuffer: the image has no buffer");
+        return 0;
+    }
+
+    const ImageBufferLayoutEnum layout = image->getBufferFormat();
+    if (layout == eImageBufferLayoutMonoChannelFullRect && data.nComps > 1) {
+        // Each channel has its own buffer, this cannot be described with strides
+        PyErr_SetString(PyExc_ValueError, "NatronEngine.ImageBuffer: the image must be packed or coplanar");
+        return 0;
+    }
+
+    PyTypeObject* type = getImageBufferType();
+    if (!type) {
+        return 0;
+    }
+    PyImageBufferObject* obj = (PyImageBufferObject*)type->tp_alloc(type, 0);
+    if (!obj) {
+        return 0;
+    }
+
+    obj->image = new ImagePtr(image);
+    obj->data = data.ptrs[0];
+    obj->x1 = data.bounds.x1;
+    obj->y1 = data.bounds.y1;
+    obj->x2 = data.bounds.x2;
+    obj->y2 = data.bounds.y2;
+    obj->nComps = data.nComps;
+    obj->mipMapLevel = image->getMipMapLevel();
+    obj->format[0] = format[0];
+    obj->format[1] = '\0';
+    obj->itemSize = getSizeOfForBitDepth(data.bitDepth);
+
+    const Py_ssize_t width = data.bounds.width();
+    const Py_ssize_t height = data.bounds.height();
+    obj->len = width * height * data.nComps * obj->itemSize;
+    obj->shape[0] = height;
+    obj->shape[1] = width;
+    obj->shape[2] = data.nComps;
+    if (layout == eImageBufferLayoutRGBACoplanarFullRect) {
+        // RRRRGGGGBBBBAAAA
+        obj->strides[0] = width * obj->itemSize;
+        obj->strides[1] = obj->itemSize;
+        obj->strides[2] = width * height * obj->itemSize;
+        obj->cContiguous = data.nComps == 1;
+    } else {
+        // RGBARGBARGBA, or a single channel
+        obj->strides[0] = width * data.nComps * obj->itemSize;
+        obj->strides[1] = data.nComps * obj->itemSize;
+        obj->strides[2] = obj->itemSize;
+        obj->cContiguous = true;
+    }
+
+    return (PyObject*)obj;
+} // createImageBufferObject
+
+NATRON_PYTHON_NAMESPACE_EXIT
+NATRON_NAMESPACE_EXIT
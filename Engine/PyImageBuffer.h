@@ -0,0 +1,51 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef NATRON_ENGINE_PYIMAGEBUFFER_H
+#define NATRON_ENGINE_PYIMAGEBUFFER_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include "Engine/EngineFwd.h"
+
+NATRON_NAMESPACE_ENTER
+NATRON_PYTHON_NAMESPACE_ENTER
+
+/**
+ * @brief Returns a new reference to a NatronEngine.ImageBuffer Python object holding the given image.
+ * The object exposes the pixels of the image through the buffer protocol without copying them: the buffer
+ * is read-only, has 3 dimensions (rows, columns, components) and its strides follow the layout of the image.
+ * Rows are ordered bottom-up, as in the image bounds: the first row is the row y1.
+ * Keeping a reference to the object (or to a memoryview/numpy array created from it) keeps the image alive.
+ *
+ * The image must be in RAM and either packed RGBA or coplanar, or have a single component.
+ * Returns NULL and sets a Python exception on failure.
+ * The caller must hold the Python GIL.
+ **/
+PyObject* createImageBufferObject(const ImagePtr& image);
+
+NATRON_PYTHON_NAMESPACE_EXIT
+NATRON_NAMESPACE_EXIT
+
+#endif // NATRON_ENGINE_PYIMAGEBUFFER_H
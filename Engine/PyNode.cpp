@@ -50,9 +50,13 @@ GCC_DIAG_ON(unused-parameter)
 #include "Engine/KnobTypes.h"
 #include "Engine/KnobFile.h"
 #include "Engine/AppInstance.h"
+#include "Engine/AppManager.h"
 #include "Engine/EffectInstance.h"
+#include "Engine/FrameViewRequest.h"
+#include "Engine/Image.h"
 #include "Engine/NodeGroup.h"
 #include "Engine/PyAppInstance.h"
+#include "Engine/PyImageBuffer.h"
 #include "Engine/PyRoto.h"
 #include "Engine/PyTracker.h"
 #include "Engine/Project.h"
@@ -1547,6 +1551,89 @@ Effect::getRegionOfDefinition(double time, const QString& view) const
 
 }
 
+PyObject*
+Effect::renderPlane(double time,
+                    int view,
+                    const ImageLayer& layer,
+                    int mipMapLevel) const
+{
+    EffectInstancePtr effect = getCurrentEffectInstance();
+    if (!effect) {
+        PythonSetNullError();
+        return 0;
+    }
+    if (mipMapLevel < 0) {
+        PyErr_SetString(PyExc_ValueError, tr("Invalid mipmap level").toStdString().c_str());
+        return 0;
+    }
+
+    TreeRender::CtorArgsPtr args(new TreeRender::CtorArgs);
+    {
+        args->treeRootEffect = effect;
+        args->provider = effect;
+        args->time = TimeValue(time);
+        args->view = ViewIdx(view);
+        args->plane = layer.getInternalComps();
+        args->mipMapLevel = (unsigned int)mipMapLevel;
+    }
+
+    TreeRenderPtr render = TreeRender::create(args);
+    if (!render) {
+        PyErr_SetString(PyExc_RuntimeError, tr("Failed to create the render").toStdString().c_str());
+        return 0;
+    }
+    ActionRetCodeEnum stat;
+    {
+        // The script holds the GILs: release them while rendering, nodes of the tree may run Python code
+        // (expressions, callbacks) from the render threads.
+        PythonGILUnlocker unlocker;
+        effect->launchRender(render);
+        stat = effect->waitForRenderFinished(render);
+    }
+    if (isFailureRetCode(stat)) {
+        PyErr_SetString(PyExc_RuntimeError, tr("Failed to render %1").arg(getScriptName()).toStdString().c_str());
+        return 0;
+    }
+
+    FrameViewRequestPtr outputRequest = render->getOutputRequest();
+    ImagePtr image = outputRequest ? outputRequest->getRequestedScaleImagePlane() : ImagePtr();
+    if (!image) {
+        PyErr_SetString(PyExc_RuntimeError, tr("Failed to render %1").arg(getScriptName()).toStdString().c_str());
+        return 0;
+    }
+
+    // The buffer protocol can only describe a single buffer in RAM: OpenGL textures and images with one buffer
+    // per channel are copied once to a packed RGBA image.
+    if (image->getStorageMode() != eStorageModeRAM ||
+        (image->getBufferFormat() == eImageBufferLayoutMonoChannelFullRect && image->getComponentsCount() > 1)) {
+        Image::InitStorageArgs initArgs;
+        {
+            initArgs.bounds = image->getBounds();
+            initArgs.plane = image->getLayer();
+            initArgs.bufferFormat = eImageBufferLayoutRGBAPackedFullRect;
+            initArgs.storage = eStorageModeRAM;
+            initArgs.bitdepth = image->getBitDepth();
+            initArgs.mipMapLevel = image->getMipMapLevel();
+            initArgs.proxyScale = image->getProxyScale();
+        }
+        ImagePtr packedImage = Image::create(initArgs);
+        if (!packedImage) {
+            PyErr_SetString(PyExc_MemoryError, tr("Failed to allocate the image").toStdString().c_str());
+            return 0;
+        }
+        Image::CopyPixelsArgs cpyArgs;
+        cpyArgs.roi = initArgs.bounds;
+        stat = packedImage->copyPixels(*image, cpyArgs);
+        if (isFailureRetCode(stat)) {
+            PyErr_SetString(PyExc_RuntimeError, tr("Failed to render %1").arg(getScriptName()).toStdString().c_str());
+            return 0;
+        }
+        image = packedImage;
+    }
+
+    return createImageBufferObject(image);
+} // renderPlane
+
 void
 Effect::setSubGraphEditable(bool editable)
 {
@@ -385,6 +385,14 @@ public:
 
     RectD getRegionOfDefinition(double time, const QString& view) const;
 
+    /**
+     * @brief Renders the given plane of the effect at the given time, view and mipmap level in memory, without going through a writer.
+     * The rendered image goes through the cache like any other render, so rendering the same plane again is a cache hit.
+     * Returns a new reference to a NatronEngine.ImageBuffer object exposing the pixels through the buffer protocol without copying them,
+     * or NULL with a Python exception set on failure.
+     **/
+    PyObject* renderPlane(double time, int /* Python API: do not use ViewIdx */ view, const ImageLayer& layer, int mipMapLevel = 0) const;
+
     static Param* createParamWrapperForKnob(const KnobIPtr& knob);
 
     static ItemsTable* createItemsTableWrapper(const KnobItemsTablePtr& table);
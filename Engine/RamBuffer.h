@@ -95,6 +95,26 @@ public:
         }
     }
 
+    /**
+     * @brief Same as resize() but the buffer is filled with zeros. For large sizes the OS maps demand-zero pages:
+     * physical memory is only committed for the pages that are written to.
+     **/
+    void resizeZeroed(U64 size)
+    {
+        if (size == 0) {
+            return;
+        }
+        count = size;
+        if (data) {
+            free(data);
+            data = 0;
+        }
+        data = (T*)calloc( size, sizeof(T) );
+        if (!data) {
+            throw std::bad_alloc();
+        }
+    }
+
     void resizeAndPreserve(U64 size)
     {
         if (size == 0 || size == count) {
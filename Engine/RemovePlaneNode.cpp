@@ -63,6 +63,7 @@ RemovePlaneNode::createPlugin()
     EffectDescriptionPtr effectDesc = ret->getEffectDescriptor();
     effectDesc->setProperty<RenderSafetyEnum>(kEffectPropRenderThreadSafety, eRenderSafetyFullySafe);
     effectDesc->setProperty<bool>(kEffectPropSupportsTiles, true);
+    effectDesc->setProperty<bool>(kEffectPropPixelLocal, true);
     ret->setProperty<bool>(kNatronPluginPropMultiPlanar, true);
     ret->setProperty<PlanePassThroughEnum>(kNatronPluginPropPlanesPassThrough, ePassThroughBlockNonRenderedPlanes);
     ret->setProperty<ImageBitDepthEnum>(kNatronPluginPropOutputSupportedBitDepths, eImageBitDepthFloat, 0);
@@ -753,8 +753,9 @@ RotoDrawableItem::refreshNodesConnections(const RotoDrawableItemPtr& previous)
 
 
     // upstreamNode is the node that should be connected as the B input of the merge node of this item.
-    // If there is a previous item, this is the previous item's merge node, otherwise this is the RotoPaint node input 0
-    NodePtr upstreamNode = previous ? previous->getMergeNode() : bgNode;
+    // If there is a previous item, this is the node outputting the stack up to the previous item (its merge node, or the global
+    // merge node of its run if it ends a concatenated run), otherwise this is the RotoPaint node input 0
+    NodePtr upstreamNode = previous ? rotoPaintNode->getStackOutputNode(previous) : bgNode;
 
     RotoStrokeType type = getBrushType();
 
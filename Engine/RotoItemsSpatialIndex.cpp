@@ -0,0 +1,477 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "RotoItemsSpatialIndex.h"
+
+#include <algorithm>
+#include <cassert>
+#include <map>
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/shared_ptr.hpp>
+#endif
+
+#include <QtCore/QMutex>
+
+#include "Engine/Bezier.h"
+#include "Engine/BezierCP.h"
+#include "Engine/FrameViewRequest.h"
+#include "Engine/KnobItemsTable.h"
+#include "Engine/RotoDrawableItem.h"
+#include "Engine/Transform.h"
+
+// Maximum number of time/view samples for which a hierarchy is kept. The least recently used one is discarded first.
+#define NATRON_ROTO_SPATIAL_INDEX_MAX_SAMPLES 8
+
+NATRON_NAMESPACE_ENTER
+
+struct RotoItemsSpatialIndexNode
+{
+    // Union of the bounding boxes of all items below this node
+    RectD bbox;
+
+    // Index of the parent node, or -1 for the root
+    int parent;
+
+    // Index of the 2 children nodes, or -1 for a leaf
+    int children[2];
+
+    // For a leaf, the index of the item in RotoItemsSpatialIndexSample::items, otherwise -1
+    int item;
+
+    RotoItemsSpatialIndexNode()
+    : bbox()
+    , parent(-1)
+    , item(-1)
+    {
+        children[0] = children[1] = -1;
+    }
+};
+
+/**
+ * @brief The hierarchy at a given time/view. Once published in the index, a sample is never modified: a refit
+ * is done on a copy, so that queries can traverse it without holding the index mutex.
+ **/
+struct RotoItemsSpatialIndexSample
+{
+    // The root is nodes[0] if there is any item
+    std::vector<RotoItemsSpatialIndexNode> nodes;
+
+    // The indexed items, in the order of KnobItemsTable::getAllItems()
+    std::vector<RotoDrawableItemWPtr> items;
+
+    // For each item, the index of its leaf node
+    std::map<const HashableObject*, int> leafNodes;
+};
+
+typedef boost::shared_ptr<const RotoItemsSpatialIndexSample> RotoItemsSpatialIndexSampleConstPtr;
+typedef boost::shared_ptr<RotoItemsSpatialIndexSample> RotoItemsSpatialIndexSamplePtr;
+
+struct RotoItemsSpatialIndexSampleEntry
+{
+    RotoItemsSpatialIndexSampleConstPtr sample;
+
+    // Items whose bounding box must be recomputed before the next query
+    std::set<const HashableObject*> dirtyItems;
+
+    // Value of RotoItemsSpatialIndexPrivate::useCounter when this sample was last queried
+    U64 lastUsed;
+
+    RotoItemsSpatialIndexSampleEntry()
+    : sample()
+    , dirtyItems()
+    , lastUsed(0)
+    {
+
+    }
+};
+
+typedef std::map<FrameViewPair, RotoItemsSpatialIndexSampleEntry, FrameView_compare_less> RotoItemsSpatialIndexSampleMap;
+
+struct RotoItemsSpatialIndexPrivate
+{
+    KnobItemsTableWPtr table;
+
+    // Protects all fields below
+    mutable QMutex lock;
+
+    RotoItemsSpatialIndexSampleMap samples;
+
+    // Incremented each time anything is invalidated, so that a sample built concurrently is not published
+    U64 generation;
+
+    U64 useCounter;
+
+    RotoItemsSpatialIndexPrivate(const KnobItemsTablePtr& table)
+    : table(table)
+    , lock()
+    , samples()
+    , generation(0)
+    , useCounter(0)
+    {
+
+    }
+
+    RotoItemsSpatialIndexSamplePtr buildSample(TimeValue time, ViewIdx view) const;
+
+    static void refitSample(TimeValue time,
+                            ViewIdx view,
+                            const std::set<const HashableObject*>& dirtyItems,
+                            RotoItemsSpatialIndexSample* sample);
+
+    // lock must be held
+    void evictSamples();
+};
+
+static void
+unionRect(const RectD& a,
+          const RectD& b,
+          RectD* ret)
+{
+    // Do not use RectD::merge: it ignores empty rectangles, but the bounding box of a single point is valid here.
+    ret->x1 = std::min(a.x1, b.x1);
+    ret->y1 = std::min(a.y1, b.y1);
+    ret->x2 = std::max(a.x2, b.x2);
+    ret->y2 = std::max(a.y2, b.y2);
+}
+
+static bool
+rectsOverlap(const RectD& a,
+             const RectD& b)
+{
+    // Edges are inclusive for the same reason
+    return a.x1 <= b.x2 && b.x1 <= a.x2 && a.y1 <= b.y2 && b.y1 <= a.y2;
+}
+
+/**
+ * @brief Returns the bounding box of the item as used by the index: this is the bounding box of the item
+ * which may also be enlarged so that it encloses everything that can be picked in the viewer.
+ **/
+static RectD
+getItemIndexBoundingBox(const RotoDrawableItemPtr& item,
+                        TimeValue time,
+                        ViewIdx view)
+{
+    RectD bbox = item->getBoundingBox(time, view);
+
+    // The bounding box of open or unfilled Beziers does not include the feather points, but they can still be selected
+    BezierPtr isBezier = toBezier(item);
+    if ( isBezier && !isBezier->isFillEnabled() ) {
+        std::list<BezierCPPtr> featherPoints = isBezier->getFeatherPoints(view);
+        if ( !featherPoints.empty() ) {
+            Transform::Matrix3x3 transform;
+            isBezier->getTransformAtTime(time, view, &transform);
+            RectD featherBbox = Bezier::getBezierSegmentListBbox(featherPoints, 0 /*featherDistance*/, time, transform);
+            unionRect(bbox, featherBbox, &bbox);
+        }
+    }
+    return bbox;
+}
+
+struct CompareLeafCenter
+{
+    const std::vector<RectD>* bboxes;
+    int axis;
+
+    bool operator() (int a, int b) const
+    {
+        const RectD& ra = (*bboxes)[a];
+        const RectD& rb = (*bboxes)[b];
+        if (axis == 0) {
+            return ra.x1 + ra.x2 < rb.x1 + rb.x2;
+        } else {
+            return ra.y1 + ra.y2 < rb.y1 + rb.y2;
+        }
+    }
+};
+
+/**
+ * @brief Builds the sub-tree containing the items leafs[begin..end[ by splitting them at the median of their center along the
+ * largest axis. Returns the index of the node.
+ **/
+static int
+buildNodeRecursive(const std::vector<RectD>& bboxes,
+                   std::vector<int>& leafs,
+                   int begin,
+                   int end,
+                   int parent,
+                   std::vector<RotoItemsSpatialIndexNode>* nodes)
+{
+    assert(end > begin);
+    int nodeIndex = (int)nodes->size();
+    nodes->push_back(RotoItemsSpatialIndexNode());
+    (*nodes)[nodeIndex].parent = parent;
+
+    if (end - begin == 1) {
+        (*nodes)[nodeIndex].item = leafs[begin];
+        (*nodes)[nodeIndex].bbox = bboxes[leafs[begin]];
+        return nodeIndex;
+    }
+
+    // Split along the axis on which the centers are the most spread
+    double minX = bboxes[leafs[begin]].x1 + bboxes[leafs[begin]].x2, maxX = minX;
+    double minY = bboxes[leafs[begin]].y1 + bboxes[leafs[begin]].y2, maxY = minY;
+    for (int i = begin + 1; i < end; ++i) {
+        const RectD& r = bboxes[leafs[i]];
+        minX = std::min(minX, r.x1 + r.x2);
+        maxX = std::max(maxX, r.x1 + r.x2);
+        minY = std::min(minY, r.y1 + r.y2);
+        maxY = std::max(maxY, r.y1 + r.y2);
+    }
+    CompareLeafCenter comp;
+    comp.bboxes = &bboxes;
+    comp.axis = (maxX - minX) >= (maxY - minY) ? 0 : 1;
+
+    int mid = begin + (end - begin) / 2;
+    std::nth_element(leafs.begin() + begin, leafs.begin() + mid, leafs.begin() + end, comp);
+
+    // nodes may be reallocated by the recursive calls, do not hold a reference
+    int left = buildNodeRecursive(bboxes, leafs, begin, mid, nodeIndex, nodes);
+    int right = buildNodeRecursive(bboxes, leafs, mid, end, nodeIndex, nodes);
+
+    RotoItemsSpatialIndexNode& node = (*nodes)[nodeIndex];
+    node.children[0] = left;
+    node.children[1] = right;
+    unionRect((*nodes)[left].bbox, (*nodes)[right].bbox, &node.bbox);
+    return nodeIndex;
+} // buildNodeRecursive
+
+RotoItemsSpatialIndexSamplePtr
+RotoItemsSpatialIndexPrivate::buildSample(TimeValue time,
+                                          ViewIdx view) const
+{
+    RotoItemsSpatialIndexSamplePtr sample(new RotoItemsSpatialIndexSample);
+
+    KnobItemsTablePtr model = table.lock();
+    if (!model) {
+        return sample;
+    }
+
+    std::vector<RectD> bboxes;
+    std::vector<KnobTableItemPtr> allItems = model->getAllItems();
+    for (std::vector<KnobTableItemPtr>::const_iterator it = allItems.begin(); it != allItems.end(); ++it) {
+        RotoDrawableItemPtr drawable = boost::dynamic_pointer_cast<RotoDrawableItem>(*it);
+        if (!drawable) {
+            continue;
+        }
+        sample->items.push_back(drawable);
+        bboxes.push_back( getItemIndexBoundingBox(drawable, time, view) );
+    }
+    if (sample->items.empty()) {
+        return sample;
+    }
+
+    std::vector<int> leafs(sample->items.size());
+    for (std::size_t i = 0; i < leafs.size(); ++i) {
+        leafs[i] = (int)i;
+    }
+
+    sample->nodes.reserve(2 * leafs.size() - 1);
+    buildNodeRecursive(bboxes, leafs, 0, (int)leafs.size(), -1, &sample->nodes);
+
+    for (std::size_t i = 0; i < sample->nodes.size(); ++i) {
+        int item = sample->nodes[i].item;
+        if (item != -1) {
+            RotoDrawableItemPtr drawable = sample->items[item].lock();
+            sample->leafNodes[drawable.get()] = (int)i;
+        }
+    }
+    return sample;
+} // buildSample
+
+void
+RotoItemsSpatialIndexPrivate::refitSample(TimeValue time,
+                                          ViewIdx view,
+                                          const std::set<const HashableObject*>& dirtyItems,
+                                          RotoItemsSpatialIndexSample* sample)
+{
+    for (std::set<const HashableObject*>::const_iterator it = dirtyItems.begin(); it != dirtyItems.end(); ++it) {
+        std::map<const HashableObject*, int>::const_iterator foundLeaf = sample->leafNodes.find(*it);
+        if (foundLeaf == sample->leafNodes.end()) {
+            continue;
+        }
+        RotoItemsSpatialIndexNode& leaf = sample->nodes[foundLeaf->second];
+        RotoDrawableItemPtr drawable = sample->items[leaf.item].lock();
+        if (!drawable) {
+            // The item was removed, invalidate() will be called
+            continue;
+        }
+        leaf.bbox = getItemIndexBoundingBox(drawable, time, view);
+
+        // Refit the ancestors
+        int parent = leaf.parent;
+        while (parent != -1) {
+            RotoItemsSpatialIndexNode& node = sample->nodes[parent];
+            unionRect(sample->nodes[node.children[0]].bbox, sample->nodes[node.children[1]].bbox, &node.bbox);
+            parent = node.parent;
+        }
+    }
+} // refitSample
+
+void
+RotoItemsSpatialIndexPrivate::evictSamples()
+{
+    while (samples.size() > NATRON_ROTO_SPATIAL_INDEX_MAX_SAMPLES) {
+        RotoItemsSpatialIndexSampleMap::iterator oldest = samples.begin();
+        for (RotoItemsSpatialIndexSampleMap::iterator it = samples.begin(); it != samples.end(); ++it) {
+            if (it->second.lastUsed < oldest->second.lastUsed) {
+                oldest = it;
+            }
+        }
+        samples.erase(oldest);
+    }
+}
+
+RotoItemsSpatialIndex::RotoItemsSpatialIndex(const KnobItemsTablePtr& table)
+: _imp(new RotoItemsSpatialIndexPrivate(table))
+{
+
+}
+
+RotoItemsSpatialIndex::~RotoItemsSpatialIndex()
+{
+
+}
+
+void
+RotoItemsSpatialIndex::getItemsIntersecting(TimeValue time,
+                                            ViewIdx view,
+                                            const RectD& rect,
+                                            std::vector<RotoDrawableItemPtr>* items) const
+{
+    FrameViewPair key = {time, view};
+
+    RotoItemsSpatialIndexSampleConstPtr sample;
+    std::set<const HashableObject*> dirtyItems;
+    U64 generation;
+    {
+        QMutexLocker k(&_imp->lock);
+        generation = _imp->generation;
+        RotoItemsSpatialIndexSampleMap::iterator found = _imp->samples.find(key);
+        if (found != _imp->samples.end()) {
+            sample = found->second.sample;
+            dirtyItems.swap(found->second.dirtyItems);
+            found->second.lastUsed = ++_imp->useCounter;
+        }
+    }
+
+    // Bounding boxes are computed without holding the lock: this calls into the items and their knobs
+    // which may themselves invalidate the index.
+    RotoItemsSpatialIndexSamplePtr updatedSample;
+    if (!sample) {
+        updatedSample = _imp->buildSample(time, view);
+    } else if ( !dirtyItems.empty() ) {
+        updatedSample.reset( new RotoItemsSpatialIndexSample(*sample) );
+        RotoItemsSpatialIndexPrivate::refitSample(time, view, dirtyItems, updatedSample.get());
+    }
+
+    if (updatedSample) {
+        QMutexLocker k(&_imp->lock);
+        RotoItemsSpatialIndexSampleMap::iterator found = _imp->samples.find(key);
+        if (sample) {
+            // Publish the refitted sample only if the one it was copied from was not discarded meanwhile.
+            // Items invalidated since then are still in the dirty list of the entry.
+            if ( (found != _imp->samples.end()) && (found->second.sample == sample) ) {
+                found->second.sample = updatedSample;
+            }
+        } else if ( (found == _imp->samples.end()) && (generation == _imp->generation) ) {
+            // If anything was invalidated while building, the bounding boxes may be out of date, do not publish it
+            RotoItemsSpatialIndexSampleEntry& entry = _imp->samples[key];
+            entry.sample = updatedSample;
+            entry.lastUsed = ++_imp->useCounter;
+            _imp->evictSamples();
+        }
+        sample = updatedSample;
+    }
+
+    if ( sample->nodes.empty() ) {
+        return;
+    }
+
+    std::vector<int> matches;
+    std::vector<int> stack;
+    stack.push_back(0);
+    while ( !stack.empty() ) {
+        const RotoItemsSpatialIndexNode& node = sample->nodes[stack.back()];
+        stack.pop_back();
+        if ( !rectsOverlap(node.bbox, rect) ) {
+            continue;
+        }
+        if (node.item != -1) {
+            matches.push_back(node.item);
+        } else {
+            stack.push_back(node.children[0]);
+            stack.push_back(node.children[1]);
+        }
+    }
+
+    // Return items in the table order
+    std::sort( matches.begin(), matches.end() );
+    items->reserve( items->size() + matches.size() );
+    for (std::size_t i = 0; i < matches.size(); ++i) {
+        RotoDrawableItemPtr drawable = sample->items[matches[i]].lock();
+        if (drawable) {
+            items->push_back(drawable);
+        }
+    }
+} // getItemsIntersecting
+
+void
+RotoItemsSpatialIndex::onHashInvalidated(const std::set<HashableObject*>& invalidatedObjects)
+{
+    QMutexLocker k(&_imp->lock);
+    ++_imp->generation;
+    if ( _imp->samples.empty() ) {
+        return;
+    }
+
+    // All samples index the same items: find the invalidated ones in any sample
+    const RotoItemsSpatialIndexSampleConstPtr& sample = _imp->samples.begin()->second.sample;
+    std::set<const HashableObject*> invalidatedItems;
+    for (std::set<HashableObject*>::const_iterator it = invalidatedObjects.begin(); it != invalidatedObjects.end(); ++it) {
+        if ( sample->leafNodes.find(*it) != sample->leafNodes.end() ) {
+            invalidatedItems.insert(*it);
+        }
+    }
+
+    if ( invalidatedItems.empty() ) {
+        // Something else than an item changed, e.g: a parameter of the RotoPaint node itself
+        _imp->samples.clear();
+        return;
+    }
+
+    for (RotoItemsSpatialIndexSampleMap::iterator it = _imp->samples.begin(); it != _imp->samples.end(); ++it) {
+        it->second.dirtyItems.insert( invalidatedItems.begin(), invalidatedItems.end() );
+    }
+} // onHashInvalidated
+
+void
+RotoItemsSpatialIndex::invalidate()
+{
+    QMutexLocker k(&_imp->lock);
+    _imp->samples.clear();
+    ++_imp->generation;
+}
+
+NATRON_NAMESPACE_EXIT
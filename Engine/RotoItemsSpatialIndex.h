@@ -0,0 +1,95 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef Engine_RotoItemsSpatialIndex_h
+#define Engine_RotoItemsSpatialIndex_h
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <set>
+#include <vector>
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/scoped_ptr.hpp>
+#endif
+
+#include "Global/GlobalDefines.h"
+#include "Engine/RectD.h"
+#include "Engine/TimeValue.h"
+#include "Engine/ViewIdx.h"
+#include "Engine/EngineFwd.h"
+
+NATRON_NAMESPACE_ENTER
+
+/**
+ * @brief A bounding volume hierarchy over the bounding boxes of the drawable items of a RotoPaint items table.
+ * It is used to find the items that may intersect a rectangle (e.g: the cursor in the viewer, enlarged by the selection tolerance)
+ * without calling getBoundingBox() on every item of the table.
+ *
+ * Since items may be animated, a hierarchy is built lazily for each time/view at which it is queried and kept until
+ * the items change. When only a few items change, their bounding box is recomputed and the hierarchy is refitted
+ * instead of being rebuilt. Adding or removing items, or any other change, discards all hierarchies.
+ *
+ * The query is conservative: it may return items whose shape does not intersect the rectangle but all items whose
+ * bounding box intersects the rectangle are returned.
+ *
+ * This class is thread-safe.
+ **/
+struct RotoItemsSpatialIndexPrivate;
+class RotoItemsSpatialIndex
+{
+public:
+
+    RotoItemsSpatialIndex(const KnobItemsTablePtr& table);
+
+    ~RotoItemsSpatialIndex();
+
+    /**
+     * @brief Returns in items all drawable items of the table whose bounding box at the given time/view intersects rect.
+     * Items are returned in the same order as KnobItemsTable::getAllItems().
+     **/
+    void getItemsIntersecting(TimeValue time,
+                              ViewIdx view,
+                              const RectD& rect,
+                              std::vector<RotoDrawableItemPtr>* items) const;
+
+    /**
+     * @brief Must be called when the hash of the RotoPaint node is invalidated with the set of objects that were invalidated
+     * so far. If it contains items that are in the index, only those items are refreshed, otherwise all hierarchies are discarded.
+     **/
+    void onHashInvalidated(const std::set<HashableObject*>& invalidatedObjects);
+
+    /**
+     * @brief Discards all hierarchies, e.g: when items are added or removed from the table.
+     **/
+    void invalidate();
+
+private:
+
+    boost::scoped_ptr<RotoItemsSpatialIndexPrivate> _imp;
+};
+
+NATRON_NAMESPACE_EXIT
+
+#endif // Engine_RotoItemsSpatialIndex_h
@@ -28,6 +28,8 @@
 #include <sstream> // stringstream
 #include <cassert>
 #include <stdexcept>
+#include <iterator> // std::advance
+#include <vector>
 
 #include "Serialization/BezierSerialization.h"
 #include "Serialization/RotoStrokeItemSerialization.h"
@@ -59,6 +61,14 @@
 #include "Global/GLIncludes.h"
 #include "Global/GlobalDefines.h"
 
+// In a tree that is not concatenated, the output of the merge node of every Nth item outside of a concatenated run is cached, so that editing an item only
+// re-composites the items above the nearest checkpoint below it.
+#define NATRON_ROTOPAINT_COMPOSITING_CHECKPOINT_INTERVAL 32
+
+// Minimum number of consecutive items that can be concatenated for them to be composited by global merge nodes
+// when the whole tree cannot be concatenated.
+#define NATRON_ROTOPAINT_MIN_CONCATENATED_RUN_LENGTH 2
+
 #define kFilterImpulse "Impulse"
 #define kFilterImpulseHint "(nearest neighbor / box) Use original values."
 #define kFilterBox "Box"
@@ -310,6 +320,29 @@ RotoPaint::getPremultNode() const
     return _imp->premultNode.lock();
 }
 
+bool
+RotoPaint::isCompositingCheckpoint(const NodePtr& node) const
+{
+    QMutexLocker k(&_imp->checkpointNodesMutex);
+    return _imp->checkpointNodes.find(node) != _imp->checkpointNodes.end();
+}
+
+NodePtr
+RotoPaint::getStackOutputNode(const RotoDrawableItemPtr& item) const
+{
+    {
+        QMutexLocker k(&_imp->stackOutputNodesMutex);
+        std::map<RotoDrawableItemWPtr, NodeWPtr>::const_iterator found = _imp->stackOutputNodes.find(item);
+        if (found != _imp->stackOutputNodes.end()) {
+            NodePtr node = found->second.lock();
+            if (node) {
+                return node;
+            }
+        }
+    }
+    return item->getMergeNode();
+}
+
 
 NodePtr
 RotoPaint::getInternalInputNode(int index) const
@@ -1326,6 +1359,16 @@ RotoPaint::initTrackingPageKnobs()
         trackingPage->addKnob(param);
         _imp->preBlurSigma = param;
     }
+    {
+        KnobBoolPtr param = createKnob<KnobBool>(kTrackerParamCoarseToFine);
+        param->setLabel(tr(kTrackerParamCoarseToFineLabel));
+        param->setHintToolTip( tr(kTrackerParamCoarseToFineHint) );
+        param->setDefaultValue(false);
+        param->setAnimationEnabled(false);
+        param->setEvaluateOnChange(false);
+        trackingPage->addKnob(param);
+        _imp->coarseToFine = param;
+    }
 
     {
         KnobChoicePtr param = createKnob<KnobChoice>(kTrackerParamMotionModel);
@@ -2867,6 +2910,7 @@ RotoPaint::initializeKnobs()
     _imp->knobsTable.reset(new RotoPaintKnobItemsTable(_imp.get(), KnobItemsTable::eKnobItemsTableTypeTree));
     _imp->knobsTable->setUserKeyframesWidgetsEnabled(_imp->nodeType != eRotoPaintTypeComp);
     _imp->knobsTable->setIconsPath(NATRON_IMAGES_PATH);
+    _imp->spatialIndex.reset(new RotoItemsSpatialIndex(_imp->knobsTable));
 
     QObject::connect( _imp->knobsTable.get(), SIGNAL(selectionChanged(std::list<KnobTableItemPtr>,std::list<KnobTableItemPtr>,TableChangeReasonEnum)), this, SLOT(onModelSelectionChanged(std::list<KnobTableItemPtr>,std::list<KnobTableItemPtr>,TableChangeReasonEnum)) );
 
@@ -3803,24 +3847,61 @@ RotoPaintKnobItemsTable::createSerializationFromItem(const KnobTableItemPtr& ite
 }
 
 bool
-RotoPaintPrivate::isRotoPaintTreeConcatenatableInternal(const std::list<RotoDrawableItemPtr >& items,  int* blendingMode) const
+RotoPaintPrivate::isRotoPaintItemConcatenatable(const RotoDrawableItemPtr& item, int* blendingMode) const
 {
-    // Iterate over items, if they all have the same compositing operator, concatenate. Concatenation only works for Solids or Comp items. If a comp item has a mask or mix is animated or different than 1, we cannot concatenate
-    bool operatorSet = false;
-    int comp_i = -1;
+    // Concatenation only works for Solids or Comp items. If a comp item has a mask or mix is animated or different than 1, we cannot concatenate
+    MergingFunctionEnum op = (MergingFunctionEnum)item->getOperatorKnob()->getValue();
 
-    for (std::list<RotoDrawableItemPtr >::const_iterator it = items.begin(); it != items.end(); ++it) {
+    // Can only concatenate with over
+    if (op != eMergeOver) {
+        return false;
+    }
+
+    KnobButtonPtr knob = item->getInvertedKnob();
+    if (knob && knob->getValue()) {
+        // An inverted shape breaks concatenation
+        return false;
+    }
+
+    // Now check the global activated/solo switches
+    if (!item->isGloballyActivated()) {
+        return false;
+    }
 
-        MergingFunctionEnum op = (MergingFunctionEnum)(*it)->getOperatorKnob()->getValue();
+    RotoStrokeType type = item->getBrushType();
 
-        // Can only concatenate with over
-        if (op != eMergeOver) {
+    // Other item types cannot concatenate since they use a custom mask on their Merge node.
+    if (type != eRotoStrokeTypeSolid && type != eRotoStrokeTypeEraser && type != eRotoStrokeTypeComp) {
+        return false;
+    }
+
+
+    // If the comp item has a mask on the merge node or a mix != 1, forget concatenating
+    if (type == eRotoStrokeTypeComp) {
+        if (item->getMergeMaskChoiceKnob()->getValue() > 0) {
             return false;
         }
+        KnobDoublePtr mixKnob = item->getMixKnob();
+        if (mixKnob->hasAnimation() || mixKnob->getValue() != 1.) {
+            return false;
+        }
+
+    }
+    *blendingMode = op;
+    return true;
+} // isRotoPaintItemConcatenatable
+
+bool
+RotoPaintPrivate::isRotoPaintTreeConcatenatableInternal(const std::list<RotoDrawableItemPtr >& items,  int* blendingMode) const
+{
+    // Iterate over items, if they can all be concatenated and have the same compositing operator, concatenate.
+    bool operatorSet = false;
+    int comp_i = -1;
 
-        KnobButtonPtr knob = (*it)->getInvertedKnob();
-        if (knob && knob->getValue()) {
-            // An inverted shape breaks concatenation
+    for (std::list<RotoDrawableItemPtr >::const_iterator it = items.begin(); it != items.end(); ++it) {
+
+        int op = -1;
+        if (!isRotoPaintItemConcatenatable(*it, &op)) {
             return false;
         }
 
@@ -3833,33 +3914,6 @@ RotoPaintPrivate::isRotoPaintTreeConcatenatableInternal(const std::list<RotoDraw
                 return false;
             }
         }
-
-        // Now check the global activated/solo switches
-        if (!(*it)->isGloballyActivated()) {
-            return false;
-        }
-
-        RotoStrokeType type = (*it)->getBrushType();
-
-        // Other item types cannot concatenate since they use a custom mask on their Merge node.
-        if (type != eRotoStrokeTypeSolid && type != eRotoStrokeTypeEraser && type != eRotoStrokeTypeComp) {
-            return false;
-        }
-
-
-        // If the comp item has a mask on the merge node or a mix != 1, forget concatenating
-        if (type == eRotoStrokeTypeComp) {
-            if ((*it)->getMergeMaskChoiceKnob()->getValue() > 0) {
-                return false;
-            }
-            KnobDoublePtr mixKnob = (*it)->getMixKnob();
-            if (mixKnob->hasAnimation() || mixKnob->getValue() != 1.) {
-                return false;
-            }
-
-        }
-
-        
     }
     if (operatorSet) {
         *blendingMode = comp_i;
@@ -3933,34 +3987,38 @@ RotoPaintPrivate::getOrCreateGlobalTimeBlurNode()
     return globalTimeBlurNode;
 }
 
+int
+RotoPaintPrivate::getGlobalMergeNodeAvailableInput(const NodePtr& mergeNode)
+{
+    const std::vector<NodeWPtr > &inputs = mergeNode->getInputs();
+
+    // Merge node goes like this: B, A, Mask, A2, A3, A4 ...
+    assert( inputs.size() >= 3 && mergeNode->isInputMask(2) );
+    if ( !inputs[1].lock() ) {
+        return 1;
+    }
+
+    //Leave the B empty to connect the next merge node
+    for (std::size_t i = 3; i < inputs.size(); ++i) {
+        if ( !inputs[i].lock() ) {
+            return (int)i;
+        }
+    }
+    return -1;
+} // getGlobalMergeNodeAvailableInput
+
 NodePtr
-RotoPaintPrivate::getOrCreateGlobalMergeNode(int blendingOperator, int *availableInputIndex)
+RotoPaintPrivate::getOrCreateGlobalMergeNode(int blendingOperator, std::size_t index)
 {
     {
         QMutexLocker k(&globalMergeNodesMutex);
-        for (NodesList::iterator it = globalMergeNodes.begin(); it != globalMergeNodes.end(); ++it) {
-            const std::vector<NodeWPtr > &inputs = (*it)->getInputs();
-
-            // Merge node goes like this: B, A, Mask, A2, A3, A4 ...
-            assert( inputs.size() >= 3 && (*it)->isInputMask(2) );
-            if ( !inputs[1].lock() ) {
-                *availableInputIndex = 1;
-                if (blendingOperator != -1) {
-                    setOperationKnob(*it, blendingOperator);
-                }
-                return *it;
-            }
-
-            //Leave the B empty to connect the next merge node
-            for (std::size_t i = 3; i < inputs.size(); ++i) {
-                if ( !inputs[i].lock() ) {
-                    *availableInputIndex = (int)i;
-                    if (blendingOperator != -1) {
-                        setOperationKnob(*it, blendingOperator);
-                    }
-                    return *it;
-                }
+        if (index < globalMergeNodes.size()) {
+            NodesList::iterator it = globalMergeNodes.begin();
+            std::advance(it, index);
+            if (blendingOperator != -1) {
+                setOperationKnob(*it, blendingOperator);
             }
+            return *it;
         }
     }
 
@@ -4002,7 +4060,6 @@ RotoPaintPrivate::getOrCreateGlobalMergeNode(int blendingOperator, int *availabl
         }
 
     }
-    *availableInputIndex = 1;
     if (blendingOperator != -1) {
         setOperationKnob(mergeNode, blendingOperator);
     }
@@ -4078,11 +4135,27 @@ RotoPaint::loadSubGraph(const SERIALIZATION_NAMESPACE::NodeSerialization* projec
     refreshRotoPaintTree();
 }
 
+bool
+RotoPaint::invalidateHashCacheInternal(std::set<HashableObject*>* invalidatedObjects)
+{
+    // Items add this node as a hash listener: when an item changes, it is in the set of invalidated objects.
+    // Update the index even if the hash was already invalidated by another path.
+    if (_imp->spatialIndex) {
+        _imp->spatialIndex->onHashInvalidated(*invalidatedObjects);
+    }
+    return NodeGroup::invalidateHashCacheInternal(invalidatedObjects);
+}
+
 void
 RotoPaint::refreshRotoPaintTree()
 {
     // Rebuild the internal tree of the RotoPaint node group from items and parameters.
 
+    // Items were added or removed: their spatial index must be rebuilt even if the tree refresh is blocked
+    if (_imp->spatialIndex) {
+        _imp->spatialIndex->invalidate();
+    }
+
     if (_imp->treeRefreshBlocked) {
         return;
     }
@@ -4094,9 +4167,35 @@ RotoPaint::refreshRotoPaintTree()
     // Check if the tree can be concatenated into a single merge node
     int blendingOperator = -1;
     bool canConcatenate = _imp->isRotoPaintTreeConcatenatableInternal(items, &blendingOperator);
-    NodePtr globalMerge;
-    int globalMergeIndex = -1;
 
+    // Otherwise, split the items in runs of consecutive items that can be concatenated with the same operator.
+    // The items of a run are connected to the A inputs of global merge nodes instead of being chained: they no longer
+    // depend on each other and are rendered concurrently by the tree render, then composited in order in a single pass
+    // by the merge node.
+    std::vector<RotoDrawableItemPtr> itemsVec(items.begin(), items.end());
+    std::vector<int> runOperators(itemsVec.size(), -1);
+    std::vector<int> runStarts(itemsVec.size(), -1);
+    {
+        std::size_t runStart = 0;
+        int runOperator = -1;
+        for (std::size_t i = 0; i <= itemsVec.size(); ++i) {
+            int op = -1;
+            bool concatenatable = i < itemsVec.size() && _imp->isRotoPaintItemConcatenatable(itemsVec[i], &op);
+            if (concatenatable && i > runStart && op == runOperator) {
+                continue;
+            }
+
+            // The run [runStart, i) ended
+            if ( runOperator != -1 && (canConcatenate || i - runStart >= NATRON_ROTOPAINT_MIN_CONCATENATED_RUN_LENGTH) ) {
+                for (std::size_t j = runStart; j < i; ++j) {
+                    runOperators[j] = runOperator;
+                    runStarts[j] = (int)runStart;
+                }
+            }
+            runStart = i;
+            runOperator = concatenatable ? op : -1;
+        }
+    }
 
     {
         NodesList mergeNodes;
@@ -4116,31 +4215,24 @@ RotoPaint::refreshRotoPaintTree()
             (*it)->endInputEdition(false /*triggerRender*/);
         }
     }
-
-    
-
-    // Get the first global merge node.
-    globalMerge = _imp->getOrCreateGlobalMergeNode(blendingOperator, &globalMergeIndex);
+    {
+        QMutexLocker k(&_imp->stackOutputNodesMutex);
+        _imp->stackOutputNodes.clear();
+    }
 
 
     RotoPaintPtr rotoPaintEffect = toRotoPaint(getNode()->getEffectInstance());
     assert(rotoPaintEffect);
 
-    // If concatenation enabled, connect the B input of the global Merge to the RotoPaint
-    // background input node.
-    if (canConcatenate) {
-        NodePtr rotoNodeBg;
-        if (getRotoPaintNodeType() != eRotoPaintTypeComp) {
-            rotoNodeBg = rotoPaintEffect->getInternalInputNode(0);
-        } else {
-            // the background for a comp node is the constant node of the first item.
-            if (!items.empty()) {
-                rotoNodeBg = items.front()->getBackgroundNode();
-            }
+    // The B input of the global merge of a run starting with the first item is the RotoPaint background input node.
+    NodePtr rotoNodeBg;
+    if (getRotoPaintNodeType() != eRotoPaintTypeComp) {
+        rotoNodeBg = rotoPaintEffect->getInternalInputNode(0);
+    } else {
+        // the background for a comp node is the constant node of the first item.
+        if (!items.empty()) {
+            rotoNodeBg = items.front()->getBackgroundNode();
         }
-
-        globalMerge->swapInput(rotoNodeBg, 0);
-
     }
 
     // Refresh each item separately
@@ -4148,59 +4240,90 @@ RotoPaint::refreshRotoPaintTree()
     Point nodePosition = {0.,0.};
     Point mergeNodeBeginPos = {0, 300};
 
-    std::list<RotoDrawableItemPtr >::const_iterator prev = items.end();
-    --prev;
-    for (std::list<RotoDrawableItemPtr >::const_iterator it = items.begin(); it != items.end(); ++it) {
+    // Nodes whose output is cached to avoid compositing again the whole stack when an item changes
+    std::set<NodeWPtr> checkpointNodes;
 
-        if (prev == items.end()) {
-            prev = items.begin();
-        } else {
-            ++prev;
-        }
+    // The global merge node receiving the items of the current run
+    NodePtr globalMerge;
+    std::size_t nGlobalMergeNodes = 0;
+
+    for (std::size_t itemIndex = 0; itemIndex < itemsVec.size(); ++itemIndex) {
+
+        const RotoDrawableItemPtr& item = itemsVec[itemIndex];
         RotoDrawableItemPtr previousItem;
-        if (prev != items.end()) {
-            previousItem = *prev;
+        if (itemIndex > 0) {
+            previousItem = itemsVec[itemIndex - 1];
         }
-        (*it)->refreshNodesConnections(previousItem);
-        (*it)->refreshNodesPositions(nodePosition.x, nodePosition.y);
+        item->refreshNodesConnections(previousItem);
+        item->refreshNodesPositions(nodePosition.x, nodePosition.y);
 
         // Place each item tree on the right
         nodePosition.x += 200;
 
-        if (canConcatenate) {
+        int runOperator = runOperators[itemIndex];
+        if (runOperator == -1) {
+            // Each merge node composites its item on top of the output of the previous item, hence its hash
+            // depends on all items below and its output can be reused as long as none of them changes.
+            if ( (itemIndex + 1) % NATRON_ROTOPAINT_COMPOSITING_CHECKPOINT_INTERVAL == 0 ) {
+                NodePtr itemMerge = item->getMergeNode();
+                if (itemMerge) {
+                    checkpointNodes.insert(itemMerge);
+                }
+            }
+            continue;
+        }
 
-            // If we concatenate the tree, connect the global merge Ax input to the effect
+        if (runStarts[itemIndex] == (int)itemIndex) {
+            // Start a new run on top of the output of the items below it
+            if (globalMerge) {
+                mergeNodeBeginPos.y -= 200;
+            }
+            globalMerge = _imp->getOrCreateGlobalMergeNode(runOperator, nGlobalMergeNodes++);
+            globalMerge->swapInput(previousItem ? getStackOutputNode(previousItem) : rotoNodeBg, 0);
+        }
 
-            NodePtr mergeInputA = (*it)->getMergeNode()->getInput(1);
-            if (mergeInputA) {
-                //qDebug() << "Connecting" << (*it)->getScriptName().c_str() << "to input" << globalMergeIndex <<
-                //"(" << globalMerge->getInputLabel(globalMergeIndex).c_str() << ")" << "of" << globalMerge->getScriptName().c_str();
-                globalMerge->swapInput(mergeInputA, globalMergeIndex);
+        // Connect the global merge Ax input to the effect
+        NodePtr mergeInputA = item->getMergeNode()->getInput(1);
+        if (mergeInputA) {
+            int globalMergeIndex = RotoPaintPrivate::getGlobalMergeNodeAvailableInput(globalMerge);
+            if (globalMergeIndex == -1) {
+                // The global merge node has all its A inputs connected, continue the run in a new one.
+                NodePtr nextMerge = _imp->getOrCreateGlobalMergeNode(runOperator, nGlobalMergeNodes++);
 
-                // If the global merge node has all its A inputs connected, create a new one, otherwise get the next A input.
-                NodePtr nextMerge = _imp->getOrCreateGlobalMergeNode(blendingOperator, &globalMergeIndex);
-                if (nextMerge != globalMerge) {
+                // Place the global merge below at the average of all nodes used
+                mergeNodeBeginPos.x = (nodePosition.x + mergeNodeBeginPos.x) / 2.;
+                globalMerge->setPosition(mergeNodeBeginPos.x, mergeNodeBeginPos.y);
 
-                    // Place the global merge below at the average of all nodes used
-                    mergeNodeBeginPos.x = (nodePosition.x + mergeNodeBeginPos.x) / 2.;
-                    globalMerge->setPosition(mergeNodeBeginPos.x, mergeNodeBeginPos.y);
+                mergeNodeBeginPos.y -= 200;
 
-                    mergeNodeBeginPos.y -= 200;
+                // Connect the B input of the new merge to the previous global merge.
+                assert( !nextMerge->getInput(0) );
+                nextMerge->connectInput(globalMerge, 0);
 
-                    // If we made a new merge node, connect the B input of the new merge to the previous global merge.
-                    assert( !nextMerge->getInput(0) );
-                    nextMerge->connectInput(globalMerge, 0);
-                    globalMerge = nextMerge;
-                }
+                // The output of each full global merge node is a checkpoint
+                checkpointNodes.insert(globalMerge);
+                globalMerge = nextMerge;
+                globalMergeIndex = RotoPaintPrivate::getGlobalMergeNodeAvailableInput(globalMerge);
             }
+            //qDebug() << "Connecting" << item->getScriptName().c_str() << "to input" << globalMergeIndex <<
+            //"(" << globalMerge->getInputLabel(globalMergeIndex).c_str() << ")" << "of" << globalMerge->getScriptName().c_str();
+            globalMerge->swapInput(mergeInputA, globalMergeIndex);
         }
 
+        if ( itemIndex + 1 == itemsVec.size() || runStarts[itemIndex + 1] != runStarts[itemIndex] ) {
+            // The run ends with this item: the items above are composited on top of the global merge output
+            {
+                QMutexLocker k(&_imp->stackOutputNodesMutex);
+                _imp->stackOutputNodes[item] = globalMerge;
+            }
+            mergeNodeBeginPos.x = (nodePosition.x + mergeNodeBeginPos.x) / 2.;
+            globalMerge->setPosition(mergeNodeBeginPos.x, mergeNodeBeginPos.y);
+        }
     }
 
-    // Refresh the last global merge position
     {
-        mergeNodeBeginPos.x = (nodePosition.x + mergeNodeBeginPos.x) / 2.;
-        globalMerge->setPosition(mergeNodeBeginPos.x, mergeNodeBeginPos.y);
+        QMutexLocker k(&_imp->checkpointNodesMutex);
+        _imp->checkpointNodes.swap(checkpointNodes);
     }
 
     // At this point all items have their tree OK, now just connect the bottom of the tree
@@ -4263,23 +4386,17 @@ RotoPaint::refreshRotoPaintTree()
     }
 
 
-    if (canConcatenate) {
-        // Connect the bottom of the tree to the last global merge node.
-        _imp->connectRotoPaintBottomTreeToItems(canConcatenate, rotoPaintEffect, premultNode,  timeBlurNode, treeOutputNode, _imp->globalMergeNodes.back());
+    if (!items.empty()) {
+        // Connect the bottom of the tree to the node outputting the last item, which is the last global merge node if concatenated.
+        _imp->connectRotoPaintBottomTreeToItems(canConcatenate, rotoPaintEffect, premultNode, timeBlurNode, treeOutputNode, getStackOutputNode(items.back()));
     } else {
-
-        if (!items.empty()) {
-            // Connect the bottom of the tree to the last item merge node.
-            _imp->connectRotoPaintBottomTreeToItems(canConcatenate, rotoPaintEffect, premultNode, timeBlurNode, treeOutputNode, items.back()->getMergeNode());
-        } else {
-            // Connect output to Input, the RotoPaint is pass-through. For a LayeredComp node,
-            // there's no background node, so render nothing.
-            NodePtr bgNode;
-            if (getRotoPaintNodeType() != eRotoPaintTypeComp) {
-                bgNode = rotoPaintEffect->getInternalInputNode(0);
-            }
-            treeOutputNode->swapInput(bgNode, 0);
+        // Connect output to Input, the RotoPaint is pass-through. For a LayeredComp node,
+        // there's no background node, so render nothing.
+        NodePtr bgNode;
+        if (getRotoPaintNodeType() != eRotoPaintTypeComp) {
+            bgNode = rotoPaintEffect->getInternalInputNode(0);
         }
+        treeOutputNode->swapInput(bgNode, 0);
     }
 
     if (premultNode) {
@@ -493,8 +493,28 @@ public:
 
     virtual void setupInitialSubGraphState() OVERRIDE FINAL;
 
+    /**
+     * @brief Overriden to keep the spatial index of the items up to date
+     **/
+    virtual bool invalidateHashCacheInternal(std::set<HashableObject*>* invalidatedObjects) OVERRIDE FINAL;
+
     NodePtr getPremultNode() const;
 
+    /**
+     * @brief Returns true if the given node of the internal tree composites a block of items of the stack on top of all
+     * items below it. Its output is cached so that when an item changes, only the items above the
+     * nearest checkpoint below it need to be composited again.
+     * MT-safe
+     **/
+    bool isCompositingCheckpoint(const NodePtr& node) const;
+
+    /**
+     * @brief Returns the node of the internal tree that outputs the given item composited on top of all items below it.
+     * This is the merge node of the item, unless the item ends a run of items concatenated in global merge nodes.
+     * MT-safe
+     **/
+    NodePtr getStackOutputNode(const RotoDrawableItemPtr& item) const;
+
     NodePtr getInternalInputNode(int index) const;
 
     void getEnabledChannelKnobs(KnobBoolPtr* r,KnobBoolPtr* g, KnobBoolPtr* b, KnobBoolPtr *a) const;
@@ -1521,8 +1521,14 @@ RotoPaintInteract::isNearbyBezier(double x,
 
 
     std::list<std::pair<BezierPtr, std::pair<int, double> > > nearbyBeziers;
-    std::vector<KnobTableItemPtr> allItems = _imp->knobsTable->getAllItems();
-    for (std::vector<KnobTableItemPtr>::const_iterator it = allItems.begin(); it!=allItems.end(); ++it) {
+
+    // Only test the items whose bounding box is within the acceptance distance of the point
+    std::vector<RotoDrawableItemPtr> candidates;
+    {
+        RectD pickRect(x - acceptance, y - acceptance, x + acceptance, y + acceptance);
+        _imp->spatialIndex->getItemsIntersecting(time, view, pickRect, &candidates);
+    }
+    for (std::vector<RotoDrawableItemPtr>::const_iterator it = candidates.begin(); it!=candidates.end(); ++it) {
         BezierPtr b = toBezier(*it);
         if ( b && !b->isLockedRecursive() ) {
             double param;
@@ -69,7 +69,12 @@ RotoPaintPrivate::RotoPaintPrivate(RotoPaint* publicInterface,
     , inputNodes()
     , premultNode()
     , knobsTable()
+    , spatialIndex()
     , globalMergeNodes()
+    , stackOutputNodesMutex()
+    , stackOutputNodes()
+    , checkpointNodesMutex()
+    , checkpointNodes()
     , treeRefreshBlocked(0)
 {
 }
@@ -28,6 +28,8 @@
 #include "Global/Macros.h"
 
 #include <list>
+#include <map>
+#include <set>
 #if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
 #include <boost/enable_shared_from_this.hpp>
 #endif
@@ -45,6 +47,7 @@
 #include "Engine/PlanarTrackerInteract.h"
 #endif
 #include "Engine/RotoPaint.h"
+#include "Engine/RotoItemsSpatialIndex.h"
 #include "Engine/KnobItemsTable.h"
 #include "Engine/TransformOverlayInteract.h"
 #include "Engine/TrackArgs.h"
@@ -675,11 +678,22 @@ public:
 
     boost::shared_ptr<RotoPaintKnobItemsTable> knobsTable;
 
-    // Merge node (or more if there are more than 64 items) used when all items share the same compositing operator to make the rotopaint tree shallow
+    // Bounding volume hierarchy over the items bounding boxes, used to find items under the cursor
+    boost::scoped_ptr<RotoItemsSpatialIndex> spatialIndex;
+
+    // Merge nodes (or more if there are more than 64 items) used to composite runs of consecutive items sharing the same compositing operator to make the rotopaint tree shallow
     mutable QMutex globalMergeNodesMutex;
     NodesList globalMergeNodes;
+
+    // For the last item of each concatenated run, the global merge node that outputs the run on top of the items below it
+    mutable QMutex stackOutputNodesMutex;
+    std::map<RotoDrawableItemWPtr, NodeWPtr> stackOutputNodes;
     NodePtr globalTimeBlurNode;
 
+    // Nodes of the tree whose output accumulates a block of items, see RotoPaint::isCompositingCheckpoint
+    mutable QMutex checkpointNodesMutex;
+    std::set<NodeWPtr> checkpointNodes;
+
     // The temporary solo items
     mutable QMutex soloItemsMutex;
     std::set<RotoDrawableItemWPtr> soloItems;
@@ -736,7 +750,7 @@ public:
     KnobBoolWPtr enableTrackRed, enableTrackGreen, enableTrackBlue;
     KnobDoubleWPtr maxError;
     KnobIntWPtr maxIterations;
-    KnobBoolWPtr bruteForcePreTrack, useNormalizedIntensities;
+    KnobBoolWPtr bruteForcePreTrack, useNormalizedIntensities, coarseToFine;
     KnobDoubleWPtr preBlurSigma;
     KnobChoiceWPtr motionModel;
     KnobIntWPtr trackerReferenceFrame;
@@ -805,6 +819,7 @@ public:
     virtual bool isBruteForcePreTrackEnabled() const OVERRIDE FINAL;
     virtual bool isNormalizeIntensitiesEnabled() const OVERRIDE FINAL;
     virtual double getPreBlurSigma() const OVERRIDE FINAL;
+    virtual bool isCoarseToFineEnabled() const OVERRIDE FINAL;
     virtual RectD getNormalizationRoD(TimeValue time, ViewIdx view) const OVERRIDE FINAL;
     ////////////////////
 
@@ -813,10 +828,15 @@ public:
     void setFromPointsToInputRod();
 #endif
 
-    NodePtr getOrCreateGlobalMergeNode(int blendingOperator, int *availableInputIndex);
+    NodePtr getOrCreateGlobalMergeNode(int blendingOperator, std::size_t index);
+
+    static int getGlobalMergeNodeAvailableInput(const NodePtr& mergeNode);
 
     NodePtr getOrCreateGlobalTimeBlurNode();
 
+    bool isRotoPaintItemConcatenatable(const RotoDrawableItemPtr& item,
+                                       int* blendingMode) const;
+
     bool isRotoPaintTreeConcatenatableInternal(const std::list<RotoDrawableItemPtr >& items,
                                                int* blendingMode) const;
 
@@ -192,8 +192,9 @@ static const char* rotoSmearDot_FragmentShader =
 "}"
 ;
 
-RotoShapeRenderNodeOpenGLData::RotoShapeRenderNodeOpenGLData(bool isGPUContext)
-: EffectOpenGLContextData(isGPUContext)
+RotoShapeRenderNodeOpenGLData::RotoShapeRenderNodeOpenGLData(const OSGLContextPtr& glContext)
+: EffectOpenGLContextData(glContext->isGPUContext())
+, _glContext(glContext)
 , _iboID(0)
 , _vboVerticesID(0)
 , _vboColorsID(0)
@@ -206,6 +207,15 @@ RotoShapeRenderNodeOpenGLData::RotoShapeRenderNodeOpenGLData(bool isGPUContext)
 
 }
 
+void
+RotoShapeRenderNodeOpenGLData::recordShaderProgram(const GLShaderBasePtr& shader)
+{
+    OSGLContextPtr glContext = _glContext.lock();
+    if (glContext) {
+        glContext->recordShaderProgram(shader);
+    }
+}
+
 void
 RotoShapeRenderNodeOpenGLData::cleanup()
 {
@@ -386,7 +396,7 @@ RotoShapeRenderNodeOpenGLData::getOrCreateFeatherRampShader(RampTypeEnum type)
     } else {
         _featherRampShader[type_i] = getOrCreateFeatherRampShaderInternal<GL_CPU>(type);
     }
-
+    recordShaderProgram(_featherRampShader[type_i]);
     return _featherRampShader[type_i];
 }
 
@@ -453,7 +463,7 @@ RotoShapeRenderNodeOpenGLData::getOrCreateStrokeDotShader(bool buildUp)
     } else {
         _strokeDotShader[index] = getOrCreateStrokeDotShaderInternal<GL_CPU>(buildUp);
     }
-
+    recordShaderProgram(_strokeDotShader[index]);
     return _strokeDotShader[index];
 }
 
@@ -533,6 +543,7 @@ RotoShapeRenderNodeOpenGLData::getOrCreateAccumulateShader()
     } else {
         _accumShader = getOrCreateAccumShaderInternal<GL_CPU>();
     }
+    recordShaderProgram(_accumShader);
     return _accumShader;
 }
 
@@ -547,6 +558,7 @@ RotoShapeRenderNodeOpenGLData::getOrCreateDivideShader()
     } else {
         _divideShader = getOrCreateDivideShaderInternal<GL_CPU>();
     }
+    recordShaderProgram(_divideShader);
     return _divideShader;
 }
 
@@ -595,7 +607,7 @@ RotoShapeRenderNodeOpenGLData::getOrCreateStrokeSecondPassShader()
     } else {
         _strokeDotSecondPassShader = getOrCreateStrokeSecondPassShaderInternal<GL_CPU>();
     }
-
+    recordShaderProgram(_strokeDotSecondPassShader);
     return _strokeDotSecondPassShader;
 }
 
@@ -658,7 +670,7 @@ RotoShapeRenderNodeOpenGLData::getOrCreateSmearShader()
     } else {
         _smearShader = getOrCreateSmearShaderInternal<GL_CPU>();
     }
-
+    recordShaderProgram(_smearShader);
     return _smearShader;
 }
 
@@ -74,6 +74,9 @@ enum RampTypeEnum
 
 class RotoShapeRenderNodeOpenGLData : public EffectOpenGLContextData
 {
+    // The context for which this data was created, used to account the shader programs in its statistics
+    OSGLContextWPtr _glContext;
+
     unsigned int _iboID;
     unsigned int _vboVerticesID;
     unsigned int _vboColorsID;
@@ -91,7 +94,7 @@ public:
 
     void cleanup();
 
-    RotoShapeRenderNodeOpenGLData(bool isGPUContext);
+    RotoShapeRenderNodeOpenGLData(const OSGLContextPtr& glContext);
 
     unsigned int getOrCreateIBOID();
 
@@ -116,6 +119,10 @@ public:
     GLShaderBasePtr getOrCreateSmearShader();
 
     virtual ~RotoShapeRenderNodeOpenGLData();
+
+private:
+
+    void recordShaderProgram(const GLShaderBasePtr& shader);
     
 };
 
@@ -25,6 +25,7 @@
 #include "RotoUndoCommand.h"
 
 #include <stdexcept>
+#include <set>
 
 CLANG_DIAG_OFF(deprecated)
 CLANG_DIAG_OFF(uninitialized)
@@ -37,6 +38,7 @@ CLANG_DIAG_ON(uninitialized)
 
 #include "Engine/Bezier.h"
 #include "Engine/BezierCP.h"
+#include "Engine/Curve.h"
 #include "Engine/FeatherPoint.h"
 #include "Engine/KnobTypes.h"
 #include "Engine/Node.h"
@@ -57,6 +59,68 @@ typedef std::list<SelectedCp> SelectedCpList;
 typedef BezierPtr BezierPtr;
 typedef std::list<BezierPtr> BezierList;
 
+static std::size_t
+getControlPointMemoryCost(const BezierCPPtr& cp)
+{
+    if (!cp) {
+        return 0;
+    }
+    std::set<double> keys;
+    cp->getKeyframeTimes(&keys);
+
+    // Each keyframe is stored in the 6 curves of the point: position and both tangents
+    return sizeof(BezierCP) + keys.size() * 6 * sizeof(KeyFrame);
+}
+
+static std::size_t
+getBezierMemoryCost(const BezierPtr& curve)
+{
+    if (!curve) {
+        return 0;
+    }
+    std::size_t ret = sizeof(Bezier);
+    std::list<ViewIdx> views = curve->getViewsList();
+    for (std::list<ViewIdx>::const_iterator it = views.begin(); it != views.end(); ++it) {
+        std::list<BezierCPPtr> cps = curve->getControlPoints(*it);
+        for (std::list<BezierCPPtr>::const_iterator it2 = cps.begin(); it2 != cps.end(); ++it2) {
+            ret += getControlPointMemoryCost(*it2);
+        }
+        std::list<BezierCPPtr> fps = curve->getFeatherPoints(*it);
+        for (std::list<BezierCPPtr>::const_iterator it2 = fps.begin(); it2 != fps.end(); ++it2) {
+            ret += getControlPointMemoryCost(*it2);
+        }
+    }
+    return ret;
+}
+
+static std::size_t
+getCurveMemoryCost(const CurvePtr& curve)
+{
+    if (!curve) {
+        return 0;
+    }
+    return sizeof(Curve) + curve->getKeyFramesCount() * sizeof(KeyFrame);
+}
+
+static std::size_t
+getStrokeMemoryCost(const RotoStrokeItemPtr& item)
+{
+    if (!item) {
+        return 0;
+    }
+    std::size_t ret = sizeof(RotoStrokeItem);
+    std::list<CurvePtr> xCurves = item->getXControlPoints();
+    std::list<CurvePtr> yCurves = item->getYControlPoints();
+    for (std::list<CurvePtr>::const_iterator it = xCurves.begin(); it != xCurves.end(); ++it) {
+        // The pressure curve of the sub-stroke has as many keyframes as the x curve
+        ret += 2 * getCurveMemoryCost(*it);
+    }
+    for (std::list<CurvePtr>::const_iterator it = yCurves.begin(); it != yCurves.end(); ++it) {
+        ret += getCurveMemoryCost(*it);
+    }
+    return ret;
+}
+
 MoveControlPointsUndoCommand::MoveControlPointsUndoCommand(const RotoPaintInteractPtr& roto,
                                                            const std::list< std::pair<BezierCPPtr, BezierCPPtr > > & toDrag
                                                            ,
@@ -596,6 +660,21 @@ RemovePointUndoCommand::redo()
     _firstRedoCalled = true;
 }
 
+std::size_t
+RemovePointUndoCommand::getMemoryCost() const
+{
+    std::size_t ret = UndoCommand::getMemoryCost() + sizeof(RemovePointUndoCommand) - sizeof(UndoCommand);
+    for (std::list<CurveDesc>::const_iterator it = _curves.begin(); it != _curves.end(); ++it) {
+        // The copy of the curve before the points were removed
+        ret += sizeof(CurveDesc) + getBezierMemoryCost(it->oldCurve);
+        if (it->curveRemoved) {
+            // The curve is no longer in the model, only this command holds it
+            ret += getBezierMemoryCost(it->curve);
+        }
+    }
+    return ret;
+}
+
 //////////////////////////
 
 
@@ -651,6 +730,12 @@ AddStrokeUndoCommand::redo()
     _firstRedoCalled = true;
 }
 
+std::size_t
+AddStrokeUndoCommand::getMemoryCost() const
+{
+    return UndoCommand::getMemoryCost() + sizeof(AddStrokeUndoCommand) - sizeof(UndoCommand) + getStrokeMemoryCost(_item);
+}
+
 AddMultiStrokeUndoCommand::AddMultiStrokeUndoCommand(const RotoPaintInteractPtr& roto,
                                                      const RotoStrokeItemPtr& item)
     : UndoCommand()
@@ -711,6 +796,17 @@ AddMultiStrokeUndoCommand::redo()
     _firstRedoCalled = true;
 }
 
+std::size_t
+AddMultiStrokeUndoCommand::getMemoryCost() const
+{
+    std::size_t ret = UndoCommand::getMemoryCost() + sizeof(AddMultiStrokeUndoCommand) - sizeof(UndoCommand);
+    ret += getCurveMemoryCost(_xCurve) + getCurveMemoryCost(_yCurve) + getCurveMemoryCost(_pCurve);
+    if (isRemoved) {
+        ret += getStrokeMemoryCost(_item);
+    }
+    return ret;
+}
+
 MoveTangentUndoCommand::MoveTangentUndoCommand(const RotoPaintInteractPtr& roto,
                                                double dx,
                                                double dy,
@@ -1342,8 +1438,8 @@ MakeBezierUndoCommand::MakeBezierUndoCommand(const RotoPaintInteractPtr& roto,
     , _roto(roto)
     , _parentLayer()
     , _indexInLayer(0)
-    , _oldCurve()
     , _newCurve(curve)
+    , _removedPoint()
     , _curveNonExistant(false)
     , _createdPoint(createPoint)
     , _x(dx)
@@ -1356,10 +1452,6 @@ MakeBezierUndoCommand::MakeBezierUndoCommand(const RotoPaintInteractPtr& roto,
 {
     if (!_newCurve) {
         _curveNonExistant = true;
-    } else {
-        // If the curve already exists, copy its current state
-        _oldCurve.reset( new Bezier(_newCurve->getModel(), _newCurve->getBaseItemName(), _newCurve->isOpenBezier()));
-        _oldCurve->copyItem( *_newCurve );
     }
     setText( tr("Draw Bezier").toStdString() );
 }
@@ -1380,7 +1472,24 @@ MakeBezierUndoCommand::undo()
     assert(_createdPoint);
     roto->setCurrentTool( roto->drawBezierAction.lock() );
     assert(_lastPointAdded != -1);
-    _oldCurve->copyItem(*_newCurve);
+
+    // Copy the point before removing it so that redo() can restore it
+    _removedPoint.clear();
+    std::list<ViewIdx> views = _newCurve->getViewsList();
+    for (std::list<ViewIdx>::const_iterator it = views.begin(); it != views.end(); ++it) {
+        BezierCPPtr cp = _newCurve->getControlPointAtIndex(_lastPointAdded, *it);
+        BezierCPPtr fp = _newCurve->getFeatherPointAtIndex(_lastPointAdded, *it);
+        CpPtr cpCopy, fpCopy;
+        if (cp) {
+            cpCopy.reset( new BezierCP(*cp) );
+        }
+        if (fp) {
+            fpCopy.reset( new FeatherPoint(_newCurve) );
+            fpCopy->copyControlPoint(*fp);
+        }
+        _removedPoint[*it] = std::make_pair(cpCopy, fpCopy);
+    }
+
     if (_newCurve->getControlPointsCount(ViewIdx(0)) == 1) {
         _curveNonExistant = true;
         roto->removeCurve(_newCurve);
@@ -1413,12 +1522,9 @@ MakeBezierUndoCommand::redo()
             if (!_newCurve) {
                 _newCurve = roto->_imp->publicInterface->makeBezier(_x, _y, _isOpenBezier ? tr(kRotoOpenBezierBaseName).toStdString() : tr(kRotoBezierBaseName).toStdString(), _time, _isOpenBezier);
                 assert(_newCurve);
-                _oldCurve.reset( new Bezier(_newCurve->getModel(), _newCurve->getBaseItemName(), _newCurve->isOpenBezier()));
-                _oldCurve->copyItem(*_newCurve);
                 _lastPointAdded = 0;
                 _curveNonExistant = false;
             } else {
-                _oldCurve->copyItem(*_newCurve);
                 _newCurve->addControlPoint(_x, _y, _time, ViewSetSpec::all());
                 int lastIndex = _newCurve->getControlPointsCount(ViewIdx(0)) - 1;
                 assert(lastIndex > 0);
@@ -1426,7 +1532,6 @@ MakeBezierUndoCommand::redo()
             }
         } else {
             assert(_newCurve);
-            _oldCurve->copyItem(*_newCurve);
             int lastIndex = _newCurve->getControlPointsCount(ViewIdx(0)) - 1;
             assert(lastIndex >= 0);
             _lastPointAdded = lastIndex;
@@ -1440,7 +1545,22 @@ MakeBezierUndoCommand::redo()
             _indexInLayer = _newCurve->getIndexInParent();
         }
     } else {
-        _newCurve->copyItem(*_oldCurve);
+        // Add back the point removed by undo() and restore its state
+        _newCurve->addControlPoint(_x, _y, _time, ViewSetSpec::all());
+        assert(_newCurve->getControlPointsCount(ViewIdx(0)) - 1 == _lastPointAdded);
+        for (std::map<ViewIdx, std::pair<BezierCPPtr, BezierCPPtr> >::const_iterator it = _removedPoint.begin(); it != _removedPoint.end(); ++it) {
+            BezierCPPtr cp = _newCurve->getControlPointAtIndex(_lastPointAdded, it->first);
+            BezierCPPtr fp = _newCurve->getFeatherPointAtIndex(_lastPointAdded, it->first);
+            if (cp && it->second.first) {
+                cp->copyControlPoint(*it->second.first);
+            }
+            if (fp && it->second.second) {
+                fp->copyControlPoint(*it->second.second);
+            }
+        }
+        _removedPoint.clear();
+        _newCurve->invalidateCacheHashAndEvaluate(true, false);
+
         if (_curveNonExistant) {
             roto->_imp->knobsTable->insertItem(_indexInLayer, _newCurve, _parentLayer, eTableChangeReasonViewer);
         }
@@ -1476,6 +1596,16 @@ MakeBezierUndoCommand::mergeWith(const UndoCommandPtr& other)
     return true;
 }
 
+std::size_t
+MakeBezierUndoCommand::getMemoryCost() const
+{
+    std::size_t ret = UndoCommand::getMemoryCost() + sizeof(MakeBezierUndoCommand) - sizeof(UndoCommand);
+    for (std::map<ViewIdx, std::pair<BezierCPPtr, BezierCPPtr> >::const_iterator it = _removedPoint.begin(); it != _removedPoint.end(); ++it) {
+        ret += getControlPointMemoryCost(it->second.first) + getControlPointMemoryCost(it->second.second);
+    }
+    return ret;
+}
+
 //////////////////////////////
 
 
@@ -1641,6 +1771,12 @@ MakeEllipseUndoCommand::mergeWith(const UndoCommandPtr &other)
     return true;
 }
 
+std::size_t
+MakeEllipseUndoCommand::getMemoryCost() const
+{
+    return UndoCommand::getMemoryCost() + sizeof(MakeEllipseUndoCommand) - sizeof(UndoCommand) + getBezierMemoryCost(_curve);
+}
+
 ////////////////////////////////////
 
 
@@ -1773,4 +1909,10 @@ MakeRectangleUndoCommand::mergeWith(const UndoCommandPtr &other)
     return true;
 }
 
+std::size_t
+MakeRectangleUndoCommand::getMemoryCost() const
+{
+    return UndoCommand::getMemoryCost() + sizeof(MakeRectangleUndoCommand) - sizeof(UndoCommand) + getBezierMemoryCost(_curve);
+}
+
 NATRON_NAMESPACE_EXIT
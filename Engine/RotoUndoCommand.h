@@ -194,6 +194,7 @@ public:
 
     virtual void undo() OVERRIDE FINAL;
     virtual void redo() OVERRIDE FINAL;
+    virtual std::size_t getMemoryCost() const OVERRIDE FINAL;
 
 private:
     RotoPaintInteractWPtr _roto;
@@ -225,6 +226,7 @@ public:
     virtual ~AddStrokeUndoCommand();
     virtual void undo() OVERRIDE FINAL;
     virtual void redo() OVERRIDE FINAL;
+    virtual std::size_t getMemoryCost() const OVERRIDE FINAL;
 
 private:
 
@@ -248,6 +250,7 @@ public:
     virtual ~AddMultiStrokeUndoCommand();
     virtual void undo() OVERRIDE FINAL;
     virtual void redo() OVERRIDE FINAL;
+    virtual std::size_t getMemoryCost() const OVERRIDE FINAL;
 
 private:
 
@@ -448,6 +451,7 @@ public:
     virtual void undo() OVERRIDE FINAL;
     virtual void redo() OVERRIDE FINAL;
     virtual bool mergeWith(const UndoCommandPtr& other) OVERRIDE FINAL;
+    virtual std::size_t getMemoryCost() const OVERRIDE FINAL;
     BezierPtr  getCurve() const
     {
         return _newCurve;
@@ -458,7 +462,11 @@ private:
     RotoPaintInteractWPtr _roto;
     RotoLayerPtr _parentLayer;
     int _indexInLayer;
-    BezierPtr _oldCurve, _newCurve;
+    BezierPtr _newCurve;
+
+    // For each view, a copy of the control point and feather point removed by undo(), so that redo() can add them back.
+    // Only the point added by this command is stored, not the whole curve.
+    std::map<ViewIdx, std::pair<BezierCPPtr, BezierCPPtr> > _removedPoint;
     bool _curveNonExistant;
     bool _createdPoint;
     double _x, _y;
@@ -491,6 +499,7 @@ public:
     virtual void undo() OVERRIDE FINAL;
     virtual void redo() OVERRIDE FINAL;
     virtual bool mergeWith(const UndoCommandPtr& other) OVERRIDE FINAL;
+    virtual std::size_t getMemoryCost() const OVERRIDE FINAL;
 
 private:
     bool _firstRedoCalled;
@@ -529,6 +538,7 @@ public:
     virtual void undo() OVERRIDE FINAL;
     virtual void redo() OVERRIDE FINAL;
     virtual bool mergeWith(const UndoCommandPtr& other) OVERRIDE FINAL;
+    virtual std::size_t getMemoryCost() const OVERRIDE FINAL;
 
 private:
     bool _firstRedoCalled;
@@ -116,7 +116,9 @@ public:
     KnobBoolPtr _autoSaveUnSavedProjects;
     KnobPathPtr _fileDialogSavedPaths;
     KnobIntPtr _autoSaveDelay;
+    KnobIntPtr _maxUndoRedoMemoryMB;
     KnobBoolPtr _saveSafetyMode;
+    KnobBoolPtr _logPerformanceStatistics;
     KnobChoicePtr _hostName;
     KnobStringPtr _customHostName;
 
@@ -131,6 +133,7 @@ public:
     KnobBoolPtr _convertNaNValues;
     KnobBoolPtr _activateRGBSupport;
     KnobBoolPtr _activateTransformConcatenationSupport;
+    KnobBoolPtr _streamPixelLocalEffects;
 
     // General/GPU rendering
     KnobPagePtr _gpuPage;
@@ -810,6 +813,17 @@ SettingsPrivate::initializeKnobsGeneral()
     _generalTab->addKnob(_autoSaveDelay);
 
 
+    _maxUndoRedoMemoryMB = _publicInterface->createKnob<KnobInt>("maxUndoRedoMemory");
+    _maxUndoRedoMemoryMB->setLabel(tr("Maximum undo/redo memory (MB)"));
+    _maxUndoRedoMemoryMB->disableSlider();
+    _maxUndoRedoMemoryMB->setRange(0, INT_MAX);
+    _maxUndoRedoMemoryMB->setHintToolTip( tr("The maximum amount of memory, in MiB, used by the undo/redo history of all panels. "
+                                             "Past this limit, the oldest events are deleted forever and can no longer be undone. "
+                                             "Set to 0 to remove the limit.") );
+    _maxUndoRedoMemoryMB->setDefaultValue(512);
+    _generalTab->addKnob(_maxUndoRedoMemoryMB);
+
+
     _autoSaveUnSavedProjects = _publicInterface->createKnob<KnobBool>("autoSaveUnSavedProjects");
     _autoSaveUnSavedProjects->setLabel(tr("Enable Auto-save for unsaved projects"));
     _autoSaveUnSavedProjects->setHintToolTip( tr("When activated %1 will auto-save projects that have never been "
@@ -835,6 +849,15 @@ SettingsPrivate::initializeKnobsGeneral()
                                        "Note that checking this parameter can make project files significantly larger.").arg(QString::fromUtf8(NATRON_APPLICATION_NAME)));
     _generalTab->addKnob(_saveSafetyMode);
 
+    _logPerformanceStatistics = _publicInterface->createKnob<KnobBool>("logPerformanceStatistics");
+    _logPerformanceStatistics->setLabel(tr("Log performance statistics"));
+    _logPerformanceStatistics->setHintToolTip( tr("When checked, %1 writes to the error log information that can help understanding "
+                                                  "its performance, such as the caching decisions taken for each node, the time "
+                                                  "spent creating the parameters of a panel or starting an OpenGL context. "
+                                                  "This should be left unchecked in production as it makes the log grow quickly.").arg( QString::fromUtf8(NATRON_APPLICATION_NAME) ) );
+    _logPerformanceStatistics->setDefaultValue(false);
+    _generalTab->addKnob(_logPerformanceStatistics);
+
 
     _hostName = _publicInterface->createKnob<KnobChoice>("pluginHostName");
     _hostName->setLabel(tr("Appear to plug-ins as"));
@@ -991,6 +1014,15 @@ SettingsPrivate::initializeKnobsRendering()
                                                                "transformations.").arg( QString::fromUtf8(NATRON_APPLICATION_NAME) ) );
     _activateTransformConcatenationSupport->setDefaultValue(true);
     _renderingPage->addKnob(_activateTransformConcatenationSupport);
+
+    _streamPixelLocalEffects = _publicInterface->createKnob<KnobBool>("streamPixelLocalEffects");
+    _streamPixelLocalEffects->setLabel(tr("Stream pixel-local effects"));
+    _streamPixelLocalEffects->setHintToolTip( tr("When checked, chains of effects that declare that they only need the pixel at the same location in their input "
+                                                 "(such as color corrections) are rendered render window by render window: each effect pulls "
+                                                 "its input for the region it is rendering instead of the full image. This reduces the memory "
+                                                 "used by long chains of such effects at the expense of a less efficient use of the cache.") );
+    _streamPixelLocalEffects->setDefaultValue(false);
+    _renderingPage->addKnob(_streamPixelLocalEffects);
 }
 
 void
@@ -3215,6 +3247,12 @@ Settings::getMaximumUndoRedoNodeGraph() const
     return _imp->_maxUndoRedoNodeGraph->getValue();
 }
 
+U64
+Settings::getMaximumUndoRedoMemory() const
+{
+    return (U64)_imp->_maxUndoRedoMemoryMB->getValue() * 1024 * 1024;
+}
+
 int
 Settings::getAutoSaveDelayMS() const
 {
@@ -3515,6 +3553,18 @@ Settings::isTransformConcatenationEnabled() const
     return _imp->_activateTransformConcatenationSupport->getValue();
 }
 
+bool
+Settings::isPerformanceLoggingEnabled() const
+{
+    return _imp->_logPerformanceStatistics->getValue();
+}
+
+bool
+Settings::isPixelLocalStreamingEnabled() const
+{
+    return _imp->_streamPixelLocalEffects->getValue();
+}
+
 bool
 Settings::isMergeAutoConnectingToAInput() const
 {
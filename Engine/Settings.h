@@ -190,6 +190,9 @@ public:
 
     int getMaximumUndoRedoNodeGraph() const;
 
+    // In bytes, 0 if unlimited
+    U64 getMaximumUndoRedoMemory() const;
+
     int getAutoSaveDelayMS() const;
 
     bool isAutoSaveEnabledForUnsavedProjects() const;
@@ -268,6 +271,10 @@ public:
 
     bool isTransformConcatenationEnabled() const;
 
+    bool isPixelLocalStreamingEnabled() const;
+
+    bool isPerformanceLoggingEnabled() const;
+
     bool isMergeAutoConnectingToAInput() const;
 
     /**
@@ -25,6 +25,9 @@
 #include "StorageDeleterThread.h"
 
 #include <list>
+#include <map>
+#include <cmath>
+#include <algorithm>
 
 #include <QMutex>
 #include <QWaitCondition>
@@ -32,6 +35,8 @@
 #include "Engine/AppManager.h"
 #include "Engine/Cache.h"
 #include "Engine/ImageStorage.h"
+#include "Engine/RamBuffer.h"
+#include "Engine/Timer.h"
 
 NATRON_NAMESPACE_ENTER
 
@@ -194,23 +199,135 @@ StorageDeleterThread::run()
       
     }
 } // run
-#if 0
+
+// Maximum amount of memory that may be held by the allocator pool. The pool is also counted in the
+// tile cache budget: it never holds more than what the cache leaves free.
+#define NATRON_STORAGE_ALLOCATOR_MAX_POOL_BYTES 536870912 // = 512 * 1024 * 1024
+
+// Buffers above this size are never pooled
+#define NATRON_STORAGE_ALLOCATOR_MAX_BUFFER_BYTES (NATRON_STORAGE_ALLOCATOR_MAX_POOL_BYTES / 8)
+
+// Period at which the allocation rate is sampled and the pool is trimmed
+#define NATRON_STORAGE_ALLOCATOR_TICK_MS 500
+
+// Number of ticks worth of allocations the pool should be able to serve without allocating
+#define NATRON_STORAGE_ALLOCATOR_LOOKAHEAD_TICKS 1.
+
+// Page size used to pre-fault buffers. This does not have to match the OS page size exactly,
+// touching more often is harmless.
+#define NATRON_STORAGE_ALLOCATOR_PAGE_SIZE 4096
+
+/**
+ * @brief Returns the size class of a buffer of nBytes: sizes are rounded up to a multiple of NATRON_TILE_SIZE_BYTES
+ * and then quantized with 4 steps per power of 2 so that at most 25% of the memory is wasted.
+ **/
+static std::size_t
+getBufferSizeClass(std::size_t nBytes)
+{
+    std::size_t units = (nBytes + NATRON_TILE_SIZE_BYTES - 1) / NATRON_TILE_SIZE_BYTES;
+    if (units <= 4) {
+        return std::max(units, (std::size_t)1) * NATRON_TILE_SIZE_BYTES;
+    }
+    std::size_t po2 = 1;
+    while (po2 * 2 <= units) {
+        po2 *= 2;
+    }
+    std::size_t step = po2 / 4;
+    units = ( (units + step - 1) / step ) * step;
+    return units * NATRON_TILE_SIZE_BYTES;
+}
+
+/**
+ * @brief Touch each page of the buffer so that the OS maps it now rather than on first write in a render thread.
+ **/
+static void
+prefaultBuffer(RamBuffer<char>* buffer)
+{
+    char* data = buffer->getData();
+    std::size_t nBytes = buffer->size();
+    for (std::size_t i = 0; i < nBytes; i += NATRON_STORAGE_ALLOCATOR_PAGE_SIZE) {
+        data[i] = 0;
+    }
+}
+
+struct BufferSizeClassPool
+{
+    // Free pre-faulted buffers
+    std::list<RamBufferPtr> buffers;
+
+    // Number of buffers requested since the last tick
+    int nAllocSinceLastTick;
+
+    // Smoothed number of buffers requested per tick
+    double allocRate;
+
+    BufferSizeClassPool()
+    : buffers()
+    , nAllocSinceLastTick(0)
+    , allocRate(0)
+    {
+
+    }
+
+    std::size_t getLowWatermark() const
+    {
+        return (std::size_t)std::ceil(allocRate * NATRON_STORAGE_ALLOCATOR_LOOKAHEAD_TICKS);
+    }
+
+    std::size_t getHighWatermark() const
+    {
+        return getLowWatermark() * 2;
+    }
+};
+
+typedef std::map<std::size_t, BufferSizeClassPool> BufferSizeClassPoolMap;
 
 struct StorageAllocatorThreadPrivate
 {
     QMutex mustQuitMutex;
     QWaitCondition mustQuitCond;
     bool mustQuit;
-    QMutex checkStorageMutex;
-    QWaitCondition checkStorageCond;
+
+    // Protects all fields below
+    mutable QMutex poolMutex;
+
+    // Woken up to request the thread to refill the pool
+    QWaitCondition refillRequestCond;
+
+    BufferSizeClassPoolMap pool;
+
+    // Total amount of bytes held in the pool
+    std::size_t poolSize;
+
+    // Maximum amount of bytes the pool may hold, see getPoolBudget()
+    std::size_t poolBudget;
+
+    // Number of refill requests not yet handled by the thread
+    int nRefillRequests;
 
     StorageAllocatorThreadPrivate()
     : mustQuitMutex()
     , mustQuitCond()
     , mustQuit(false)
+    , poolMutex()
+    , refillRequestCond()
+    , pool()
+    , poolSize(0)
+    , poolBudget(0)
+    , nRefillRequests(0)
     {
 
     }
+
+    void sampleAllocationRates();
+
+    std::size_t getWantedPoolSize() const;
+
+    std::size_t getPoolBudget(std::size_t wantedPoolSize) const;
+
+    void refillPool();
+
+    void trimPool();
 };
 
 
@@ -237,29 +354,217 @@ StorageAllocatorThread::quitThread()
     _imp->mustQuit = true;
 
     {
-
+        QMutexLocker k2(&_imp->poolMutex);
+        _imp->refillRequestCond.wakeOne();
     }
     while (_imp->mustQuit) {
         _imp->mustQuitCond.wait(&_imp->mustQuitMutex);
     }
     wait();
+
+    clearPool();
+}
+
+RamBufferPtr
+StorageAllocatorThread::allocateBuffer(std::size_t nBytes)
+{
+    std::size_t sizeClass = getBufferSizeClass(nBytes);
+    if (sizeClass > NATRON_STORAGE_ALLOCATOR_MAX_BUFFER_BYTES) {
+        // Too big to be pooled, allocate it directly
+        RamBufferPtr ret(new RamBuffer<char>);
+        ret->resize(nBytes);
+        return ret;
+    }
+
+    {
+        QMutexLocker k(&_imp->poolMutex);
+        BufferSizeClassPool& classPool = _imp->pool[sizeClass];
+        ++classPool.nAllocSinceLastTick;
+        if ( !classPool.buffers.empty() ) {
+            RamBufferPtr ret = classPool.buffers.front();
+            classPool.buffers.pop_front();
+            assert(_imp->poolSize >= sizeClass);
+            _imp->poolSize -= sizeClass;
+
+            // Wake-up the thread if we fall under the low watermark so that it refills this size class
+            // before it is exhausted
+            if (classPool.buffers.size() < classPool.getLowWatermark()) {
+                ++_imp->nRefillRequests;
+                _imp->refillRequestCond.wakeOne();
+            }
+            return ret;
+        }
+
+        // The pool is empty for this size class: let the thread know so that next allocations
+        // do not hit this path.
+        ++_imp->nRefillRequests;
+        _imp->refillRequestCond.wakeOne();
+    }
+
+    // Allocate in this thread: this may throw a std::bad_alloc
+    RamBufferPtr ret(new RamBuffer<char>);
+    ret->resize(sizeClass);
+    return ret;
+} // allocateBuffer
+
+void
+StorageAllocatorThread::recycleBuffer(const RamBufferPtr& buffer)
+{
+    if (!buffer || !buffer->getData()) {
+        return;
+    }
+    std::size_t sizeClass = buffer->size();
+    if (sizeClass > NATRON_STORAGE_ALLOCATOR_MAX_BUFFER_BYTES || getBufferSizeClass(sizeClass) != sizeClass) {
+        // Not allocated by the pool
+        return;
+    }
+    {
+        QMutexLocker k(&_imp->mustQuitMutex);
+        if ( _imp->mustQuit || !isRunning() ) {
+            return;
+        }
+    }
+    QMutexLocker k(&_imp->poolMutex);
+    BufferSizeClassPoolMap::iterator found = _imp->pool.find(sizeClass);
+    if ( found == _imp->pool.end() ) {
+        return;
+    }
+    if ( (_imp->poolSize + sizeClass > _imp->poolBudget) ||
+         (found->second.buffers.size() >= found->second.getHighWatermark()) ) {
+        // Let the buffer be freed by the caller
+        return;
+    }
+    found->second.buffers.push_back(buffer);
+    _imp->poolSize += sizeClass;
 }
 
 void
-StorageAllocatorThread::requestTilesStorageAllocation()
+StorageAllocatorThread::clearPool()
 {
+    // Swap the buffers out of the lock so that memory is freed without blocking other threads
+    BufferSizeClassPoolMap toFree;
+    {
+        QMutexLocker k(&_imp->poolMutex);
+        for (BufferSizeClassPoolMap::iterator it = _imp->pool.begin(); it != _imp->pool.end(); ++it) {
+            toFree[it->first].buffers.swap(it->second.buffers);
+        }
+        _imp->poolSize = 0;
+    }
+}
 
+void
+StorageAllocatorThreadPrivate::sampleAllocationRates()
+{
+    // Must be called with poolMutex locked
+    for (BufferSizeClassPoolMap::iterator it = pool.begin(); it != pool.end(); ++it) {
+        // Exponential moving average so that the pool adapts quickly to a burst while
+        // slowly forgetting size classes that are no longer used
+        it->second.allocRate = it->second.allocRate * 0.5 + it->second.nAllocSinceLastTick * 0.5;
+        it->second.nAllocSinceLastTick = 0;
+    }
 }
 
-bool
-StorageAllocatorThread::isWorking() const
+std::size_t
+StorageAllocatorThreadPrivate::getWantedPoolSize() const
+{
+    // Must be called with poolMutex locked
+    std::size_t ret = 0;
+    for (BufferSizeClassPoolMap::const_iterator it = pool.begin(); it != pool.end(); ++it) {
+        ret += it->second.getHighWatermark() * it->first;
+    }
+    return std::min(ret, (std::size_t)NATRON_STORAGE_ALLOCATOR_MAX_POOL_BYTES);
+}
+
+std::size_t
+StorageAllocatorThreadPrivate::getPoolBudget(std::size_t wantedPoolSize) const
 {
+    // Must be called without poolMutex locked.
+    // The pool memory is counted in the tile cache budget: the pool only uses the room
+    // the cache leaves free and never evicts cache entries to grow.
+    CacheBasePtr cache = appPTR->getTileCache();
+    if (!cache) {
+        return wantedPoolSize;
+    }
+    std::size_t maxSize = cache->getMaximumCacheSize();
+    if (maxSize == 0) {
+        // No limit
+        return wantedPoolSize;
+    }
+    std::size_t curSize = cache->getCurrentSize();
+    if (curSize >= maxSize) {
+        return 0;
+    }
+    return std::min(wantedPoolSize, maxSize - curSize);
+}
+
+void
+StorageAllocatorThreadPrivate::refillPool()
+{
+    // Must be called with poolMutex locked: the lock is released while allocating.
+    for (BufferSizeClassPoolMap::iterator it = pool.begin(); it != pool.end(); ++it) {
+        const std::size_t sizeClass = it->first;
+        while ( it->second.buffers.size() < it->second.getHighWatermark() &&
+                poolSize + sizeClass <= poolBudget ) {
+            RamBufferPtr buffer;
+            poolMutex.unlock();
+            try {
+                buffer.reset(new RamBuffer<char>);
+                buffer->resize(sizeClass);
+                prefaultBuffer(buffer.get());
+            } catch (const std::bad_alloc&) {
+                buffer.reset();
+            }
+            poolMutex.lock();
+            if (!buffer) {
+                // Out of memory, do not insist
+                return;
+            }
+            // The map is never erased from outside of this thread, the iterator is still valid.
+            it->second.buffers.push_back(buffer);
+            poolSize += sizeClass;
+        }
+    }
+}
 
+void
+StorageAllocatorThreadPrivate::trimPool()
+{
+    // Must be called with poolMutex locked
+    std::list<RamBufferPtr> toFree;
+    for (BufferSizeClassPoolMap::iterator it = pool.begin(); it != pool.end();) {
+        std::size_t highWatermark = it->second.getHighWatermark();
+        while (it->second.buffers.size() > highWatermark) {
+            toFree.push_back( it->second.buffers.back() );
+            it->second.buffers.pop_back();
+            poolSize -= it->first;
+        }
+        if ( it->second.buffers.empty() && it->second.allocRate < 1e-2 && it->second.nAllocSinceLastTick == 0 ) {
+            // This size class is no longer used
+            pool.erase(it++);
+        } else {
+            ++it;
+        }
+    }
+    // The cache may have grown since the last pass: give back what exceeds the budget, biggest buffers first
+    for (BufferSizeClassPoolMap::reverse_iterator it = pool.rbegin(); it != pool.rend() && poolSize > poolBudget; ++it) {
+        while ( !it->second.buffers.empty() && poolSize > poolBudget ) {
+            toFree.push_back( it->second.buffers.back() );
+            it->second.buffers.pop_back();
+            poolSize -= it->first;
+        }
+    }
+    if ( !toFree.empty() ) {
+        poolMutex.unlock();
+        toFree.clear();
+        poolMutex.lock();
+    }
 }
 
 void
 StorageAllocatorThread::run()
 {
+    TimeLapse tickTimer;
+    double timeSinceLastTick = 0;
     for (;;) {
         bool quit;
         {
@@ -267,14 +572,34 @@ StorageAllocatorThread::run()
             quit = _imp->mustQuit;
         }
         if (quit) {
+            QMutexLocker k(&_imp->mustQuitMutex);
+            _imp->mustQuit = false;
+            _imp->mustQuitCond.wakeOne();
             return;
         }
 
+        QMutexLocker k(&_imp->poolMutex);
+        if (_imp->nRefillRequests <= 0) {
+            _imp->refillRequestCond.wait(&_imp->poolMutex, NATRON_STORAGE_ALLOCATOR_TICK_MS);
+        }
+        _imp->nRefillRequests = 0;
 
+        timeSinceLastTick += tickTimer.getTimeElapsedReset();
+        if (timeSinceLastTick * 1000. >= NATRON_STORAGE_ALLOCATOR_TICK_MS) {
+            timeSinceLastTick = 0;
+            _imp->sampleAllocationRates();
+        }
 
+        // The cache may lock its buckets to compute its size: do not hold the pool lock meanwhile
+        std::size_t wantedPoolSize = _imp->getWantedPoolSize();
+        k.unlock();
+        std::size_t poolBudget = _imp->getPoolBudget(wantedPoolSize);
+        k.relock();
+        _imp->poolBudget = poolBudget;
 
+        _imp->trimPool();
+        _imp->refillPool();
     }
 } // run
-#endif
 
 NATRON_NAMESPACE_EXIT
@@ -28,6 +28,7 @@
 #include "Global/Macros.h"
 
 #include <list>
+#include <cstddef>
 
 #include <QtCore/QThread>
 
@@ -72,9 +73,15 @@ private:
     boost::scoped_ptr<StorageDeleterThreadPrivate> _imp;
 };
 
-#if 0
 /**
- * @brief The point of this thread is to monitor the cache tiles storage and create storage when needed.
+ * @brief The point of this thread is to keep a pool of pre-faulted RAM buffers ready to be used by render threads,
+ * so that they do not have to allocate and page-fault fresh memory on the critical path.
+ * Buffers are grouped by size classes (multiples of NATRON_TILE_SIZE_BYTES). For each size class, the thread
+ * measures the recent allocation rate and keeps the number of free buffers between a low and a high watermark
+ * derived from this rate. Buffers deallocated by the StorageDeleterThread are recycled into the pool instead of
+ * being returned to the OS, as long as the pool stays under its memory budget.
+ * The pool memory is counted in the tile cache budget: the pool never holds more than what the cache leaves free
+ * and is shrunk when the cache grows. It never evicts cache entries.
  **/
 struct StorageAllocatorThreadPrivate;
 class StorageAllocatorThread
@@ -89,14 +96,25 @@ public:
     virtual ~StorageAllocatorThread();
 
     /**
-     * @brief To be called when a Cache bucket no longer has sufficient free tiles. 
-     * This call is blocking and returns once all buckets are guaranteed to contain at least 1 free tile. 
+     * @brief Returns a buffer of at least nBytes bytes. If a buffer of the corresponding size class is available
+     * in the pool it is returned immediately, otherwise a new buffer is allocated by the calling thread.
+     * The returned buffer size is always nBytes rounded up to its size class.
+     * Note that this function may throw an std::bad_alloc exception if it could not allocate the required memory.
      **/
-    void requestTilesStorageAllocation();
+    RamBufferPtr allocateBuffer(std::size_t nBytes);
 
-    void quitThread();
+    /**
+     * @brief Gives back a buffer to the pool. If the pool for this size class is already above its high watermark
+     * or the pool memory budget is exceeded, the buffer is freed instead.
+     **/
+    void recycleBuffer(const RamBufferPtr& buffer);
 
-    bool isWorking() const;
+    /**
+     * @brief Frees all buffers held by the pool. This is called when clearing caches.
+     **/
+    void clearPool();
+
+    void quitThread();
 
 private:
 
@@ -104,7 +122,6 @@ private:
 
     boost::scoped_ptr<StorageAllocatorThreadPrivate> _imp;
 };
-#endif 
 
 
 NATRON_NAMESPACE_EXIT
@@ -24,6 +24,15 @@
 
 #include "TrackerFrameAccessor.h"
 
+#include <algorithm>
+#include <cstring>
+
+// MSVC does not define __SSE2__
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NATRON_TRACKER_CONVERSION_USE_SSE2
+#include <emmintrin.h>
+#endif
+
 #include <boost/utility.hpp>
 
 GCC_DIAG_OFF(unused-function)
@@ -42,9 +51,13 @@ GCC_DIAG_ON(unused-parameter)
 #include "Engine/FrameViewRequest.h"
 #include "Engine/MultiThread.h"
 #include "Engine/Image.h"
+#include "Engine/ImageKernelDispatch.h"
 #include "Engine/TreeRender.h"
 #include "Engine/Node.h"
 
+// Number of pixels of a scan-line converted at once to the libmv format
+#define NATRON_TRACKER_CONVERSION_BLOCK_SIZE 256
+
 NATRON_NAMESPACE_ENTER
 
 NATRON_NAMESPACE_ANONYMOUS_ENTER
@@ -107,6 +120,101 @@ struct FrameAccessorCacheEntry
 
 typedef std::multimap<FrameAccessorCacheKey, FrameAccessorCacheEntry, CacheKey_compare_less > FrameAccessorCache;
 
+/**
+ * @brief Converts count pixels of a channel to float in a contiguous buffer.
+ * This is the same conversion as Image::convertPixelDepth<PIX, float>, inlined.
+ **/
+template <typename PIX, int maxValue>
+static inline void
+convertChannelToLibMVFloat(const PIX* srcPixels,
+                           int srcPixelStride,
+                           int count,
+                           float* dstPixels)
+{
+    for (int x = 0; x < count; ++x) {
+        dstPixels[x] = maxValue == 1 ? (float)srcPixels[x * srcPixelStride] : srcPixels[x * srcPixelStride] / (float)maxValue;
+    }
+}
+
+/**
+ * @brief Computes the luminance of count pixels from contiguous float channels.
+ * The vector and scalar loops do the same operations in the same order so that the result does not depend on
+ * which one processes a pixel.
+ **/
+static void
+computeLibMVLuminance(const float* r,
+                      const float* g,
+                      const float* b,
+                      float scale,
+                      int count,
+                      float* dstPixels)
+{
+    int x = 0;
+#ifdef NATRON_TRACKER_CONVERSION_USE_SSE2
+    const __m128 wR = _mm_set1_ps(0.2126f);
+    const __m128 wG = _mm_set1_ps(0.7152f);
+    const __m128 wB = _mm_set1_ps(0.0722f);
+    const __m128 s = _mm_set1_ps(scale);
+    for (; x + 4 <= count; x += 4) {
+        __m128 lum = _mm_add_ps( _mm_add_ps( _mm_mul_ps( wR, _mm_loadu_ps(r + x) ), _mm_mul_ps( wG, _mm_loadu_ps(g + x) ) ),
+                                 _mm_mul_ps( wB, _mm_loadu_ps(b + x) ) );
+        _mm_storeu_ps( dstPixels + x, _mm_div_ps(lum, s) );
+    }
+    // Scalar instructions are used for the remaining pixels as well: the compiler could otherwise contract
+    // the C++ expression into fused multiply-adds which round differently on CPUs that have them.
+    for (; x < count; ++x) {
+        __m128 lum = _mm_add_ss( _mm_add_ss( _mm_mul_ss( wR, _mm_load_ss(r + x) ), _mm_mul_ss( wG, _mm_load_ss(g + x) ) ),
+                                 _mm_mul_ss( wB, _mm_load_ss(b + x) ) );
+        _mm_store_ss( dstPixels + x, _mm_div_ss(lum, s) );
+    }
+#else
+    for (; x < count; ++x) {
+        dstPixels[x] = (0.2126f * r[x] + 0.7152f * g[x] + 0.0722f * b[x]) / scale;
+    }
+#endif
+}
+
+/**
+ * @brief Converts count pixels of a scan-line to the libmv mono float format.
+ * The RGB channels of a block of pixels are first converted to float in contiguous buffers, then the luminance
+ * of the block is computed at once.
+ * The RGB weighted sum is only computed when red is enabled (the luminance is 0 otherwise) and is normalized by the
+ * weights of all enabled channels, as done by the former per-pixel conversion so that the tracking results do not change.
+ **/
+template <typename PIX, int maxValue, int srcNComps, bool doR>
+static void
+convertToLibMVForPixels(const PIX* srcPixelPtrs[4],
+                        int srcPixelStride,
+                        bool takeDstFromAlpha,
+                        float scale,
+                        int count,
+                        float* dstPixels)
+{
+    if (srcNComps == 1) {
+        convertChannelToLibMVFloat<PIX, maxValue>(srcPixelPtrs[0], srcPixelStride, count, dstPixels);
+        return;
+    }
+    if (srcNComps == 4 && takeDstFromAlpha) {
+        convertChannelToLibMVFloat<PIX, maxValue>(srcPixelPtrs[3], srcPixelStride, count, dstPixels);
+        return;
+    }
+
+    // Channels that are not read stay at 0
+    const int nRGBComps = doR ? std::min(srcNComps, 3) : 0;
+    float rgb[3][NATRON_TRACKER_CONVERSION_BLOCK_SIZE];
+    for (int c = nRGBComps; c < 3; ++c) {
+        std::fill(rgb[c], rgb[c] + NATRON_TRACKER_CONVERSION_BLOCK_SIZE, 0.f);
+    }
+
+    for (int x = 0; x < count; x += NATRON_TRACKER_CONVERSION_BLOCK_SIZE) {
+        const int blockSize = std::min(NATRON_TRACKER_CONVERSION_BLOCK_SIZE, count - x);
+        for (int c = 0; c < nRGBComps; ++c) {
+            convertChannelToLibMVFloat<PIX, maxValue>(srcPixelPtrs[c] + x * srcPixelStride, srcPixelStride, blockSize, rgb[c]);
+        }
+        computeLibMVLuminance(rgb[0], rgb[1], rgb[2], scale, blockSize, dstPixels + x);
+    }
+} // convertToLibMVForPixels
+
 class ConvertToLibMVImageProcessorBase : public ImageMultiThreadProcessorBase
 {
 protected:
@@ -132,7 +240,7 @@ public:
     void setValues(const Image::CPUData& source,
                    MvFloatImage* destination,
                    const RectI& destinationBounds,
-                   bool enabledChannels[3],
+                   const bool enabledChannels[3],
                    bool takeDstFromAlpha)
     {
         _source = source;
@@ -145,7 +253,7 @@ public:
     }
 };
 
-template <int srcNComps, typename PIX, int maxValue>
+template <typename PIX, int maxValue, int srcNComps>
 class ConvertToLibMVImageProcessor : public ConvertToLibMVImageProcessorBase
 {
 
@@ -167,132 +275,74 @@ private:
 
     virtual ActionRetCodeEnum multiThreadProcessImages(const RectI& renderWindow) OVERRIDE FINAL
     {
+        // Only the red flag changes the computation of a pixel, the other ones only change the normalization
         if (_enabledChannels[0]) {
-            if (_enabledChannels[1]) {
-                if (_enabledChannels[2]) {
-                    return processInternal<true, true, true>(renderWindow);
-                } else {
-                    return processInternal<true, true, false>(renderWindow);
-                }
-            } else {
-                if (_enabledChannels[2]) {
-                    return processInternal<true, false, true>(renderWindow);
-                } else {
-                    return processInternal<true, false, false>(renderWindow);
-                }
-            }
+            return processInternal<true>(renderWindow);
         } else {
-            if (_enabledChannels[1]) {
-                if (_enabledChannels[2]) {
-                    return processInternal<false, true, true>(renderWindow);
-                } else {
-                    return processInternal<false, true, false>(renderWindow);
-                }
-            } else {
-                if (_enabledChannels[2]) {
-                    return processInternal<false, false, true>(renderWindow);
-                } else {
-                    return processInternal<false, false, false>(renderWindow);
-                }
-            }
+            return processInternal<false>(renderWindow);
         }
-
     }
 
-    template <bool doR, bool doG, bool doB>
+    template <bool doR>
     ActionRetCodeEnum processInternal(const RectI& roi)
     {
-
-        // LibMV images have their origin in the top left hand corner
-
-        float* dst_pixels = (float*)Image::pixelAtStatic(roi.x1, roi.y1, _destinationBounds, 1, sizeof(float), (unsigned char*)_destination->Data());
-        assert(dst_pixels);
-
-
         // It's important to rescale the result appropriately so that e.g. if only
         // blue is selected, it's not zeroed out.
-        const float scale = (doR ? 0.2126f : 0.0f) + (doG ? 0.7152f : 0.0f) + (doB ? 0.0722f : 0.0f);
+        const float scale = (_enabledChannels[0] ? 0.2126f : 0.0f) + (_enabledChannels[1] ? 0.7152f : 0.0f) + (_enabledChannels[2] ? 0.0722f : 0.0f);
+
+        const int width = roi.width();
 
         for ( int y = roi.y1; y < roi.y2; ++y) {
 
-            for (int x = roi.x1; x < roi.x2; ++x) {
-
-                int srcPixelsStride;
-                const PIX* src_pixels[4] = {NULL, NULL, NULL, NULL};
-                Image::getChannelPointers<PIX, srcNComps>((const PIX**)_source.ptrs, x, y, _source.bounds, (PIX**)src_pixels, &srcPixelsStride);
-
-                if (!src_pixels[0]) {
-                    *dst_pixels = 0;
-                } else {
-                    if (srcNComps == 1) {
-                        *dst_pixels = Image::convertPixelDepth<PIX, float>(*src_pixels[0]);
-                    } else if (srcNComps == 4 && _takeDstFromAlpha) {
-                        *dst_pixels = Image::convertPixelDepth<PIX, float>(*src_pixels[3]);
-                    } else {
-                        float tmpPix[4] = {0.f, 0.f, 0.f, 0.f};
-                        for (int c = 0; c < srcNComps; ++c) {
-                            tmpPix[c] = doR ? Image::convertPixelDepth<PIX, float>(*src_pixels[c]) : 0.f;
-                        }
-                        /// Apply luminance conversion while we copy the image
-                        /// This code is taken from DisableChannelsTransform::run in libmv/autotrack/autotrack.cc
-                        *dst_pixels = (0.2126f * tmpPix[0] + 0.7152f * tmpPix[1] + 0.0722f * tmpPix[2]) / scale;
-                    }
-                }
+            // LibMV images have their origin in the top left hand corner
+            float* dstPixels = (float*)Image::pixelAtStatic(roi.x1, y, _destinationBounds, 1, sizeof(float), (unsigned char*)_destination->Data());
+            assert(dstPixels);
+
+            // Split the scan-line where the source image starts and ends: pixels outside of the source are 0.
+            int srcX1 = roi.x2, srcX2 = roi.x2;
+            if (_source.ptrs[0] && y >= _source.bounds.y1 && y < _source.bounds.y2) {
+                srcX1 = std::min(std::max(_source.bounds.x1, roi.x1), roi.x2);
+                srcX2 = std::max(std::min(_source.bounds.x2, roi.x2), srcX1);
+            }
+
+            std::fill(dstPixels, dstPixels + (srcX1 - roi.x1), 0.f);
+            if (srcX1 < srcX2) {
+                const PIX* srcPixelPtrs[4] = {NULL, NULL, NULL, NULL};
+                int srcPixelStride;
+                Image::getChannelPointers<PIX, srcNComps>((const PIX**)_source.ptrs, srcX1, y, _source.bounds, (PIX**)srcPixelPtrs, &srcPixelStride);
+                assert(srcPixelPtrs[0]);
+                convertToLibMVForPixels<PIX, maxValue, srcNComps, doR>(srcPixelPtrs, srcPixelStride, _takeDstFromAlpha, scale, srcX2 - srcX1, dstPixels + (srcX1 - roi.x1));
+            }
+            std::fill(dstPixels + (srcX2 - roi.x1), dstPixels + width, 0.f);
 
-                ++dst_pixels;
-                
-            } // for each pixels
-            
         } // for each scanline
         return eActionStatusOK;
     }
 };
 
-ActionRetCodeEnum
-natronImageToLibMvFloatImageForDepth(bool enabledChannels[3],
-                                     const Image& sourceImage,
-                                     const RectI& roi,
-                                     MvFloatImage& mvImg,
-                                     bool takeDstFromAlpha,
-                                     const boost::shared_ptr<ConvertToLibMVImageProcessorBase>& proc)
+struct ConvertToLibMVImageArgs
 {
-    Image::CPUData data;
-    sourceImage.getCPUData(&data);
-
-    proc->setValues(data, &mvImg, roi, enabledChannels, takeDstFromAlpha);
-    proc->setRenderWindow(roi);
-
-    return proc->launchThreadsBlocking();
-
-} // natronImageToLibMvFloatImageForDepth
+    Image::CPUData source;
+    MvFloatImage* destination;
+    RectI roi;
+    bool enabledChannels[3];
+    bool takeDstFromAlpha;
+};
 
-template <int srcNComps>
-ActionRetCodeEnum
-natronImageToLibMvFloatImageForNComps(bool enabledChannels[3],
-                                      const Image& source,
-                                      const RectI& roi,
-                                      bool takeDstFromAlpha,
-                                      MvFloatImage& mvImg)
+template <typename PIX, int maxValue, int srcNComps>
+class ConvertToLibMVImageKernel
 {
-    EffectInstancePtr renderClone;
-    boost::shared_ptr<ConvertToLibMVImageProcessorBase> proc;
-    switch (source.getBitDepth()) {
-        case eImageBitDepthByte:
-            proc.reset(new ConvertToLibMVImageProcessor<srcNComps, unsigned char, 255>(renderClone));
-            break;
-        case eImageBitDepthShort:
-            proc.reset(new ConvertToLibMVImageProcessor<srcNComps, unsigned short, 65535>(renderClone));
-            break;
-        case eImageBitDepthFloat:
-            proc.reset(new ConvertToLibMVImageProcessor<srcNComps, float, 1>(renderClone));
-            break;
-        default:
-            return eActionStatusFailed;
-    }
-
-    return natronImageToLibMvFloatImageForDepth(enabledChannels, source, roi, mvImg, takeDstFromAlpha, proc);
+public:
 
-}
+    static ActionRetCodeEnum run(const ConvertToLibMVImageArgs& args)
+    {
+        EffectInstancePtr renderClone;
+        ConvertToLibMVImageProcessor<PIX, maxValue, srcNComps> proc(renderClone);
+        proc.setValues(args.source, args.destination, args.roi, args.enabledChannels, args.takeDstFromAlpha);
+        proc.setRenderWindow(args.roi);
+        return proc.launchThreadsBlocking();
+    }
+};
 
 
 NATRON_NAMESPACE_ANONYMOUS_EXIT
@@ -306,18 +356,34 @@ TrackerFrameAccessor::natronImageToLibMvFloatImage(bool enabledChannels[3],
                                                    MvFloatImage& mvImg)
 {
     assert(source.getStorageMode() == eStorageModeRAM);
-    switch (source.getComponentsCount()) {
-        case 1:
-            return natronImageToLibMvFloatImageForNComps<1>(enabledChannels, source, roi, takeDstFromAlpha, mvImg);
-        case 2:
-            return natronImageToLibMvFloatImageForNComps<2>(enabledChannels, source, roi, takeDstFromAlpha, mvImg);
-        case 3:
-            return natronImageToLibMvFloatImageForNComps<3>(enabledChannels, source, roi, takeDstFromAlpha, mvImg);
-        case 4:
-            return natronImageToLibMvFloatImageForNComps<4>(enabledChannels, source, roi, takeDstFromAlpha, mvImg);
-        default:
-            return eActionStatusFailed;
+
+    Image::CPUData data;
+    source.getCPUData(&data);
+    return natronCPUImageToLibMvFloatImage(enabledChannels, (const void**)data.ptrs, data.bounds, data.bitDepth, data.nComps, roi, takeDstFromAlpha, mvImg);
+}
+
+ActionRetCodeEnum
+TrackerFrameAccessor::natronCPUImageToLibMvFloatImage(const bool enabledChannels[3],
+                                                      const void* ptrs[4],
+                                                      const RectI& bounds,
+                                                      ImageBitDepthEnum bitDepth,
+                                                      int nComps,
+                                                      const RectI& roi,
+                                                      bool takeDstFromAlpha,
+                                                      MvFloatImage& mvImg)
+{
+    ConvertToLibMVImageArgs args;
+    memcpy(args.source.ptrs, ptrs, sizeof(void*) * 4);
+    args.source.bounds = bounds;
+    args.source.bitDepth = bitDepth;
+    args.source.nComps = nComps;
+    args.destination = &mvImg;
+    args.roi = roi;
+    for (int i = 0; i < 3; ++i) {
+        args.enabledChannels[i] = enabledChannels[i];
     }
+    args.takeDstFromAlpha = takeDstFromAlpha;
+    return ImageKernelTable<ConvertToLibMVImageArgs, ConvertToLibMVImageKernel>::run(bitDepth, nComps, args);
 }
 
 
@@ -439,6 +505,9 @@ TrackerFrameAccessor::GetImageInternal(std::list<mv::FrameAccessor::GetImageArgs
             if (args.region) {
                 convertLibMVRegionToRectI(*args.region, _imp->formatHeight, &allRenders[i].roi);
 
+                // The region is in full scale pixel coordinates, the image is extracted at the requested mipmap level
+                allRenders[i].roi = allRenders[i].roi.downscalePowerOfTwoSmallestEnclosing( (unsigned int)args.downscale );
+
                 QMutexLocker k(&_imp->cacheMutex);
                 std::pair<FrameAccessorCache::iterator, FrameAccessorCache::iterator> range = _imp->cache.equal_range(allRenders[i].key);
                 for (FrameAccessorCache::iterator it = range.first; it != range.second; ++it) {
@@ -482,7 +551,7 @@ TrackerFrameAccessor::GetImageInternal(std::list<mv::FrameAccessor::GetImageArgs
 
             // Convert roi to canonical coordinates
             RectD roiCanonical;
-            allRenders[i].roi.toCanonical_noClipping(0, 1., &roiCanonical);
+            allRenders[i].roi.toCanonical_noClipping( (unsigned int)args.downscale, 1., &roiCanonical );
 
 
             TreeRender::CtorArgsPtr renderArgs(new TreeRender::CtorArgs);
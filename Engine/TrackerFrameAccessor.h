@@ -137,6 +137,19 @@ public:
                                                           const RectI& roi,
                                                           bool takeDstFromAlpha,
                                                           MvFloatImage& mvImg);
+
+    /**
+     * @brief Same as natronImageToLibMvFloatImage() for a RAM image given by its buffers, see Image::CPUData.
+     * mvImg must have the size of the roi, pixels of the roi outside of the bounds are set to 0.
+     **/
+    static ActionRetCodeEnum natronCPUImageToLibMvFloatImage(const bool enabledChannels[3],
+                                                             const void* ptrs[4],
+                                                             const RectI& bounds,
+                                                             ImageBitDepthEnum bitDepth,
+                                                             int nComps,
+                                                             const RectI& roi,
+                                                             bool takeDstFromAlpha,
+                                                             MvFloatImage& mvImg);
     
 
 private:
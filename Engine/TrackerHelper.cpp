@@ -226,6 +226,7 @@ TrackerHelper::trackMarkers(const std::list<TrackMarkerPtr >& markers,
      Get the global parameters for the LivMV track: pre-blur sigma, No iterations, normalized intensities, etc...
      */
     _imp->beginLibMVOptionsForTrack(&mvOptions);
+    bool coarseToFine = provider->isCoarseToFineEnabled();
 
     /*
      For the given markers, do the following:
@@ -399,8 +400,13 @@ TrackerHelper::trackMarkers(const std::list<TrackMarkerPtr >& markers,
             }
         }
 
+        // Now that the filter has learned from the previous frames, let it reduce the search window
+        // around its predictions while they are accurate
+        t->mvState.SetAdaptiveSearchRegion(true);
+
 
         t->mvOptions = mvOptions;
+        t->coarseToFine = coarseToFine;
         trackAndOptions.push_back(t);
     }
     
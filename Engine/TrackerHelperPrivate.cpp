@@ -43,6 +43,12 @@
 #include <omp.h>
 #endif
 
+// Highest mipmap level on which a track may be searched before being refined at full resolution
+#define NATRON_TRACKER_COARSE_TO_FINE_MAX_LEVEL 3
+
+// Minimum size in pixels of the pattern at the mipmap level used for coarse-to-fine tracking
+#define NATRON_TRACKER_COARSE_TO_FINE_MIN_PATTERN_SIZE 12
+
 NATRON_NAMESPACE_ENTER
 
 
@@ -361,6 +367,31 @@ TrackerHelperPrivate::beginLibMVOptionsForTrack(mv::TrackRegionOptions* options)
 
 
 
+/*
+ * @brief Returns the mipmap level on which the marker should be searched before refining its position at full resolution,
+ * or 0 if coarse-to-fine tracking would not be worth it for this marker.
+ */
+static int
+getCoarseToFineMipMapLevel(const mv::Marker& marker)
+{
+    mv::Vec2f patternMin = marker.patch.coordinates.colwise().minCoeff().transpose();
+    mv::Vec2f patternMax = marker.patch.coordinates.colwise().maxCoeff().transpose();
+    double patternSize = std::min(patternMax(0) - patternMin(0), patternMax(1) - patternMin(1));
+    double searchSize = std::min(marker.search_region.max(0) - marker.search_region.min(0),
+                                 marker.search_region.max(1) - marker.search_region.min(1));
+
+    // If the search window is barely larger than the pattern, searching at full resolution is as fast
+    if (searchSize < 2 * patternSize) {
+        return 0;
+    }
+
+    int level = 0;
+    while ( level < NATRON_TRACKER_COARSE_TO_FINE_MAX_LEVEL && (patternSize / (1 << (level + 1)) >= NATRON_TRACKER_COARSE_TO_FINE_MIN_PATTERN_SIZE) ) {
+        ++level;
+    }
+    return level;
+}
+
 /*
  * @brief This is the internal tracking function that makes use of TrackerPM to do 1 track step
  * @param trackingIndex This is the index of the Marker we should track in the args
@@ -453,12 +484,34 @@ TrackerHelperPrivate::trackStepLibMV(int trackIndex,
 #endif
 
 
-        // Do the actual tracking
+        // Do the actual tracking. The Kalman filter predicts the position of the marker from the previous frames
+        // and reduces the search window around it if the previous predictions were accurate.
+        // With coarse-to-fine tracking, the marker is first searched on a mipmap level of the source, which is
+        // rendered through the cache and thus shared with the viewer.
+        int coarseMipMapLevel = track->coarseToFine ? getCoarseToFineMipMapLevel(track->mvMarker) : 0;
         libmv::TrackRegionResult result;
-        bool trackOk = autoTrack->TrackMarker(&track->mvMarker, &result,  &track->mvState, &track->mvOptions);
+        bool trackOk = autoTrack->TrackMarker(&track->mvMarker, &result,  &track->mvState, &track->mvOptions, coarseMipMapLevel);
         if (!result.is_usable()) {
             trackOk = false;
         }
+        bool searchWindowReduced = track->mvState.IsSearchRegionReduced();
+        if (!trackOk && searchWindowReduced) {
+            // The prediction was wrong: the filter state is already at this frame, so tracking again
+            // predicts the same position but in the full search window.
+#ifdef TRACE_LIB_MV
+            qDebug() << QThread::currentThread() << "Tracking FAILED in the reduced search window for track" << trackIndex << "at frame" << trackTime << ", retrying with the full window";
+#endif
+            ++track->searchWindowStats.nFullWindowRetries;
+            track->mvState.SetAdaptiveSearchRegion(false);
+            result = libmv::TrackRegionResult();
+            trackOk = autoTrack->TrackMarker(&track->mvMarker, &result,  &track->mvState, &track->mvOptions, coarseMipMapLevel);
+            if (!result.is_usable()) {
+                trackOk = false;
+            }
+            track->mvState.SetAdaptiveSearchRegion(true);
+            searchWindowReduced = false;
+        }
+        track->searchWindowStats.addSearchWindow(track->mvMarker.search_region, searchWindowReduced);
 
         if (!trackOk) {
 #ifdef TRACE_LIB_MV
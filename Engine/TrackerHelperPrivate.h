@@ -27,6 +27,7 @@
 
 #include "Global/Macros.h"
 
+#include <algorithm>
 #include <list>
 
 #include "Global/Macros.h"
@@ -65,6 +66,51 @@ enum libmv_MarkerChannelEnum
     LIBMV_MARKER_CHANNEL_B = (1 << 2),
 };
 
+/**
+ * @brief Statistics on the search windows in which libmv looked for a marker during a track sequence.
+ * Search windows are reduced around the position predicted by the Kalman filter when the predictions are accurate.
+ **/
+struct TrackSearchWindowStats
+{
+    // Number of frames tracked
+    int nFrames;
+
+    // Number of frames for which the search window was reduced
+    int nReducedWindows;
+
+    // Number of frames that failed to track in the reduced search window and were tracked again in the full one
+    int nFullWindowRetries;
+
+    // Area in pixels of the search windows
+    double minArea, maxArea, sumArea;
+
+    TrackSearchWindowStats()
+    : nFrames(0)
+    , nReducedWindows(0)
+    , nFullWindowRetries(0)
+    , minArea(0)
+    , maxArea(0)
+    , sumArea(0)
+    {
+    }
+
+    void addSearchWindow(const mv::Region& region, bool reduced)
+    {
+        double area = (double)(region.max(0) - region.min(0)) * (double)(region.max(1) - region.min(1));
+        if (nFrames == 0) {
+            minArea = maxArea = area;
+        } else {
+            minArea = std::min(minArea, area);
+            maxArea = std::max(maxArea, area);
+        }
+        sumArea += area;
+        ++nFrames;
+        if (reduced) {
+            ++nReducedWindows;
+        }
+    }
+};
+
 class TrackMarkerAndOptions
 {
 public:
@@ -72,6 +118,20 @@ public:
     mv::Marker mvMarker;
     mv::TrackRegionOptions mvOptions;
     mv::KalmanFilterState mvState;
+    TrackSearchWindowStats searchWindowStats;
+
+    // If true, the marker is searched on a mipmap level of the source before being refined at full resolution
+    bool coarseToFine;
+
+    TrackMarkerAndOptions()
+    : natronMarker()
+    , mvMarker()
+    , mvOptions()
+    , mvState()
+    , searchWindowStats()
+    , coarseToFine(false)
+    {
+    }
 };
 
 
@@ -24,9 +24,13 @@
 
 #include <boost/algorithm/clamp.hpp>
 
+#include <QtCore/QDateTime>
+#include <QtCore/QDebug>
+
 #include "TrackerNode.h"
 
 #include "Engine/AppInstance.h"
+#include "Engine/AppManager.h"
 #include "Engine/CreateNodeArgs.h"
 #include "Engine/Curve.h"
 #include "Engine/Format.h"
@@ -35,6 +39,7 @@
 #include "Engine/Lut.h"
 #include "Engine/Project.h"
 #include "Engine/OverlaySupport.h"
+#include "Engine/Settings.h"
 #include "Engine/TimeLine.h"
 #include "Engine/TrackArgs.h"
 #include "Engine/TrackerHelper.h"
@@ -912,6 +917,16 @@ TrackerNode::initializeTrackingPageKnobs(const KnobPagePtr& trackingPage)
         trackingPage->addKnob(param);
         _imp->preBlurSigma = param;
     }
+    {
+        KnobBoolPtr param = createKnob<KnobBool>(kTrackerParamCoarseToFine);
+        param->setLabel(tr(kTrackerParamCoarseToFineLabel));
+        param->setHintToolTip( tr(kTrackerParamCoarseToFineHint) );
+        param->setDefaultValue(false);
+        param->setAnimationEnabled(false);
+        param->setEvaluateOnChange(false);
+        trackingPage->addKnob(param);
+        _imp->coarseToFine = param;
+    }
 
     {
         KnobSeparatorPtr  param = createKnob<KnobSeparator>(kTrackerParamPerTrackParamsSeparator, 3);
@@ -1993,8 +2008,31 @@ TrackerNodePrivate::endTrackSequence(const TrackArgsBasePtr& args)
     TrackArgs* trackerArgs = dynamic_cast<TrackArgs*>(args.get());
     const std::vector<TrackMarkerAndOptionsPtr >& tracks = trackerArgs->getTracks();
 
+    SettingsPtr settings = appPTR->getCurrentSettings();
+    bool logStats = settings && settings->isPerformanceLoggingEnabled();
+    NodePtr node = getTrackerNode();
+
     for (std::size_t i = 0; i < tracks.size(); ++i) {
         tracks[i]->natronMarker->notifyTrackingEnded();
+
+        // Report how much the motion prediction reduced the search windows
+        const TrackSearchWindowStats& stats = tracks[i]->searchWindowStats;
+        if (logStats && node && stats.nFrames > 0) {
+            LogEntry::LogEntryColor c;
+            if ( node->getColor(&c.r, &c.g, &c.b) ) {
+                c.colorSet = true;
+            }
+            appPTR->writeToErrorLog_mt_safe( QString::fromUtf8( node->getLabel_mt_safe().c_str() ), QDateTime::currentDateTime(),
+                                             TrackerNode::tr("Track %1: %2 frames tracked, search window area min/mean/max: %3/%4/%5 px, "
+                                                             "%6 reduced windows, %7 retries in the full window")
+                                             .arg( QString::fromUtf8( tracks[i]->natronMarker->getScriptName_mt_safe().c_str() ) )
+                                             .arg(stats.nFrames)
+                                             .arg(stats.minArea)
+                                             .arg(stats.sumArea / stats.nFrames)
+                                             .arg(stats.maxArea)
+                                             .arg(stats.nReducedWindows)
+                                             .arg(stats.nFullWindowRetries), false, c );
+        }
     }
 
 }
@@ -2107,6 +2145,12 @@ TrackerNodePrivate::getPreBlurSigma() const
     return preBlurSigma.lock()->getValue();
 }
 
+bool
+TrackerNodePrivate::isCoarseToFineEnabled() const
+{
+    return coarseToFine.lock()->getValue();
+}
+
 RectD
 TrackerNodePrivate::getNormalizationRoD(TimeValue time, ViewIdx view) const
 {
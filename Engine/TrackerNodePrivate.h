@@ -280,6 +280,13 @@ NATRON_NAMESPACE_ENTER
 #define kTrackerParamPreBlurSigmaLabel "Pre-blur sigma"
 #define kTrackerParamPreBlurSigmaHint "The size in pixels of the blur kernel used to both smooth the image and take the image derivative."
 
+#define kTrackerParamCoarseToFine "coarseToFine"
+#define kTrackerParamCoarseToFineLabel "Coarse-to-fine"
+#define kTrackerParamCoarseToFineHint "When checked, each track is first searched in its whole search window on a lower resolution " \
+"version of the source image, then its position is refined at full resolution in a small window around it. " \
+"This is much faster on large images with large search windows. The resolution is chosen for each track so that its pattern keeps " \
+"enough pixels. When the lower resolution track fails, the full resolution image is searched instead."
+
 
 #define kTrackerParamAutoKeyEnabled "autoKeyEnabled"
 #define kTrackerParamAutoKeyEnabledLabel "Animate Enabled"
@@ -625,7 +632,7 @@ public:
     KnobBoolWPtr enableTrackRed, enableTrackGreen, enableTrackBlue;
     KnobDoubleWPtr maxError;
     KnobIntWPtr maxIterations;
-    KnobBoolWPtr bruteForcePreTrack, useNormalizedIntensities;
+    KnobBoolWPtr bruteForcePreTrack, useNormalizedIntensities, coarseToFine;
     KnobDoubleWPtr preBlurSigma;
     KnobSeparatorWPtr perTrackParamsSeparator;
     KnobBoolWPtr activateTrack;
@@ -786,6 +793,7 @@ public:
     virtual bool isBruteForcePreTrackEnabled() const OVERRIDE FINAL;
     virtual bool isNormalizeIntensitiesEnabled() const OVERRIDE FINAL;
     virtual double getPreBlurSigma() const OVERRIDE FINAL;
+    virtual bool isCoarseToFineEnabled() const OVERRIDE FINAL;
     virtual RectD getNormalizationRoD(TimeValue time, ViewIdx view) const OVERRIDE FINAL;
     ////////////////////
 
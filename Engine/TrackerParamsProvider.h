@@ -152,6 +152,11 @@ public:
      **/
     virtual double getPreBlurSigma() const = 0;
 
+    /**
+     * @brief Should the tracks be searched on a lower resolution image before being refined at full resolution ?
+     **/
+    virtual bool isCoarseToFineEnabled() const = 0;
+
     /**
      * @brief Returns the rectangle used to normalize coordinates for the given time/view
      **/
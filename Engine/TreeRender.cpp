@@ -103,6 +103,7 @@ struct TreeRenderPrivate
 
     bool handleNaNs;
     bool useConcatenations;
+    bool streamPixelLocalEffects;
 
 
     TreeRenderPrivate(TreeRender* publicInterface)
@@ -122,6 +123,7 @@ struct TreeRenderPrivate
     , aborted()
     , handleNaNs(true)
     , useConcatenations(true)
+    , streamPixelLocalEffects(false)
     {
         aborted.fetchAndStoreAcquire(0);
 
@@ -170,8 +172,11 @@ TreeRender::CtorArgs::CtorArgs()
 , mipMapLevel(0)
 , draftMode(false)
 , playback(false)
+, cachePriority(eCacheEntryPriorityViewer)
 , byPassCache(false)
 , preventConcurrentTreeRenders(false)
+, streamedRender(false)
+, parentRender()
 {
 
 }
@@ -256,6 +261,10 @@ TreeRender::isRenderAborted() const
     if ((int)_imp->aborted > 0) {
         return true;
     }
+    // A streamed render is not known by the scheduler: it is aborted with the render it was issued from
+    if (_imp->ctorArgs && _imp->ctorArgs->parentRender) {
+        return _imp->ctorArgs->parentRender->isRenderAborted();
+    }
     return false;
 }
 
@@ -271,6 +280,12 @@ TreeRender::isPlayback() const
     return _imp->ctorArgs->playback;
 }
 
+CacheEntryPriorityEnum
+TreeRender::getCachePriority() const
+{
+    return _imp->ctorArgs->cachePriority;
+}
+
 
 bool
 TreeRender::isDraftRender() const
@@ -297,6 +312,18 @@ TreeRender::isConcatenationEnabled() const
     return _imp->useConcatenations;
 }
 
+bool
+TreeRender::isPixelLocalStreamingEnabled() const
+{
+    return _imp->streamPixelLocalEffects;
+}
+
+bool
+TreeRender::isStreamedRender() const
+{
+    return _imp->ctorArgs->streamedRender;
+}
+
 TreeRenderQueueProviderConstPtr
 TreeRender::getProvider() const
 {
@@ -437,6 +464,7 @@ TreeRenderPrivate::init(const TreeRender::CtorArgsPtr& inArgs)
     SettingsPtr settings = appPTR->getCurrentSettings();
     handleNaNs = settings && settings->isNaNHandlingEnabled();
     useConcatenations = settings && settings->isTransformConcatenationEnabled();
+    streamPixelLocalEffects = settings && settings->isPixelLocalStreamingEnabled();
     
     // Initialize all requested extra nodes to a null result
     for (std::list<NodePtr>::const_iterator it = inArgs->extraNodesToSample.begin(); it != inArgs->extraNodesToSample.end(); ++it) {
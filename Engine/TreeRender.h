@@ -210,6 +210,10 @@ public:
         // Is this render triggered by a playback or render on disk ?
         bool playback;
 
+        // The priority class given to images cached by this render.
+        // Lower priority images are evicted first when the cache is full.
+        CacheEntryPriorityEnum cachePriority;
+
         // Make sure each node in the tree gets rendered at least once
         bool byPassCache;
 
@@ -218,6 +222,14 @@ public:
         // mouse move event renders are processed in order.
         bool preventConcurrentTreeRenders;
 
+        // True if this render was issued by getImage() to produce a streamed input of a pixel-local effect
+        // for a single render window. The output image is not cached and is released once the caller is done with it.
+        bool streamedRender;
+
+        // For a streamed render, the render of the effect that requested the streamed input.
+        // This render is aborted as soon as the parent render is aborted.
+        TreeRenderPtr parentRender;
+
         CtorArgs();
     };
 
@@ -295,6 +307,11 @@ public:
      **/
     bool isPlayback() const;
 
+    /**
+     * @brief Returns the priority class of images cached by this render
+     **/
+    CacheEntryPriorityEnum getCachePriority() const;
+
     /**
      * @brief Returns whether this render is a bad quality render (typically used when scrubbing a slider or the timeline) or normal quality render
      **/
@@ -315,6 +332,17 @@ public:
      **/
     bool isConcatenationEnabled() const;
 
+    /**
+     * @brief Should chains of pixel-local effects be streamed render window by render window
+     * instead of rendering full images for their inputs
+     **/
+    bool isPixelLocalStreamingEnabled() const;
+
+    /**
+     * @brief Returns whether this render produces a streamed input for a single render window, see CtorArgs::streamedRender
+     **/
+    bool isStreamedRender() const;
+
 
     /**
      * @brief Returns the request of the given node if it was requested in the
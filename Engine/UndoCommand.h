@@ -28,6 +28,7 @@
 #include "Global/Macros.h"
 
 #include <string>
+#include <cstddef>
 
 #include "Engine/EngineFwd.h"
 
@@ -75,6 +76,16 @@ public:
     {
         return false;
     }
+
+    /**
+     * @brief Returns an estimate of the memory held by this action, in bytes. This is used to
+     * bound the memory used by the undo/redo history.
+     * Derived classes holding large data should add it to the value returned by this implementation.
+     **/
+    virtual std::size_t getMemoryCost() const
+    {
+        return sizeof(UndoCommand) + _text.capacity();
+    }
 };
 
 NATRON_NAMESPACE_EXIT
@@ -283,6 +283,7 @@ static ActionRetCodeEnum createFrameRenderResultsForView(const ViewerNodePtr& vi
         initArgs->activeRotoDrawableItem = activeDrawingStroke;
         initArgs->draftMode = draftModeEnabled;
         initArgs->playback = isPlayback;
+        initArgs->cachePriority = isPlayback ? eCacheEntryPriorityPlayback : eCacheEntryPriorityViewer;
         initArgs->byPassCache = byPassCache;
         initArgs->preventConcurrentTreeRenders = (activeDrawingStroke || partialUpdateRoIParam);
         if (!isPlayback && subResult->textureTransferType == OpenGLViewerI::TextureTransferArgs::eTextureTransferTypeReplace && !activeDrawingStroke) {
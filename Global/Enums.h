@@ -621,6 +621,38 @@ enum CacheAccessModeEnum
     eCacheAccessModeWriteOnly
 };
 
+// Per-node override of the decision to cache the output of a node
+enum NodeCachingPolicyEnum
+{
+    // The output is cached if it is worth it: see EffectInstance::shouldCacheOutput()
+    eNodeCachingPolicyAutomatic = 0,
+
+    // The output is always cached
+    eNodeCachingPolicyAlways,
+
+    // The output is never cached, unless required for the render to work correctly (e.g: painting)
+    eNodeCachingPolicyNever
+};
+
+// The priority class of a cache entry. When the cache is full, entries of
+// a lower class are evicted before entries of a higher class.
+enum CacheEntryPriorityEnum
+{
+    // Images produced by a background/batch render (render on disk)
+    eCacheEntryPriorityBatch = 0,
+
+    // Images produced to compute a node preview
+    eCacheEntryPriorityPreview,
+
+    // Images produced during viewer playback
+    eCacheEntryPriorityPlayback,
+
+    // Images produced for interactive viewer renders
+    eCacheEntryPriorityViewer
+};
+
+#define NATRON_CACHE_ENTRY_PRIORITY_COUNT 4
+
 enum ImageBufferLayoutEnum
 {
     // This will make an image with an internal storage composed
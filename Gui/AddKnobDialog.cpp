@@ -891,9 +891,10 @@ AddKnobDialog::AddKnobDialog(DockablePanel* panel,
     }
 
 
-    const KnobsGuiMapping& knobs = _imp->panel->getKnobsMapping();
-    for (KnobsGuiMapping::const_iterator it = knobs.begin(); it != knobs.end(); ++it) {
-        KnobIPtr knob = it->first.lock();
+    // Use the internal knobs rather than the knobs gui since the gui of pages that were never displayed is not created
+    const KnobsVec& knobs = _imp->panel->getInternalKnobs();
+    for (KnobsVec::const_iterator it = knobs.begin(); it != knobs.end(); ++it) {
+        const KnobIPtr& knob = *it;
         if (!knob) {
             continue;
         }
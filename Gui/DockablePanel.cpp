@@ -962,9 +962,10 @@ DockablePanel::setClosedInternal(bool closed)
     }
 
     ///Remove any color picker active
-    const KnobsGuiMapping& knobs = getKnobsMapping();
-    for (KnobsGuiMapping::const_iterator it = knobs.begin(); it != knobs.end(); ++it) {
-        KnobColorPtr ck = toKnobColor(it->first.lock());
+    // Picking is a state of the internal knob: also check knobs of pages whose gui was not created yet
+    const KnobsVec& knobs = getInternalKnobs();
+    for (KnobsVec::const_iterator it = knobs.begin(); it != knobs.end(); ++it) {
+        KnobColorPtr ck = toKnobColor(*it);
         if (ck) {
             ck->setPickingEnabled(ViewSetSpec::all(), false);
         }
@@ -1649,6 +1650,30 @@ DockablePanel::onHideUnmodifiedButtonClicked(bool checked)
     }
 }
 
+void
+DockablePanel::onPageKnobsCreated(const KnobPageGuiPtr& /*page*/)
+{
+    if ( !_imp->_hideUnmodifiedButton || !_imp->_hideUnmodifiedButton->isChecked() ) {
+        return;
+    }
+    // Knobs of the page were just created: hide them as well if they are not modified
+    const KnobsGuiMapping& knobsMap = getKnobsMapping();
+    for (KnobsGuiMapping::const_iterator it = knobsMap.begin(); it != knobsMap.end(); ++it) {
+        if ( _imp->_knobsVisibilityBeforeHideModif.find(it->second) != _imp->_knobsVisibilityBeforeHideModif.end() ) {
+            continue;
+        }
+        KnobIPtr knob = it->first.lock();
+        KnobGroupPtr isGroup = toKnobGroup(knob);
+        KnobParametricPtr isParametric = toKnobParametric(knob);
+        if (knob && !isGroup && !isParametric) {
+            _imp->_knobsVisibilityBeforeHideModif.insert( std::make_pair( it->second, it->second->isSecretRecursive() ) );
+            if ( !knob->hasModifications() ) {
+                it->second->hide();
+            }
+        }
+    }
+}
+
 std::string
 DockablePanel::getHolderFullyQualifiedScriptName() const
 {
@@ -156,6 +156,7 @@ private:
     virtual void removePageFromContainer(const KnobPageGuiPtr& page) OVERRIDE FINAL;
     virtual void setPagesOrder(const std::list<KnobPageGuiPtr>& order, const KnobPageGuiPtr& curPage, bool restorePageIndex) OVERRIDE FINAL;
     virtual void onKnobsRecreated() OVERRIDE FINAL;
+    virtual void onPageKnobsCreated(const KnobPageGuiPtr& page) OVERRIDE FINAL;
     virtual void onPageActivated(const KnobPageGuiPtr& page) OVERRIDE FINAL;
     virtual void refreshCurrentPage() OVERRIDE FINAL;
     virtual void onPageLabelChanged(const KnobPageGuiPtr& page) OVERRIDE FINAL;
@@ -608,6 +608,11 @@ Gui::createMenuActions()
     _imp->menuEdit->addAction(undoAction);
     _imp->menuEdit->addAction(redoAction);
 
+    _imp->undoMemoryAction = new QAction(_imp->menuEdit);
+    _imp->undoMemoryAction->setEnabled(false);
+    _imp->menuEdit->addAction(_imp->undoMemoryAction);
+    onUndoStackIndexChanged();
+
     _imp->menuLayout->addAction(_imp->actionImportLayout);
     _imp->menuLayout->addAction(_imp->actionExportLayout);
     _imp->menuLayout->addAction(_imp->actionRestoreDefaultLayout);
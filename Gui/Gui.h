@@ -553,6 +553,13 @@ Q_SIGNALS:
 
 public Q_SLOTS:
 
+    /**
+     * @brief Called when a command is pushed, undone or redone in any undo stack: discards the oldest
+     * commands of all stacks if the memory limit of the undo/redo history is exceeded and refreshes
+     * the memory counter in the Edit menu.
+     **/
+    void onUndoStackIndexChanged();
+
     void onMustRefreshViewersAndKnobsLaterReceived();
 
     void onMustRefreshTimelineGuiKeyframesLaterReceived();
@@ -29,6 +29,7 @@
 #include <map>
 #include <list>
 #include <utility>
+#include <vector>
 #include <stdexcept>
 
 #include <QtCore/QThread>
@@ -43,6 +44,8 @@
 #include <QUndoGroup>
 #include <QUndoStack>
 
+#include "Engine/MemoryInfo.h" // printAsRAM
+#include "Engine/Settings.h"
 #include "Engine/Utils.h" // convertFromPlainText
 #include "Engine/ViewIdx.h"
 
@@ -57,6 +60,10 @@
 #include "Gui/QtEnumConvert.h"
 #include "Gui/ResizableMessageBox.h"
 #include "Gui/TabWidget.h"
+#include "Gui/UndoCommand_qt.h"
+
+// Estimated memory of undo commands that do not report it, e.g: node graph commands
+#define NATRON_UNDO_COMMAND_DEFAULT_MEMORY_COST 1024
 
 
 NATRON_NAMESPACE_ENTER
@@ -669,13 +676,79 @@ void
 Gui::registerNewUndoStack(const boost::shared_ptr<QUndoStack>& stack)
 {
     _imp->_undoStacksGroup->addStack(stack.get());
+    QObject::connect( stack.get(), SIGNAL(indexChanged(int)), this, SLOT(onUndoStackIndexChanged()) );
 }
 
 void
 Gui::removeUndoStack(const boost::shared_ptr<QUndoStack>& stack)
 {
+    QObject::disconnect( stack.get(), SIGNAL(indexChanged(int)), this, SLOT(onUndoStackIndexChanged()) );
     _imp->_undoStacksGroup->removeStack(stack.get());
+    onUndoStackIndexChanged();
 }
 
+struct DiscardableUndoCommand
+{
+    UndoCommand_qt* command;
+    QUndoStack* stack;
+};
+
+struct DiscardableUndoCommand_CompareAge
+{
+    bool operator() (const DiscardableUndoCommand& lhs,
+                     const DiscardableUndoCommand& rhs) const
+    {
+        return lhs.command->getAge() < rhs.command->getAge();
+    }
+};
+
+void
+Gui::onUndoStackIndexChanged()
+{
+    if (!_imp->_undoStacksGroup) {
+        return;
+    }
+
+    U64 totalMemory = 0;
+    std::vector<DiscardableUndoCommand> discardable;
+    QList<QUndoStack*> stacks = _imp->_undoStacksGroup->stacks();
+    for (QList<QUndoStack*>::const_iterator it = stacks.begin(); it != stacks.end(); ++it) {
+        int nCommands = (*it)->count();
+        int index = (*it)->index();
+        for (int i = 0; i < nCommands; ++i) {
+            const UndoCommand_qt* cmd = dynamic_cast<const UndoCommand_qt*>( (*it)->command(i) );
+            if (!cmd) {
+                totalMemory += NATRON_UNDO_COMMAND_DEFAULT_MEMORY_COST;
+                continue;
+            }
+            totalMemory += cmd->getMemoryCost();
+
+            // Only commands that were done can be discarded, and the last one is always kept so that
+            // the most recent action can still be undone
+            if ( !cmd->isDiscarded() && (i < index - 1) ) {
+                DiscardableUndoCommand d;
+                d.command = const_cast<UndoCommand_qt*>(cmd);
+                d.stack = *it;
+                discardable.push_back(d);
+            }
+        }
+    }
+
+    U64 maxMemory = appPTR->getCurrentSettings()->getMaximumUndoRedoMemory();
+    if ( (maxMemory > 0) && (totalMemory > maxMemory) ) {
+        // Discard the oldest commands across all stacks first. Within a stack, commands are sorted by age
+        // so that a command is only discarded once all commands before it are discarded.
+        std::sort( discardable.begin(), discardable.end(), DiscardableUndoCommand_CompareAge() );
+        for (std::vector<DiscardableUndoCommand>::const_iterator it = discardable.begin(); it != discardable.end() && totalMemory > maxMemory; ++it) {
+            totalMemory -= std::min( totalMemory, (U64)it->command->getMemoryCost() );
+            it->command->discard();
+        }
+    }
+
+    if (_imp->undoMemoryAction) {
+        _imp->undoMemoryAction->setText( tr("Undo history: %1").arg( printAsRAM(totalMemory) ) );
+    }
+} // onUndoStackIndexChanged
+
 
 NATRON_NAMESPACE_EXIT
@@ -138,6 +138,7 @@ GuiPrivate::GuiPrivate(const GuiAppInstancePtr& app,
     , _currentUndoAction(0)
     , _currentRedoAction(0)
     , _undoStacksGroup(0)
+    , undoMemoryAction(0)
     , _isTripleSyncEnabled(false)
     , areRenderStatsEnabledMutex()
     , areRenderStatsEnabled(false)
@@ -85,6 +85,9 @@ public:
     ///all the undo stacks of Natron are gathered here
     QUndoGroup* _undoStacksGroup;
 
+    // Disabled entry of the Edit menu showing the memory used by the undo/redo history
+    QAction* undoMemoryAction;
+
     ///all the splitters used to separate the "panes" of the application
     std::map<NATRON_PYTHON_NAMESPACE::PyPanel*, std::string> _userPanels;
     bool _isTripleSyncEnabled;
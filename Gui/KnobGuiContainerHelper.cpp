@@ -36,13 +36,17 @@ CLANG_DIAG_OFF(uninitialized)
 #include <QUndoStack>
 #include <QUndoCommand>
 #include <QDebug>
+#include <QtCore/QDateTime>
 CLANG_DIAG_ON(deprecated)
 CLANG_DIAG_ON(uninitialized)
 
+#include "Engine/AppManager.h"
 #include "Engine/EffectInstance.h"
 #include "Engine/KnobTypes.h"
 #include "Engine/KnobItemsTable.h"
 #include "Engine/Node.h"
+#include "Engine/Settings.h"
+#include "Engine/Timer.h"
 
 #include "Gui/KnobGui.h"
 #include "Gui/ClickableLabel.h"
@@ -81,6 +85,9 @@ struct KnobGuiContainerHelperPrivate
 
     std::map<std::string, KnobItemsTableGuiPtr> tables;
 
+    // Time spent creating knob widgets, in seconds
+    double knobsCreationTime;
+
 
     KnobGuiContainerHelperPrivate(KnobGuiContainerHelper* p,
                                   const KnobHolderPtr& holder,
@@ -97,6 +104,7 @@ struct KnobGuiContainerHelperPrivate
     , clearedStackDuringPush(false)
     , signals( new KnobGuiContainerSignalsHandler(p) )
     , tables()
+    , knobsCreationTime(0)
     {
         if (stack) {
             undoStack = stack;
@@ -110,6 +118,11 @@ struct KnobGuiContainerHelperPrivate
     KnobsGuiMapping::iterator findKnobGui(const KnobIPtr& knob);
 
     void refreshPagesEnabledness();
+
+    /**
+     * @brief Writes the time spent creating knob widgets to the error log if the performance logging preference is checked.
+     **/
+    void logKnobsCreation(const QString& what, double timeSpent, double totalTimeSpent) const;
 };
 
 KnobGuiContainerHelper::KnobGuiContainerHelper(const KnobHolderPtr& holder,
@@ -141,15 +154,77 @@ KnobGuiContainerHelper::getPages() const
 KnobGuiPtr
 KnobGuiContainerHelper::getKnobGui(const KnobIPtr& knob) const
 {
-    for (KnobsGuiMapping::const_iterator it = _imp->knobsMap.begin(); it != _imp->knobsMap.end(); ++it) {
-        if (it->first.lock() == knob) {
-            return it->second;
+    KnobsGuiMapping::iterator found = _imp->findKnobGui(knob);
+    if ( found != _imp->knobsMap.end() ) {
+        return found->second;
+    }
+
+    // The knob may belong to a page that was never displayed: create the knobs of the page now
+    if ( knob && isKnobInDeferredPage(knob) ) {
+        KnobPagePtr page = toKnobPage(knob);
+        if (!page) {
+            page = knob->getTopLevelPage();
+        }
+        PagesMap::const_iterator foundPage = _imp->pages.find(page);
+        assert( foundPage != _imp->pages.end() );
+        const_cast<KnobGuiContainerHelper*>(this)->createPageKnobs(foundPage->second);
+
+        found = _imp->findKnobGui(knob);
+        if ( found != _imp->knobsMap.end() ) {
+            return found->second;
         }
     }
 
     return KnobGuiPtr();
 }
 
+bool
+KnobGuiContainerHelper::isKnobInDeferredPage(const KnobIPtr& knob) const
+{
+    if ( !isPagingEnabled() ) {
+        return false;
+    }
+    KnobPagePtr page = toKnobPage(knob);
+    if (!page) {
+        page = knob->getTopLevelPage();
+    }
+    if (!page) {
+        return false;
+    }
+    PagesMap::const_iterator found = _imp->pages.find(page);
+
+    return found != _imp->pages.end() && !found->second->knobsCreated;
+}
+
+double
+KnobGuiContainerHelper::getKnobsCreationTime() const
+{
+    return _imp->knobsCreationTime;
+}
+
+void
+KnobGuiContainerHelperPrivate::logKnobsCreation(const QString& what,
+                                                double timeSpent,
+                                                double totalTimeSpent) const
+{
+    SettingsPtr settings = appPTR->getCurrentSettings();
+    if ( !settings || !settings->isPerformanceLoggingEnabled() ) {
+        return;
+    }
+    QString holderName;
+    EffectInstancePtr isEffect = toEffectInstance( holder.lock() );
+    if (isEffect) {
+        holderName = QString::fromUtf8( isEffect->getScriptName_mt_safe().c_str() );
+    } else {
+        holderName = KnobHolder::tr("Settings");
+    }
+    appPTR->writeToErrorLog_mt_safe( holderName, QDateTime::currentDateTime(),
+                                     KnobHolder::tr("Created %1 in %2 (%3 in total for this panel)")
+                                     .arg(what)
+                                     .arg( Timer::printAsTime(timeSpent, false) )
+                                     .arg( Timer::printAsTime(totalTimeSpent, false) ) );
+}
+
 int
 KnobGuiContainerHelper::getItemsSpacingOnSameLine() const
 {
@@ -226,9 +301,44 @@ void
 KnobGuiContainerHelper::setCurrentPage(const KnobPageGuiPtr& curPage)
 {
     _imp->currentPage = curPage;
+
+    // Create the knobs of the page if this is the first time it is displayed
+    if ( curPage && !curPage->knobsCreated && isPagingEnabled() ) {
+        createPageKnobs(curPage);
+    }
     _imp->refreshPagesEnabledness();
 }
 
+void
+KnobGuiContainerHelper::createPageKnobs(const KnobPageGuiPtr& page)
+{
+    if (!page || page->knobsCreated) {
+        return;
+    }
+    KnobPagePtr pageKnob = page->pageKnob.lock();
+    if (!pageKnob) {
+        return;
+    }
+    page->knobsCreated = true;
+
+    TimeLapse timer;
+    std::size_t nKnobsBefore = _imp->knobsMap.size();
+
+    initializeKnobVector( pageKnob->getChildren() );
+
+    // A table placed after a knob of this page could not be created before
+    if ( !_imp->dialogKnob.lock() ) {
+        createKnobItemsTablesGui();
+    }
+
+    double timeSpent = timer.getTimeSinceCreation();
+    _imp->knobsCreationTime += timeSpent;
+    _imp->logKnobsCreation( KnobHolder::tr("%1 knobs of page %2").arg( (int)(_imp->knobsMap.size() - nKnobsBefore) ).arg( QString::fromUtf8( pageKnob->getLabel().c_str() ) ),
+                            timeSpent, getKnobsCreationTime() );
+
+    onPageKnobsCreated(page);
+} // createPageKnobs
+
 KnobPageGuiPtr
 KnobGuiContainerHelper::getOrCreatePage(const KnobPagePtr& page)
 {
@@ -367,6 +477,8 @@ KnobGuiContainerHelper::getKnobItemsTable(const std::string& tableName) const
 void
 KnobGuiContainerHelper::initializeKnobs()
 {
+    TimeLapse timer;
+
     initializeKnobVector( _imp->holder.lock()->getKnobs() );
     _imp->refreshPagesEnabledness();
     refreshCurrentPage();
@@ -375,57 +487,72 @@ KnobGuiContainerHelper::initializeKnobs()
 
     if (!_imp->dialogKnob.lock()) {
         // Add the table if not done before
-        KnobHolderPtr holder = _imp->holder.lock();
-        std::list<KnobItemsTablePtr> tables = holder->getAllItemsTables();
-        for (std::list<KnobItemsTablePtr>::const_iterator it = tables.begin(); it != tables.end(); ++it) {
-            const KnobItemsTablePtr& table = *it;
-
-            std::string tableName = table->getTableIdentifier();
-            std::map<std::string, KnobItemsTableGuiPtr>::iterator foundGuiTable = _imp->tables.find(tableName);
-            if (foundGuiTable != _imp->tables.end()) {
-                continue;
-            }
+        createKnobItemsTablesGui();
+    }
 
-            std::string previousKnobTableName = holder->getItemsTablePreviousKnobScriptName(tableName);
-            KnobHolder::KnobItemsTablePositionEnum knobTablePosition = holder->getItemsTablePosition(tableName);
-            switch (knobTablePosition) {
-                case KnobHolder::eKnobItemsTablePositionAfterKnob: {
-                    KnobIPtr foundKnob = holder->getKnobByName(previousKnobTableName);
-                    KnobPagePtr page = toKnobPage(foundKnob);
-                    KnobPageGuiPtr guiPage;
-                    if (!page) {
-                        // Look for the first page available
-                        if (!_imp->pages.empty()) {
-                            guiPage = _imp->pages.begin()->second;
-                        }
-                    } else {
-                        PagesMap::const_iterator found = _imp->pages.find(page);
-                        if (found != _imp->pages.end()) {
-                            guiPage = found->second;
-                        }
+    double timeSpent = timer.getTimeSinceCreation();
+    _imp->knobsCreationTime += timeSpent;
+    _imp->logKnobsCreation( KnobHolder::tr("%1 knobs").arg( (int)_imp->knobsMap.size() ), timeSpent, getKnobsCreationTime() );
+} // initializeKnobs
+
+void
+KnobGuiContainerHelper::createKnobItemsTablesGui()
+{
+    KnobHolderPtr holder = _imp->holder.lock();
+    std::list<KnobItemsTablePtr> tables = holder->getAllItemsTables();
+    for (std::list<KnobItemsTablePtr>::const_iterator it = tables.begin(); it != tables.end(); ++it) {
+        const KnobItemsTablePtr& table = *it;
+
+        std::string tableName = table->getTableIdentifier();
+        std::map<std::string, KnobItemsTableGuiPtr>::iterator foundGuiTable = _imp->tables.find(tableName);
+        if (foundGuiTable != _imp->tables.end()) {
+            continue;
+        }
+
+        std::string previousKnobTableName = holder->getItemsTablePreviousKnobScriptName(tableName);
+        KnobHolder::KnobItemsTablePositionEnum knobTablePosition = holder->getItemsTablePosition(tableName);
+        switch (knobTablePosition) {
+            case KnobHolder::eKnobItemsTablePositionAfterKnob: {
+                KnobIPtr foundKnob = holder->getKnobByName(previousKnobTableName);
+
+                // The table will be created along with the knobs of the page when it is displayed
+                if ( foundKnob && isKnobInDeferredPage(foundKnob) ) {
+                    continue;
+                }
+
+                KnobPagePtr page = toKnobPage(foundKnob);
+                KnobPageGuiPtr guiPage;
+                if (!page) {
+                    // Look for the first page available
+                    if (!_imp->pages.empty()) {
+                        guiPage = _imp->pages.begin()->second;
                     }
-                    if (guiPage) {
-                        KnobItemsTableGuiPtr guiTable = createKnobItemsTable(table, guiPage->tab);
-                        guiTable->addWidgetsToLayout(guiPage->gridLayout);
-                        _imp->tables.insert(std::make_pair(tableName, guiTable));
+                } else {
+                    PagesMap::const_iterator found = _imp->pages.find(page);
+                    if (found != _imp->pages.end()) {
+                        guiPage = found->second;
                     }
-
-                }   break;
-                case KnobHolder::eKnobItemsTablePositionBottomOfAllPages: {
-                    QWidget* container = getMainContainer();
-                    QLayout* mainLayout = getMainContainerLayout();
-                    KnobItemsTableGuiPtr guiTable = createKnobItemsTable(table, container);
-                    guiTable->addWidgetsToLayout(mainLayout);
+                }
+                if (guiPage) {
+                    KnobItemsTableGuiPtr guiTable = createKnobItemsTable(table, guiPage->tab);
+                    guiTable->addWidgetsToLayout(guiPage->gridLayout);
                     _imp->tables.insert(std::make_pair(tableName, guiTable));
-                }   break;
-            }
+                }
 
-            KnobsVec tableControlKnobs = table->getTableControlKnobs();
-            initializeKnobVectorInternal(tableControlKnobs, 0);
+            }   break;
+            case KnobHolder::eKnobItemsTablePositionBottomOfAllPages: {
+                QWidget* container = getMainContainer();
+                QLayout* mainLayout = getMainContainerLayout();
+                KnobItemsTableGuiPtr guiTable = createKnobItemsTable(table, container);
+                guiTable->addWidgetsToLayout(mainLayout);
+                _imp->tables.insert(std::make_pair(tableName, guiTable));
+            }   break;
         }
 
+        KnobsVec tableControlKnobs = table->getTableControlKnobs();
+        initializeKnobVectorInternal(tableControlKnobs, 0);
     }
-} // initializeKnobs
+} // createKnobItemsTablesGui
 
 void
 KnobGuiContainerHelper::initializeKnobVectorInternal(const KnobsVec& siblingsVec,
@@ -468,7 +595,41 @@ KnobGuiContainerHelper::initializeKnobVector(const KnobsVec& knobs)
             regularKnobs.push_back(knobs[i]);
         }
     }
+    // Only the knobs of the page that is displayed are created. Knobs of other pages are created by createPageKnobs()
+    // when the page is displayed for the first time.
+    // The page displayed is the current page if any, otherwise the first page visible.
+    KnobPagePtr pageToCreate;
+    if ( isPagingEnabled() && !pages.empty() ) {
+        KnobPageGuiPtr curPage = getCurrentPage();
+        KnobPagePtr curPageKnob;
+        if (curPage) {
+            curPageKnob = curPage->pageKnob.lock();
+        }
+        if ( curPageKnob && ( std::find(pages.begin(), pages.end(), curPageKnob) != pages.end() ) && !curPageKnob->getChildren().empty() ) {
+            pageToCreate = curPageKnob;
+        } else {
+            for (std::list<KnobPagePtr >::iterator it = pages.begin(); it != pages.end(); ++it) {
+                if ( !(*it)->getIsSecret() && !(*it)->getChildren().empty() ) {
+                    pageToCreate = *it;
+                    break;
+                }
+            }
+        }
+    }
+
     for (std::list<KnobPagePtr >::iterator it = pages.begin(); it != pages.end(); ++it) {
+
+        if ( isPagingEnabled() && !(*it)->getChildren().empty() ) {
+            // Create the page itself so that it appears in the pages container
+            KnobPageGuiPtr pageGui = getOrCreatePage(*it);
+            if (pageGui && !pageGui->knobsCreated) {
+                if (*it != pageToCreate) {
+                    continue;
+                }
+                pageGui->knobsCreated = true;
+            }
+        }
+
         // Create page
         KnobGuiPtr knobGui = findKnobGuiOrCreate(*it);
         Q_UNUSED(knobGui);
@@ -483,6 +644,10 @@ KnobGuiContainerHelper::initializeKnobVector(const KnobsVec& knobs)
 
     KnobsVec tmp;
     for (KnobsVec::const_iterator it = regularKnobs.begin(); it != regularKnobs.end(); ++it) {
+        // Knobs of pages that are not displayed yet are created later on
+        if ( isKnobInDeferredPage(*it) ) {
+            continue;
+        }
         bool isTableControl = false;
         for (std::list<KnobItemsTablePtr>::const_iterator it2 = tables.begin(); it2 != tables.end(); ++it2) {
             if ((*it2)->isTableControlKnob(*it)) {
@@ -64,11 +64,16 @@ struct KnobPageGui
     KnobPageWPtr pageKnob;
     QGridLayout* gridLayout;
 
+    // The knobs of a page are created only when the page is displayed for the first time.
+    // True once KnobGui have been created for the children of the page.
+    bool knobsCreated;
+
     KnobPageGui()
         : tab(0)
         , groupAsTab(0)
         , pageKnob()
         , gridLayout(0)
+        , knobsCreated(false)
     {
     }
 };
@@ -145,9 +150,16 @@ public:
     /**
      * @brief Call once to create all the gui. This will properly create all the knobs by recursing over them.
      * Once created once, if knob changes (deletion, creation...) happen you should instead call refreshGuiForKnobsChanges() to refresh knob changes.
+     * Only the knobs of the page that is displayed are created: the knobs of other pages are created when the page becomes
+     * current for the first time, see setCurrentPage().
      **/
     void initializeKnobs();
 
+    /**
+     * @brief Returns the total time spent creating knob widgets in this container, in seconds.
+     **/
+    double getKnobsCreationTime() const;
+
     /**
      * @brief Returns all the pages inside this container
      **/
@@ -179,7 +191,9 @@ public:
     const KnobsVec& getInternalKnobs() const;
 
     /**
-     * @brief Returns a mapping between the internal knobs and the gui counter part
+     * @brief Returns a mapping between the internal knobs and the gui counter part.
+     * Knobs of pages that were never displayed are not in the mapping, use getKnobGui() to ensure
+     * the gui of a knob is created.
      **/
     const KnobsGuiMapping& getKnobsMapping() const;
 
@@ -277,6 +291,7 @@ public:
 
     /**
      * @brief Returns a pointe to the KnobGui representing the given internal knob.
+     * If the knob belongs to a page whose knobs were not created yet, they are created.
      **/
     virtual KnobGuiPtr getKnobGui(const KnobIPtr& knob) const OVERRIDE FINAL WARN_UNUSED_RETURN;
 
@@ -312,7 +327,7 @@ protected:
 
     /**
      * @brief Set the pointer to the current page, this should be called by the derived implementation when the current page has changed,
-     * i.e: when the current tab of a tabwidget has changed
+     * i.e: when the current tab of a tabwidget has changed. This creates the knobs of the page if they were not created yet.
      **/
     void setCurrentPage(const KnobPageGuiPtr& curPage);
 
@@ -321,6 +336,12 @@ protected:
      **/
     virtual void onKnobsInitialized() {}
 
+    /**
+     * @brief Called when the knobs of a page were created after initializeKnobs(), because the page was displayed
+     * for the first time.
+     **/
+    virtual void onPageKnobsCreated(const KnobPageGuiPtr& /*page*/) {}
+
     /**
      * @brief This is called when a page is made current externally, e.g: not by the user changing it from the tab-widget
      **/
@@ -396,6 +417,12 @@ private:
 
     void initializeKnobVector(const KnobsVec& knobs);
 
+    void createPageKnobs(const KnobPageGuiPtr& page);
+
+    void createKnobItemsTablesGui();
+
+    bool isKnobInDeferredPage(const KnobIPtr& knob) const;
+
     void refreshPagesOrder(const KnobPageGuiPtr& curTabName, bool restorePageIndex);
 
     void clearUndoRedoStack();
@@ -251,6 +251,11 @@ public:
 
     void markInputNull(Edge* e);
 
+    /**
+     * @brief Returns the knobs of the settings panel that have a gui, see KnobGuiContainerHelper::getKnobsMapping().
+     * Knobs of pages that were never displayed are not in the list: their gui is created with up to date values
+     * when the page is displayed. Callers that need every knob should use the internal knobs of the node instead.
+     **/
     const std::list<std::pair<KnobIWPtr, KnobGuiPtr> > & getKnobs() const;
     static const int DEFAULT_OFFSET_BETWEEN_NODES = 30;
 
@@ -278,14 +278,8 @@ getKnobGuiForKnob(const NodePtr& selectedNode,
     }
 
 
-    const std::list<std::pair<KnobIWPtr, KnobGuiPtr> >& knobsMap = selectedPanel->getKnobsMapping();
-    for (std::list<std::pair<KnobIWPtr, KnobGuiPtr> >::const_iterator it = knobsMap.begin(); it != knobsMap.end(); ++it) {
-        if (it->first.lock() == knob) {
-            return it->second;
-        }
-    }
-
-    return KnobGuiPtr();
+    // The knob may be on a page that was never displayed: getKnobGui() ensures it is created
+    return selectedPanel->getKnobGui(knob);
 }
 
 void
@@ -32,9 +32,14 @@
 
 NATRON_NAMESPACE_ENTER
 
+// Commands are only created on the main thread
+static U64 undoCommandsCounter = 0;
+
 UndoCommand_qt::UndoCommand_qt(const UndoCommandPtr& command)
 : QUndoCommand()
 , _command(command)
+, _age(++undoCommandsCounter)
+, _memoryCost(command->getMemoryCost())
 {
     setText( QString::fromUtf8( command->getText().c_str() ) );
 }
@@ -46,13 +51,29 @@ UndoCommand_qt::~UndoCommand_qt()
 void
 UndoCommand_qt::redo()
 {
+    if (!_command) {
+        return;
+    }
     _command->redo();
+    _memoryCost = _command->getMemoryCost();
 }
 
 void
 UndoCommand_qt::undo()
 {
+    if (!_command) {
+        return;
+    }
     _command->undo();
+    _memoryCost = _command->getMemoryCost();
+}
+
+void
+UndoCommand_qt::discard()
+{
+    _command.reset();
+    _memoryCost = 0;
+    setText( QObject::tr("%1 (discarded)").arg( text() ) );
 }
 
 int
@@ -66,11 +87,15 @@ UndoCommand_qt::mergeWith(const QUndoCommand* other)
 {
     const UndoCommand_qt* o = dynamic_cast<const UndoCommand_qt*>(other);
 
-    if (!o) {
+    if (!o || !_command || !o->_command) {
         return false;
     }
 
-    return _command->mergeWith(o->_command);
+    if ( !_command->mergeWith(o->_command) ) {
+        return false;
+    }
+    _memoryCost = _command->getMemoryCost();
+    return true;
 }
 
 
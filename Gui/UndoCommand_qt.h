@@ -26,12 +26,16 @@
 #include <Python.h>
 // ***** END PYTHON BLOCK *****
 
+#include <cstddef>
+
 #include <QUndoCommand>
 #if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
 #include <boost/scoped_ptr.hpp>
 #include <boost/shared_ptr.hpp>
 #endif
 
+#include "Global/GlobalDefines.h"
+
 #include "Gui/GuiFwd.h"
 NATRON_NAMESPACE_ENTER;
 
@@ -40,6 +44,12 @@ class UndoCommand_qt
 {
     boost::shared_ptr<UndoCommand> _command;
 
+    // Incremented for each command created, used to discard the oldest commands first
+    U64 _age;
+
+    // Cached value of _command->getMemoryCost(), refreshed whenever the command changes
+    std::size_t _memoryCost;
+
 public:
 
     UndoCommand_qt(const UndoCommandPtr& command);
@@ -52,7 +62,30 @@ public:
 
     virtual int id() const OVERRIDE FINAL WARN_UNUSED_RETURN;
     
-    virtual bool mergeWith(const QUndoCommand* other) OVERRIDE FINAL WARN_UNUSED_RETURN;};
+    virtual bool mergeWith(const QUndoCommand* other) OVERRIDE FINAL WARN_UNUSED_RETURN;
+
+    U64 getAge() const
+    {
+        return _age;
+    }
+
+    std::size_t getMemoryCost() const
+    {
+        return _memoryCost;
+    }
+
+    bool isDiscarded() const
+    {
+        return !_command;
+    }
+
+    /**
+     * @brief Release the internal command to free its memory: undo() and redo() no longer do anything.
+     * This must only be called if all the commands before this one in the stack are discarded as well,
+     * so that undoing and redoing over them does not change the state.
+     **/
+    void discard();
+};
 
 NATRON_NAMESPACE_EXIT;
 
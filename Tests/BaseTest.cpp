@@ -25,6 +25,8 @@
 #include "Global/Macros.h"
 
 #include <cstdlib>
+#include <iostream>
+#include <sstream> // stringstream
 
 #include "BaseTest.h"
 
@@ -47,6 +49,7 @@ CLANG_DIAG_ON(unknown-pragmas)
 #include "Engine/Project.h"
 #include "Engine/AppManager.h"
 #include "Engine/AppInstance.h"
+#include "Engine/Cache.h"
 #include "Engine/KnobTypes.h"
 #include "Engine/EffectInstance.h"
 #include "Engine/Plugin.h"
@@ -281,6 +284,57 @@ TEST_F(BaseTest, SetValues)
     }
 }
 
+///Render a plane from Python while the tree evaluates a Python expression in the render threads:
+///the script must release the GIL while it waits for the render.
+TEST_F(BaseTest, RenderPlaneWithPythonExpression)
+{
+    NodePtr generator = createNode(_generatorPluginID);
+    ASSERT_TRUE( bool(generator) );
+
+    Format f(0, 0, 64, 64, "renderPlaneTest", 1.);
+    generator->getApp()->getProject()->setOrAddProjectFormat(f);
+
+    KnobDoublePtr knob = toKnobDouble(generator->getKnobByName("noiseZ"));
+    ASSERT_TRUE( bool(knob) );
+    knob->setExpression(DimSpec(0), ViewSetSpec(0), "frame / 100.", eExpressionLanguagePython, false /*hasRetVariable*/, true /*failIfInvalid*/);
+
+    std::stringstream ss;
+    ss << "import NatronEngine\n";
+    ss << "image = " << getApp()->getAppIDString() << "." << generator->getScriptName_mt_safe()
+       << ".renderPlane(3, 0, NatronEngine.ImageLayer.getRGBAComponents())\n";
+    ss << "renderPlaneWidth = image.bounds.width()\n";
+    ss << "del image\n";
+
+    std::string error;
+    bool ok = NATRON_PYTHON_NAMESPACE::interpretPythonScript(ss.str(), &error, 0);
+    EXPECT_TRUE(ok) << error;
+
+    ok = NATRON_PYTHON_NAMESPACE::interpretPythonScript("assert renderPlaneWidth == 64\n", &error, 0);
+    EXPECT_TRUE(ok) << error;
+}
+
+///Creating a cache and reading its size, which is done before each insertion, must not map the table of contents
+///of the buckets: this is what makes the startup time independent of the cache size.
+TEST_F(BaseTest, CacheStartup)
+{
+    CacheBasePtr cache = Cache<false>::create(true /*enableTileStorage*/);
+    ASSERT_TRUE( bool(cache) );
+
+    // Reading the size of the cache must not map the table of contents of the buckets
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ( (std::size_t)0, cache->getCurrentSize() );
+    }
+    EXPECT_EQ( (U64)0, cache->getStatistics().getValue(CacheStatistics::eCounterToCMappings) );
+
+    // Same for the application tile cache, which is persistent
+    CacheBasePtr tileCache = appPTR->getTileCache();
+    tileCache->getStatistics().reset();
+    for (int i = 0; i < 100; ++i) {
+        tileCache->getCurrentSize();
+    }
+    EXPECT_EQ( (U64)0, tileCache->getStatistics().getValue(CacheStatistics::eCounterToCMappings) );
+}
+
 ///High level test: simple node connections test
 TEST_F(BaseTest, SimpleNodeConnections) {
     ///create the generator
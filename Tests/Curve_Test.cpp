@@ -24,6 +24,8 @@
 
 #include "Global/Macros.h"
 
+#include <vector>
+
 #include <gtest/gtest.h>
 
 #include <QtCore/QString>
@@ -124,3 +126,72 @@ TEST(Curve, Basic)
 }
 
 
+
+TEST(Curve, BatchEvaluation)
+{
+    Curve c;
+
+    EXPECT_TRUE( c.setOrAddKeyframe( KeyFrame(0., 10., 0., 0., eKeyframeTypeSmooth) ) == eValueChangedReturnCodeKeyframeAdded );
+    EXPECT_TRUE( c.setOrAddKeyframe( KeyFrame(10., 20., 0., 0., eKeyframeTypeCatmullRom) ) == eValueChangedReturnCodeKeyframeAdded );
+    EXPECT_TRUE( c.setOrAddKeyframe( KeyFrame(20., -5., 0., 0., eKeyframeTypeLinear) ) == eValueChangedReturnCodeKeyframeAdded );
+    EXPECT_TRUE( c.setOrAddKeyframe( KeyFrame(30., 0., 0., 0., eKeyframeTypeConstant) ) == eValueChangedReturnCodeKeyframeAdded );
+
+    // increasing times, then decreasing times, crossing all segments
+    std::vector<TimeValue> times;
+    for (double t = -5.; t <= 35.; t += 0.25) {
+        times.push_back( TimeValue(t) );
+    }
+    for (double t = 35.; t >= -5.; t -= 0.75) {
+        times.push_back( TimeValue(t) );
+    }
+
+    // Values given by the Hermite evaluation of each segment, before the segment polynomials were precomputed:
+    // they check the coefficients of each segment type, not only that both evaluation paths agree.
+    const std::size_t nSamples = 15;
+    const double sampleTimes[nSamples] = {
+        -5., 0., 2.5, 5., 7.25, 10., 12.5, 15., 17.75, 20., 22.5, 25., 29.5, 30., 35.
+    };
+    const double expectedValues[nSamples] = {
+        10., 10., 13.3203125, 17.1875, 19.7795703125, 20., 16.62109375, 10.78125, 2.494082031249998, -5., -3.75, -2.5, -0.25, 0., 0.
+    };
+    const double expectedValuesModified[nSamples] = {
+        10., 10., 21.89453125, 32.03125, 38.19853515625, 40., 34.90234375, 24.53125, 9.130175781249994, -5., -3.75, -2.5, -0.25, 0., 0.
+    };
+    std::vector<TimeValue> samples;
+    for (std::size_t i = 0; i < nSamples; ++i) {
+        samples.push_back( TimeValue(sampleTimes[i]) );
+    }
+
+    std::vector<double> values;
+    c.getValuesAt(samples, true, &values);
+    ASSERT_EQ( samples.size(), values.size() );
+    for (std::size_t i = 0; i < nSamples; ++i) {
+        EXPECT_NEAR( expectedValues[i], values[i], 1e-9 );
+        EXPECT_NEAR( expectedValues[i], c.getValueAt(samples[i]).getValue(), 1e-9 );
+    }
+
+    c.getValuesAt(times, true, &values);
+    ASSERT_EQ( times.size(), values.size() );
+    for (std::size_t i = 0; i < times.size(); ++i) {
+        EXPECT_EQ( c.getValueAt(times[i]).getValue(), values[i] );
+    }
+
+    // the precomputed segments must follow keyframe changes
+    EXPECT_EQ( 20., c.getValueAt(TimeValue(10.)).getValue() );
+    EXPECT_TRUE( c.setOrAddKeyframe( KeyFrame(10., 40., 0., 0., eKeyframeTypeCatmullRom) ) == eValueChangedReturnCodeKeyframeModified );
+    EXPECT_EQ( 40., c.getValueAt(TimeValue(10.)).getValue() );
+    c.getValuesAt(samples, true, &values);
+    for (std::size_t i = 0; i < nSamples; ++i) {
+        EXPECT_NEAR( expectedValuesModified[i], values[i], 1e-9 );
+    }
+    c.getValuesAt(times, true, &values);
+    for (std::size_t i = 0; i < times.size(); ++i) {
+        EXPECT_EQ( c.getValueAt(times[i]).getValue(), values[i] );
+    }
+
+    c.clearKeyFrames();
+    c.getValuesAt(times, true, &values);
+    for (std::size_t i = 0; i < times.size(); ++i) {
+        EXPECT_EQ( 0., values[i] );
+    }
+}
@@ -0,0 +1,197 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Engine/FitCurve.h"
+
+NATRON_NAMESPACE_USING
+using namespace NATRON_NAMESPACE::FitCurve;
+
+// User error squared passed to the fitters: points must be within 2 pixels of the curve
+#define FIT_ERROR 4.
+
+static Point
+makePoint(double x,
+          double y)
+{
+    Point p;
+
+    p.x = x;
+    p.y = y;
+
+    return p;
+}
+
+// A dense freehand-like stroke: a wave going right, followed by a spiral
+static std::vector<Point>
+makeStroke()
+{
+    std::vector<Point> points;
+
+    for (int i = 0; i < 400; ++i) {
+        double t = i;
+        points.push_back( makePoint( t * 1.5, 60. * std::sin(t / 25.) + 10. * std::sin(t / 7.) ) );
+    }
+    for (int i = 1; i < 400; ++i) {
+        double a = i / 40.;
+        double r = 100. + i * 0.25;
+        points.push_back( makePoint( 600. + r * std::sin(a), 60. * std::sin(400. / 25.) + 10. * std::sin(400. / 7.) + r - r * std::cos(a) ) );
+    }
+
+    return points;
+}
+
+static Point
+evalSegment(const SimpleBezierCP& cp0,
+            const SimpleBezierCP& cp1,
+            double u)
+{
+    double a = (1. - u) * (1. - u) * (1. - u);
+    double b = 3. * u * (1. - u) * (1. - u);
+    double c = 3. * u * u * (1. - u);
+    double d = u * u * u;
+
+    return makePoint(a * cp0.p.x + b * cp0.rightTan.x + c * cp1.leftTan.x + d * cp1.p.x,
+                     a * cp0.p.y + b * cp0.rightTan.y + c * cp1.leftTan.y + d * cp1.p.y);
+}
+
+// Returns the largest distance from a point to the curve, the curve being densely sampled
+static double
+maxDistanceToBezier(const std::vector<Point>& points,
+                    const std::vector<SimpleBezierCP>& bezier)
+{
+    const int nSamples = 2000;
+    std::vector<Point> samples;
+
+    for (std::size_t i = 0; i + 1 < bezier.size(); ++i) {
+        for (int s = 0; s <= nSamples; ++s) {
+            samples.push_back( evalSegment(bezier[i], bezier[i + 1], s / (double)nSamples) );
+        }
+    }
+
+    double maxDist = 0.;
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        double minDistSq = std::numeric_limits<double>::infinity();
+        for (std::size_t s = 0; s < samples.size(); ++s) {
+            double dx = samples[s].x - points[i].x;
+            double dy = samples[s].y - points[i].y;
+            minDistSq = std::min(minDistSq, dx * dx + dy * dy);
+        }
+        maxDist = std::max( maxDist, std::sqrt(minDistSq) );
+    }
+
+    return maxDist;
+}
+
+// The sampling of the curve adds a small error to the distance
+#define FIT_TOLERANCE (std::sqrt(FIT_ERROR) + 0.05)
+
+TEST(FitCurve, ErrorBound)
+{
+    std::vector<Point> points = makeStroke();
+    std::vector<SimpleBezierCP> bezier;
+
+    fit_cubic(points, FIT_ERROR, &bezier);
+    ASSERT_GE(bezier.size(), 2u);
+    EXPECT_LT( bezier.size(), points.size() / 4 );
+    EXPECT_LE( maxDistanceToBezier(points, bezier), FIT_TOLERANCE );
+}
+
+TEST(FitCurve, Batch)
+{
+    std::vector<Point> stroke = makeStroke();
+    std::vector<std::vector<Point> > pointSets(4);
+
+    // Different parts of the stroke, including a set too small to be fitted
+    pointSets[0] = stroke;
+    pointSets[1].assign(stroke.begin(), stroke.begin() + 400);
+    pointSets[2].assign(stroke.begin() + 300, stroke.end());
+    pointSets[3].assign(stroke.begin(), stroke.begin() + 1);
+
+    std::vector<std::vector<SimpleBezierCP> > beziers;
+    fit_cubic_batch(pointSets, FIT_ERROR, &beziers);
+    ASSERT_EQ( pointSets.size(), beziers.size() );
+
+    // Each set must be fitted exactly as with fit_cubic
+    for (std::size_t i = 0; i < pointSets.size(); ++i) {
+        std::vector<SimpleBezierCP> bezier;
+        fit_cubic(pointSets[i], FIT_ERROR, &bezier);
+        ASSERT_EQ( bezier.size(), beziers[i].size() );
+        for (std::size_t j = 0; j < bezier.size(); ++j) {
+            EXPECT_EQ(bezier[j].p.x, beziers[i][j].p.x);
+            EXPECT_EQ(bezier[j].p.y, beziers[i][j].p.y);
+            EXPECT_EQ(bezier[j].leftTan.x, beziers[i][j].leftTan.x);
+            EXPECT_EQ(bezier[j].leftTan.y, beziers[i][j].leftTan.y);
+            EXPECT_EQ(bezier[j].rightTan.x, beziers[i][j].rightTan.x);
+            EXPECT_EQ(bezier[j].rightTan.y, beziers[i][j].rightTan.y);
+        }
+    }
+    EXPECT_TRUE( beziers[3].empty() );
+}
+
+TEST(FitCurve, Incremental)
+{
+    std::vector<Point> points = makeStroke();
+    IncrementalFitter fitter(FIT_ERROR);
+    std::vector<Point> appended;
+    std::vector<SimpleBezierCP> bezier;
+    std::size_t maxTailPoints = 0;
+
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        fitter.appendPoint(points[i]);
+        // duplicates are ignored
+        fitter.appendPoint(points[i]);
+        appended.push_back(points[i]);
+        ASSERT_EQ( appended.size(), fitter.getPointsCount() );
+        maxTailPoints = std::max( maxTailPoints, fitter.getTailPointsCount() );
+
+        // The curve must be within the error of all the points appended so far, at any time
+        if ( (i % 100 == 99) || (i + 1 == points.size()) ) {
+            fitter.getBezier(&bezier);
+            ASSERT_GE(bezier.size(), 2u);
+            EXPECT_EQ( points[0].x, bezier.front().p.x );
+            EXPECT_EQ( points[0].y, bezier.front().p.y );
+            EXPECT_EQ( points[i].x, bezier.back().p.x );
+            EXPECT_EQ( points[i].y, bezier.back().p.y );
+            EXPECT_LE( maxDistanceToBezier(appended, bezier), FIT_TOLERANCE );
+        }
+    }
+
+    // Only a small part of the stroke was fitted again for each point
+    EXPECT_LT( maxTailPoints, points.size() / 2 );
+
+    fitter.clear();
+    EXPECT_EQ( 0u, fitter.getPointsCount() );
+    fitter.appendPoint( makePoint(0., 0.) );
+    fitter.getBezier(&bezier);
+    EXPECT_EQ( 1u, bezier.size() );
+}
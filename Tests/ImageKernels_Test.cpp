@@ -0,0 +1,414 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2018 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Engine/Image.h"
+#include "Engine/ImageKernelDispatch.h"
+#include "Engine/ImagePrivate.h"
+#include "Engine/TrackerFrameAccessor.h"
+
+NATRON_NAMESPACE_USING
+
+// Size of the images processed by each kernel of the test matrix
+#define KERNEL_TEST_SIZE 512
+
+static const ImageBitDepthEnum kernelDepths[NATRON_IMAGE_KERNEL_N_DEPTHS] = {
+    eImageBitDepthByte, eImageBitDepthShort, eImageBitDepthFloat
+};
+
+static const char*
+getDepthName(ImageBitDepthEnum depth)
+{
+    switch (depth) {
+        case eImageBitDepthByte:
+            return "byte";
+        case eImageBitDepthShort:
+            return "short";
+        case eImageBitDepthFloat:
+            return "float";
+        default:
+            return "none";
+    }
+}
+
+/**
+ * @brief A packed RGBA-style buffer of a given depth and number of components, with accessors in normalized float.
+ **/
+class KernelTestBuffer
+{
+public:
+
+    KernelTestBuffer(ImageBitDepthEnum depth, int nComps, const RectI& bounds)
+    : _depth(depth)
+    , _nComps(nComps)
+    , _bounds(bounds)
+    , _data(getSizeOfForBitDepth(depth) * std::max(nComps, 1) * bounds.area())
+    {
+        memset(_ptrs, 0, sizeof(void*) * 4);
+        if (nComps > 0) {
+            _ptrs[0] = &_data[0];
+        }
+    }
+
+    void** ptrs()
+    {
+        return _ptrs;
+    }
+
+    const void** constPtrs()
+    {
+        return (const void**)_ptrs;
+    }
+
+    float get(int x, int y, int c) const
+    {
+        std::size_t i = ( (std::size_t)(y - _bounds.y1) * _bounds.width() + (x - _bounds.x1) ) * _nComps + c;
+        switch (_depth) {
+            case eImageBitDepthByte:
+                return ( (const unsigned char*)&_data[0] )[i] / 255.f;
+            case eImageBitDepthShort:
+                return ( (const unsigned short*)&_data[0] )[i] / 65535.f;
+            default:
+                return ( (const float*)&_data[0] )[i];
+        }
+    }
+
+    void set(int x, int y, int c, float v)
+    {
+        std::size_t i = ( (std::size_t)(y - _bounds.y1) * _bounds.width() + (x - _bounds.x1) ) * _nComps + c;
+        switch (_depth) {
+            case eImageBitDepthByte:
+                ( (unsigned char*)&_data[0] )[i] = (unsigned char)(v * 255.f + 0.5f);
+                break;
+            case eImageBitDepthShort:
+                ( (unsigned short*)&_data[0] )[i] = (unsigned short)(v * 65535.f + 0.5f);
+                break;
+            default:
+                ( (float*)&_data[0] )[i] = v;
+                break;
+        }
+    }
+
+    void fill(float v)
+    {
+        for (int y = _bounds.y1; y < _bounds.y2; ++y) {
+            for (int x = _bounds.x1; x < _bounds.x2; ++x) {
+                for (int c = 0; c < _nComps; ++c) {
+                    set(x, y, c, v);
+                }
+            }
+        }
+    }
+
+private:
+
+    ImageBitDepthEnum _depth;
+    int _nComps;
+    RectI _bounds;
+    std::vector<unsigned char> _data;
+    void* _ptrs[4];
+};
+
+// Tolerance of a value stored at the given depth, in normalized float
+static float
+getDepthTolerance(ImageBitDepthEnum depth)
+{
+    switch (depth) {
+        case eImageBitDepthByte:
+            return 1.01f / 255.f;
+        case eImageBitDepthShort:
+            return 1.01f / 65535.f;
+        default:
+            return 1e-5f;
+    }
+}
+
+struct KernelTestArgs
+{
+    int* pixelSize;
+    int* nComps;
+};
+
+template <typename PIX, int maxValue, int nComps>
+class KernelTestDummy
+{
+public:
+
+    static ActionRetCodeEnum run(const KernelTestArgs& args)
+    {
+        *args.pixelSize = (int)sizeof(PIX);
+        *args.nComps = nComps;
+        return eActionStatusOK;
+    }
+};
+
+TEST(ImageKernels, DispatchTable)
+{
+    int pixelSize = 0, nCompsRun = 0;
+    KernelTestArgs args;
+    args.pixelSize = &pixelSize;
+    args.nComps = &nCompsRun;
+
+    for (int nComps = 1; nComps <= 4; ++nComps) {
+        EXPECT_EQ( eActionStatusFailed, (ImageKernelTable<KernelTestArgs, KernelTestDummy>::run(eImageBitDepthHalf, nComps, args)) );
+        EXPECT_EQ( eActionStatusFailed, (ImageKernelTable<KernelTestArgs, KernelTestDummy>::run(eImageBitDepthNone, nComps, args)) );
+        for (int d = 0; d < NATRON_IMAGE_KERNEL_N_DEPTHS; ++d) {
+            EXPECT_EQ( eActionStatusOK, (ImageKernelTable<KernelTestArgs, KernelTestDummy>::run(kernelDepths[d], nComps, args)) );
+            EXPECT_EQ( (int)getSizeOfForBitDepth(kernelDepths[d]), pixelSize );
+            EXPECT_EQ( nComps, nCompsRun );
+        }
+    }
+    EXPECT_TRUE( (ImageKernelTable<KernelTestArgs, KernelTestDummy>::getKernel(eImageBitDepthFloat, 0)) == NULL );
+    EXPECT_TRUE( (ImageKernelTable<KernelTestArgs, KernelTestDummy>::getKernel(eImageBitDepthFloat, 5)) == NULL );
+}
+
+TEST(ImageKernels, Fill)
+{
+    const RectI bounds(0, 0, KERNEL_TEST_SIZE, KERNEL_TEST_SIZE);
+    // Leave a border untouched to check that the kernel stays in the roi
+    const RectI roi(3, 5, KERNEL_TEST_SIZE - 7, KERNEL_TEST_SIZE - 2);
+    const float color[4] = {0.25f, 0.5f, 0.75f, 1.f};
+
+    for (int d = 0; d < NATRON_IMAGE_KERNEL_N_DEPTHS; ++d) {
+        for (int nComps = 1; nComps <= 4; ++nComps) {
+            KernelTestBuffer buf(kernelDepths[d], nComps, bounds);
+            buf.fill(0.f);
+
+            ActionRetCodeEnum stat = ImagePrivate::fillCPU(buf.ptrs(), color[0], color[1], color[2], color[3], nComps, kernelDepths[d], bounds, roi, EffectInstancePtr());
+            ASSERT_EQ(eActionStatusOK, stat);
+
+            const float tolerance = getDepthTolerance(kernelDepths[d]);
+            for (int y = bounds.y1; y < bounds.y2; y += 7) {
+                for (int x = bounds.x1; x < bounds.x2; x += 3) {
+                    bool inside = roi.contains(x, y);
+                    for (int c = 0; c < nComps; ++c) {
+                        float expected = inside ? (nComps == 1 ? color[3] : color[c]) : 0.f;
+                        ASSERT_NEAR(expected, buf.get(x, y, c), tolerance);
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST(ImageKernels, MaskMix)
+{
+    const RectI bounds(0, 0, KERNEL_TEST_SIZE, KERNEL_TEST_SIZE);
+    const RectI roi = bounds;
+    // The mask only covers the left half of the image: pixels outside of it are not masked
+    const RectI maskBounds(0, 0, KERNEL_TEST_SIZE / 2, KERNEL_TEST_SIZE);
+    const float dstValue = 0.8f;
+    const float srcValue = 0.2f;
+    const float maskValue = 0.5f;
+    const double mix = 0.75;
+
+    for (int d = 0; d < NATRON_IMAGE_KERNEL_N_DEPTHS; ++d) {
+        ImageBitDepthEnum depth = kernelDepths[d];
+        for (int srcNComps = 0; srcNComps <= 4; ++srcNComps) {
+            for (int dstNComps = 1; dstNComps <= 4; ++dstNComps) {
+                for (int masked = 0; masked < 2; ++masked) {
+                    KernelTestBuffer src(depth, srcNComps, bounds);
+                    src.fill(srcValue);
+                    KernelTestBuffer mask(depth, 1, maskBounds);
+                    mask.fill(maskValue);
+                    KernelTestBuffer dst(depth, dstNComps, bounds);
+                    dst.fill(dstValue);
+
+                    const void* noMaskPtrs[4] = {NULL, NULL, NULL, NULL};
+
+                    ActionRetCodeEnum stat = ImagePrivate::applyMaskMixCPU(src.constPtrs(), bounds, srcNComps, masked ? mask.constPtrs() : noMaskPtrs, maskBounds, dst.ptrs(), depth, dstNComps, mix, false, bounds, roi, EffectInstancePtr());
+                    ASSERT_EQ(eActionStatusOK, stat);
+
+                    // Each conversion of the mixed value back to the pixel depth may round
+                    const float tolerance = 2.f * getDepthTolerance(depth);
+                    for (int y = bounds.y1; y < bounds.y2; y += 5) {
+                        for (int x = bounds.x1; x < bounds.x2; x += 3) {
+                            float alpha = mix;
+                            if (masked) {
+                                alpha *= maskBounds.contains(x, y) ? maskValue : 0.f;
+                            }
+                            for (int c = 0; c < dstNComps; ++c) {
+                                float srcF = c < srcNComps ? srcValue : 0.f;
+                                float expected = dstValue * alpha + (1.f - alpha) * srcF;
+                                ASSERT_NEAR(expected, dst.get(x, y, c), tolerance);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+} // TEST
+
+TEST(ImageKernels, ConvertMatrix)
+{
+    const RectI bounds(0, 0, KERNEL_TEST_SIZE, KERNEL_TEST_SIZE);
+    const float value = 0.5f;
+
+    for (int s = 0; s < NATRON_IMAGE_KERNEL_N_DEPTHS; ++s) {
+        for (int d = 0; d < NATRON_IMAGE_KERNEL_N_DEPTHS; ++d) {
+            for (int nComps = 1; nComps <= 4; ++nComps) {
+                KernelTestBuffer src(kernelDepths[s], nComps, bounds);
+                src.fill(value);
+                KernelTestBuffer dst(kernelDepths[d], nComps, bounds);
+                dst.fill(0.f);
+
+                ActionRetCodeEnum stat = ImagePrivate::convertCPUImage(bounds, eViewerColorSpaceLinear, eViewerColorSpaceLinear, false, 3, Image::eAlphaChannelHandlingFillFromChannel, Image::eMonoToPackedConversionCopyToAll, src.constPtrs(), nComps, kernelDepths[s], bounds, dst.ptrs(), nComps, kernelDepths[d], bounds, EffectInstancePtr());
+                ASSERT_EQ(eActionStatusOK, stat);
+
+                const float tolerance = getDepthTolerance(kernelDepths[s]) + getDepthTolerance(kernelDepths[d]);
+                for (int y = bounds.y1; y < bounds.y2; y += 5) {
+                    for (int x = bounds.x1; x < bounds.x2; x += 3) {
+                        for (int c = 0; c < nComps; ++c) {
+                            ASSERT_NEAR(src.get(x, y, c), dst.get(x, y, c), tolerance);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    // Half float is not supported on CPU
+    KernelTestBuffer src(eImageBitDepthFloat, 4, bounds);
+    KernelTestBuffer dst(eImageBitDepthFloat, 4, bounds);
+    EXPECT_EQ( eActionStatusFailed, ImagePrivate::convertCPUImage(bounds, eViewerColorSpaceLinear, eViewerColorSpaceLinear, false, 3, Image::eAlphaChannelHandlingFillFromChannel, Image::eMonoToPackedConversionCopyToAll, src.constPtrs(), 4, eImageBitDepthHalf, bounds, dst.ptrs(), 4, eImageBitDepthFloat, bounds, EffectInstancePtr()) );
+} // TEST
+
+struct ConvertToLibMVReferenceArgs
+{
+    const bool* enabledChannels;
+    const void** ptrs;
+    RectI bounds;
+    RectI roi;
+    bool takeDstFromAlpha;
+    MvFloatImage* destination;
+};
+
+/**
+ * @brief The per-pixel conversion to the libmv format that TrackerFrameAccessor did before converting by blocks.
+ * It is the reference the block conversion must match bit for bit, so that tracking results do not change.
+ **/
+template <typename PIX, int maxValue, int srcNComps>
+class ConvertToLibMVReferenceKernel
+{
+public:
+
+    static ActionRetCodeEnum run(const ConvertToLibMVReferenceArgs& args)
+    {
+        const bool doR = args.enabledChannels[0];
+        const bool doG = args.enabledChannels[1];
+        const bool doB = args.enabledChannels[2];
+        const RectI& roi = args.roi;
+
+        float* dst_pixels = (float*)Image::pixelAtStatic(roi.x1, roi.y1, roi, 1, sizeof(float), (unsigned char*)args.destination->Data());
+        const float scale = (doR ? 0.2126f : 0.0f) + (doG ? 0.7152f : 0.0f) + (doB ? 0.0722f : 0.0f);
+
+        for (int y = roi.y1; y < roi.y2; ++y) {
+            for (int x = roi.x1; x < roi.x2; ++x) {
+                int srcPixelsStride;
+                const PIX* src_pixels[4] = {NULL, NULL, NULL, NULL};
+                Image::getChannelPointers<PIX, srcNComps>( (const PIX**)args.ptrs, x, y, args.bounds, (PIX**)src_pixels, &srcPixelsStride );
+
+                if (!src_pixels[0]) {
+                    *dst_pixels = 0;
+                } else {
+                    if (srcNComps == 1) {
+                        *dst_pixels = Image::convertPixelDepth<PIX, float>(*src_pixels[0]);
+                    } else if (srcNComps == 4 && args.takeDstFromAlpha) {
+                        *dst_pixels = Image::convertPixelDepth<PIX, float>(*src_pixels[3]);
+                    } else {
+                        float tmpPix[4] = {0.f, 0.f, 0.f, 0.f};
+                        for (int c = 0; c < srcNComps; ++c) {
+                            tmpPix[c] = doR ? Image::convertPixelDepth<PIX, float>(*src_pixels[c]) : 0.f;
+                        }
+                        *dst_pixels = (0.2126f * tmpPix[0] + 0.7152f * tmpPix[1] + 0.0722f * tmpPix[2]) / scale;
+                    }
+                }
+                ++dst_pixels;
+            }
+        }
+
+        return eActionStatusOK;
+    }
+};
+
+TEST(ImageKernels, ConvertToLibMV)
+{
+    // The source does not cover the whole roi and its scan-lines are longer than a block of the conversion
+    const RectI srcBounds(5, 3, 300, 200);
+    const RectI roi(0, 0, 320, 210);
+
+    for (int d = 0; d < NATRON_IMAGE_KERNEL_N_DEPTHS; ++d) {
+        ImageBitDepthEnum depth = kernelDepths[d];
+        for (int nComps = 1; nComps <= 4; ++nComps) {
+            KernelTestBuffer src(depth, nComps, srcBounds);
+            for (int y = srcBounds.y1; y < srcBounds.y2; ++y) {
+                for (int x = srcBounds.x1; x < srcBounds.x2; ++x) {
+                    for (int c = 0; c < nComps; ++c) {
+                        float v = ( (x * 7 + y * 13 + c * 29) % 101 ) / 100.f;
+                        if (depth == eImageBitDepthFloat) {
+                            // Out of [0,1] values and signed zeros are only representable in float
+                            v = (x + y + c) % 17 == 0 ? -0.f : v * 2.f - 0.5f;
+                        }
+                        src.set(x, y, c, v);
+                    }
+                }
+            }
+
+            for (int mask = 0; mask < 8; ++mask) {
+                const bool enabledChannels[3] = { (mask & 1) != 0, (mask & 2) != 0, (mask & 4) != 0 };
+                for (int alpha = 0; alpha < 2; ++alpha) {
+                    MvFloatImage expected( roi.height(), roi.width() );
+                    ConvertToLibMVReferenceArgs args;
+                    args.enabledChannels = enabledChannels;
+                    args.ptrs = src.constPtrs();
+                    args.bounds = srcBounds;
+                    args.roi = roi;
+                    args.takeDstFromAlpha = alpha != 0;
+                    args.destination = &expected;
+                    ASSERT_EQ( eActionStatusOK, (ImageKernelTable<ConvertToLibMVReferenceArgs, ConvertToLibMVReferenceKernel>::run(depth, nComps, args)) );
+
+                    MvFloatImage converted( roi.height(), roi.width() );
+                    ASSERT_EQ( eActionStatusOK, TrackerFrameAccessor::natronCPUImageToLibMvFloatImage(enabledChannels, src.constPtrs(), srcBounds, depth, nComps, roi, alpha != 0, converted) );
+
+                    // Compare the bits so that NaNs (no channel enabled) and signed zeros must match too
+                    const std::size_t nPixels = roi.area();
+                    for (std::size_t i = 0; i < nPixels; ++i) {
+                        unsigned int expectedBits, convertedBits;
+                        memcpy(&expectedBits, expected.Data() + i, sizeof(float));
+                        memcpy(&convertedBits, converted.Data() + i, sizeof(float));
+                        ASSERT_EQ(expectedBits, convertedBits) << getDepthName(depth) << " " << nComps << " comps, channels mask " << mask << (alpha ? ", from alpha" : "") << ", pixel " << i;
+                    }
+                }
+            }
+        }
+    }
+} // TEST
@@ -30,6 +30,7 @@
 #include "Engine/Image.h"
 #include "Engine/ImageCacheKey.h"
 #include "Engine/ImageCacheEntryProcessing.h"
+#include "Engine/ImageStorage.h"
 #include "Engine/CacheEntryKeyBase.h"
 #include "Engine/ViewIdx.h"
 
@@ -68,6 +69,36 @@ TEST(ImageKeyTest, Difference) {
     ASSERT_TRUE(keyHash1 != keyHash2);
 }
 
+TEST(RAMImageStorageTest, SparseBufferZeroFilled) {
+    RAMAllocateMemoryArgs args;
+    args.bitDepth = eImageBitDepthFloat;
+    args.numComponents = 1;
+    args.bounds.set(0, 0, 4096, 4096);
+    ASSERT_GE(args.bounds.area() * sizeof(float), (std::size_t)NATRON_RAM_IMAGE_STORAGE_SPARSE_MIN_BYTES);
+
+    RAMImageStorage storage;
+    storage.allocateMemory(args);
+    ASSERT_TRUE(storage.isAllocated());
+    ASSERT_TRUE(storage.isZeroFilled());
+
+    // Reading the buffer does not change its state
+    const RAMImageStorage& constStorage = storage;
+    const float* constData = (const float*)constStorage.getData();
+    ASSERT_TRUE(constData != 0);
+    EXPECT_EQ(0.f, constData[0]);
+    EXPECT_EQ(0.f, constData[args.bounds.area() / 2 + 17]);
+    EXPECT_EQ(0.f, constData[args.bounds.area() - 1]);
+    ASSERT_TRUE(storage.isZeroFilled());
+
+    // Once handed out for writing, the buffer is no longer known to be zero
+    float* data = (float*)storage.getData();
+    data[12345] = 1.f;
+    EXPECT_FALSE(storage.isZeroFilled());
+    EXPECT_EQ(1.f, constData[12345]);
+
+    storage.deallocateMemory();
+}
+
 #define getBufAt(x,y) (&buf[roundedBounds.width() * y + x])
 
 
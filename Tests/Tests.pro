@@ -51,9 +51,11 @@ SOURCES += \
     BaseTest.cpp \
     Hash64_Test.cpp \
     Image_Test.cpp \
+    ImageKernels_Test.cpp \
     Lut_Test.cpp \
     KnobFile_Test.cpp \
     Curve_Test.cpp \
+    FitCurve_Test.cpp \
     Tracker_Test.cpp \
     wmain.cpp
 
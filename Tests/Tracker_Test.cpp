@@ -37,6 +37,11 @@ GCC_DIAG_OFF(maybe-uninitialized)
 GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_OFF
 #include <openMVG/robust_estimation/robust_estimator_Prosac.hpp>
 GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
+GCC_DIAG_OFF(unused-function)
+GCC_DIAG_OFF(unused-parameter)
+#include <libmv/autotrack/predict_tracks.h>
+GCC_DIAG_ON(unused-function)
+GCC_DIAG_ON(unused-parameter)
 #if ( ( __GNUC__ * 100) + __GNUC_MINOR__) >= 408
 GCC_DIAG_ON(maybe-uninitialized)
 #endif
@@ -471,3 +476,93 @@ TEST(ModelSearch, HomographyNPoints)
     }
     testHomography(x1);
 }
+
+static mv::Marker
+makeMarker(int frame,
+           float x,
+           float y)
+{
+    mv::Marker m;
+
+    m.clip = 0;
+    m.frame = frame;
+    m.track = 0;
+    m.center = mv::Vec2f(x, y);
+    // 20x20 pattern in a 200x200 search window
+    m.patch.coordinates << x - 10, y - 10,
+                           x + 10, y - 10,
+                           x + 10, y + 10,
+                           x - 10, y + 10;
+    m.search_region.min = mv::Vec2f(x - 100, y - 100);
+    m.search_region.max = mv::Vec2f(x + 100, y + 100);
+
+    return m;
+}
+
+// Predicts the marker at each frame of a marker moving at constant velocity, with a sudden jump at jumpFrame
+static void
+predictTrack(int jumpFrame,
+             std::vector<mv::Marker>* predictions)
+{
+    mv::KalmanFilterState state;
+
+    state.Init(makeMarker(0, 100, 100), 1);
+    state.SetAdaptiveSearchRegion(true);
+    for (int f = 1; f < 20; ++f) {
+        mv::Marker predicted = makeMarker(f, 0, 0);
+        state.PredictForward(f, &predicted);
+        predictions->push_back(predicted);
+
+        mv::Marker measured = makeMarker(f, 100 + 5 * f + (f >= jumpFrame ? 60 : 0), 100 + 2 * f);
+        measured.search_region = predicted.search_region;
+        measured.search_region.Offset(measured.center - predicted.center);
+        state.Update(measured);
+    }
+}
+
+static double
+regionArea(const mv::Region& r)
+{
+    return (double)(r.max(0) - r.min(0)) * (double)(r.max(1) - r.min(1));
+}
+
+TEST(TrackerPrediction, AdaptiveSearchRegion)
+{
+    const int jumpFrame = 12;
+    std::vector<mv::Marker> predictions;
+
+    predictTrack(jumpFrame, &predictions);
+
+    const double fullArea = 200. * 200.;
+    for (std::size_t i = 0; i < predictions.size(); ++i) {
+        const mv::Marker& m = predictions[i];
+        // The search window must always contain the predicted pattern and stay within the full search window
+        for (int c = 0; c < 4; ++c) {
+            EXPECT_GE( m.patch.coordinates(c, 0), m.search_region.min(0) );
+            EXPECT_GE( m.patch.coordinates(c, 1), m.search_region.min(1) );
+            EXPECT_LE( m.patch.coordinates(c, 0), m.search_region.max(0) );
+            EXPECT_LE( m.patch.coordinates(c, 1), m.search_region.max(1) );
+        }
+        EXPECT_LE( regionArea(m.search_region), fullArea * 1.0001 );
+    }
+
+    // Once the motion is learned, the prediction is accurate and the search window is reduced
+    const mv::Marker& settled = predictions[jumpFrame - 2];
+    EXPECT_NEAR( 100 + 5 * settled.frame, settled.center(0), 1. );
+    EXPECT_NEAR( 100 + 2 * settled.frame, settled.center(1), 1. );
+    EXPECT_LT( regionArea(settled.search_region), fullArea / 4 );
+
+    // After the jump the prediction error is large: the full search window is used again
+    const mv::Marker& afterJump = predictions[jumpFrame];
+    EXPECT_NEAR( fullArea, regionArea(afterJump.search_region), fullArea * 0.0001 );
+
+    // The same inputs must give the same search windows
+    std::vector<mv::Marker> predictions2;
+    predictTrack(jumpFrame, &predictions2);
+    ASSERT_EQ( predictions.size(), predictions2.size() );
+    for (std::size_t i = 0; i < predictions.size(); ++i) {
+        EXPECT_EQ( predictions[i].center, predictions2[i].center );
+        EXPECT_EQ( predictions[i].search_region.min, predictions2[i].search_region.min );
+        EXPECT_EQ( predictions[i].search_region.max, predictions2[i].search_region.max );
+    }
+}
@@ -94,12 +94,15 @@ struct GetImageForMarkerArgs
 {
     const Marker* marker;
     FrameAccessor::GetImageTypeEnum sourceType;
+    // The marker coordinates are expressed at this downscale level.
+    int downscale;
     FloatImage* image;
     FrameAccessor::Key key;
 
     GetImageForMarkerArgs()
     : marker(0)
     , sourceType(FrameAccessor::eGetImageTypeSource)
+    , downscale(0)
     , image(0)
     , key(0)
     {
@@ -124,6 +127,9 @@ void GetImageForMarker(std::list<GetImageForMarkerArgs>& args, FrameAccessor* fr
         // do rounding here.
         // Ideally we would need to pass IntRegion to the frame accessor.
         regions[i] = it->marker->search_region.Rounded();
+        // The accessor expects a region in original-image coordinates.
+        regions[i].min *= (float)(1 << it->downscale);
+        regions[i].max *= (float)(1 << it->downscale);
 
         bool needsTransform = false;
         if (!transform.get() && it->marker->disabled_channels != 0 && it->sourceType == FrameAccessor::eGetImageTypeSource) {
@@ -136,7 +142,7 @@ void GetImageForMarker(std::list<GetImageForMarkerArgs>& args, FrameAccessor* fr
         access.frame = it->marker->frame;
         access.sourceType = it->sourceType;
         access.input_mode = FrameAccessor::MONO;
-        access.downscale = 0; // No downscale for now.
+        access.downscale = it->downscale;
         access.region = &regions[i];
         access.transform = needsTransform ? transform.get() : 0;
         access.destination = 0;
@@ -153,52 +159,68 @@ void GetImageForMarker(std::list<GetImageForMarkerArgs>& args, FrameAccessor* fr
     }
 }
 
-}  // namespace
-
-bool AutoTrack::TrackMarker(Marker* tracked_marker,
-                            TrackRegionResult* result,
-                            KalmanFilterState* predictionState,
-                            const TrackRegionOptions* track_options) {
-    
-  // Try to predict the location of the second marker.
-    bool predicted_position;
-    if (predictionState) {
-        predicted_position = predictionState->PredictForward(tracked_marker->frame, tracked_marker);
-    } else {
-        predicted_position = PredictMarkerPosition(tracks_, tracked_marker);
-    }
-  if (predicted_position) {
-    LG << "Succesfully predicted!";
-  } else {
-    LG << "Prediction failed; trying to track anyway.";
+// Returns a copy of the marker with its coordinates divided by 2^downscale.
+Marker DownscaleMarker(const Marker& marker, int downscale) {
+  Marker result = marker;
+  if (downscale > 0) {
+    float scale = 1.0f / (1 << downscale);
+    result.center *= scale;
+    result.patch.coordinates *= scale;
+    result.search_region.min *= scale;
+    result.search_region.max *= scale;
   }
+  return result;
+}
 
-  Marker reference_marker;
-  tracks_.GetMarker(tracked_marker->reference_clip,
-                    tracked_marker->reference_frame,
-                    tracked_marker->track,
-                    &reference_marker);
+// Margin, in pixels of the coarse level, added around the pattern found on the
+// downscaled images to get the region in which it is refined at full resolution.
+const float kCoarseToFineRefineMargin = 2.0f;
+
+Region CoarseToFineRefineRegion(const Marker& coarse_marker, int coarse_downscale) {
+  float margin = kCoarseToFineRefineMargin * (1 << coarse_downscale);
+  Region region;
+  region.min = coarse_marker.patch.coordinates.colwise().minCoeff().transpose();
+  region.max = coarse_marker.patch.coordinates.colwise().maxCoeff().transpose();
+  region.min -= Vec2f(margin, margin);
+  region.max += Vec2f(margin, margin);
+  return region;
+}
+
+// Tracks the marker on images downscaled by 2^downscale. The position found
+// is written back to tracked_marker in original-image coordinates and its
+// search region is offset by the motion of the center.
+// Returns false if the images could not be retrieved.
+bool TrackMarkerAtDownscale(FrameAccessor* frame_accessor,
+                            const Marker& reference_marker,
+                            Marker* tracked_marker,
+                            int downscale,
+                            const TrackRegionOptions& track_options,
+                            TrackRegionResult* result) {
+  Marker level_reference_marker = DownscaleMarker(reference_marker, downscale);
+  Marker level_tracked_marker = DownscaleMarker(*tracked_marker, downscale);
 
   // Convert markers into the format expected by TrackRegion.
   double x1[5], y1[5];
-  MarkerToArrays(reference_marker, x1, y1);
+  MarkerToArrays(level_reference_marker, x1, y1);
 
   double x2[5], y2[5];
-  MarkerToArrays(*tracked_marker, x2, y2);
+  MarkerToArrays(level_tracked_marker, x2, y2);
 
   // TODO(keir): Technically this could take a smaller slice from the source
   // image instead of taking one the size of the search window.
   std::list<GetImageForMarkerArgs> getImageArgs;
   {
       GetImageForMarkerArgs args;
-      args.marker = &reference_marker;
+      args.marker = &level_reference_marker;
       args.sourceType = FrameAccessor::eGetImageTypeSource;
+      args.downscale = downscale;
       getImageArgs.push_back(args);
   }
   {
       GetImageForMarkerArgs args;
-      args.marker = tracked_marker;
+      args.marker = &level_tracked_marker;
       args.sourceType = FrameAccessor::eGetImageTypeSource;
+      args.downscale = downscale;
       getImageArgs.push_back(args);
   }
   {
@@ -206,12 +228,13 @@ bool AutoTrack::TrackMarker(Marker* tracked_marker,
       // image1, even though only values inside the image1 quad are examined. The
       // values must be in the range 0.0 to 0.1.
       GetImageForMarkerArgs args;
-      args.marker = &reference_marker;
+      args.marker = &level_reference_marker;
       args.sourceType = FrameAccessor::eGetImageTypeMask;
+      args.downscale = downscale;
       getImageArgs.push_back(args);
   }
 
-  GetImageForMarker(getImageArgs, frame_accessor_);
+  GetImageForMarker(getImageArgs, frame_accessor);
 
 
 
@@ -234,13 +257,22 @@ bool AutoTrack::TrackMarker(Marker* tracked_marker,
 
   if (!reference_key) {
     LG << "Couldn't get frame for reference marker: " << reference_marker;
+    if (reference_mask) {
+      frame_accessor->ReleaseImage(reference_mask_key);
+    }
+    if (tracked_key) {
+      frame_accessor->ReleaseImage(tracked_key);
+    }
     return false;
   }
 
 
   if (!tracked_key) {
-    frame_accessor_->ReleaseImage(reference_key);
-    LG << "Couldn't get frame for tracked marker: " << tracked_marker;
+    frame_accessor->ReleaseImage(reference_key);
+    if (reference_mask) {
+      frame_accessor->ReleaseImage(reference_mask_key);
+    }
+    LG << "Couldn't get frame for tracked marker: " << *tracked_marker;
     return false;
   }
 
@@ -249,16 +281,11 @@ bool AutoTrack::TrackMarker(Marker* tracked_marker,
   Vec2f original_center = tracked_marker->center;
 
   // Do the tracking!
-  TrackRegionOptions local_track_region_options;
-  if (track_options) {
-    local_track_region_options = *track_options;
-  }
+  TrackRegionOptions local_track_region_options = track_options;
   if (reference_mask_key != NULL) {
     LG << "Using mask for reference marker: " << reference_marker;
     local_track_region_options.image1_mask = reference_mask;
   }
-  local_track_region_options.num_extra_points = 1;  // For center point.
-  local_track_region_options.attempt_refine_before_brute = predicted_position;
   TrackRegion(*reference_image,
               *tracked_image,
               x1, y1,
@@ -267,27 +294,113 @@ bool AutoTrack::TrackMarker(Marker* tracked_marker,
               result);
 
   // Copy results over the tracked marker.
-  Vec2f tracked_origin = tracked_marker->search_region.Rounded().min;
+  float scale = (float)(1 << downscale);
+  Vec2f tracked_origin = level_tracked_marker.search_region.Rounded().min;
   for (int i = 0; i < 4; ++i) {
-    tracked_marker->patch.coordinates(i, 0) = x2[i] + tracked_origin[0];
-    tracked_marker->patch.coordinates(i, 1) = y2[i] + tracked_origin[1];
+    tracked_marker->patch.coordinates(i, 0) = (x2[i] + tracked_origin[0]) * scale;
+    tracked_marker->patch.coordinates(i, 1) = (y2[i] + tracked_origin[1]) * scale;
   }
-  tracked_marker->center(0) = x2[4] + tracked_origin[0];
-  tracked_marker->center(1) = y2[4] + tracked_origin[1];
+  tracked_marker->center(0) = (x2[4] + tracked_origin[0]) * scale;
+  tracked_marker->center(1) = (y2[4] + tracked_origin[1]) * scale;
   Vec2f delta = tracked_marker->center - original_center;
   tracked_marker->search_region.Offset(delta);
-  tracked_marker->source = Marker::TRACKED;
-  tracked_marker->status = Marker::UNKNOWN;
-  tracked_marker->reference_clip  = reference_marker.clip;
-  tracked_marker->reference_frame = reference_marker.frame;
 
   // Release the images and masks from the accessor cache.
-  frame_accessor_->ReleaseImage(reference_key);
-  frame_accessor_->ReleaseImage(tracked_key);
+  frame_accessor->ReleaseImage(reference_key);
+  frame_accessor->ReleaseImage(tracked_key);
 
   if (reference_mask) {
-      frame_accessor_->ReleaseImage(reference_mask_key);
+      frame_accessor->ReleaseImage(reference_mask_key);
+  }
+  return true;
+}
+
+}  // namespace
+
+bool AutoTrack::TrackMarker(Marker* tracked_marker,
+                            TrackRegionResult* result,
+                            KalmanFilterState* predictionState,
+                            const TrackRegionOptions* track_options,
+                            int coarse_downscale) {
+    
+  // Try to predict the location of the second marker.
+    bool predicted_position;
+    if (predictionState) {
+        predicted_position = predictionState->PredictForward(tracked_marker->frame, tracked_marker);
+    } else {
+        predicted_position = PredictMarkerPosition(tracks_, tracked_marker);
+    }
+  if (predicted_position) {
+    LG << "Succesfully predicted!";
+  } else {
+    LG << "Prediction failed; trying to track anyway.";
+  }
+
+  Marker reference_marker;
+  tracks_.GetMarker(tracked_marker->reference_clip,
+                    tracked_marker->reference_frame,
+                    tracked_marker->track,
+                    &reference_marker);
+
+  TrackRegionOptions local_track_region_options;
+  if (track_options) {
+    local_track_region_options = *track_options;
   }
+  local_track_region_options.num_extra_points = 1;  // For center point.
+  local_track_region_options.attempt_refine_before_brute = predicted_position;
+
+  bool tracked = false;
+  if (coarse_downscale > 0) {
+    // Find the marker in the whole search region on the downscaled images,
+    // then refine its position at full resolution in a small region around it.
+    Marker coarse_marker = *tracked_marker;
+    TrackRegionResult coarse_result;
+    if (TrackMarkerAtDownscale(frame_accessor_,
+                               reference_marker,
+                               &coarse_marker,
+                               coarse_downscale,
+                               local_track_region_options,
+                               &coarse_result) &&
+        coarse_result.is_usable()) {
+      Marker fine_marker = coarse_marker;
+      fine_marker.search_region = CoarseToFineRefineRegion(coarse_marker, coarse_downscale);
+      TrackRegionOptions fine_track_region_options = local_track_region_options;
+      fine_track_region_options.attempt_refine_before_brute = true;
+      if (TrackMarkerAtDownscale(frame_accessor_,
+                                 reference_marker,
+                                 &fine_marker,
+                                 0,
+                                 fine_track_region_options,
+                                 result) &&
+          result->is_usable()) {
+        // Keep the size of the original search region for the next frames.
+        Vec2f delta = fine_marker.center - tracked_marker->center;
+        fine_marker.search_region = tracked_marker->search_region;
+        fine_marker.search_region.Offset(delta);
+        *tracked_marker = fine_marker;
+        tracked = true;
+      } else {
+        LG << "Coarse-to-fine refinement failed; tracking at full resolution.";
+      }
+    } else {
+      LG << "Coarse tracking failed; tracking at full resolution.";
+    }
+  }
+  if (!tracked) {
+    if (!TrackMarkerAtDownscale(frame_accessor_,
+                                reference_marker,
+                                tracked_marker,
+                                0,
+                                local_track_region_options,
+                                result)) {
+      return false;
+    }
+  }
+
+  tracked_marker->source = Marker::TRACKED;
+  tracked_marker->status = Marker::UNKNOWN;
+  tracked_marker->reference_clip  = reference_marker.clip;
+  tracked_marker->reference_frame = reference_marker.frame;
 
   // Update the kalman filter with the new measurement
   if (predictionState && result->is_usable()) {
@@ -89,10 +89,17 @@ class AutoTrack {
 
   // Find the marker for the track in the frame indicated by the marker.
   // Caller maintains ownership of *result and *tracked_marker.
+  //
+  // If coarse_downscale is greater than 0, the marker is first tracked in its
+  // whole search region on images downscaled by 2^coarse_downscale, then its
+  // position is refined on the original images in a small region around the
+  // coarse position. If any of the two steps fails, the marker is tracked on
+  // the original images in its whole search region.
   bool TrackMarker(Marker* tracked_marker,
                    TrackRegionResult* result,
                    KalmanFilterState* predictionState = NULL,
-                   const TrackRegionOptions* track_options=NULL);
+                   const TrackRegionOptions* track_options=NULL,
+                   int coarse_downscale = 0);
 
   // Wrapper around Tracks API; however these may add additional processing.
   void AddMarker(const Marker& tracked_marker);
@@ -20,6 +20,7 @@
 //
 // Author: mierle@gmail.com (Keir Mierle)
 
+#include <algorithm>
 #include <cassert>
 
 #include "libmv/autotrack/marker.h"
@@ -126,6 +127,19 @@ const double initial_covariance_data[] = {
 };
 
 
+// The search region is only reduced once the prediction error was measured
+// at least this many times.
+const int kMinUpdatesForAdaptiveSearchRegion = 3;
+
+// Weight of the last prediction error in the smoothed prediction error.
+const double kPredictionErrorSmoothing = 0.5;
+
+// The reduced search region extends the predicted pattern by this many times
+// the smoothed prediction error, but never less than the minimum margin (in
+// pixels) so that the tracker still has room to refine the position.
+const double kSearchRegionErrorScale = 4.0;
+const double kMinSearchRegionMargin = 8.0;
+
 TrackerKalman filter(state_transition_data,
                      observation_data,
                      process_covariance_data,
@@ -326,6 +340,11 @@ void KalmanFilterState::Init(const Marker& first_marker, int frameStep) {
   _previousMarker = first_marker;
   _frameStep = frameStep;
   _hasInitializedState = true;
+  _searchRegionMinOffset = first_marker.search_region.min - first_marker.center;
+  _searchRegionMaxOffset = first_marker.search_region.max - first_marker.center;
+  _searchRegionReduced = false;
+  _predictionError = 0;
+  _numUpdates = 0;
 }
     
 // predict forward until target_frame is reached
@@ -355,8 +374,39 @@ bool KalmanFilterState::PredictForward(const int target_frame,
   }
   
   // Alter the search area as well so it always corresponds to the center.
-  predicted_marker->search_region = _previousMarker.search_region;
-  predicted_marker->search_region.Offset(delta);
+  if (_searchRegionReduced) {
+    // The previous marker was tracked in a reduced search area, start again
+    // from the full one.
+    predicted_marker->search_region.min = predicted_marker->center + _searchRegionMinOffset;
+    predicted_marker->search_region.max = predicted_marker->center + _searchRegionMaxOffset;
+  } else {
+    predicted_marker->search_region = _previousMarker.search_region;
+    predicted_marker->search_region.Offset(delta);
+  }
+  _searchRegionReduced = false;
+
+  if (_adaptiveSearchRegion &&
+      _numUpdates >= kMinUpdatesForAdaptiveSearchRegion) {
+    // The predictions are reliable: the pattern should be found close to the
+    // prediction, only search around it.
+    float margin = std::max(kMinSearchRegionMargin,
+                            kSearchRegionErrorScale * _predictionError);
+    Vec2f patch_min = predicted_marker->patch.coordinates.colwise().minCoeff().transpose();
+    Vec2f patch_max = predicted_marker->patch.coordinates.colwise().maxCoeff().transpose();
+    Region reduced;
+    reduced.min = patch_min - Vec2f(margin, margin);
+    reduced.max = patch_max + Vec2f(margin, margin);
+
+    // Never search outside of the full search area.
+    Region& full = predicted_marker->search_region;
+    reduced.min = reduced.min.cwiseMax(full.min);
+    reduced.max = reduced.max.cwiseMin(full.max);
+    if (reduced.min(0) > full.min(0) || reduced.min(1) > full.min(1) ||
+        reduced.max(0) < full.max(0) || reduced.max(1) < full.max(1)) {
+      full = reduced;
+      _searchRegionReduced = true;
+    }
+  }
   _previousMarker = *predicted_marker;
   return _hasInitializedState;
 } // PredictForward
@@ -369,6 +419,13 @@ bool KalmanFilterState::Update(const Marker& measured_marker) {
       Vec2(_state.mean(0), _state.mean(3));
   LG << "Prediction error: ("
      << error.x() << ", " << error.y() << "); norm: " << error.norm();
+  if (_numUpdates == 0) {
+    _predictionError = error.norm();
+  } else {
+    _predictionError = kPredictionErrorSmoothing * error.norm() +
+        (1 - kPredictionErrorSmoothing) * _predictionError;
+  }
+  ++_numUpdates;
   // Now that the state is predicted in the current frame, update the state
   // based on the measurement from the current frame.
   filter.Update(measured_marker.center.cast<double>(),
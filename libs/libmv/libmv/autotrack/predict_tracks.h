@@ -39,9 +39,27 @@ class KalmanFilterState {
   bool _hasInitializedState;
   int _frameStep;
   Marker _previousMarker;
-    
+
+  // Search region of the first marker, relative to its center.
+  Vec2f _searchRegionMinOffset;
+  Vec2f _searchRegionMaxOffset;
+
+  // When enabled, the search region is reduced around the predicted pattern
+  // as long as the predictions are accurate.
+  bool _adaptiveSearchRegion;
+  bool _searchRegionReduced;
+
+  // Smoothed norm of the prediction error and number of measurements it was
+  // computed from.
+  double _predictionError;
+  int _numUpdates;
+
 public:
-  KalmanFilterState() : _state(), _stateFrame(0), _hasInitializedState(false), _frameStep(1), _previousMarker() {}
+  KalmanFilterState()
+    : _state(), _stateFrame(0), _hasInitializedState(false), _frameStep(1), _previousMarker(),
+      _searchRegionMinOffset(Vec2f::Zero()), _searchRegionMaxOffset(Vec2f::Zero()),
+      _adaptiveSearchRegion(false), _searchRegionReduced(false),
+      _predictionError(0), _numUpdates(0) {}
     
   // Initialize the Kalman state.
   void Init(const Marker& first_marker, int frameStep);
@@ -52,6 +70,17 @@ public:
     
   // returns true if update was succesful
   bool Update(const Marker& measured_marker);
+
+  // If enabled, PredictForward() reduces the search region to the predicted
+  // pattern plus a margin following the recent prediction errors, within the
+  // search region of the first marker.
+  void SetAdaptiveSearchRegion(bool enabled) { _adaptiveSearchRegion = enabled; }
+
+  // Returns true if the last call to PredictForward() reduced the search region.
+  bool IsSearchRegionReduced() const { return _searchRegionReduced; }
+
+  // Smoothed norm of the prediction error, in pixels.
+  double GetPredictionError() const { return _predictionError; }
 };
 
 